@@ -14,6 +14,7 @@ LICENSE file in the root directory of this source tree.
 ABoneCapsuleTriggerLogic::ABoneCapsuleTriggerLogic()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	CollidersTouchingChangeCount = 0;
 }
 
 void ABoneCapsuleTriggerLogic::InitializeOverlapEvents(
@@ -54,6 +55,7 @@ void ABoneCapsuleTriggerLogic::OnOverlapBegin(class UPrimitiveComponent* Overlap
 	if (ColliderZoneOverlapped != nullptr && (ColliderZoneOverlapped->ParentInteractable->GetValidToolTagsMask() & (int)ToolTags) != 0)
 	{
 		CollidersTouching.Add(ColliderZoneOverlapped);
+		CollidersTouchingChangeCount++;
 	}
 }
 
@@ -70,6 +72,7 @@ void ABoneCapsuleTriggerLogic::OnOverlapEnd(class UPrimitiveComponent* Overlappe
 	if (ColliderZoneOverlapped != nullptr && (ColliderZoneOverlapped->ParentInteractable->GetValidToolTagsMask() & (int)ToolTags) != 0)
 	{
 		CollidersTouching.Remove(ColliderZoneOverlapped);
+		CollidersTouchingChangeCount++;
 	}
 }
 
@@ -93,5 +96,6 @@ void ABoneCapsuleTriggerLogic::CleanUpDeadColliders()
 	for (auto ColliderToRemove : ElementsToCleanUp)
 	{
 		CollidersTouching.Remove(ColliderToRemove);
+		CollidersTouchingChangeCount++;
 	}
 }
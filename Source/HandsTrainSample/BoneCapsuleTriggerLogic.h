@@ -43,6 +43,12 @@ public:
 
 	virtual void Tick(float DeltaTime) override;
 
+	/** Changes every time a collider starts or stops touching. */
+	uint32 GetCollidersTouchingChangeCount() const
+	{
+		return CollidersTouchingChangeCount;
+	}
+
 protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Properties")
 	EInteractableToolTags ToolTags;
@@ -53,6 +59,7 @@ protected:
 private:
 	// this variable is used for house keeping. declared ahead of time.
 	TArray<UColliderZone*> ElementsToCleanUp;
+	uint32 CollidersTouchingChangeCount;
 
 	/**
 	 * Sometimes colliders get disabled and trigger exit doesn't get called.
@@ -10,6 +10,7 @@ LICENSE file in the root directory of this source tree.
 #include "ColliderZone.h"
 #include "InteractableTool.h"
 #include "InteractableButton.h"
+#include "MaterialParameterCache.h"
 #include "Math/UnrealMathUtility.h"
 #include <Components/StaticMeshComponent.h>
 
@@ -24,6 +25,7 @@ UButtonMeshHelper::UButtonMeshHelper()
 	ButtonActionColor = FColor(253, 239, 162, 255);
 
 	ContactMaxDisplacementDistance = 1.365f;
+	ParameterCache = nullptr;
 }
 
 void UButtonMeshHelper::Initialize(AInteractableButton* ParentButton, UColliderZone* ButtonContact, UStaticMeshComponent* StaticMeshComponent)
@@ -33,6 +35,7 @@ void UButtonMeshHelper::Initialize(AInteractableButton* ParentButton, UColliderZ
 	this->Button = ParentButton;
 	this->ButtonContactComponent = ButtonContact;
 	this->MeshComponent = StaticMeshComponent;
+	ParameterCache = GetWorld()->GetSubsystem<UMaterialParameterCache>();
 
 	ButtonInContactOrActionStates = false;
 
@@ -53,30 +56,22 @@ void UButtonMeshHelper::InteractableStateChanged(const FInteractableStateArgs& S
 	{
 		case EInteractableState::ContactState:
 			Button->StopResetLerp();
-			MeshComponent->SetVectorParameterValueOnMaterials(
-				UButtonMeshHelper::TintColorParameterName,
-				FVector(ButtonContactColor));
+			SetTintColor(ButtonContactColor);
 			ButtonInContactOrActionStates = true;
 			break;
 		case EInteractableState::ProximityState:
 			Button->ResetPositionLerp(LerpToOldPositionDuration, LerpToOldPositionDuration);
-			MeshComponent->SetVectorParameterValueOnMaterials(
-				UButtonMeshHelper::TintColorParameterName,
-				FVector(ButtonDefaultColor));
+			SetTintColor(ButtonDefaultColor);
 			break;
 		case EInteractableState::ActionState:
 			Button->StopResetLerp();
-			MeshComponent->SetVectorParameterValueOnMaterials(
-				UButtonMeshHelper::TintColorParameterName,
-				FVector(ButtonActionColor));
+			SetTintColor(ButtonActionColor);
 			Button->PlayClickSound();
 			ButtonInContactOrActionStates = true;
 			break;
 		default:
 			Button->ResetPositionLerp(LerpToOldPositionDuration, LerpToOldPositionDuration);
-			MeshComponent->SetVectorParameterValueOnMaterials(
-				UButtonMeshHelper::TintColorParameterName,
-				FVector(ButtonDefaultColor));
+			SetTintColor(ButtonDefaultColor);
 			break;
 	}
 }
@@ -94,8 +89,9 @@ void UButtonMeshHelper::ActionOrInContactZoneStayEvent(
 	/** Calculate how much the button should be pushed inwards based on the contact
 	 * zone. The collider's dimension is required for this. Another way to test
 	 * distances is to measure distance to the plane that represents where the button
-	 * translation must stop. */
-	FVector InteractionPosition = ZoneArgs.CollidingTool->GetInteractionPosition();
+	 * translation must stop. The predicted position is used so the button
+	 * keeps up with the finger once the frame is displayed. */
+	FVector InteractionPosition = ZoneArgs.CollidingTool->GetPredictedInteractionPosition();
 	const FTransform& ContactZoneTransform = Button->ContactZone->GetComponentTransform();
 	FVector PositionInContactZoneLocalSpace = ContactZoneTransform.InverseTransformPosition(
 		InteractionPosition);
@@ -115,3 +111,11 @@ void UButtonMeshHelper::ActionOrInContactZoneStayEvent(
 				OldRelativePosition.Z));
 	}
 }
+
+void UButtonMeshHelper::SetTintColor(const FColor& Color)
+{
+	if (ParameterCache != nullptr)
+	{
+		ParameterCache->SetVectorParameter(MeshComponent, TintColorParameterName, FLinearColor(FVector(Color)));
+	}
+}
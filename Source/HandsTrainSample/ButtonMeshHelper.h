@@ -16,6 +16,7 @@ LICENSE file in the root directory of this source tree.
 class AInteractableButton;
 class UStaticMeshComponent;
 class UColliderZone;
+class UMaterialParameterCache;
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class HANDSTRAINSAMPLE_API UButtonMeshHelper : public UActorComponent
@@ -71,4 +72,7 @@ private:
 
 	float ButtonInContactOrActionStates;
 	UStaticMeshComponent* MeshComponent;
+	UMaterialParameterCache* ParameterCache;
+
+	void SetTintColor(const FColor& Color);
 };
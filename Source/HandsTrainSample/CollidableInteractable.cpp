@@ -10,11 +10,13 @@ LICENSE file in the root directory of this source tree.
 #include "ColliderZone.h"
 #include "ButtonTriggerZone.h"
 #include "InteractableTool.h"
+#include "InteractableEventQueue.h"
 #include "ButtonTriggerZone.h"
 #include "Kismet/KismetSystemLibrary.h"
 
 const float ACollidableInteractable::EntryDotThreshold = 0.8f;
 const float ACollidableInteractable::PerpDotThreshold = 0.5f;
+const int32 ACollidableInteractable::ToolSlotsReserveSize = 4;
 
 ACollidableInteractable::ACollidableInteractable()
 {
@@ -31,6 +33,12 @@ ACollidableInteractable::ACollidableInteractable()
 	InteractablePlaneCenter = CreateDefaultSubobject<USceneComponent>(
 		FName(TEXT("InteractablePlaneCenter")));
 	InteractablePlaneCenter->SetupAttachment(RootComponent);
+
+	EventQueue = nullptr;
+	ToolSlots.Reserve(ToolSlotsReserveSize);
+	WorldPressDirection = FVector::ZeroVector;
+	PositiveSidePlane = FPlane(ForceInit);
+	CachedLocalPressDirection = FVector::ZeroVector;
 }
 
 void ACollidableInteractable::BeginPlay()
@@ -41,6 +49,32 @@ void ACollidableInteractable::BeginPlay()
 	ContactZone->ParentInteractable = this;
 	ActionZone->ParentInteractable = this;
 	CurrentState = EInteractableState::Default;
+	EventQueue = GetWorld()->GetSubsystem<UInteractableEventQueue>();
+
+	UpdatePressPlane();
+	// also fires when the actor itself moves, since the plane center is attached to it
+	InteractablePlaneCenter->TransformUpdated.AddUObject(this,
+		&ACollidableInteractable::OnPlaneCenterTransformUpdated);
+}
+
+void ACollidableInteractable::UpdatePressPlane()
+{
+	CachedLocalPressDirection = LocalPressDirection;
+	WorldPressDirection = GetActorTransform().TransformVector(LocalPressDirection);
+	PositiveSidePlane = FPlane(InteractablePlaneCenter->GetComponentLocation(), -WorldPressDirection);
+}
+
+void ACollidableInteractable::OnPlaneCenterTransformUpdated(USceneComponent* UpdatedComponent,
+	EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	UpdatePressPlane();
+}
+
+int32 ACollidableInteractable::FindToolSlot(AInteractableTool* Tool) const
+{
+	return ToolSlots.IndexOfByPredicate([Tool](const FInteractableToolSlot& ToolSlot) {
+		return ToolSlot.Tool == Tool;
+	});
 }
 
 void ACollidableInteractable::UpdateCollisionDepth_Implementation(
@@ -48,20 +82,26 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 	EInteractableCollisionDepth NewCollisionDepth)
 {
 	bool IsFarFieldTool = InteractableTool->IsFarFieldTool;
+	int32 ToolSlotIndex = FindToolSlot(InteractableTool);
 
 	// If this is a near field tool and another tool already controls it, bail
-	if (!IsFarFieldTool && ToolToState.Num() > 0 && !ToolToState.Contains(InteractableTool))
+	if (!IsFarFieldTool && ToolSlots.Num() > 0 && ToolSlotIndex == INDEX_NONE)
 	{
 		return;
 	}
 
 	auto OldState = CurrentState;
+	// every event of this update happens on the same frame
+	int64 FrameCount = UKismetSystemLibrary::GetFrameCount();
 
-	// Ignore contact test if you are using the far field tool
-	auto MyTransform = GetActorTransform();
-	auto CurrPressDirection = MyTransform.TransformVector(LocalPressDirection);
+	// the press direction can be changed from blueprints at any time
+	if (CachedLocalPressDirection != LocalPressDirection)
+	{
+		UpdatePressPlane();
+	}
 
-	bool ValidContact = IsValidContact(InteractableTool, CurrPressDirection) || InteractableTool->IsFarFieldTool;
+	// Ignore contact test if you are using the far field tool
+	bool ValidContact = IsFarFieldTool || IsValidContact(InteractableTool, WorldPressDirection);
 	// In case tool enters contact zone first, we are in proximity as well
 	bool ToolIsInProximity = NewCollisionDepth >= EInteractableCollisionDepth::Proximity;
 	bool ToolIsInContactZone = NewCollisionDepth == EInteractableCollisionDepth::Contact;
@@ -71,14 +111,14 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 	if (SwitchingStates)
 	{
 		FireInteractionEventsEventsOnDepth(OldCollisionDepth,
-			InteractableTool, ECollisionInteractionType::Exit);
+			InteractableTool, ECollisionInteractionType::Exit, FrameCount);
 		FireInteractionEventsEventsOnDepth(NewCollisionDepth,
-			InteractableTool, ECollisionInteractionType::Enter);
+			InteractableTool, ECollisionInteractionType::Enter, FrameCount);
 	}
 	else
 	{
 		FireInteractionEventsEventsOnDepth(NewCollisionDepth,
-			InteractableTool, ECollisionInteractionType::Stay);
+			InteractableTool, ECollisionInteractionType::Stay, FrameCount);
 	}
 
 	auto UpcomingState = OldState;
@@ -90,9 +130,8 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 	else
 	{
 		// Use plane describing positive side of interactable to filter collisions
-		FPlane InteractableZonePlane(InteractablePlaneCenter->GetComponentLocation(), -CurrPressDirection);
 		// Skip plane test if boolean flag tells us to ignore it
-		float DotProdPlane = InteractableZonePlane.PlaneDot(InteractableTool->GetInteractionPosition());
+		float DotProdPlane = PositiveSidePlane.PlaneDot(InteractableTool->GetInteractionPosition());
 		bool OnPositiveSideOfInteractable = !MakeSureInteractingToolIsOnPositiveSide || DotProdPlane > 0.0f;
 		UpcomingState = GetUpcomingStateNearField(OldState, NewCollisionDepth,
 			ToolIsInActionZone, ToolIsInContactZone, ToolIsInProximity,
@@ -101,18 +140,18 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 
 	if (UpcomingState != EInteractableState::Default)
 	{
-		if (ToolToState.Contains(InteractableTool))
+		if (ToolSlotIndex != INDEX_NONE)
 		{
-			ToolToState[InteractableTool] = UpcomingState;
+			ToolSlots[ToolSlotIndex].State = UpcomingState;
 		}
 		else
 		{
-			ToolToState.Add(InteractableTool, UpcomingState);
+			ToolSlots.Emplace(InteractableTool, UpcomingState);
 		}
 	}
-	else
+	else if (ToolSlotIndex != INDEX_NONE)
 	{
-		ToolToState.Remove(InteractableTool);
+		ToolSlots.RemoveAtSwap(ToolSlotIndex);
 	}
 
 	// Far field set max state set so far. This can happen
@@ -120,12 +159,11 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 	// you don't want another one to lower the interactable's state.
 	if (IsFarFieldTool)
 	{
-		for (auto ToolStatePair : ToolToState)
+		for (const FInteractableToolSlot& ToolSlot : ToolSlots)
 		{
-			auto ToolState = ToolStatePair.Value;
-			if (UpcomingState < ToolState)
+			if (UpcomingState < ToolSlot.State)
 			{
-				UpcomingState = ToolState;
+				UpcomingState = ToolSlot.State;
 			}
 		}
 	}
@@ -133,15 +171,25 @@ void ACollidableInteractable::UpdateCollisionDepth_Implementation(
 	if (OldState != UpcomingState)
 	{
 		CurrentState = UpcomingState;
+		if (!OnInteractableStateChanged.IsBound())
+		{
+			return;
+		}
 		auto InteractionType = !SwitchingStates ? ECollisionInteractionType::Stay : NewCollisionDepth == EInteractableCollisionDepth::None ? ECollisionInteractionType::Exit
 																																		   : ECollisionInteractionType::Enter;
 		auto CurrentCollider = CurrentState == EInteractableState::ProximityState ? ProximityZone : CurrentState == EInteractableState::ContactState ? ContactZone
 			: CurrentState == EInteractableState::ActionState																						 ? ActionZone
 																																					 : nullptr;
-		OnInteractableStateChanged.Broadcast(
-			FInteractableStateArgs(this, InteractableTool, OldState, CurrentState,
-				FColliderZoneArgs(CurrentCollider, UKismetSystemLibrary::GetFrameCount(),
-					InteractableTool, InteractionType)));
+		FInteractableStateArgs StateArgs(this, InteractableTool, OldState, CurrentState,
+			FColliderZoneArgs(CurrentCollider, FrameCount, InteractableTool, InteractionType));
+		if (EventQueue != nullptr && EventQueue->IsCollecting())
+		{
+			EventQueue->EnqueueStateChange(this, StateArgs);
+		}
+		else
+		{
+			OnInteractableStateChanged.Broadcast(StateArgs);
+		}
 	}
 }
 
@@ -223,23 +271,41 @@ EInteractableState ACollidableInteractable::GetUpcomingStateNearField(EInteracta
 }
 
 void ACollidableInteractable::FireInteractionEventsEventsOnDepth(EInteractableCollisionDepth CurrentDepth,
-	AInteractableTool* CollidingTool, ECollisionInteractionType InteractionType)
+	AInteractableTool* CollidingTool, ECollisionInteractionType InteractionType, int64 FrameCount)
 {
+	FZoneEventSignature* ZoneEvent = nullptr;
+	UColliderZone* Zone = nullptr;
 	switch (CurrentDepth)
 	{
 		case EInteractableCollisionDepth::Proximity:
-			OnProximityZoneEvent.Broadcast(FColliderZoneArgs(ProximityZone,
-				UKismetSystemLibrary::GetFrameCount(), CollidingTool, InteractionType));
+			ZoneEvent = &OnProximityZoneEvent;
+			Zone = ProximityZone;
 			break;
 		case EInteractableCollisionDepth::Contact:
-			OnContactZoneEvent.Broadcast(FColliderZoneArgs(ContactZone,
-				UKismetSystemLibrary::GetFrameCount(), CollidingTool, InteractionType));
+			ZoneEvent = &OnContactZoneEvent;
+			Zone = ContactZone;
 			break;
 		case EInteractableCollisionDepth::Action:
-			OnActionZoneEvent.Broadcast(FColliderZoneArgs(ActionZone,
-				UKismetSystemLibrary::GetFrameCount(), CollidingTool, InteractionType));
+			ZoneEvent = &OnActionZoneEvent;
+			Zone = ActionZone;
 			break;
 	}
+
+	// most zones have no listeners, so skip building their args
+	if (ZoneEvent == nullptr || !ZoneEvent->IsBound())
+	{
+		return;
+	}
+
+	FColliderZoneArgs ZoneArgs(Zone, FrameCount, CollidingTool, InteractionType);
+	if (EventQueue != nullptr && EventQueue->IsCollecting())
+	{
+		EventQueue->EnqueueZoneEvent(this, CurrentDepth, ZoneArgs);
+	}
+	else
+	{
+		ZoneEvent->Broadcast(ZoneArgs);
+	}
 }
 
 bool ACollidableInteractable::IsValidContact(AInteractableTool* CollidingTool, FVector EntryDirection)
@@ -12,6 +12,8 @@ LICENSE file in the root directory of this source tree.
 #include "Interactable.h"
 #include "CollidableInteractable.generated.h"
 
+class UInteractableEventQueue;
+
 UENUM(BlueprintType)
 enum class EContactTest : uint8
 {
@@ -19,6 +21,28 @@ enum class EContactTest : uint8
 	BackwardsPress,
 };
 
+/** State of one tool interacting with an interactable. */
+USTRUCT()
+struct FInteractableToolSlot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	AInteractableTool* Tool;
+
+	EInteractableState State;
+
+	FInteractableToolSlot()
+		: Tool(nullptr), State(EInteractableState::Default)
+	{
+	}
+
+	FInteractableToolSlot(AInteractableTool* Tool, EInteractableState State)
+		: Tool(Tool), State(State)
+	{
+	}
+};
+
 /**
  * Basic functionality for (most) collidable interactables.
  */
@@ -55,12 +79,26 @@ protected:
 	virtual void BeginPlay() override;
 
 	/** Normally this would be private. Make it a UPROPERTY to
-	 * prevent dangling references. */
+	 * prevent dangling references. Rarely holds more than a couple of
+	 * tools, so it's a small array that is scanned rather than a map. */
 	UPROPERTY()
-	TMap<AInteractableTool*, EInteractableState> ToolToState;
+	TArray<FInteractableToolSlot> ToolSlots;
 
 private:
 	EInteractableState CurrentState;
+	UInteractableEventQueue* EventQueue;
+
+	// press direction and positive side plane in world space; only
+	// recomputed when the plane center moves or the press direction changes
+	FVector WorldPressDirection;
+	FPlane PositiveSidePlane;
+	FVector CachedLocalPressDirection;
+
+	void UpdatePressPlane();
+	void OnPlaneCenterTransformUpdated(USceneComponent* UpdatedComponent,
+		EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	int32 FindToolSlot(AInteractableTool* Tool) const;
 
 	EInteractableState GetUpcomingStateNearField(EInteractableState OldState,
 		EInteractableCollisionDepth NewCollisionDepth,
@@ -69,15 +107,18 @@ private:
 
 	/** Can call enter, stay and exit on a specific depth. */
 	void FireInteractionEventsEventsOnDepth(EInteractableCollisionDepth CurrentDepth,
-		AInteractableTool* CollidingTool, ECollisionInteractionType InteractionType);
+		AInteractableTool* CollidingTool, ECollisionInteractionType InteractionType, int64 FrameCount);
 
 	/** If necessary, restrict contacts with button in case a button cannot be pressed
 	 * incorrectly. */
 	bool IsValidContact(AInteractableTool* CollidingTool, FVector EntryDirection);
 
+	/** Uses the tool's estimated velocity, so a single noisy frame of tracking
+	 * doesn't decide whether the press is accepted. */
 	bool PassEntryTest(AInteractableTool* CollidingTool, FVector EntryDirection);
 	bool PassPerpTest(AInteractableTool* CollidingTool, FVector EntryDirection);
 
 	const static float EntryDotThreshold;
 	const static float PerpDotThreshold;
+	const static int32 ToolSlotsReserveSize;
 };
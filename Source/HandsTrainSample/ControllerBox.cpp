@@ -34,8 +34,16 @@ void AControllerBox::FindLocomotive()
 {
 	if (!IsValid(Locomotive))
 	{
-		Locomotive = (ATrainLocomotive*)UGameplayStatics::GetActorOfClass(GetWorld(),
-			ATrainLocomotive::StaticClass());
+		TArray<AActor*> LocomotiveActors;
+		UGameplayStatics::GetAllActorsOfClass(GetWorld(),
+			ATrainLocomotive::StaticClass(), LocomotiveActors);
+		Locomotives.Reset(LocomotiveActors.Num());
+		for (AActor* LocomotiveActor : LocomotiveActors)
+		{
+			Locomotives.Add((ATrainLocomotive*)LocomotiveActor);
+		}
+
+		Locomotive = Locomotives.Num() > 0 ? Locomotives[0] : nullptr;
 		if (!IsValid(Locomotive))
 		{
 			UE_LOG(LogTemp, Error, TEXT("Controller box found no locomotive actor!"));
@@ -297,18 +305,24 @@ void AControllerBox::StartStopButtonStateChanged(const FInteractableStateArgs&
 void AControllerBox::StartStopTrain()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->StartStopTrainStateChanged();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->StartStopTrainStateChanged();
+		}
 	}
 }
 
 void AControllerBox::TrainBlowSmoke()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->BlowLotsOfSmoke();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->BlowLotsOfSmoke();
+		}
 	}
 }
 
@@ -324,36 +338,48 @@ void AControllerBox::CowMoo()
 void AControllerBox::TrainBlowWhistle()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->WhistleButtonStateChanged();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->WhistleButtonStateChanged();
+		}
 	}
 }
 
 void AControllerBox::TrainSpeedUp()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->IncreaseSpeed();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->IncreaseSpeed();
+		}
 	}
 }
 
 void AControllerBox::TrainSlowDown()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->DecreaseSpeed();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->DecreaseSpeed();
+		}
 	}
 }
 
 void AControllerBox::TrainReverse()
 {
 	FindLocomotive();
-	if (IsValid(Locomotive))
+	for (ATrainLocomotive* TrainLocomotive : Locomotives)
 	{
-		Locomotive->Reverse();
+		if (IsValid(TrainLocomotive))
+		{
+			TrainLocomotive->Reverse();
+		}
 	}
 }
 
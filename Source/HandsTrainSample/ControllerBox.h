@@ -138,6 +138,10 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	ATrainLocomotive* Locomotive;
 
+	// every locomotive in the level; the buttons drive all of them
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TArray<ATrainLocomotive*> Locomotives;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	ACowCar* CowCar;
 
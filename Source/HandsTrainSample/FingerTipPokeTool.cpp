@@ -9,10 +9,12 @@ LICENSE file in the root directory of this source tree.
 #include "FingerTipPokeTool.h"
 #include "OculusXRHandComponent.h"
 #include "BoneCapsuleTriggerLogic.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainStats.h"
 #include "ColliderZone.h"
+#include "Interactable.h"
 #include "Components/StaticMeshComponent.h"
 #include "Kismet/KismetMathLibrary.h"
-#include <cstring>
 #include <vector>
 
 AFingerTipPokeTool::AFingerTipPokeTool()
@@ -29,8 +31,17 @@ AFingerTipPokeTool::AFingerTipPokeTool()
 
 	SphereRadius = TargetMesh->GetRelativeScale3D()[0] * 0.5f;
 	LastScale = 1.0f;
-	CurrentVelocityFrame = 0;
-	SampledMaxFramesAlready = false;
+	HandInput = nullptr;
+	VelocityEstimate = EVelocityEstimate::Mean;
+	OneEuroMinCutoff = 1.0f;
+	OneEuroBeta = 0.5f;
+	OneEuroDerivativeCutoff = 1.0f;
+	PredictionHorizon = 0.0f;
+	bSweepContacts = true;
+	SpatialIndex = nullptr;
+	SweepStartPosition = FVector::ZeroVector;
+	TipPosition = FVector::ZeroVector;
+	bHasSweepStart = false;
 	bIsInitialized = false;
 }
 
@@ -38,14 +49,14 @@ void AFingerTipPokeTool::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (!bIsInitialized || !IsValid(CapsuleToTrack.Capsule))
+	if (!bIsInitialized || !IsValid(CapsuleToTrack.Capsule) || HandInput == nullptr)
 	{
 		return;
 	}
 
 	auto CapsuleObject = CapsuleToTrack.Capsule;
 	auto HandType = IsRightHandedTool ? EOculusXRHandType::HandRight : EOculusXRHandType::HandLeft;
-	float CurrentHandScale = UOculusXRInputFunctionLibrary::GetHandScale(HandType);
+	float CurrentHandScale = HandInput->GetHandState(HandType).HandScale;
 
 	const FTransform& CapsuleTransform = CapsuleObject->GetComponentTransform();
 	FQuat CapsuleRotation = CapsuleTransform.GetRotation();
@@ -63,15 +74,18 @@ void AFingerTipPokeTool::Tick(float DeltaTime)
 		CapsuleDirection, CapsuleRotation.GetRightVector())
 			.Quaternion());
 
+	TipPosition = CapsuleTipPosition;
 	InteractionPosition = CapsuleTipPosition;
 
-	UpdateAverageVelocity(DeltaTime);
-	CheckAndUpdateScale();
+	UpdateVelocity(DeltaTime);
+	CheckAndUpdateScale(CurrentHandScale);
 }
 
 void AFingerTipPokeTool::Initialize_Implementation(UOculusXRHandComponent* HandComponent)
 {
-	memset(VelocityFrames, 0, NumVelocityFrames * sizeof(FVector));
+	VelocityEstimator.Reset();
+	VelocityEstimator.SetMode(VelocityEstimate);
+	VelocityEstimator.SetOneEuroParameters(OneEuroMinCutoff, OneEuroBeta, OneEuroDerivativeCutoff);
 
 	BoneToTestCollisions = EOculusXRBone::Pinky_3;
 	switch (FingerToFollow)
@@ -130,6 +144,9 @@ void AFingerTipPokeTool::Initialize_Implementation(UOculusXRHandComponent* HandC
 		CapsuleToTrack = CollisionCapsulesForBone[0];
 	}
 
+	HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
+	SpatialIndex = bSweepContacts ? GetWorld()->GetSubsystem<UInteractableSpatialIndex>() : nullptr;
+	bHasSweepStart = false;
 	SetVisualEnableState_Implementation(true);
 	bIsInitialized = true;
 }
@@ -151,7 +168,7 @@ EInteractableToolTags AFingerTipPokeTool::GetToolTags_Implementation()
 
 void AFingerTipPokeTool::RefreshCurrentIntersectingObjects_Implementation()
 {
-	CurrentIntersectingObjects.Empty();
+	CurrentIntersectingObjects.Reset();
 	TSet<UColliderZone*>& CollidersTouching = TriggerLogic->CollidersTouching;
 	for (UColliderZone* ColliderZone : CollidersTouching)
 	{
@@ -159,44 +176,73 @@ void AFingerTipPokeTool::RefreshCurrentIntersectingObjects_Implementation()
 			ColliderZone, ColliderZone->GetCollisionDepth(),
 			this));
 	}
-}
 
-void AFingerTipPokeTool::UpdateAverageVelocity(float DeltaTime)
-{
-	FVector CurrentPosition = GetActorLocation();
-	FVector CurrentVelocityVec = (CurrentPosition - LastPosition) / DeltaTime;
-	LastPosition = CurrentPosition;
-	VelocityFrames[CurrentVelocityFrame] = CurrentVelocityVec;
-	// if sampled more than allowed, loop back toward the beginning
-	CurrentVelocityFrame = (CurrentVelocityFrame + 1) % NumVelocityFrames;
-
-	CalculatedToolVelocity = FVector::ZeroVector;
-	/**
-	 * Edge case; when we first start up, we will have only
-	 * sampled less than the max frames. So only compute the
-	 * average over that subset. After that, the max frame samples
-	 * will act like and array that loops back toward the
-	 * beginning
-	 */
-	if (!SampledMaxFramesAlready && CurrentVelocityFrame == NumVelocityFrames - 1)
+	if (SpatialIndex != nullptr && bHasSweepStart && IsValid(CapsuleToTrack.Capsule))
 	{
-		SampledMaxFramesAlready = true;
+		AddSweptContacts();
 	}
+	// the next sweep starts from the tip, not from where it was pulled back
+	// to; starting on a zone's face would hit it again at distance zero
+	SweepStartPosition = TipPosition;
+	bHasSweepStart = true;
+}
+
+void AFingerTipPokeTool::AddSweptContacts()
+{
+	float Radius = CapsuleToTrack.Capsule->GetScaledCapsuleRadius();
+	SweptZoneHits.Reset();
+	SpatialIndex->SweepSphere(SweepStartPosition, TipPosition, Radius,
+		(uint32)GetToolTags_Implementation(), SweptZoneHits);
 
-	uint32 NumFramesToSample = SampledMaxFramesAlready ? NumVelocityFrames
-													   : CurrentVelocityFrame + 1;
-	for (uint32 FrameIndex = 0; FrameIndex < NumFramesToSample;
-		FrameIndex++)
+	FVector SweepDirection = (TipPosition - SweepStartPosition).GetSafeNormal();
+	for (const FInteractableZoneHit& ZoneHit : SweptZoneHits)
 	{
-		CalculatedToolVelocity += VelocityFrames[FrameIndex];
+		UColliderZone* Zone = ZoneHit.Zone;
+		if (!IsValid(Zone->ParentInteractable))
+		{
+			continue;
+		}
+
+		EInteractableCollisionDepth Depth = Zone->GetCollisionDepth();
+		PassedThroughObjects.Add(FInteractableCollisionInfo(Zone, Depth, this));
+		bool bOverlapping = CurrentIntersectingObjects.ContainsByPredicate(
+			[Zone](const FInteractableCollisionInfo& CollisionInfo) {
+				return CollisionInfo.InteractableCollider == Zone;
+			});
+		if (!bOverlapping)
+		{
+			CurrentIntersectingObjects.Add(FInteractableCollisionInfo(Zone, Depth, this));
+			HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_SweptContacts, EHandsTrainCounter::SweptContacts, 1);
+		}
+
+		// whatever lies beyond the first button pressed is shielded by it
+		if (Depth == EInteractableCollisionDepth::Action)
+		{
+			if (!bOverlapping)
+			{
+				InteractionPosition = SweepStartPosition + SweepDirection * ZoneHit.Distance;
+				PredictedInteractionPosition = InteractionPosition;
+			}
+			break;
+		}
 	}
-	CalculatedToolVelocity /= NumFramesToSample;
 }
 
-void AFingerTipPokeTool::CheckAndUpdateScale()
+uint32 AFingerTipPokeTool::GetInputChangeStamp() const
+{
+	// zones moving into or out of the finger come through as overlap events
+	return IsValid(TriggerLogic) ? TriggerLogic->GetCollidersTouchingChangeCount() : 0;
+}
+
+void AFingerTipPokeTool::UpdateVelocity(float DeltaTime)
+{
+	VelocityEstimator.AddSample(GetActorLocation(), DeltaTime);
+	CalculatedToolVelocity = VelocityEstimator.GetVelocity();
+	PredictedInteractionPosition = InteractionPosition + CalculatedToolVelocity * PredictionHorizon;
+}
+
+void AFingerTipPokeTool::CheckAndUpdateScale(float CurrentHandScale)
 {
-	float CurrentHandScale = UOculusXRInputFunctionLibrary::GetHandScale(
-		IsRightHandedTool ? EOculusXRHandType::HandRight : EOculusXRHandType::HandLeft);
 	if (fabs(CurrentHandScale - LastScale) > 0.001f)
 	{
 		SetActorRelativeScale3D(FVector(CurrentHandScale, CurrentHandScale,
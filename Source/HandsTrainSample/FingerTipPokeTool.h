@@ -9,8 +9,10 @@ LICENSE file in the root directory of this source tree.
 #pragma once
 
 #include "CoreMinimal.h"
+#include "InteractableSpatialIndex.h"
 #include "InteractableTool.h"
 #include "OculusXRInputFunctionLibrary.h"
+#include "RingBufferVelocityEstimator.h"
 #include "FingerTipPokeTool.generated.h"
 
 class UOculusXRHandComponent;
@@ -27,6 +29,7 @@ enum class EHandFinger : uint8
 };
 
 class ABoneCapsuleTriggerLogic;
+class UHandInputSubsystem;
 class USceneComponent;
 class UStaticMeshComponent;
 
@@ -52,6 +55,30 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties")
 	EHandFinger FingerToFollow;
 
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties",
+		meta = (ToolTip = "How the tool's velocity is estimated from its recent positions."))
+	EVelocityEstimate VelocityEstimate;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties|One Euro",
+		meta = (ClampMin = "0.01", ToolTip = "Cutoff frequency in Hz of the one euro filter when the finger is still; lower is smoother."))
+	float OneEuroMinCutoff;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties|One Euro",
+		meta = (ClampMin = "0.0", ToolTip = "Hz the one euro cutoff rises per cm/s of finger speed; higher lags less on fast pokes."))
+	float OneEuroBeta;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties|One Euro",
+		meta = (ClampMin = "0.01", ToolTip = "Cutoff frequency in Hz of the speed that raises the one euro cutoff."))
+	float OneEuroDerivativeCutoff;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties",
+		meta = (ClampMin = "0.0", ToolTip = "Seconds to extrapolate the interaction position by, e.g. the display latency, so buttons react to a poke a frame earlier."))
+	float PredictionHorizon;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tool Properties",
+		meta = (ToolTip = "Also find zones the finger tip passed through since the last update, so fast pokes can't skip over thin zones."))
+	bool bSweepContacts;
+
 	virtual void Initialize_Implementation(UOculusXRHandComponent* HandComponent)
 		override;
 
@@ -63,6 +90,8 @@ public:
 
 	void RefreshCurrentIntersectingObjects_Implementation() override;
 
+	virtual uint32 GetInputChangeStamp() const override;
+
 protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	ABoneCapsuleTriggerLogic* TriggerLogic;
@@ -80,18 +109,36 @@ protected:
 	EOculusXRBone BoneToTestCollisions;
 
 private:
-	const static uint32 NumVelocityFrames = 10;
-	FVector VelocityFrames[NumVelocityFrames];
-	uint32 CurrentVelocityFrame;
+	const static int32 NumVelocityFrames = 10;
+	TRingBufferVelocityEstimator<NumVelocityFrames> VelocityEstimator;
 
 	float SphereRadius;
 
 	bool bIsInitialized;
 	float LastScale;
-
-	FVector LastPosition;
-	bool SampledMaxFramesAlready;
-
-	void UpdateAverageVelocity(float DeltaTime);
-	void CheckAndUpdateScale();
+	UHandInputSubsystem* HandInput;
+	UInteractableSpatialIndex* SpatialIndex;
+
+	// where the finger tip really is; InteractionPosition may be pulled back
+	// to where the tip entered a button
+	FVector TipPosition;
+	// tip position as of the last refresh
+	FVector SweepStartPosition;
+	bool bHasSweepStart;
+	TArray<FInteractableZoneHit> SweptZoneHits;
+
+	void UpdateVelocity(float DeltaTime);
+
+	/**
+	 * Adds the zones the finger tip passed through since the last refresh
+	 * without overlapping them now. Stops at the first action zone, and
+	 * moves the interaction position back to where the tip entered it, so
+	 * the interactable sees the press from the side it came from. Every
+	 * zone passed is also recorded in entry order, so the interactable
+	 * steps through proximity and contact on its way to action. A zone the
+	 * tip went all the way through counts as touched until the next
+	 * refresh, so the press lasts a frame and is released on the next.
+	 */
+	void AddSweptContacts();
+	void CheckAndUpdateScale(float CurrentHandScale);
 };
@@ -0,0 +1,222 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "HandBoneSegmentKernel.h"
+#include "Kismet/KismetMathLibrary.h"
+
+namespace
+{
+	// vectors too short to normalize come out as zero
+	void NormalizeLanes(VectorRegister4Float& X, VectorRegister4Float& Y, VectorRegister4Float& Z)
+	{
+		VectorRegister4Float LengthSquared = VectorMultiply(X, X);
+		LengthSquared = VectorMultiplyAdd(Y, Y, LengthSquared);
+		LengthSquared = VectorMultiplyAdd(Z, Z, LengthSquared);
+		VectorRegister4Float IsTooShort = VectorCompareLE(LengthSquared, VectorSetFloat1(UE_SMALL_NUMBER));
+		VectorRegister4Float InvLength = VectorSelect(IsTooShort, GlobalVectorConstants::FloatZero,
+			VectorDivide(GlobalVectorConstants::FloatOne, VectorSqrt(LengthSquared)));
+		X = VectorMultiply(X, InvLength);
+		Y = VectorMultiply(Y, InvLength);
+		Z = VectorMultiply(Z, InvLength);
+	}
+}
+
+FHandBoneSegmentKernel::FHandBoneSegmentKernel()
+{
+}
+
+void FHandBoneSegmentKernel::Reset()
+{
+	StartBoneIndices.Reset();
+	EndBoneIndices.Reset();
+	for (TArray<float>* Lanes : { &StartX, &StartY, &StartZ, &EndX, &EndY, &EndZ, &BoneUpX, &BoneUpY, &BoneUpZ,
+			 &MidX, &MidY, &MidZ, &Lengths, &ForwardX, &ForwardY, &ForwardZ, &RightX, &RightY, &RightZ,
+			 &UpX, &UpY, &UpZ, &Degenerate })
+	{
+		Lanes->Reset();
+	}
+}
+
+void FHandBoneSegmentKernel::AddSegment(int32 StartBoneIndex, int32 EndBoneIndex)
+{
+	int32 Index = StartBoneIndices.Add(StartBoneIndex);
+	EndBoneIndices.Add(EndBoneIndex);
+	if (Index == StartX.Num())
+	{
+		// padding lanes are all zeros, which makes them degenerate
+		for (TArray<float>* Lanes : { &StartX, &StartY, &StartZ, &EndX, &EndY, &EndZ, &BoneUpX, &BoneUpY, &BoneUpZ,
+				 &MidX, &MidY, &MidZ, &Lengths, &ForwardX, &ForwardY, &ForwardZ, &RightX, &RightY, &RightZ,
+				 &UpX, &UpY, &UpZ, &Degenerate })
+		{
+			Lanes->AddZeroed(4);
+		}
+	}
+}
+
+void FHandBoneSegmentKernel::Gather(TArrayView<const FTransform> BoneTransforms)
+{
+	for (int32 Index = 0; Index < Num(); Index++)
+	{
+		const FTransform& StartTransform = BoneTransforms[StartBoneIndices[Index]];
+		const FTransform& EndTransform = BoneTransforms[EndBoneIndices[Index]];
+		FVector StartPosition = StartTransform.GetLocation();
+		FVector EndPosition = EndTransform.GetLocation();
+		FVector BoneUp = (StartTransform.GetRotation().GetUpVector() + EndTransform.GetRotation().GetUpVector()) * 0.5f;
+
+		StartX[Index] = (float)StartPosition.X;
+		StartY[Index] = (float)StartPosition.Y;
+		StartZ[Index] = (float)StartPosition.Z;
+		EndX[Index] = (float)EndPosition.X;
+		EndY[Index] = (float)EndPosition.Y;
+		EndZ[Index] = (float)EndPosition.Z;
+		BoneUpX[Index] = (float)BoneUp.X;
+		BoneUpY[Index] = (float)BoneUp.Y;
+		BoneUpZ[Index] = (float)BoneUp.Z;
+	}
+}
+
+void FHandBoneSegmentKernel::Compute(TArrayView<const FTransform> BoneTransforms, const FTransform& WorldToInstance,
+	const FVector& ViewPosition, float LengthScale, float Thickness, TArrayView<FTransform> SegmentTransforms)
+{
+	Gather(BoneTransforms);
+
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float SamePositionTolerance = VectorSetFloat1(UE_KINDA_SMALL_NUMBER);
+	const VectorRegister4Float ParallelTolerance = VectorSetFloat1(0.00001f);
+	const VectorRegister4Float ViewX = VectorSetFloat1((float)ViewPosition.X);
+	const VectorRegister4Float ViewY = VectorSetFloat1((float)ViewPosition.Y);
+	const VectorRegister4Float ViewZ = VectorSetFloat1((float)ViewPosition.Z);
+
+	const int32 NumPadded = StartX.Num();
+	for (int32 Index = 0; Index < NumPadded; Index += 4)
+	{
+		VectorRegister4Float SX = VectorLoad(&StartX[Index]);
+		VectorRegister4Float SY = VectorLoad(&StartY[Index]);
+		VectorRegister4Float SZ = VectorLoad(&StartZ[Index]);
+		VectorRegister4Float EX = VectorLoad(&EndX[Index]);
+		VectorRegister4Float EY = VectorLoad(&EndY[Index]);
+		VectorRegister4Float EZ = VectorLoad(&EndZ[Index]);
+
+		VectorRegister4Float MX = VectorMultiply(VectorAdd(SX, EX), Half);
+		VectorRegister4Float MY = VectorMultiply(VectorAdd(SY, EY), Half);
+		VectorRegister4Float MZ = VectorMultiply(VectorAdd(SZ, EZ), Half);
+
+		VectorRegister4Float FX = VectorSubtract(EX, SX);
+		VectorRegister4Float FY = VectorSubtract(EY, SY);
+		VectorRegister4Float FZ = VectorSubtract(EZ, SZ);
+
+		// bones in the same place, per component like FVector::Equals
+		VectorRegister4Float IsDegenerate = VectorBitwiseAnd(
+			VectorBitwiseAnd(VectorCompareLE(VectorAbs(FX), SamePositionTolerance),
+				VectorCompareLE(VectorAbs(FY), SamePositionTolerance)),
+			VectorCompareLE(VectorAbs(FZ), SamePositionTolerance));
+
+		VectorRegister4Float LengthSquared = VectorMultiply(FX, FX);
+		LengthSquared = VectorMultiplyAdd(FY, FY, LengthSquared);
+		LengthSquared = VectorMultiplyAdd(FZ, FZ, LengthSquared);
+		VectorRegister4Float Length = VectorSqrt(LengthSquared);
+		NormalizeLanes(FX, FY, FZ);
+
+		// up faces the viewer, unless that's along the segment
+		VectorRegister4Float UX = VectorSubtract(ViewX, MX);
+		VectorRegister4Float UY = VectorSubtract(ViewY, MY);
+		VectorRegister4Float UZ = VectorSubtract(ViewZ, MZ);
+		NormalizeLanes(UX, UY, UZ);
+		VectorRegister4Float Dot = VectorMultiply(FX, UX);
+		Dot = VectorMultiplyAdd(FY, UY, Dot);
+		Dot = VectorMultiplyAdd(FZ, UZ, Dot);
+		VectorRegister4Float UseBoneUp = VectorCompareLT(
+			VectorAbs(VectorSubtract(Dot, GlobalVectorConstants::FloatOne)), ParallelTolerance);
+
+		VectorRegister4Float BX = VectorLoad(&BoneUpX[Index]);
+		VectorRegister4Float BY = VectorLoad(&BoneUpY[Index]);
+		VectorRegister4Float BZ = VectorLoad(&BoneUpZ[Index]);
+		NormalizeLanes(BX, BY, BZ);
+		UX = VectorSelect(UseBoneUp, BX, UX);
+		UY = VectorSelect(UseBoneUp, BY, UY);
+		UZ = VectorSelect(UseBoneUp, BZ, UZ);
+
+		// same basis as FRotationMatrix::MakeFromXZ: right = up x forward, up = forward x right
+		VectorRegister4Float RX = VectorSubtract(VectorMultiply(UY, FZ), VectorMultiply(UZ, FY));
+		VectorRegister4Float RY = VectorSubtract(VectorMultiply(UZ, FX), VectorMultiply(UX, FZ));
+		VectorRegister4Float RZ = VectorSubtract(VectorMultiply(UX, FY), VectorMultiply(UY, FX));
+		NormalizeLanes(RX, RY, RZ);
+		UX = VectorSubtract(VectorMultiply(FY, RZ), VectorMultiply(FZ, RY));
+		UY = VectorSubtract(VectorMultiply(FZ, RX), VectorMultiply(FX, RZ));
+		UZ = VectorSubtract(VectorMultiply(FX, RY), VectorMultiply(FY, RX));
+
+		VectorStore(MX, &MidX[Index]);
+		VectorStore(MY, &MidY[Index]);
+		VectorStore(MZ, &MidZ[Index]);
+		VectorStore(Length, &Lengths[Index]);
+		VectorStore(FX, &ForwardX[Index]);
+		VectorStore(FY, &ForwardY[Index]);
+		VectorStore(FZ, &ForwardZ[Index]);
+		VectorStore(RX, &RightX[Index]);
+		VectorStore(RY, &RightY[Index]);
+		VectorStore(RZ, &RightZ[Index]);
+		VectorStore(UX, &UpX[Index]);
+		VectorStore(UY, &UpY[Index]);
+		VectorStore(UZ, &UpZ[Index]);
+		VectorStore(VectorSelect(IsDegenerate, GlobalVectorConstants::FloatOne, GlobalVectorConstants::FloatZero),
+			&Degenerate[Index]);
+	}
+
+	// moving into the instanced mesh's space is one transform per segment, so it stays scalar
+	for (int32 Index = 0; Index < Num(); Index++)
+	{
+		if (Degenerate[Index] != 0.0f)
+		{
+			continue;
+		}
+		FMatrix Basis(FVector(ForwardX[Index], ForwardY[Index], ForwardZ[Index]),
+			FVector(RightX[Index], RightY[Index], RightZ[Index]),
+			FVector(UpX[Index], UpY[Index], UpZ[Index]),
+			FVector::ZeroVector);
+		FVector WorldPosition(MidX[Index], MidY[Index], MidZ[Index]);
+		SegmentTransforms[Index].SetComponents(WorldToInstance.TransformRotation(FQuat(Basis)),
+			WorldToInstance.TransformPosition(WorldPosition),
+			FVector(Lengths[Index] * LengthScale, Thickness, Thickness));
+	}
+}
+
+void FHandBoneSegmentKernel::ComputeScalar(TArrayView<const FTransform> BoneTransforms,
+	const FTransform& WorldToInstance, const FVector& ViewPosition, float LengthScale, float Thickness,
+	TArrayView<FTransform> SegmentTransforms) const
+{
+	for (int32 Index = 0; Index < Num(); Index++)
+	{
+		const FTransform& StartTransform = BoneTransforms[StartBoneIndices[Index]];
+		const FTransform& EndTransform = BoneTransforms[EndBoneIndices[Index]];
+
+		FVector StartPosition = StartTransform.GetLocation();
+		FVector EndPosition = EndTransform.GetLocation();
+		if (StartPosition.Equals(EndPosition))
+		{
+			continue;
+		}
+
+		FVector AveragePosition = (StartPosition + EndPosition) * 0.5f;
+		FVector SegmentForwardVector = EndPosition - StartPosition;
+		float SegmentSize = SegmentForwardVector.Size();
+		SegmentForwardVector /= SegmentSize;
+
+		FVector SegmentWorldUp = ViewPosition - AveragePosition;
+		SegmentWorldUp.Normalize();
+		if (fabs(FVector::DotProduct(SegmentForwardVector, SegmentWorldUp) - 1.0f) < 0.00001f)
+		{
+			SegmentWorldUp = (StartTransform.GetRotation().GetUpVector() + EndTransform.GetRotation().GetUpVector()) * 0.5f;
+			SegmentWorldUp.Normalize();
+		}
+
+		FQuat SegmentWorldRotation = UKismetMathLibrary::MakeRotFromXZ(SegmentForwardVector, SegmentWorldUp).Quaternion();
+		SegmentTransforms[Index].SetComponents(WorldToInstance.TransformRotation(SegmentWorldRotation),
+			WorldToInstance.TransformPosition(AveragePosition),
+			FVector(SegmentSize * LengthScale, Thickness, Thickness));
+	}
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Turns a hand's bone transforms into the instance transforms of the
+ * segments drawn between bones and their parents. Each segment sits
+ * between its two bones, is as long as they are apart, and faces the
+ * viewer. Bone positions are packed into separate coordinate arrays so
+ * four segments are worked on at a time.
+ */
+class HANDSTRAINSAMPLE_API FHandBoneSegmentKernel
+{
+public:
+	FHandBoneSegmentKernel();
+
+	void Reset();
+
+	void AddSegment(int32 StartBoneIndex, int32 EndBoneIndex);
+
+	int32 Num() const
+	{
+		return StartBoneIndices.Num();
+	}
+
+	/**
+	 * @param BoneTransforms - World transforms of the hand's bones.
+	 * @param WorldToInstance - From world space to the instanced mesh's space.
+	 * @param ViewPosition - Segments turn their up vector toward it.
+	 * @param LengthScale - Segment length is multiplied by it to get the instance's X scale.
+	 * @param Thickness - Instance Y and Z scale.
+	 * @param SegmentTransforms - One per segment. Segments whose bones are in
+	 * the same place keep their transform.
+	 */
+	void Compute(TArrayView<const FTransform> BoneTransforms, const FTransform& WorldToInstance,
+		const FVector& ViewPosition, float LengthScale, float Thickness,
+		TArrayView<FTransform> SegmentTransforms);
+
+	/** Same result as Compute, one segment at a time. */
+	void ComputeScalar(TArrayView<const FTransform> BoneTransforms, const FTransform& WorldToInstance,
+		const FVector& ViewPosition, float LengthScale, float Thickness,
+		TArrayView<FTransform> SegmentTransforms) const;
+
+private:
+	TArray<int32> StartBoneIndices;
+	TArray<int32> EndBoneIndices;
+
+	// per segment, padded to a multiple of four; filled in by Compute
+	TArray<float> StartX, StartY, StartZ;
+	TArray<float> EndX, EndY, EndZ;
+	TArray<float> BoneUpX, BoneUpY, BoneUpZ;
+	TArray<float> MidX, MidY, MidZ;
+	TArray<float> Lengths;
+	TArray<float> ForwardX, ForwardY, ForwardZ;
+	TArray<float> RightX, RightY, RightZ;
+	TArray<float> UpX, UpY, UpZ;
+	TArray<float> Degenerate;
+
+	void Gather(TArrayView<const FTransform> BoneTransforms);
+};
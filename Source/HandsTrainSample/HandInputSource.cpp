@@ -0,0 +1,221 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "HandInputSource.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "OculusXRHandComponent.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+const uint32 FHandInputRecorder::FileMagic = 0x52485448; // "HTHR"
+const uint32 FHandInputRecorder::FileVersion = 1;
+
+namespace
+{
+	void SerializeTransform(FArchive& Ar, FTransform& Transform)
+	{
+		FVector3f Location(Transform.GetLocation());
+		FQuat4f Rotation(Transform.GetRotation());
+		Ar << Location << Rotation;
+		if (Ar.IsLoading())
+		{
+			Transform = FTransform(FQuat(Rotation), FVector(Location));
+		}
+	}
+
+	// a frame with no bones: the tracking enabled flag, then per hand the
+	// confidence and pointer pose flags, two transforms, scale, pinch
+	// strength and the bone count
+	const int64 MinFrameSize = 1 + 2 * (2 + 2 * 28 + 2 * 4 + 1);
+
+	void SerializeHand(FArchive& Ar, FHandInputState& Hand)
+	{
+		uint8 Confidence = (uint8)Hand.TrackingConfidence;
+		uint8 PointerPoseValid = Hand.bPointerPoseValid ? 1 : 0;
+		Ar << Confidence << PointerPoseValid;
+		Hand.TrackingConfidence = (EOculusXRTrackingConfidence)Confidence;
+		Hand.bPointerPoseValid = PointerPoseValid != 0;
+
+		SerializeTransform(Ar, Hand.PointerPose);
+		Ar << Hand.HandScale << Hand.PinchStrength;
+		SerializeTransform(Ar, Hand.ComponentTransform);
+
+		uint8 NumBones = (uint8)FMath::Min(Hand.BoneSpaceTransforms.Num(), (int32)MAX_uint8);
+		Ar << NumBones;
+		if (Ar.IsLoading())
+		{
+			Hand.BoneSpaceTransforms.SetNum(NumBones);
+		}
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
+		{
+			SerializeTransform(Ar, Hand.BoneSpaceTransforms[BoneIndex]);
+		}
+	}
+}
+
+void FHandInputFrame::Serialize(FArchive& Ar)
+{
+	uint8 HandTrackingEnabled = bHandTrackingEnabled ? 1 : 0;
+	Ar << HandTrackingEnabled;
+	bHandTrackingEnabled = HandTrackingEnabled != 0;
+	SerializeHand(Ar, Hands[0]);
+	SerializeHand(Ar, Hands[1]);
+}
+
+FLiveHandInputSource::FLiveHandInputSource(UWorld* InWorld)
+	: World(InWorld)
+{
+	// the keys behind the pinch strength axis mappings in DefaultInput.ini
+	PinchStrengthKeys[0] = FKey(TEXT("OculusHand_Left_IndexPinchStrength"));
+	PinchStrengthKeys[1] = FKey(TEXT("OculusHand_Right_IndexPinchStrength"));
+}
+
+void FLiveHandInputSource::SetHand(UOculusXRHandComponent* Hand)
+{
+	if (IsValid(Hand))
+	{
+		Hands[FHandInputFrame::GetHandIndex(Hand->SkeletonType)] = Hand;
+	}
+}
+
+bool FLiveHandInputSource::ReadFrame(FHandInputFrame& OutFrame)
+{
+	OutFrame.bHandTrackingEnabled = UOculusXRInputFunctionLibrary::IsHandTrackingEnabled();
+	APlayerController* PlayerController = World.IsValid() ? World->GetFirstPlayerController() : nullptr;
+
+	const EOculusXRHandType HandTypes[2] = { EOculusXRHandType::HandLeft, EOculusXRHandType::HandRight };
+	for (int32 HandIndex = 0; HandIndex < 2; HandIndex++)
+	{
+		EOculusXRHandType HandType = HandTypes[HandIndex];
+		FHandInputState& HandState = OutFrame.Hands[HandIndex];
+		HandState.TrackingConfidence = UOculusXRInputFunctionLibrary::GetTrackingConfidence(HandType, 0);
+		HandState.bPointerPoseValid = UOculusXRInputFunctionLibrary::IsPointerPoseValid(HandType);
+		HandState.PointerPose = UOculusXRInputFunctionLibrary::GetPointerPose(HandType);
+		HandState.HandScale = UOculusXRInputFunctionLibrary::GetHandScale(HandType);
+		HandState.PinchStrength = IsValid(PlayerController)
+			? PlayerController->GetInputAnalogKeyState(PinchStrengthKeys[HandIndex])
+			: 0.0f;
+		HandState.BoneSpaceTransforms.Reset();
+	}
+	return true;
+}
+
+void FLiveHandInputSource::ReadBonePoses(FHandInputFrame& OutFrame) const
+{
+	for (int32 HandIndex = 0; HandIndex < 2; HandIndex++)
+	{
+		UOculusXRHandComponent* Hand = Hands[HandIndex].Get();
+		FHandInputState& HandState = OutFrame.Hands[HandIndex];
+		if (Hand != nullptr)
+		{
+			HandState.ComponentTransform = Hand->GetComponentTransform();
+			HandState.BoneSpaceTransforms = Hand->BoneSpaceTransforms;
+		}
+		else
+		{
+			HandState.BoneSpaceTransforms.Reset();
+		}
+	}
+}
+
+FRecordedHandInputSource::FRecordedHandInputSource()
+	: NextFrameIndex(0)
+{
+}
+
+bool FRecordedHandInputSource::Load(const FString& Filename)
+{
+	Frames.Reset();
+	NextFrameIndex = 0;
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *Filename))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not read hand input recording %s"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 NumFrames = 0;
+	Reader << Magic << Version << NumFrames;
+	if (Magic != FHandInputRecorder::FileMagic || Version != FHandInputRecorder::FileVersion || NumFrames < 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s is not a hand input recording this build can read"), *Filename);
+		return false;
+	}
+
+	// don't trust the header to size the array; a damaged file could claim
+	// far more frames than it holds
+	if ((int64)NumFrames * MinFrameSize > Reader.TotalSize() - Reader.Tell())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Hand input recording %s is truncated"), *Filename);
+		return false;
+	}
+
+	Frames.SetNum(NumFrames);
+	for (FHandInputFrame& Frame : Frames)
+	{
+		Frame.Serialize(Reader);
+		if (Reader.IsError())
+		{
+			break;
+		}
+	}
+	if (Reader.IsError())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Hand input recording %s is truncated"), *Filename);
+		Frames.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FRecordedHandInputSource::ReadFrame(FHandInputFrame& OutFrame)
+{
+	if (!Frames.IsValidIndex(NextFrameIndex))
+	{
+		return false;
+	}
+	OutFrame = Frames[NextFrameIndex++];
+	return true;
+}
+
+FHandInputRecorder::FHandInputRecorder()
+	: NumFrames(0)
+{
+}
+
+void FHandInputRecorder::AddFrame(const FHandInputFrame& Frame)
+{
+	FMemoryWriter Writer(FrameData, false, true);
+	// serializing only reads from the frame when writing
+	const_cast<FHandInputFrame&>(Frame).Serialize(Writer);
+	NumFrames++;
+}
+
+bool FHandInputRecorder::Save(const FString& Filename) const
+{
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	int32 FrameCount = NumFrames;
+	Writer << Magic << Version << FrameCount;
+	FileData.Append(FrameData);
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *Filename))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not write hand input recording %s"), *Filename);
+		return false;
+	}
+	return true;
+}
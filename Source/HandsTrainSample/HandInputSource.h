@@ -0,0 +1,137 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "InputCoreTypes.h"
+#include "OculusXRInputFunctionLibrary.h"
+
+class UOculusXRHandComponent;
+
+/** Tracking input of one hand for one frame. */
+struct HANDSTRAINSAMPLE_API FHandInputState
+{
+	EOculusXRTrackingConfidence TrackingConfidence = EOculusXRTrackingConfidence::Low;
+	bool bPointerPoseValid = false;
+	FTransform PointerPose;
+	float HandScale = 1.0f;
+	float PinchStrength = 0.0f;
+
+	// only captured while recording, and only applied while replaying
+	FTransform ComponentTransform;
+	TArray<FTransform> BoneSpaceTransforms;
+};
+
+/** Tracking input of both hands for one frame. */
+struct HANDSTRAINSAMPLE_API FHandInputFrame
+{
+	bool bHandTrackingEnabled = false;
+	FHandInputState Hands[2];
+
+	static int32 GetHandIndex(EOculusXRHandType HandType)
+	{
+		return HandType == EOculusXRHandType::HandRight ? 1 : 0;
+	}
+
+	const FHandInputState& GetHand(EOculusXRHandType HandType) const
+	{
+		return Hands[GetHandIndex(HandType)];
+	}
+
+	/**
+	 * Reads or writes the frame in the recording format. Transforms are
+	 * stored in single precision and bone scales are dropped, since hand
+	 * bones are only ever rotated and offset.
+	 */
+	void Serialize(FArchive& Ar);
+};
+
+/** Where the hand tracking input of a frame comes from. */
+class HANDSTRAINSAMPLE_API IHandInputSource
+{
+public:
+	virtual ~IHandInputSource()
+	{
+	}
+
+	/**
+	 * Fills in the input for the current frame.
+	 * @return False once the source has no more frames.
+	 */
+	virtual bool ReadFrame(FHandInputFrame& OutFrame) = 0;
+};
+
+/** Reads input from the headset through the OculusXR input plugin. */
+class HANDSTRAINSAMPLE_API FLiveHandInputSource : public IHandInputSource
+{
+public:
+	explicit FLiveHandInputSource(UWorld* InWorld);
+
+	void SetHand(UOculusXRHandComponent* Hand);
+
+	virtual bool ReadFrame(FHandInputFrame& OutFrame) override;
+
+	/**
+	 * Fills in the hands' component and bone transforms, which only recordings
+	 * need. Hands pose their bones when they tick, so this should be called
+	 * after actors tick, or the bones lag a frame behind the rest of the input.
+	 */
+	void ReadBonePoses(FHandInputFrame& OutFrame) const;
+
+private:
+	TWeakObjectPtr<UWorld> World;
+	TWeakObjectPtr<UOculusXRHandComponent> Hands[2];
+	FKey PinchStrengthKeys[2];
+};
+
+/** Plays back frames loaded from a recording, in order. */
+class HANDSTRAINSAMPLE_API FRecordedHandInputSource : public IHandInputSource
+{
+public:
+	FRecordedHandInputSource();
+
+	bool Load(const FString& Filename);
+
+	int32 GetNumFrames() const
+	{
+		return Frames.Num();
+	}
+
+	virtual bool ReadFrame(FHandInputFrame& OutFrame) override;
+
+private:
+	TArray<FHandInputFrame> Frames;
+	int32 NextFrameIndex;
+};
+
+/**
+ * Collects frames in memory and writes them out as a recording. The file
+ * is a small header followed by the serialized frames.
+ */
+class HANDSTRAINSAMPLE_API FHandInputRecorder
+{
+public:
+	FHandInputRecorder();
+
+	void AddFrame(const FHandInputFrame& Frame);
+
+	int32 GetNumFrames() const
+	{
+		return NumFrames;
+	}
+
+	bool Save(const FString& Filename) const;
+
+	const static uint32 FileMagic;
+	const static uint32 FileVersion;
+
+private:
+	TArray<uint8> FrameData;
+	int32 NumFrames;
+};
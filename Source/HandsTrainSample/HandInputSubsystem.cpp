@@ -0,0 +1,224 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "HandInputSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HandsTrainStats.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "OculusXRHandComponent.h"
+
+namespace
+{
+	UHandInputSubsystem* GetHandInput(UWorld* World)
+	{
+		return World != nullptr ? World->GetSubsystem<UHandInputSubsystem>() : nullptr;
+	}
+
+	FAutoConsoleCommandWithWorldAndArgs RecordHandInputCommand(
+		TEXT("HandsTrain.RecordHandInput"),
+		TEXT("Starts recording hand tracking input. Save it with HandsTrain.StopHandInputRecording <file>."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World) {
+			UHandInputSubsystem* HandInput = GetHandInput(World);
+			if (HandInput != nullptr)
+			{
+				HandInput->StartRecording();
+			}
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs StopHandInputRecordingCommand(
+		TEXT("HandsTrain.StopHandInputRecording"),
+		TEXT("Stops recording hand tracking input and saves it to the file given."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World) {
+			UHandInputSubsystem* HandInput = GetHandInput(World);
+			if (HandInput != nullptr)
+			{
+				HandInput->StopRecording(Args.Num() > 0 ? Args[0] : TEXT("HandInput.bin"));
+			}
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs PlayHandInputCommand(
+		TEXT("HandsTrain.PlayHandInput"),
+		TEXT("Replaces live hand tracking input with a recording."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World) {
+			UHandInputSubsystem* HandInput = GetHandInput(World);
+			if (HandInput != nullptr && Args.Num() > 0)
+			{
+				HandInput->StartPlayback(Args[0]);
+			}
+		}));
+
+	FAutoConsoleCommandWithWorldAndArgs StopHandInputPlaybackCommand(
+		TEXT("HandsTrain.StopHandInputPlayback"),
+		TEXT("Goes back to live hand tracking input."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World) {
+			UHandInputSubsystem* HandInput = GetHandInput(World);
+			if (HandInput != nullptr)
+			{
+				HandInput->StopPlayback();
+			}
+		}));
+}
+
+UHandInputSubsystem::UHandInputSubsystem()
+	: bQuitWhenPlaybackEnds(false)
+{
+}
+
+bool UHandInputSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UHandInputSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LiveSource = MakeUnique<FLiveHandInputSource>(GetWorld());
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(
+		this, &UHandInputSubsystem::OnWorldPreActorTick);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(
+		this, &UHandInputSubsystem::OnWorldPostActorTick);
+}
+
+void UHandInputSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PlaybackSource.Reset();
+	Recorder.Reset();
+	LiveSource.Reset();
+	Super::Deinitialize();
+}
+
+void UHandInputSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FString ReplayFilename;
+	if (FParse::Value(FCommandLine::Get(), TEXT("HandsTrainReplay="), ReplayFilename))
+	{
+		bQuitWhenPlaybackEnds = FParse::Param(FCommandLine::Get(), TEXT("HandsTrainReplayQuit"));
+		StartPlayback(ReplayFilename);
+	}
+}
+
+void UHandInputSubsystem::RegisterHand(UOculusXRHandComponent* Hand)
+{
+	if (!IsValid(Hand))
+	{
+		return;
+	}
+	Hands[FHandInputFrame::GetHandIndex(Hand->SkeletonType)] = Hand;
+	LiveSource->SetHand(Hand);
+}
+
+void UHandInputSubsystem::StartRecording()
+{
+	Recorder = MakeUnique<FHandInputRecorder>();
+	UE_LOG(LogTemp, Log, TEXT("Recording hand input"));
+}
+
+bool UHandInputSubsystem::StopRecording(const FString& Filename)
+{
+	if (!Recorder.IsValid())
+	{
+		return false;
+	}
+	FString Path = GetRecordingPath(Filename);
+	bool bSaved = Recorder->Save(Path);
+	if (bSaved)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Saved %d frames of hand input to %s"), Recorder->GetNumFrames(), *Path);
+	}
+	Recorder.Reset();
+	return bSaved;
+}
+
+bool UHandInputSubsystem::StartPlayback(const FString& Filename)
+{
+	TUniquePtr<FRecordedHandInputSource> Recording = MakeUnique<FRecordedHandInputSource>();
+	FString Path = GetRecordingPath(Filename);
+	if (!Recording->Load(Path))
+	{
+		return false;
+	}
+	UE_LOG(LogTemp, Log, TEXT("Playing %d frames of hand input from %s"), Recording->GetNumFrames(), *Path);
+	PlaybackSource = MoveTemp(Recording);
+	return true;
+}
+
+void UHandInputSubsystem::StopPlayback()
+{
+	PlaybackSource.Reset();
+}
+
+FString UHandInputSubsystem::GetRecordingPath(const FString& Filename)
+{
+	if (FPaths::IsRelative(Filename))
+	{
+		return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("HandInput"), Filename);
+	}
+	return Filename;
+}
+
+void UHandInputSubsystem::OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+
+	if (PlaybackSource.IsValid())
+	{
+		if (PlaybackSource->ReadFrame(CurrentFrame))
+		{
+			ApplyBonePoses();
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Hand input playback finished"));
+		PlaybackSource.Reset();
+		if (bQuitWhenPlaybackEnds)
+		{
+			FHandsTrainFrameStats::DumpFrameStats(*GLog);
+			FPlatformMisc::RequestExit(false);
+		}
+	}
+
+	LiveSource->ReadFrame(CurrentFrame);
+}
+
+void UHandInputSubsystem::OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld() || !Recorder.IsValid() || PlaybackSource.IsValid())
+	{
+		return;
+	}
+	LiveSource->ReadBonePoses(CurrentFrame);
+	Recorder->AddFrame(CurrentFrame);
+}
+
+void UHandInputSubsystem::ApplyBonePoses()
+{
+	for (int32 HandIndex = 0; HandIndex < 2; HandIndex++)
+	{
+		UOculusXRHandComponent* Hand = Hands[HandIndex].Get();
+		const FHandInputState& HandState = CurrentFrame.Hands[HandIndex];
+		// recordings made with a different hand skeleton can't be applied
+		if (Hand == nullptr || HandState.BoneSpaceTransforms.Num() != Hand->BoneSpaceTransforms.Num())
+		{
+			continue;
+		}
+		Hand->SetWorldTransform(HandState.ComponentTransform);
+		Hand->BoneSpaceTransforms = HandState.BoneSpaceTransforms;
+		// also moves the bone capsules attached to the hand
+		Hand->RefreshBoneTransforms();
+	}
+}
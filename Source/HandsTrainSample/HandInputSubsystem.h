@@ -0,0 +1,91 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HandInputSource.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HandInputSubsystem.generated.h"
+
+class UOculusXRHandComponent;
+
+/**
+ * Hand tracking input for the frame, read once before actors tick, so
+ * tools and visuals that tick later all see the same values. Nothing else
+ * should ask the hand tracking plugin directly. Input normally comes
+ * from the headset, but can be recorded to a file and played back, which
+ * poses the registered hand components from the file too. That lets the
+ * interaction code run without a headset, e.g. with -nullrhi
+ * -HandsTrainReplay=<file> -HandsTrainReplayQuit on a build machine.
+ *
+ * Console commands:
+ *   HandsTrain.RecordHandInput / HandsTrain.StopHandInputRecording <file>
+ *   HandsTrain.PlayHandInput <file> / HandsTrain.StopHandInputPlayback
+ * Relative file names are under Saved/HandInput.
+ */
+UCLASS()
+class HANDSTRAINSAMPLE_API UHandInputSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UHandInputSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/** Hand components to record bone poses from and to pose during playback. */
+	void RegisterHand(UOculusXRHandComponent* Hand);
+
+	bool IsHandTrackingEnabled() const
+	{
+		return CurrentFrame.bHandTrackingEnabled;
+	}
+
+	const FHandInputState& GetHandState(EOculusXRHandType HandType) const
+	{
+		return CurrentFrame.GetHand(HandType);
+	}
+
+	void StartRecording();
+	bool StopRecording(const FString& Filename);
+
+	bool StartPlayback(const FString& Filename);
+	void StopPlayback();
+
+	bool IsPlayingBack() const
+	{
+		return PlaybackSource.IsValid();
+	}
+
+	static FString GetRecordingPath(const FString& Filename);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FHandInputFrame CurrentFrame;
+	TWeakObjectPtr<UOculusXRHandComponent> Hands[2];
+
+	TUniquePtr<FLiveHandInputSource> LiveSource;
+	TUniquePtr<FRecordedHandInputSource> PlaybackSource;
+	TUniquePtr<FHandInputRecorder> Recorder;
+	bool bQuitWhenPlaybackEnds;
+
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle PostActorTickHandle;
+
+	void OnWorldPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	/** Records the frame once the hands have posed their bones for it. */
+	void OnWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	/** Poses hand components from the bones in the current frame. */
+	void ApplyBonePoses();
+};
@@ -8,7 +8,7 @@ LICENSE file in the root directory of this source tree.
 
 #include "HandsActiveChecker.h"
 #include "Components/StaticMeshComponent.h"
-#include "OculusXRInputFunctionLibrary.h"
+#include "HandInputSubsystem.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -26,11 +26,14 @@ AHandsActiveChecker::AHandsActiveChecker()
 	NotificationMesh->SetupAttachment(RootComponent);
 	NotificationMesh->SetMobility(EComponentMobility::Movable);
 	NotificationMesh->SetVisibility(false);
+
+	HandInput = nullptr;
 }
 
 void AHandsActiveChecker::BeginPlay()
 {
 	Super::BeginPlay();
+	HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
 	FindPawnAndControllers();
 }
 
@@ -38,12 +41,12 @@ void AHandsActiveChecker::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (!IsValid(PlayerPawn) || !IsValid(LeftMesh) || !IsValid(RightMesh))
+	if (!IsValid(PlayerPawn) || !IsValid(LeftMesh) || !IsValid(RightMesh) || HandInput == nullptr)
 	{
 		return;
 	}
 
-	if (UOculusXRInputFunctionLibrary::IsHandTrackingEnabled())
+	if (HandInput->IsHandTrackingEnabled())
 	{
 		if (NotificationMesh->IsVisible())
 		{
@@ -13,6 +13,7 @@ LICENSE file in the root directory of this source tree.
 #include "HandsActiveChecker.generated.h"
 
 class UMotionControllerComponent;
+class UHandInputSubsystem;
 
 UCLASS()
 class HANDSTRAINSAMPLE_API AHandsActiveChecker : public AActor
@@ -43,5 +44,7 @@ protected:
 	UStaticMeshComponent* RightMesh;
 
 private:
+	UHandInputSubsystem* HandInput;
+
 	void FindPawnAndControllers();
 };
@@ -0,0 +1,211 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "HandsTrainStats.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_STAT(STAT_HandsTrain_ToolsManagerTick);
+DEFINE_STAT(STAT_HandsTrain_InputRouterUpdateTools);
+DEFINE_STAT(STAT_HandsTrain_RayToolRefresh);
+DEFINE_STAT(STAT_HandsTrain_HandBoneVisuals);
+DEFINE_STAT(STAT_HandsTrain_LocomotiveUpdate);
+DEFINE_STAT(STAT_HandsTrain_RayMeshUpdate);
+DEFINE_STAT(STAT_HandsTrain_OverlapQueries);
+DEFINE_STAT(STAT_HandsTrain_InstanceBufferUpdates);
+DEFINE_STAT(STAT_HandsTrain_RaycastHitsExamined);
+DEFINE_STAT(STAT_HandsTrain_ToolsEvaluated);
+DEFINE_STAT(STAT_HandsTrain_ToolsSkipped);
+DEFINE_STAT(STAT_HandsTrain_SweptContacts);
+DEFINE_STAT(STAT_HandsTrain_QueuedInteractableEvents);
+DEFINE_STAT(STAT_HandsTrain_InstancesUploaded);
+DEFINE_STAT(STAT_HandsTrain_MaterialParameterWrites);
+
+namespace
+{
+	const int32 NumHistoryFrames = 600;
+	const int32 NumTimers = (int32)EHandsTrainTimer::Num;
+	const int32 NumCounters = (int32)EHandsTrainCounter::Num;
+
+	const TCHAR* TimerNames[NumTimers] = {
+		TEXT("ToolsManagerTick"),
+		TEXT("InputRouterUpdateTools"),
+		TEXT("RayToolRefresh"),
+		TEXT("HandBoneVisuals"),
+		TEXT("LocomotiveUpdate"),
+		TEXT("RayMeshUpdate"),
+	};
+
+	const TCHAR* CounterNames[NumCounters] = {
+		TEXT("OverlapQueries"),
+		TEXT("InstanceBufferUpdates"),
+		TEXT("RaycastHitsExamined"),
+		TEXT("ToolsEvaluated"),
+		TEXT("ToolsSkipped"),
+		TEXT("SweptContacts"),
+		TEXT("QueuedInteractableEvents"),
+		TEXT("InstancesUploaded"),
+		TEXT("MaterialParameterWrites"),
+	};
+
+	struct FFrameHistory
+	{
+		// totals of the frame being recorded
+		uint64 FrameCycles[NumTimers] = {};
+		uint32 FrameCalls[NumTimers] = {};
+		uint32 FrameCounts[NumCounters] = {};
+		// scopes nest (the tools manager tick contains the input router
+		// update, which contains ray tool refreshes), so the total only
+		// adds up the outermost ones
+		uint64 FrameTotalCycles = 0;
+		int32 ScopeDepth = 0;
+		uint64 CurrentFrame = 0;
+
+		// ring buffers of finished frames
+		float TimerMs[NumTimers][NumHistoryFrames] = {};
+		uint32 TimerCalls[NumTimers][NumHistoryFrames] = {};
+		uint32 Counts[NumCounters][NumHistoryFrames] = {};
+		float TotalMs[NumHistoryFrames] = {};
+		int32 NextFrameIndex = 0;
+		int32 NumFrames = 0;
+
+		void BeginFrameIfNeeded()
+		{
+			if (CurrentFrame == GFrameCounter)
+			{
+				return;
+			}
+			// frames where none of the scopes ran are skipped rather
+			// than counted as zero; they'd only pull the percentiles down
+			if (CurrentFrame != 0)
+			{
+				for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+				{
+					TimerMs[TimerIndex][NextFrameIndex] = FPlatformTime::ToMilliseconds64(FrameCycles[TimerIndex]);
+					TimerCalls[TimerIndex][NextFrameIndex] = FrameCalls[TimerIndex];
+				}
+				for (int32 CounterIndex = 0; CounterIndex < NumCounters; CounterIndex++)
+				{
+					Counts[CounterIndex][NextFrameIndex] = FrameCounts[CounterIndex];
+				}
+				TotalMs[NextFrameIndex] = FPlatformTime::ToMilliseconds64(FrameTotalCycles);
+				NextFrameIndex = (NextFrameIndex + 1) % NumHistoryFrames;
+				NumFrames = FMath::Min(NumFrames + 1, NumHistoryFrames);
+			}
+			FMemory::Memzero(FrameCycles);
+			FMemory::Memzero(FrameCalls);
+			FMemory::Memzero(FrameCounts);
+			FrameTotalCycles = 0;
+			CurrentFrame = GFrameCounter;
+		}
+
+		void Reset()
+		{
+			FMemory::Memzero(*this);
+		}
+	};
+
+	FFrameHistory& GetFrameHistory()
+	{
+		static FFrameHistory FrameHistory;
+		return FrameHistory;
+	}
+
+	template <typename T>
+	void GetPercentiles(const T* Values, int32 NumValues, T& OutP50, T& OutP95, T& OutP99)
+	{
+		TArray<T> Sorted(Values, NumValues);
+		Sorted.Sort();
+		auto AtPercentile = [&Sorted](float Percentile) {
+			int32 Index = FMath::Clamp(FMath::CeilToInt(Percentile * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+			return Sorted[Index];
+		};
+		OutP50 = AtPercentile(0.5f);
+		OutP95 = AtPercentile(0.95f);
+		OutP99 = AtPercentile(0.99f);
+	}
+
+	FAutoConsoleCommandWithOutputDevice DumpFrameStatsCommand(
+		TEXT("HandsTrain.DumpFrameStats"),
+		TEXT("Prints p50/p95/p99 of HandsTrain hot path times and counters over recent frames."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateStatic(&FHandsTrainFrameStats::DumpFrameStats));
+
+	FAutoConsoleCommand ResetFrameStatsCommand(
+		TEXT("HandsTrain.ResetFrameStats"),
+		TEXT("Clears the frames recorded for HandsTrain.DumpFrameStats."),
+		FConsoleCommandDelegate::CreateStatic(&FHandsTrainFrameStats::Reset));
+}
+
+void FHandsTrainFrameStats::BeginScope()
+{
+	GetFrameHistory().ScopeDepth++;
+}
+
+void FHandsTrainFrameStats::AddTime(EHandsTrainTimer Timer, uint64 Cycles)
+{
+	FFrameHistory& FrameHistory = GetFrameHistory();
+	FrameHistory.BeginFrameIfNeeded();
+	FrameHistory.FrameCycles[(int32)Timer] += Cycles;
+	FrameHistory.FrameCalls[(int32)Timer]++;
+	FrameHistory.ScopeDepth = FMath::Max(FrameHistory.ScopeDepth - 1, 0);
+	if (FrameHistory.ScopeDepth == 0)
+	{
+		FrameHistory.FrameTotalCycles += Cycles;
+	}
+}
+
+void FHandsTrainFrameStats::AddCount(EHandsTrainCounter Counter, uint32 Amount)
+{
+	FFrameHistory& FrameHistory = GetFrameHistory();
+	FrameHistory.BeginFrameIfNeeded();
+	FrameHistory.FrameCounts[(int32)Counter] += Amount;
+}
+
+uint32 FHandsTrainFrameStats::GetCount(EHandsTrainCounter Counter)
+{
+	FFrameHistory& FrameHistory = GetFrameHistory();
+	FrameHistory.BeginFrameIfNeeded();
+	return FrameHistory.FrameCounts[(int32)Counter];
+}
+
+void FHandsTrainFrameStats::DumpFrameStats(FOutputDevice& Ar)
+{
+	const FFrameHistory& FrameHistory = GetFrameHistory();
+	int32 NumFrames = FrameHistory.NumFrames;
+	if (NumFrames == 0)
+	{
+		Ar.Logf(TEXT("HandsTrain frame stats: no frames recorded"));
+		return;
+	}
+
+	// ring buffer order doesn't matter for percentiles
+	Ar.Logf(TEXT("HandsTrain frame stats over %d frames (p50 / p95 / p99):"), NumFrames);
+	for (int32 TimerIndex = 0; TimerIndex < NumTimers; TimerIndex++)
+	{
+		float P50, P95, P99;
+		uint32 CallsP50, CallsP95, CallsP99;
+		GetPercentiles(FrameHistory.TimerMs[TimerIndex], NumFrames, P50, P95, P99);
+		GetPercentiles(FrameHistory.TimerCalls[TimerIndex], NumFrames, CallsP50, CallsP95, CallsP99);
+		Ar.Logf(TEXT("  %-24s %7.3f / %7.3f / %7.3f ms, %u / %u / %u calls"),
+			TimerNames[TimerIndex], P50, P95, P99, CallsP50, CallsP95, CallsP99);
+	}
+	float TotalP50, TotalP95, TotalP99;
+	GetPercentiles(FrameHistory.TotalMs, NumFrames, TotalP50, TotalP95, TotalP99);
+	Ar.Logf(TEXT("  %-24s %7.3f / %7.3f / %7.3f ms"), TEXT("Total"), TotalP50, TotalP95, TotalP99);
+
+	for (int32 CounterIndex = 0; CounterIndex < NumCounters; CounterIndex++)
+	{
+		uint32 P50, P95, P99;
+		GetPercentiles(FrameHistory.Counts[CounterIndex], NumFrames, P50, P95, P99);
+		Ar.Logf(TEXT("  %-24s %u / %u / %u"), CounterNames[CounterIndex], P50, P95, P99);
+	}
+}
+
+void FHandsTrainFrameStats::Reset()
+{
+	GetFrameHistory().Reset();
+}
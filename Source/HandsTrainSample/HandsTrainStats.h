@@ -0,0 +1,130 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("HandsTrain"), STATGROUP_HandsTrain, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tools Manager Tick"), STAT_HandsTrain_ToolsManagerTick,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Input Router Update Tools"), STAT_HandsTrain_InputRouterUpdateTools,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ray Tool Refresh Intersections"), STAT_HandsTrain_RayToolRefresh,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hand Bone Visuals"), STAT_HandsTrain_HandBoneVisuals,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Locomotive Update State"), STAT_HandsTrain_LocomotiveUpdate,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Ray Mesh Update"), STAT_HandsTrain_RayMeshUpdate,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Overlap Queries"), STAT_HandsTrain_OverlapQueries,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Instance Buffer Updates"), STAT_HandsTrain_InstanceBufferUpdates,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Raycast Hits Examined"), STAT_HandsTrain_RaycastHitsExamined,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Tools Evaluated"), STAT_HandsTrain_ToolsEvaluated,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Tools Skipped"), STAT_HandsTrain_ToolsSkipped,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Swept Contacts"), STAT_HandsTrain_SweptContacts,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Queued Interactable Events"), STAT_HandsTrain_QueuedInteractableEvents,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Instances Uploaded"), STAT_HandsTrain_InstancesUploaded,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Material Parameter Writes"), STAT_HandsTrain_MaterialParameterWrites,
+	STATGROUP_HandsTrain, HANDSTRAINSAMPLE_API);
+
+// rolling frame stats cost a timer read per scope, so they stay out of shipping builds
+#define HANDSTRAIN_FRAME_STATS !UE_BUILD_SHIPPING
+
+enum class EHandsTrainTimer : uint8
+{
+	ToolsManagerTick,
+	InputRouterUpdateTools,
+	RayToolRefresh,
+	HandBoneVisuals,
+	LocomotiveUpdate,
+	RayMeshUpdate,
+	Num
+};
+
+enum class EHandsTrainCounter : uint8
+{
+	OverlapQueries,
+	InstanceBufferUpdates,
+	RaycastHitsExamined,
+	ToolsEvaluated,
+	ToolsSkipped,
+	SweptContacts,
+	QueuedInteractableEvents,
+	InstancesUploaded,
+	MaterialParameterWrites,
+	Num
+};
+
+/**
+ * Per-frame totals of the module's hot paths over the last few hundred
+ * frames, so percentiles can be dumped on device with
+ * HandsTrain.DumpFrameStats without a profiler attached. Game thread only.
+ */
+class HANDSTRAINSAMPLE_API FHandsTrainFrameStats
+{
+public:
+	class FScopedTimer
+	{
+	public:
+		explicit FScopedTimer(EHandsTrainTimer InTimer)
+			: Timer(InTimer)
+		{
+			FHandsTrainFrameStats::BeginScope();
+			StartCycles = FPlatformTime::Cycles64();
+		}
+
+		~FScopedTimer()
+		{
+			FHandsTrainFrameStats::AddTime(Timer, FPlatformTime::Cycles64() - StartCycles);
+		}
+
+	private:
+		EHandsTrainTimer Timer;
+		uint64 StartCycles;
+	};
+
+	static void BeginScope();
+	/** Ends the innermost scope; only time outside any other scope counts toward the frame total. */
+	static void AddTime(EHandsTrainTimer Timer, uint64 Cycles);
+	static void AddCount(EHandsTrainCounter Counter, uint32 Amount);
+	/** Amount counted so far on the current frame. */
+	static uint32 GetCount(EHandsTrainCounter Counter);
+
+	/** Logs p50/p95/p99 of every timer and counter over the recorded frames. */
+	static void DumpFrameStats(FOutputDevice& Ar);
+
+	static void Reset();
+};
+
+// cycle counters already show up as CPU trace scopes, so no separate trace scope
+#if HANDSTRAIN_FRAME_STATS
+#define HANDSTRAIN_SCOPE_TIMER(Stat, Timer) \
+	SCOPE_CYCLE_COUNTER(Stat);              \
+	FHandsTrainFrameStats::FScopedTimer ANONYMOUS_VARIABLE(HandsTrainTimer)(Timer)
+#define HANDSTRAIN_INC_COUNTER(Stat, Counter, Amount) \
+	INC_DWORD_STAT_BY(Stat, Amount);                  \
+	FHandsTrainFrameStats::AddCount(Counter, Amount)
+#else
+#define HANDSTRAIN_SCOPE_TIMER(Stat, Timer) \
+	SCOPE_CYCLE_COUNTER(Stat)
+#define HANDSTRAIN_INC_COUNTER(Stat, Counter, Amount) \
+	INC_DWORD_STAT_BY(Stat, Amount)
+#endif
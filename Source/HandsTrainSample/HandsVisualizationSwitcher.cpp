@@ -13,7 +13,9 @@ LICENSE file in the root directory of this source tree.
 #include "OculusXRHandComponent.h"
 #include "OculusXRInputFunctionLibrary.h"
 #include "Materials/MaterialInstanceDynamic.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainStats.h"
+#include "MaterialParameterCache.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Logging/StructuredLog.h"
@@ -41,11 +43,14 @@ AHandsVisualizationSwitcher::AHandsVisualizationSwitcher()
 		FName(TEXT("RightHandBoneInstancedMeshes")));
 	RightHandBoneInstancedMeshes->SetupAttachment(RootComponent);
 	RightHandBoneInstancedMeshes->SetMobility(EComponentMobility::Movable);
+
+	ParameterCache = nullptr;
 }
 
 void AHandsVisualizationSwitcher::BeginPlay()
 {
 	Super::BeginPlay();
+	ParameterCache = GetWorld()->GetSubsystem<UMaterialParameterCache>();
 	EnableInput(GetWorld()->GetFirstPlayerController());
 	InputComponent->BindAction(LeftGestureActionName,
 		EInputEvent::IE_Pressed, this,
@@ -76,29 +81,40 @@ void AHandsVisualizationSwitcher::Tick(float DeltaTime)
 		return;
 	}
 
-	bool bLeftHandConfidenceHigh = UOculusXRInputFunctionLibrary::IsHandTrackingEnabled() && UOculusXRInputFunctionLibrary::GetTrackingConfidence(LeftHand->SkeletonType, 0) == EOculusXRTrackingConfidence::High;
+	UHandInputSubsystem* HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
+	if (HandInput == nullptr)
+	{
+		return;
+	}
+
+	const FHandInputState& LeftHandState = HandInput->GetHandState(LeftHand->SkeletonType);
+	bool bLeftHandConfidenceHigh = HandInput->IsHandTrackingEnabled() && LeftHandState.TrackingConfidence == EOculusXRTrackingConfidence::High;
 	UpdateHandBoneVisuals(LeftHand, LeftHandBoneInstancedMeshes,
 		LeftHandSegmentTransforms,
-		LeftHandSegmentInfos,
+		LeftHandSegmentKernel,
+		LeftHandInstanceUploader,
 		bLeftHandBonesVisible, bLeftHandConfidenceHigh,
-		UOculusXRInputFunctionLibrary::GetHandScale(LeftHand->SkeletonType));
+		LeftHandState.HandScale);
 
-	bool bRightHandConfidenceHigh = UOculusXRInputFunctionLibrary::IsHandTrackingEnabled() && UOculusXRInputFunctionLibrary::GetTrackingConfidence(RightHand->SkeletonType, 0) == EOculusXRTrackingConfidence::High;
+	const FHandInputState& RightHandState = HandInput->GetHandState(RightHand->SkeletonType);
+	bool bRightHandConfidenceHigh = HandInput->IsHandTrackingEnabled() && RightHandState.TrackingConfidence == EOculusXRTrackingConfidence::High;
 	UpdateHandBoneVisuals(RightHand, RightHandBoneInstancedMeshes,
 		RightHandSegmentTransforms,
-		RightHandSegmentInfos,
+		RightHandSegmentKernel,
+		RightHandInstanceUploader,
 		bRightHandBonesVisible, bRightHandConfidenceHigh,
-		UOculusXRInputFunctionLibrary::GetHandScale(RightHand->SkeletonType));
+		RightHandState.HandScale);
 
 	// if the hand component toggled the alpha of our hand (it can happen if the hand
-	// detects the system gesture), make sure that is corrected
+	// detects the system gesture), make sure that is corrected. The cache didn't see
+	// that change, so the write is forced
 	float ProperAlpha = (CurrentVisualMode == EOculusXRHandsVisualMode::Both) ? HandAlphaWhenBonesVisible : 1.0f;
 	float LeftAlpha;
 	float RightAlpha;
-	if (CurrentVisualMode == EOculusXRHandsVisualMode::Both && LeftHandMaterial->GetScalarParameterValue(HandAlphaParamName, LeftAlpha) && RightHandMaterial->GetScalarParameterValue(HandAlphaParamName, RightAlpha) && (LeftAlpha > ProperAlpha || RightAlpha > ProperAlpha))
+	if (CurrentVisualMode == EOculusXRHandsVisualMode::Both && ParameterCache != nullptr && LeftHandMaterial->GetScalarParameterValue(HandAlphaParamName, LeftAlpha) && RightHandMaterial->GetScalarParameterValue(HandAlphaParamName, RightAlpha) && (LeftAlpha > ProperAlpha || RightAlpha > ProperAlpha))
 	{
-		LeftHand->SetScalarParameterValueOnMaterials(HandAlphaParamName, ProperAlpha);
-		RightHand->SetScalarParameterValueOnMaterials(HandAlphaParamName, ProperAlpha);
+		ParameterCache->SetScalarParameter(LeftHand, HandAlphaParamName, ProperAlpha, true);
+		ParameterCache->SetScalarParameter(RightHand, HandAlphaParamName, ProperAlpha, true);
 	}
 }
 
@@ -113,6 +129,13 @@ void AHandsVisualizationSwitcher::InitializeMeshesFromHands()
 	LeftHandMaterial = LeftHand->GetMaterial(0);
 	RightHandMaterial = RightHand->GetMaterial(0);
 
+	UHandInputSubsystem* HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
+	if (HandInput != nullptr)
+	{
+		HandInput->RegisterHand(LeftHand);
+		HandInput->RegisterHand(RightHand);
+	}
+
 	InitVisualsPerHand(LeftHand);
 	InitVisualsPerHand(RightHand);
 	EnforceCurrentVisualMode();
@@ -136,18 +159,17 @@ void AHandsVisualizationSwitcher::InitVisualsPerHand(UOculusXRHandComponent* Han
 		if (ParentBoneName.Compare(NoParent))
 		{
 			auto ParentIndex = Hand->GetBoneIndex(ParentBoneName);
-			FLineSegment NewLineSegment(ParentIndex, BoneIndex);
 
 			if (IsLeftHand)
 			{
 				LeftHandBoneInstancedMeshes->AddInstance(StandardBoneTransform);
-				LeftHandSegmentInfos.Add(NewLineSegment);
+				LeftHandSegmentKernel.AddSegment(ParentIndex, BoneIndex);
 				LeftHandSegmentTransforms.Add(StandardBoneTransform);
 			}
 			else
 			{
 				RightHandBoneInstancedMeshes->AddInstance(StandardBoneTransform);
-				RightHandSegmentInfos.Add(NewLineSegment);
+				RightHandSegmentKernel.AddSegment(ParentIndex, BoneIndex);
 				RightHandSegmentTransforms.Add(StandardBoneTransform);
 			}
 		}
@@ -167,10 +189,12 @@ void AHandsVisualizationSwitcher::UpdateHandBoneVisuals(
 	UOculusXRHandComponent* Hand,
 	UInstancedStaticMeshComponent* BoneInstancedMeshes,
 	TArray<FTransform>& SegmentTransforms,
-	TArray<FLineSegment>& HandSegmentInfos,
+	FHandBoneSegmentKernel& SegmentKernel,
+	FInstanceTransformUploader& InstanceUploader,
 	bool bMeshVisibility, bool bConfidenceIsHigh,
 	float HandScale)
 {
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_HandBoneVisuals, EHandsTrainTimer::HandBoneVisuals);
 	auto NumRenderInstances = BoneInstancedMeshes->GetNumRenderInstances();
 	if (NumRenderInstances == 0)
 	{
@@ -207,59 +231,19 @@ void AHandsVisualizationSwitcher::UpdateHandBoneVisuals(
 	FTransform PlayerTransform = PlayerPawn->GetTransform();
 	FVector HDMPosition = PlayerTransform.TransformPosition(DevicePosition);
 
-	for (int32 InstancedIndex = 0; InstancedIndex < NumRenderInstances; InstancedIndex++)
+	// neighboring segments share bones, so read every bone once up front
+	const FTransform& HandToWorld = Hand->GetComponentTransform();
+	int32 NumBones = Hand->GetNumBones();
+	BoneTransforms.SetNum(NumBones);
+	for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
 	{
-		auto& SegmentTransform = SegmentTransforms[InstancedIndex];
-		auto const& HandSegmentInfo = HandSegmentInfos[InstancedIndex];
-
-		FTransform StartTransform = Hand->GetBoneTransform(HandSegmentInfo.StartBoneIndex);
-		FTransform EndTransform = Hand->GetBoneTransform(HandSegmentInfo.EndBoneIndex);
-
-		FVector StartPosition = StartTransform.GetLocation();
-		FVector EndPosition = EndTransform.GetLocation();
-		if (StartPosition.Equals(EndPosition))
-		{
-			// No need to update this instance, since there's a single bone
-			continue;
-		}
-
-		FVector AveragePosition = (StartPosition + EndPosition) * 0.5f;
-		FVector SegmentLocalPosition(InstanceWorldToLocal.TransformPosition(AveragePosition));
-
-		FVector SegmentForwardVector = EndPosition - StartPosition;
-		float SegmentSize = SegmentForwardVector.Size();
-		FVector SegmentLocalScale(SegmentSize * BoneScaleFactor,
-			CurrentBoneScale, CurrentBoneScale);
-
-		FQuat SegmentStartWorldRotation = StartTransform.GetRotation();
-		FQuat SegmentEndWorldRotation = EndTransform.GetRotation();
-		FVector StartUp = SegmentStartWorldRotation.GetUpVector();
-		FVector EndUp = SegmentEndWorldRotation.GetUpVector();
-
-		SegmentForwardVector /= SegmentSize;
-		// make segment's up face HMD
-		FVector SegmentWorldUp = (HDMPosition - AveragePosition);
-		SegmentWorldUp.Normalize();
-		// If up is nearly parallel/anti-parallel with forward, use bone's up instead
-		if (fabs(FVector::DotProduct(SegmentForwardVector, SegmentWorldUp) - 1.0f)
-			< 0.00001f)
-		{
-			SegmentWorldUp = (StartUp + EndUp) * 0.5f;
-			SegmentWorldUp.Normalize();
-		}
-
-		FQuat SegmentWorldRotation = UKismetMathLibrary::MakeRotFromXZ(
-			SegmentForwardVector, SegmentWorldUp)
-										 .Quaternion();
-		FQuat SegmentLocalRotation = InstanceWorldToLocal.TransformRotation(
-			SegmentWorldRotation);
-
-		SegmentTransform.SetComponents(SegmentLocalRotation, SegmentLocalPosition,
-			SegmentLocalScale);
+		BoneTransforms[BoneIndex] = Hand->GetBoneTransform(BoneIndex, HandToWorld);
 	}
 
-	BoneInstancedMeshes->BatchUpdateInstancesTransforms(0,
-		SegmentTransforms, false, true);
+	SegmentKernel.Compute(BoneTransforms, InstanceWorldToLocal, HDMPosition, BoneScaleFactor,
+		CurrentBoneScale, SegmentTransforms);
+
+	InstanceUploader.Upload(BoneInstancedMeshes, SegmentTransforms);
 }
 
 void AHandsVisualizationSwitcher::SwitchHandsVisualization()
@@ -276,8 +260,12 @@ void AHandsVisualizationSwitcher::SwitchHandsVisualization()
 void AHandsVisualizationSwitcher::EnforceCurrentVisualMode()
 {
 	float ProperAlpha = (CurrentVisualMode == EOculusXRHandsVisualMode::Both) ? HandAlphaWhenBonesVisible : 1.0f;
-	LeftHand->SetScalarParameterValueOnMaterials(HandAlphaParamName, ProperAlpha);
-	RightHand->SetScalarParameterValueOnMaterials(HandAlphaParamName, ProperAlpha);
+	// the hand may have changed its alpha since the last mode switch
+	if (ParameterCache != nullptr)
+	{
+		ParameterCache->SetScalarParameter(LeftHand, HandAlphaParamName, ProperAlpha, true);
+		ParameterCache->SetScalarParameter(RightHand, HandAlphaParamName, ProperAlpha, true);
+	}
 
 	switch (CurrentVisualMode)
 	{
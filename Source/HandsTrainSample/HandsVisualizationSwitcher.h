@@ -10,11 +10,14 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "HandBoneSegmentKernel.h"
+#include "InstanceTransformUploader.h"
 #include "OculusXRInputFunctionLibrary.h"
 #include "HandsVisualizationSwitcher.generated.h"
 
 struct FOculusXRCapsuleCollider;
 class UOculusXRHandComponent;
+class UMaterialParameterCache;
 
 UENUM(BlueprintType)
 enum class EOculusXRHandsVisualMode : uint8
@@ -24,27 +27,6 @@ enum class EOculusXRHandsVisualMode : uint8
 	Both,
 };
 
-USTRUCT(BlueprintType)
-struct FLineSegment
-{
-	GENERATED_BODY()
-
-	UPROPERTY(BlueprintReadOnly)
-	int32 StartBoneIndex;
-	UPROPERTY(BlueprintReadOnly)
-	int32 EndBoneIndex;
-
-	FLineSegment()
-		: StartBoneIndex(0), EndBoneIndex(0)
-	{
-	}
-
-	FLineSegment(int32 StartBoneIndex, int32 EndBoneIndex)
-		: StartBoneIndex(StartBoneIndex), EndBoneIndex(EndBoneIndex)
-	{
-	}
-};
-
 /**
  * Controls visual state of hands.
  */
@@ -94,12 +76,6 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Visual")
 	bool bRightHandBonesVisible;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Visual")
-	TArray<FLineSegment> LeftHandSegmentInfos;
-
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Visual")
-	TArray<FLineSegment> RightHandSegmentInfos;
-
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Visual")
 	TArray<FTransform> LeftHandSegmentTransforms;
 
@@ -129,6 +105,14 @@ private:
 
 	const static float HandAlphaWhenBonesVisible;
 
+	FHandBoneSegmentKernel LeftHandSegmentKernel;
+	FHandBoneSegmentKernel RightHandSegmentKernel;
+	FInstanceTransformUploader LeftHandInstanceUploader;
+	FInstanceTransformUploader RightHandInstanceUploader;
+	// world transforms of the hand being updated, read once per bone
+	TArray<FTransform> BoneTransforms;
+	UMaterialParameterCache* ParameterCache;
+
 	void EnforceCurrentVisualMode();
 
 	void InitVisualsPerHand(UOculusXRHandComponent* Hand);
@@ -136,7 +120,8 @@ private:
 		UOculusXRHandComponent* Hand,
 		UInstancedStaticMeshComponent* BoneInstancedMeshes,
 		TArray<FTransform>& SegmentTransforms,
-		TArray<FLineSegment>& HandSegmentInfos,
+		FHandBoneSegmentKernel& SegmentKernel,
+		FInstanceTransformUploader& InstanceUploader,
 		bool bMeshVisibility, bool bConfidenceIsHigh,
 		float HandScale);
 
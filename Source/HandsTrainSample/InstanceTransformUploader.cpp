@@ -0,0 +1,74 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "InstanceTransformUploader.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "HandsTrainStats.h"
+
+// instance space is in centimeters; instance scales are around 0.01
+const float FInstanceTransformUploader::DefaultLocationTolerance = 0.01f;
+const float FInstanceTransformUploader::DefaultRotationTolerance = 0.0001f;
+const float FInstanceTransformUploader::DefaultScaleTolerance = 0.00001f;
+
+FInstanceTransformUploader::FInstanceTransformUploader(float InLocationTolerance, float InRotationTolerance,
+	float InScaleTolerance)
+	: LocationTolerance(InLocationTolerance)
+	, RotationTolerance(InRotationTolerance)
+	, ScaleTolerance(InScaleTolerance)
+{
+}
+
+bool FInstanceTransformUploader::HasMoved(const FTransform& Uploaded, const FTransform& Current) const
+{
+	return !Uploaded.GetTranslation().Equals(Current.GetTranslation(), LocationTolerance)
+		|| !Uploaded.GetRotation().Equals(Current.GetRotation(), RotationTolerance)
+		|| !Uploaded.GetScale3D().Equals(Current.GetScale3D(), ScaleTolerance);
+}
+
+int32 FInstanceTransformUploader::Upload(UInstancedStaticMeshComponent* Mesh, const TArray<FTransform>& Transforms)
+{
+	const int32 NumInstances = FMath::Min(Transforms.Num(), Mesh->GetInstanceCount());
+	// the mesh's instances are unknown, so send them all
+	const bool bSendAll = UploadedTransforms.Num() != NumInstances;
+	if (bSendAll)
+	{
+		UploadedTransforms.SetNum(NumInstances);
+	}
+
+	int32 NumSent = 0;
+	int32 NumRuns = 0;
+	int32 Index = 0;
+	while (Index < NumInstances)
+	{
+		if (!bSendAll && !HasMoved(UploadedTransforms[Index], Transforms[Index]))
+		{
+			Index++;
+			continue;
+		}
+
+		int32 RunStart = Index;
+		RunTransforms.Reset();
+		while (Index < NumInstances && (bSendAll || HasMoved(UploadedTransforms[Index], Transforms[Index])))
+		{
+			UploadedTransforms[Index] = Transforms[Index];
+			RunTransforms.Add(Transforms[Index]);
+			Index++;
+		}
+		Mesh->BatchUpdateInstancesTransforms(RunStart, RunTransforms, false, false);
+		NumSent += RunTransforms.Num();
+		NumRuns++;
+	}
+
+	if (NumRuns > 0)
+	{
+		Mesh->MarkRenderStateDirty();
+		HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_InstanceBufferUpdates, EHandsTrainCounter::InstanceBufferUpdates, NumRuns);
+		HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_InstancesUploaded, EHandsTrainCounter::InstancesUploaded, NumSent);
+	}
+	return NumSent;
+}
@@ -0,0 +1,58 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UInstancedStaticMeshComponent;
+
+/**
+ * Sends instance transforms to an instanced mesh only where they moved
+ * since the last upload. Each contiguous run of changed instances is one
+ * batch update, the render state is marked dirty once at the end, and
+ * nothing is sent when no instance changed.
+ */
+class HANDSTRAINSAMPLE_API FInstanceTransformUploader
+{
+public:
+	/**
+	 * @param InLocationTolerance - Distance an instance has to move to be sent again.
+	 * @param InRotationTolerance - Per quaternion component.
+	 * @param InScaleTolerance - Per scale component.
+	 */
+	explicit FInstanceTransformUploader(float InLocationTolerance = DefaultLocationTolerance,
+		float InRotationTolerance = DefaultRotationTolerance, float InScaleTolerance = DefaultScaleTolerance);
+
+	/**
+	 * @param Transforms - Instance space transforms, one per instance.
+	 * @return Number of instances sent.
+	 */
+	int32 Upload(UInstancedStaticMeshComponent* Mesh, const TArray<FTransform>& Transforms);
+
+	/** Makes the next upload send every instance. */
+	void Invalidate()
+	{
+		UploadedTransforms.Reset();
+	}
+
+	const static float DefaultLocationTolerance;
+	const static float DefaultRotationTolerance;
+	const static float DefaultScaleTolerance;
+
+private:
+	float LocationTolerance;
+	float RotationTolerance;
+	float ScaleTolerance;
+
+	// what the mesh has, as of the last upload
+	TArray<FTransform> UploadedTransforms;
+	TArray<FTransform> RunTransforms;
+
+	bool HasMoved(const FTransform& Uploaded, const FTransform& Current) const;
+};
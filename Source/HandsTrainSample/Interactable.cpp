@@ -8,6 +8,7 @@ LICENSE file in the root directory of this source tree.
 
 #include "Interactable.h"
 #include "ColliderZone.h"
+#include "InteractableSpatialIndex.h"
 #include "InteractableTool.h"
 
 AInteractable::AInteractable()
@@ -26,6 +27,23 @@ void AInteractable::BeginPlay()
 	{
 		AllValidToolTagsMask |= (int)validToolTag;
 	}
+
+	// zones are indexed with our tags, so this has to come after them
+	UInteractableSpatialIndex* SpatialIndex = GetWorld()->GetSubsystem<UInteractableSpatialIndex>();
+	if (SpatialIndex != nullptr)
+	{
+		SpatialIndex->RegisterInteractable(this);
+	}
+}
+
+void AInteractable::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UInteractableSpatialIndex* SpatialIndex = GetWorld()->GetSubsystem<UInteractableSpatialIndex>();
+	if (SpatialIndex != nullptr)
+	{
+		SpatialIndex->UnregisterInteractable(this);
+	}
+	Super::EndPlay(EndPlayReason);
 }
 
 void AInteractable::UpdateCollisionDepth_Implementation(
@@ -149,6 +149,7 @@ protected:
 	USceneComponent* RootSceneComponent;
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	uint32 AllValidToolTagsMask;
 };
@@ -0,0 +1,145 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "InteractableConeCandidates.h"
+
+FInteractableConeCandidates::FInteractableConeCandidates()
+{
+}
+
+void FInteractableConeCandidates::Reset()
+{
+	PositionsX.Reset();
+	PositionsY.Reset();
+	PositionsZ.Reset();
+	ToolTagsMasks.Reset();
+	Interactables.Reset();
+}
+
+void FInteractableConeCandidates::Add(AInteractable* Interactable, const FVector& Position, uint32 ToolTagsMask)
+{
+	int32 Index = Interactables.Add(Interactable);
+	if (Index == PositionsX.Num())
+	{
+		// padding has a mask of zero, so it never matches a tool
+		PositionsX.AddZeroed(4);
+		PositionsY.AddZeroed(4);
+		PositionsZ.AddZeroed(4);
+		ToolTagsMasks.AddZeroed(4);
+	}
+	PositionsX[Index] = (float)Position.X;
+	PositionsY[Index] = (float)Position.Y;
+	PositionsZ[Index] = (float)Position.Z;
+	ToolTagsMasks[Index] = ToolTagsMask;
+}
+
+int32 FInteractableConeCandidates::FindNearestInCone(const FVector& Origin, const FVector& Direction,
+	float CosConeAngle, uint32 ToolTagsMask) const
+{
+	// A candidate is inside the cone when Dot / Length >= Cos. Multiplying
+	// both sides by Length and keeping the signs with x * |x| avoids the
+	// square root and division: Dot * |Dot| >= Cos * |Cos| * LengthSquared.
+	const VectorRegister4Float OriginX = VectorSetFloat1((float)Origin.X);
+	const VectorRegister4Float OriginY = VectorSetFloat1((float)Origin.Y);
+	const VectorRegister4Float OriginZ = VectorSetFloat1((float)Origin.Z);
+	const VectorRegister4Float DirectionX = VectorSetFloat1((float)Direction.X);
+	const VectorRegister4Float DirectionY = VectorSetFloat1((float)Direction.Y);
+	const VectorRegister4Float DirectionZ = VectorSetFloat1((float)Direction.Z);
+	const VectorRegister4Float SignedCosSquared = VectorSetFloat1(CosConeAngle * FMath::Abs(CosConeAngle));
+	const VectorRegister4Int ToolMask = VectorIntSet1((int32)ToolTagsMask);
+	const VectorRegister4Float IndexStep = VectorSetFloat1(4.0f);
+
+	// each lane keeps its own nearest candidate; indices fit exactly in a float
+	VectorRegister4Float BestDistanceSquared = VectorSetFloat1(MAX_flt);
+	VectorRegister4Float BestIndex = VectorSetFloat1(-1.0f);
+	VectorRegister4Float LaneIndex = MakeVectorRegisterFloat(0.0f, 1.0f, 2.0f, 3.0f);
+
+	const int32 NumPadded = PositionsX.Num();
+	for (int32 Index = 0; Index < NumPadded; Index += 4)
+	{
+		VectorRegister4Float ToCandidateX = VectorSubtract(VectorLoad(&PositionsX[Index]), OriginX);
+		VectorRegister4Float ToCandidateY = VectorSubtract(VectorLoad(&PositionsY[Index]), OriginY);
+		VectorRegister4Float ToCandidateZ = VectorSubtract(VectorLoad(&PositionsZ[Index]), OriginZ);
+
+		VectorRegister4Float DistanceSquared = VectorMultiply(ToCandidateX, ToCandidateX);
+		DistanceSquared = VectorMultiplyAdd(ToCandidateY, ToCandidateY, DistanceSquared);
+		DistanceSquared = VectorMultiplyAdd(ToCandidateZ, ToCandidateZ, DistanceSquared);
+
+		VectorRegister4Float Dot = VectorMultiply(ToCandidateX, DirectionX);
+		Dot = VectorMultiplyAdd(ToCandidateY, DirectionY, Dot);
+		Dot = VectorMultiplyAdd(ToCandidateZ, DirectionZ, Dot);
+
+		VectorRegister4Float InCone = VectorCompareGE(VectorMultiply(Dot, VectorAbs(Dot)),
+			VectorMultiply(SignedCosSquared, DistanceSquared));
+
+		VectorRegister4Int MatchedTags = VectorIntAnd(VectorIntLoad(&ToolTagsMasks[Index]), ToolMask);
+		VectorRegister4Float NoMatchingTags = VectorCastIntToFloat(
+			VectorIntCompareEQ(MatchedTags, GlobalVectorConstants::IntZero));
+
+		// strictly nearer, so the earlier candidate in a lane wins ties
+		VectorRegister4Float IsBetter = VectorBitwiseAnd(InCone,
+			VectorCompareLT(DistanceSquared, BestDistanceSquared));
+		IsBetter = VectorSelect(NoMatchingTags, GlobalVectorConstants::FloatZero, IsBetter);
+
+		BestDistanceSquared = VectorSelect(IsBetter, DistanceSquared, BestDistanceSquared);
+		BestIndex = VectorSelect(IsBetter, LaneIndex, BestIndex);
+		LaneIndex = VectorAdd(LaneIndex, IndexStep);
+	}
+
+	float LaneDistancesSquared[4];
+	float LaneIndices[4];
+	VectorStore(BestDistanceSquared, LaneDistancesSquared);
+	VectorStore(BestIndex, LaneIndices);
+
+	int32 NearestIndex = INDEX_NONE;
+	float NearestDistanceSquared = MAX_flt;
+	for (int32 Lane = 0; Lane < 4; Lane++)
+	{
+		int32 CandidateIndex = (int32)LaneIndices[Lane];
+		if (CandidateIndex == INDEX_NONE)
+		{
+			continue;
+		}
+		if (NearestIndex == INDEX_NONE || LaneDistancesSquared[Lane] < NearestDistanceSquared
+			|| (LaneDistancesSquared[Lane] == NearestDistanceSquared && CandidateIndex < NearestIndex))
+		{
+			NearestIndex = CandidateIndex;
+			NearestDistanceSquared = LaneDistancesSquared[Lane];
+		}
+	}
+	return NearestIndex;
+}
+
+int32 FInteractableConeCandidates::FindNearestInConeScalar(const FVector& Origin, const FVector& Direction,
+	float CosConeAngle, uint32 ToolTagsMask) const
+{
+	int32 NearestIndex = INDEX_NONE;
+	float NearestDistance = 0.0f;
+	for (int32 Index = 0; Index < Interactables.Num(); Index++)
+	{
+		if ((ToolTagsMasks[Index] & ToolTagsMask) == 0)
+		{
+			continue;
+		}
+
+		FVector ToCandidate(PositionsX[Index] - Origin.X, PositionsY[Index] - Origin.Y,
+			PositionsZ[Index] - Origin.Z);
+		float Distance = ToCandidate.Size();
+		if (FVector::DotProduct(ToCandidate / Distance, Direction) < CosConeAngle)
+		{
+			continue;
+		}
+
+		if (NearestIndex == INDEX_NONE || Distance < NearestDistance)
+		{
+			NearestIndex = Index;
+			NearestDistance = Distance;
+		}
+	}
+	return NearestIndex;
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AInteractable;
+
+/**
+ * Interactables found near a ray, packed as separate position and tool tag
+ * arrays so they can be scored four at a time. Picks the nearest candidate
+ * inside a cone around the ray; ties go to the candidate added first.
+ */
+class HANDSTRAINSAMPLE_API FInteractableConeCandidates
+{
+public:
+	FInteractableConeCandidates();
+
+	void Reset();
+
+	void Add(AInteractable* Interactable, const FVector& Position, uint32 ToolTagsMask);
+
+	int32 Num() const
+	{
+		return Interactables.Num();
+	}
+
+	/**
+	 * @param Origin - Cone apex.
+	 * @param Direction - Cone axis, normalized.
+	 * @param CosConeAngle - Cosine of the angle between the axis and the edge of the cone.
+	 * @param ToolTagsMask - Candidates need at least one of these tags.
+	 * @return Index of the nearest candidate inside the cone, or INDEX_NONE.
+	 */
+	int32 FindNearestInCone(const FVector& Origin, const FVector& Direction, float CosConeAngle,
+		uint32 ToolTagsMask) const;
+
+	/** Same result as FindNearestInCone, one candidate at a time. */
+	int32 FindNearestInConeScalar(const FVector& Origin, const FVector& Direction, float CosConeAngle,
+		uint32 ToolTagsMask) const;
+
+	AInteractable* GetInteractable(int32 Index) const
+	{
+		return Interactables[Index];
+	}
+
+private:
+	// padded to a multiple of four with candidates no mask matches
+	TArray<float> PositionsX;
+	TArray<float> PositionsY;
+	TArray<float> PositionsZ;
+	TArray<uint32> ToolTagsMasks;
+
+	TArray<AInteractable*> Interactables;
+};
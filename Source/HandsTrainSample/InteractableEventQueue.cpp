@@ -0,0 +1,84 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "InteractableEventQueue.h"
+#include "HandsTrainStats.h"
+
+void UInteractableEventQueue::BeginBatch()
+{
+	bCollecting = true;
+}
+
+void UInteractableEventQueue::FlushBatch()
+{
+	bCollecting = false;
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_QueuedInteractableEvents, EHandsTrainCounter::QueuedInteractableEvents,
+		QueuedEvents.Num());
+
+	// listeners may raise more events; with collection off they go out right away
+	Swap(QueuedEvents, DispatchingEvents);
+	QueuedStayEvents.Reset();
+	for (const FQueuedEvent& Event : DispatchingEvents)
+	{
+		AInteractable* Interactable = Event.Interactable.Get();
+		if (Interactable == nullptr)
+		{
+			continue;
+		}
+
+		switch (Event.Depth)
+		{
+			case EInteractableCollisionDepth::Proximity:
+				Interactable->OnProximityZoneEvent.Broadcast(Event.ZoneArgs);
+				break;
+			case EInteractableCollisionDepth::Contact:
+				Interactable->OnContactZoneEvent.Broadcast(Event.ZoneArgs);
+				break;
+			case EInteractableCollisionDepth::Action:
+				Interactable->OnActionZoneEvent.Broadcast(Event.ZoneArgs);
+				break;
+			default:
+				Interactable->OnInteractableStateChanged.Broadcast(Event.StateArgs);
+				break;
+		}
+	}
+	DispatchingEvents.Reset();
+}
+
+void UInteractableEventQueue::EnqueueZoneEvent(AInteractable* Interactable, EInteractableCollisionDepth Depth,
+	const FColliderZoneArgs& ZoneArgs)
+{
+	TPair<const UColliderZone*, const AInteractableTool*> ZoneTool(ZoneArgs.Zone, ZoneArgs.CollidingTool);
+	if (ZoneArgs.InteractionT == ECollisionInteractionType::Stay)
+	{
+		bool bAlreadyQueued = false;
+		QueuedStayEvents.Add(ZoneTool, &bAlreadyQueued);
+		if (bAlreadyQueued)
+		{
+			return;
+		}
+	}
+	else
+	{
+		// a stay after the tool leaves or comes back is a new one
+		QueuedStayEvents.Remove(ZoneTool);
+	}
+
+	FQueuedEvent& Event = QueuedEvents.AddDefaulted_GetRef();
+	Event.Interactable = Interactable;
+	Event.Depth = Depth;
+	Event.ZoneArgs = ZoneArgs;
+}
+
+void UInteractableEventQueue::EnqueueStateChange(AInteractable* Interactable, const FInteractableStateArgs& StateArgs)
+{
+	FQueuedEvent& Event = QueuedEvents.AddDefaulted_GetRef();
+	Event.Interactable = Interactable;
+	Event.Depth = EInteractableCollisionDepth::None;
+	Event.StateArgs = StateArgs;
+}
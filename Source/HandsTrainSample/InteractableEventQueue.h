@@ -0,0 +1,62 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interactable.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InteractableEventQueue.generated.h"
+
+/**
+ * Holds interactable zone and state events raised while the input router
+ * updates tools, and broadcasts them in one pass once every tool is
+ * done, so listeners don't run in the middle of routing. Events are
+ * broadcast in the order they were raised. Repeated Stay events of a tool
+ * in the same zone are dropped, keeping the first one's place, until the
+ * tool enters or exits that zone again.
+ * Only collects between BeginBatch and FlushBatch; outside of that,
+ * interactables broadcast right away.
+ */
+UCLASS()
+class HANDSTRAINSAMPLE_API UInteractableEventQueue : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	bool IsCollecting() const
+	{
+		return bCollecting;
+	}
+
+	void BeginBatch();
+
+	/** Broadcasts every event collected since BeginBatch and stops collecting. */
+	void FlushBatch();
+
+	void EnqueueZoneEvent(AInteractable* Interactable, EInteractableCollisionDepth Depth,
+		const FColliderZoneArgs& ZoneArgs);
+
+	void EnqueueStateChange(AInteractable* Interactable, const FInteractableStateArgs& StateArgs);
+
+private:
+	struct FQueuedEvent
+	{
+		TWeakObjectPtr<AInteractable> Interactable;
+		// None for state changes
+		EInteractableCollisionDepth Depth;
+		FColliderZoneArgs ZoneArgs;
+		FInteractableStateArgs StateArgs;
+	};
+
+	bool bCollecting = false;
+	TArray<FQueuedEvent> QueuedEvents;
+	TSet<TPair<const UColliderZone*, const AInteractableTool*>> QueuedStayEvents;
+	// events queued while flushing wait for the next pass
+	TArray<FQueuedEvent> DispatchingEvents;
+};
@@ -0,0 +1,641 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "InteractableSpatialIndex.h"
+#include "Algo/Sort.h"
+#include "ColliderZone.h"
+#include "Interactable.h"
+
+FInteractableSpatialGrid::FInteractableSpatialGrid(float InCellSize)
+	: CellSize(FMath::Max(InCellSize, 1.0f))
+	, InvCellSize(1.0f / CellSize)
+	, QueryStamp(0)
+{
+}
+
+int32 FInteractableSpatialGrid::Add(const FTransform& BoxTransform, const FVector& BoxExtent, uint32 Mask)
+{
+	int32 Id;
+	if (FreeIds.Num() > 0)
+	{
+		Id = FreeIds.Pop();
+	}
+	else
+	{
+		Id = Entries.AddDefaulted();
+		EntryQueryStamps.Add(0);
+	}
+
+	FEntry& Entry = Entries[Id];
+	Entry.Mask = Mask;
+	Entry.bInUse = true;
+	SetEntryBox(Entry, BoxTransform, BoxExtent);
+	AddToCells(Id, Entry.MinCell, Entry.MaxCell);
+	return Id;
+}
+
+void FInteractableSpatialGrid::Update(int32 Id, const FTransform& BoxTransform, const FVector& BoxExtent)
+{
+	if (!Entries.IsValidIndex(Id) || !Entries[Id].bInUse)
+	{
+		return;
+	}
+
+	FEntry& Entry = Entries[Id];
+	FIntVector OldMinCell = Entry.MinCell;
+	FIntVector OldMaxCell = Entry.MaxCell;
+	SetEntryBox(Entry, BoxTransform, BoxExtent);
+	// most moves stay within the same cells
+	if (Entry.MinCell != OldMinCell || Entry.MaxCell != OldMaxCell)
+	{
+		RemoveFromCells(Id, OldMinCell, OldMaxCell);
+		AddToCells(Id, Entry.MinCell, Entry.MaxCell);
+	}
+}
+
+void FInteractableSpatialGrid::Remove(int32 Id)
+{
+	if (!Entries.IsValidIndex(Id) || !Entries[Id].bInUse)
+	{
+		return;
+	}
+	RemoveFromCells(Id, Entries[Id].MinCell, Entries[Id].MaxCell);
+	Entries[Id].bInUse = false;
+	FreeIds.Add(Id);
+}
+
+void FInteractableSpatialGrid::Reset()
+{
+	Entries.Reset();
+	FreeIds.Reset();
+	Cells.Reset();
+	EntryQueryStamps.Reset();
+	QueryStamp = 0;
+}
+
+void FInteractableSpatialGrid::Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance,
+	uint32 Mask, TArray<FRayHit>& OutHits) const
+{
+	int32 FirstHitIndex = OutHits.Num();
+	ForEachCandidateOnRay(Origin, Direction, MaxDistance, Mask, [&](int32 Id, const FEntry& Entry) {
+		float Distance;
+		if (RayIntersectsBox(Origin, Direction, MaxDistance, Entry, Distance))
+		{
+			OutHits.Add({ Id, Distance });
+		}
+	});
+
+	// few hits per query, so sorting them is cheap
+	Algo::Sort(MakeArrayView(OutHits.GetData() + FirstHitIndex, OutHits.Num() - FirstHitIndex),
+		[](const FRayHit& Hit1, const FRayHit& Hit2) { return Hit1.Distance < Hit2.Distance; });
+}
+
+bool FInteractableSpatialGrid::RaycastFirst(const FVector& Origin, const FVector& Direction, float MaxDistance,
+	uint32 Mask, TFunctionRef<bool(int32 Id)> Accept, FRayHit& OutHit, int32& OutNumTested) const
+{
+	bool bFoundHit = false;
+	float NearestDistance = MaxDistance;
+	OutNumTested = 0;
+	ForEachCandidateOnRay(Origin, Direction, MaxDistance, Mask, [&](int32 Id, const FEntry& Entry) {
+		OutNumTested++;
+		// boxes entered beyond the nearest hit so far can't replace it
+		float Distance;
+		if (RayIntersectsBox(Origin, Direction, NearestDistance, Entry, Distance)
+			&& (!bFoundHit || Distance < NearestDistance) && Accept(Id))
+		{
+			OutHit = { Id, Distance };
+			NearestDistance = Distance;
+			bFoundHit = true;
+		}
+	}, &NearestDistance);
+	return bFoundHit;
+}
+
+void FInteractableSpatialGrid::OverlapBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent,
+	uint32 Mask, TArray<int32>& OutIds) const
+{
+	FVector BoundsExtent = GetBoundsExtent(Rotation, Extent);
+	FBox QueryBounds(Center - BoundsExtent, Center + BoundsExtent);
+	ForEachCandidate(QueryBounds, Mask, [&](int32 Id, const FEntry& Entry) {
+		if (Entry.Bounds.Intersect(QueryBounds)
+			&& BoxesIntersect(Center, Rotation, Extent, Entry.Center, Entry.Rotation, Entry.Extent))
+		{
+			OutIds.Add(Id);
+		}
+	});
+}
+
+void FInteractableSpatialGrid::OverlapSphere(const FVector& Center, float Radius, uint32 Mask,
+	TArray<int32>& OutIds) const
+{
+	FBox QueryBounds(Center - FVector(Radius), Center + FVector(Radius));
+	float RadiusSqr = Radius * Radius;
+	ForEachCandidate(QueryBounds, Mask, [&](int32 Id, const FEntry& Entry) {
+		// closest point of the box to the sphere, in box space
+		FVector LocalCenter = Entry.Rotation.UnrotateVector(Center - Entry.Center);
+		FVector ClosestPoint = LocalCenter.BoundToBox(-Entry.Extent, Entry.Extent);
+		if (FVector::DistSquared(LocalCenter, ClosestPoint) <= RadiusSqr)
+		{
+			OutIds.Add(Id);
+		}
+	});
+}
+
+void FInteractableSpatialGrid::SweepSphere(const FVector& Start, const FVector& End, float Radius, uint32 Mask,
+	TArray<FRayHit>& OutHits) const
+{
+	FVector Delta = End - Start;
+	float Length = Delta.Size();
+	// a sweep that doesn't move is an overlap of the start
+	FVector Direction = Length > UE_KINDA_SMALL_NUMBER ? Delta / Length : FVector::ForwardVector;
+	FBox QueryBounds = FBox(Start.ComponentMin(End), Start.ComponentMax(End)).ExpandBy(Radius);
+
+	int32 FirstHitIndex = OutHits.Num();
+	ForEachCandidate(QueryBounds, Mask, [&](int32 Id, const FEntry& Entry) {
+		float Distance;
+		if (Entry.Bounds.Intersect(QueryBounds)
+			&& RayIntersectsBox(Start, Direction, Length, Entry, Distance, Radius))
+		{
+			OutHits.Add({ Id, Distance });
+		}
+	});
+
+	Algo::Sort(MakeArrayView(OutHits.GetData() + FirstHitIndex, OutHits.Num() - FirstHitIndex),
+		[](const FRayHit& Hit1, const FRayHit& Hit2) { return Hit1.Distance < Hit2.Distance; });
+}
+
+FIntVector FInteractableSpatialGrid::ToCell(const FVector& Position) const
+{
+	return FIntVector(
+		FMath::FloorToInt(Position.X * InvCellSize),
+		FMath::FloorToInt(Position.Y * InvCellSize),
+		FMath::FloorToInt(Position.Z * InvCellSize));
+}
+
+void FInteractableSpatialGrid::SetEntryBox(FEntry& Entry, const FTransform& BoxTransform,
+	const FVector& BoxExtent) const
+{
+	Entry.Center = BoxTransform.GetLocation();
+	Entry.Rotation = BoxTransform.GetRotation();
+	Entry.Extent = BoxExtent;
+	FVector BoundsExtent = GetBoundsExtent(Entry.Rotation, Entry.Extent);
+	Entry.Bounds = FBox(Entry.Center - BoundsExtent, Entry.Center + BoundsExtent);
+	Entry.MinCell = ToCell(Entry.Bounds.Min);
+	Entry.MaxCell = ToCell(Entry.Bounds.Max);
+}
+
+void FInteractableSpatialGrid::AddToCells(int32 Id, const FIntVector& MinCell, const FIntVector& MaxCell)
+{
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(Id);
+			}
+		}
+	}
+}
+
+void FInteractableSpatialGrid::RemoveFromCells(int32 Id, const FIntVector& MinCell, const FIntVector& MaxCell)
+{
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				FIntVector Cell(X, Y, Z);
+				TArray<int32>* CellIds = Cells.Find(Cell);
+				if (CellIds == nullptr)
+				{
+					continue;
+				}
+				CellIds->RemoveSingleSwap(Id);
+				if (CellIds->Num() == 0)
+				{
+					Cells.Remove(Cell);
+				}
+			}
+		}
+	}
+}
+
+uint32 FInteractableSpatialGrid::BeginQuery() const
+{
+	QueryStamp++;
+	if (QueryStamp == 0)
+	{
+		// wrapped around; old stamps could match again
+		FMemory::Memzero(EntryQueryStamps.GetData(), EntryQueryStamps.Num() * sizeof(uint32));
+		QueryStamp = 1;
+	}
+	return QueryStamp;
+}
+
+void FInteractableSpatialGrid::VisitCell(const FIntVector& Cell, uint32 Stamp, uint32 Mask,
+	TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit) const
+{
+	const TArray<int32>* CellIds = Cells.Find(Cell);
+	if (CellIds == nullptr)
+	{
+		return;
+	}
+	for (int32 Id : *CellIds)
+	{
+		const FEntry& Entry = Entries[Id];
+		if (EntryQueryStamps[Id] != Stamp && (Entry.Mask & Mask) != 0)
+		{
+			EntryQueryStamps[Id] = Stamp;
+			Visit(Id, Entry);
+		}
+	}
+}
+
+void FInteractableSpatialGrid::ForEachCandidate(const FBox& QueryBounds, uint32 Mask,
+	TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit) const
+{
+	FIntVector MinCell = ToCell(QueryBounds.Min);
+	FIntVector MaxCell = ToCell(QueryBounds.Max);
+	int64 NumQueryCells = (int64)(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1)
+		* (MaxCell.Z - MinCell.Z + 1);
+
+	// big queries over a sparse grid are cheaper as a plain scan
+	if (NumQueryCells > Num())
+	{
+		int32 NumEntries = Entries.Num();
+		for (int32 Id = 0; Id < NumEntries; Id++)
+		{
+			const FEntry& Entry = Entries[Id];
+			if (Entry.bInUse && (Entry.Mask & Mask) != 0 && Entry.Bounds.Intersect(QueryBounds))
+			{
+				Visit(Id, Entry);
+			}
+		}
+		return;
+	}
+
+	uint32 Stamp = BeginQuery();
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				VisitCell(FIntVector(X, Y, Z), Stamp, Mask, Visit);
+			}
+		}
+	}
+}
+
+void FInteractableSpatialGrid::ForEachCandidateOnRay(const FVector& Origin, const FVector& Direction,
+	float MaxDistance, uint32 Mask, TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit,
+	const float* StopDistance) const
+{
+	FIntVector Cell = ToCell(Origin);
+	FIntVector EndCell = ToCell(Origin + Direction * MaxDistance);
+	int64 NumRayCells = (int64)FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y)
+		+ FMath::Abs(EndCell.Z - Cell.Z) + 1;
+	if (NumRayCells > Num())
+	{
+		FBox RayBounds(Origin, Origin);
+		RayBounds += Origin + Direction * MaxDistance;
+		ForEachCandidate(RayBounds, Mask, Visit);
+		return;
+	}
+
+	// walk the cells along the ray one boundary crossing at a time
+	FIntVector Step;
+	FVector NextCrossing;
+	FVector CrossingDelta;
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		float AxisDirection = Direction[Axis];
+		if (FMath::IsNearlyZero(AxisDirection))
+		{
+			Step[Axis] = 0;
+			NextCrossing[Axis] = MAX_flt;
+			CrossingDelta[Axis] = MAX_flt;
+			continue;
+		}
+		Step[Axis] = AxisDirection > 0.0f ? 1 : -1;
+		float Boundary = (Cell[Axis] + (AxisDirection > 0.0f ? 1 : 0)) * CellSize;
+		NextCrossing[Axis] = (Boundary - Origin[Axis]) / AxisDirection;
+		CrossingDelta[Axis] = CellSize / FMath::Abs(AxisDirection);
+	}
+
+	uint32 Stamp = BeginQuery();
+	for (int64 CellIndex = 0; CellIndex < NumRayCells; CellIndex++)
+	{
+		VisitCell(Cell, Stamp, Mask, Visit);
+		if (Cell == EndCell)
+		{
+			break;
+		}
+		// boxes not seen yet don't touch the cells walked so far,
+		// so the ray can't enter them before leaving this cell
+		if (StopDistance != nullptr && *StopDistance <= FMath::Min3(NextCrossing.X, NextCrossing.Y, NextCrossing.Z))
+		{
+			break;
+		}
+		int32 Axis = NextCrossing.X < NextCrossing.Y
+			? (NextCrossing.X < NextCrossing.Z ? 0 : 2)
+			: (NextCrossing.Y < NextCrossing.Z ? 1 : 2);
+		Cell[Axis] += Step[Axis];
+		NextCrossing[Axis] += CrossingDelta[Axis];
+	}
+}
+
+bool FInteractableSpatialGrid::RayIntersectsBox(const FVector& Origin, const FVector& Direction,
+	float MaxDistance, const FEntry& Entry, float& OutDistance, float Padding)
+{
+	// slab test in box space
+	FVector Extent = Entry.Extent + FVector(Padding);
+	FVector LocalOrigin = Entry.Rotation.UnrotateVector(Origin - Entry.Center);
+	FVector LocalDirection = Entry.Rotation.UnrotateVector(Direction);
+	float EnterDistance = 0.0f;
+	float ExitDistance = MaxDistance;
+	for (int32 Axis = 0; Axis < 3; Axis++)
+	{
+		if (FMath::IsNearlyZero(LocalDirection[Axis]))
+		{
+			if (FMath::Abs(LocalOrigin[Axis]) > Extent[Axis])
+			{
+				return false;
+			}
+			continue;
+		}
+		float InvDirection = 1.0f / LocalDirection[Axis];
+		float Distance1 = (-Extent[Axis] - LocalOrigin[Axis]) * InvDirection;
+		float Distance2 = (Extent[Axis] - LocalOrigin[Axis]) * InvDirection;
+		EnterDistance = FMath::Max(EnterDistance, FMath::Min(Distance1, Distance2));
+		ExitDistance = FMath::Min(ExitDistance, FMath::Max(Distance1, Distance2));
+		if (EnterDistance > ExitDistance)
+		{
+			return false;
+		}
+	}
+	OutDistance = EnterDistance;
+	return true;
+}
+
+bool FInteractableSpatialGrid::BoxesIntersect(const FVector& CenterA, const FQuat& RotationA,
+	const FVector& ExtentA, const FVector& CenterB, const FQuat& RotationB, const FVector& ExtentB)
+{
+	// separating axis test over both boxes' axes and their cross products
+	const FVector AxesA[3] = { RotationA.GetAxisX(), RotationA.GetAxisY(), RotationA.GetAxisZ() };
+	const FVector AxesB[3] = { RotationB.GetAxisX(), RotationB.GetAxisY(), RotationB.GetAxisZ() };
+	FVector Offset = CenterB - CenterA;
+
+	auto IsSeparatingAxis = [&](const FVector& Axis) {
+		if (Axis.SizeSquared() < UE_KINDA_SMALL_NUMBER)
+		{
+			// parallel edges; the face axes cover this case
+			return false;
+		}
+		float ProjectedA = ExtentA.X * FMath::Abs(Axis | AxesA[0]) + ExtentA.Y * FMath::Abs(Axis | AxesA[1])
+			+ ExtentA.Z * FMath::Abs(Axis | AxesA[2]);
+		float ProjectedB = ExtentB.X * FMath::Abs(Axis | AxesB[0]) + ExtentB.Y * FMath::Abs(Axis | AxesB[1])
+			+ ExtentB.Z * FMath::Abs(Axis | AxesB[2]);
+		return FMath::Abs(Offset | Axis) > ProjectedA + ProjectedB;
+	};
+
+	for (int32 AxisIndex = 0; AxisIndex < 3; AxisIndex++)
+	{
+		if (IsSeparatingAxis(AxesA[AxisIndex]) || IsSeparatingAxis(AxesB[AxisIndex]))
+		{
+			return false;
+		}
+	}
+	for (int32 AxisIndexA = 0; AxisIndexA < 3; AxisIndexA++)
+	{
+		for (int32 AxisIndexB = 0; AxisIndexB < 3; AxisIndexB++)
+		{
+			if (IsSeparatingAxis(AxesA[AxisIndexA] ^ AxesB[AxisIndexB]))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+FVector FInteractableSpatialGrid::GetBoundsExtent(const FQuat& Rotation, const FVector& Extent)
+{
+	FVector AxisX = Rotation.GetAxisX() * Extent.X;
+	FVector AxisY = Rotation.GetAxisY() * Extent.Y;
+	FVector AxisZ = Rotation.GetAxisZ() * Extent.Z;
+	return AxisX.GetAbs() + AxisY.GetAbs() + AxisZ.GetAbs();
+}
+
+void UInteractableSpatialIndex::Deinitialize()
+{
+	for (const FIndexedZone& IndexedZone : IndexedZones)
+	{
+		UColliderZone* Zone = IndexedZone.Zone.Get();
+		if (IsValid(Zone))
+		{
+			Zone->TransformUpdated.Remove(IndexedZone.TransformUpdatedHandle);
+		}
+	}
+	IndexedZones.Reset();
+	ZoneIds.Reset();
+	Grid.Reset();
+	RecentZoneChanges.Reset();
+	ZoneChangesPrunedFrame = 0;
+	Super::Deinitialize();
+}
+
+void UInteractableSpatialIndex::RegisterInteractable(AInteractable* Interactable)
+{
+	if (!IsValid(Interactable))
+	{
+		return;
+	}
+	uint32 ToolTagsMask = (uint32)Interactable->GetValidToolTagsMask();
+	RegisterZone(Interactable->ProximityZone, ToolTagsMask);
+	RegisterZone(Interactable->ContactZone, ToolTagsMask);
+	RegisterZone(Interactable->ActionZone, ToolTagsMask);
+}
+
+void UInteractableSpatialIndex::UnregisterInteractable(AInteractable* Interactable)
+{
+	if (Interactable == nullptr)
+	{
+		return;
+	}
+	UnregisterZone(Interactable->ProximityZone);
+	UnregisterZone(Interactable->ContactZone);
+	UnregisterZone(Interactable->ActionZone);
+}
+
+void UInteractableSpatialIndex::Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance,
+	uint32 ToolTagsMask, TArray<FInteractableZoneHit>& OutHits) const
+{
+	ScratchRayHits.Reset();
+	Grid.Raycast(Origin, Direction, MaxDistance, ToolTagsMask, ScratchRayHits);
+	for (const FInteractableSpatialGrid::FRayHit& RayHit : ScratchRayHits)
+	{
+		UColliderZone* Zone = GetQueryableZone(RayHit.Id);
+		if (Zone != nullptr)
+		{
+			OutHits.Add({ Zone, RayHit.Distance });
+		}
+	}
+}
+
+bool UInteractableSpatialIndex::RaycastFirst(const FVector& Origin, const FVector& Direction, float MaxDistance,
+	uint32 ToolTagsMask, FInteractableZoneHit& OutHit, int32& OutNumExamined) const
+{
+	FInteractableSpatialGrid::FRayHit RayHit;
+	bool bHit = Grid.RaycastFirst(Origin, Direction, MaxDistance, ToolTagsMask,
+		[this](int32 Id) {
+			UColliderZone* Zone = GetQueryableZone(Id);
+			return Zone != nullptr && IsValid(Zone->ParentInteractable);
+		},
+		RayHit, OutNumExamined);
+	if (bHit)
+	{
+		OutHit = { IndexedZones[RayHit.Id].Zone.Get(), RayHit.Distance };
+	}
+	return bHit;
+}
+
+void UInteractableSpatialIndex::OverlapBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent,
+	uint32 ToolTagsMask, TArray<UColliderZone*>& OutZones) const
+{
+	ScratchIds.Reset();
+	Grid.OverlapBox(Center, Rotation, Extent, ToolTagsMask, ScratchIds);
+	for (int32 Id : ScratchIds)
+	{
+		UColliderZone* Zone = GetQueryableZone(Id);
+		if (Zone != nullptr)
+		{
+			OutZones.Add(Zone);
+		}
+	}
+}
+
+void UInteractableSpatialIndex::OverlapSphere(const FVector& Center, float Radius, uint32 ToolTagsMask,
+	TArray<UColliderZone*>& OutZones) const
+{
+	ScratchIds.Reset();
+	Grid.OverlapSphere(Center, Radius, ToolTagsMask, ScratchIds);
+	for (int32 Id : ScratchIds)
+	{
+		UColliderZone* Zone = GetQueryableZone(Id);
+		if (Zone != nullptr)
+		{
+			OutZones.Add(Zone);
+		}
+	}
+}
+
+void UInteractableSpatialIndex::SweepSphere(const FVector& Start, const FVector& End, float Radius,
+	uint32 ToolTagsMask, TArray<FInteractableZoneHit>& OutHits) const
+{
+	ScratchRayHits.Reset();
+	Grid.SweepSphere(Start, End, Radius, ToolTagsMask, ScratchRayHits);
+	for (const FInteractableSpatialGrid::FRayHit& SweepHit : ScratchRayHits)
+	{
+		UColliderZone* Zone = GetQueryableZone(SweepHit.Id);
+		if (Zone != nullptr)
+		{
+			OutHits.Add({ Zone, SweepHit.Distance });
+		}
+	}
+}
+
+void UInteractableSpatialIndex::RegisterZone(UColliderZone* Zone, uint32 ToolTagsMask)
+{
+	if (!IsValid(Zone) || ZoneIds.Contains(Zone))
+	{
+		return;
+	}
+
+	int32 Id = Grid.Add(Zone->GetComponentTransform(), Zone->GetScaledBoxExtent(), ToolTagsMask);
+	ZoneIds.Add(Zone, Id);
+	if (IndexedZones.Num() <= Id)
+	{
+		IndexedZones.SetNum(Id + 1);
+	}
+	IndexedZones[Id].Zone = Zone;
+	IndexedZones[Id].TransformUpdatedHandle =
+		Zone->TransformUpdated.AddUObject(this, &UInteractableSpatialIndex::OnZoneTransformUpdated);
+	RecordZoneChange(Grid.GetBounds(Id));
+}
+
+void UInteractableSpatialIndex::UnregisterZone(UColliderZone* Zone)
+{
+	int32 Id;
+	if (Zone == nullptr || !ZoneIds.RemoveAndCopyValue(Zone, Id))
+	{
+		return;
+	}
+	Zone->TransformUpdated.Remove(IndexedZones[Id].TransformUpdatedHandle);
+	IndexedZones[Id] = FIndexedZone();
+	RecordZoneChange(Grid.GetBounds(Id));
+	Grid.Remove(Id);
+}
+
+void UInteractableSpatialIndex::OnZoneTransformUpdated(USceneComponent* UpdatedComponent,
+	EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	UColliderZone* Zone = Cast<UColliderZone>(UpdatedComponent);
+	int32* Id = ZoneIds.Find(Zone);
+	if (Id != nullptr)
+	{
+		// both where the zone was and where it is now have changed
+		FBox ChangedBounds = Grid.GetBounds(*Id);
+		Grid.Update(*Id, Zone->GetComponentTransform(), Zone->GetScaledBoxExtent());
+		RecordZoneChange(ChangedBounds + Grid.GetBounds(*Id));
+	}
+}
+
+UColliderZone* UInteractableSpatialIndex::GetQueryableZone(int32 Id) const
+{
+	UColliderZone* Zone = IndexedZones[Id].Zone.Get();
+	// match what the physics queries on the interactable channel would see
+	if (!IsValid(Zone) || !Zone->IsCollisionEnabled()
+		|| Zone->GetCollisionResponseToChannel(ECollisionChannel::ECC_GameTraceChannel1) == ECR_Ignore)
+	{
+		return nullptr;
+	}
+	return Zone;
+}
+
+bool UInteractableSpatialIndex::HasZoneChangedWithin(const FBox& Bounds, uint64 SinceFrame) const
+{
+	if (SinceFrame + 1 < GFrameCounter)
+	{
+		return true;
+	}
+	for (const FZoneChange& ZoneChange : RecentZoneChanges)
+	{
+		if (ZoneChange.Frame >= SinceFrame && ZoneChange.Bounds.Intersect(Bounds))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UInteractableSpatialIndex::RecordZoneChange(const FBox& Bounds)
+{
+	// callers only look back as far as the previous frame, so
+	// older changes only need dropping once a frame
+	if (ZoneChangesPrunedFrame != GFrameCounter)
+	{
+		RecentZoneChanges.RemoveAll([](const FZoneChange& ZoneChange) {
+			return ZoneChange.Frame + 1 < GFrameCounter;
+		});
+		ZoneChangesPrunedFrame = GFrameCounter;
+	}
+	RecentZoneChanges.Add({ Bounds, GFrameCounter });
+}
@@ -0,0 +1,231 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InteractableSpatialIndex.generated.h"
+
+class AInteractable;
+class UColliderZone;
+
+/**
+ * Oriented boxes bucketed into a uniform hash grid. Boxes are added to
+ * every cell their bounds touch, and queries only test the boxes in the
+ * cells they touch. Queries that would visit more cells than are occupied
+ * test every box instead. Doesn't know about actors, so it can be used
+ * and tested on its own.
+ */
+class HANDSTRAINSAMPLE_API FInteractableSpatialGrid
+{
+public:
+	struct FRayHit
+	{
+		int32 Id;
+		// distance along the ray where it enters the box; 0 if it starts inside
+		float Distance;
+	};
+
+	explicit FInteractableSpatialGrid(float InCellSize = 50.0f);
+
+	/**
+	 * @param BoxTransform - Location and rotation of the box. Scale is ignored.
+	 * @param BoxExtent - Half size of the box, with scale applied.
+	 * @param Mask - Queries only return boxes whose mask overlaps theirs.
+	 * @return Id of the box.
+	 */
+	int32 Add(const FTransform& BoxTransform, const FVector& BoxExtent, uint32 Mask);
+
+	void Update(int32 Id, const FTransform& BoxTransform, const FVector& BoxExtent);
+
+	void Remove(int32 Id);
+
+	void Reset();
+
+	int32 Num() const
+	{
+		return Entries.Num() - FreeIds.Num();
+	}
+
+	/** World space bounds of a box. */
+	const FBox& GetBounds(int32 Id) const
+	{
+		return Entries[Id].Bounds;
+	}
+
+	/** Appends every box hit within MaxDistance, nearest first. Direction must be normalized. */
+	void Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance, uint32 Mask,
+		TArray<FRayHit>& OutHits) const;
+
+	/**
+	 * Finds the nearest box hit within MaxDistance that Accept returns true for.
+	 * Stops walking cells once no box left to test could be nearer.
+	 * @param OutNumTested - Number of boxes tested against the ray.
+	 * @return Whether a box was hit.
+	 */
+	bool RaycastFirst(const FVector& Origin, const FVector& Direction, float MaxDistance, uint32 Mask,
+		TFunctionRef<bool(int32 Id)> Accept, FRayHit& OutHit, int32& OutNumTested) const;
+
+	/** Appends every box overlapping an oriented box. */
+	void OverlapBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent, uint32 Mask,
+		TArray<int32>& OutIds) const;
+
+	/** Appends every box overlapping a sphere. */
+	void OverlapSphere(const FVector& Center, float Radius, uint32 Mask, TArray<int32>& OutIds) const;
+
+	/**
+	 * Appends every box a sphere touches while moving from Start to End, in
+	 * the order it enters them. Boxes are treated as grown by the radius, so
+	 * hits near their edges are conservative.
+	 */
+	void SweepSphere(const FVector& Start, const FVector& End, float Radius, uint32 Mask,
+		TArray<FRayHit>& OutHits) const;
+
+private:
+	struct FEntry
+	{
+		FVector Center;
+		FQuat Rotation;
+		FVector Extent;
+		FBox Bounds;
+		FIntVector MinCell;
+		FIntVector MaxCell;
+		uint32 Mask;
+		bool bInUse;
+	};
+
+	float CellSize;
+	float InvCellSize;
+
+	TArray<FEntry> Entries;
+	TArray<int32> FreeIds;
+	TMap<FIntVector, TArray<int32>> Cells;
+
+	// boxes span several cells; stamping them per query
+	// makes sure each is only tested once
+	mutable TArray<uint32> EntryQueryStamps;
+	mutable uint32 QueryStamp;
+
+	FIntVector ToCell(const FVector& Position) const;
+	void SetEntryBox(FEntry& Entry, const FTransform& BoxTransform, const FVector& BoxExtent) const;
+	void AddToCells(int32 Id, const FIntVector& MinCell, const FIntVector& MaxCell);
+	void RemoveFromCells(int32 Id, const FIntVector& MinCell, const FIntVector& MaxCell);
+	uint32 BeginQuery() const;
+	void VisitCell(const FIntVector& Cell, uint32 Stamp, uint32 Mask,
+		TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit) const;
+
+	/** Calls Visit once for every box with the mask whose cells touch the bounds. */
+	void ForEachCandidate(const FBox& QueryBounds, uint32 Mask,
+		TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit) const;
+
+	/**
+	 * Same, for the cells a ray segment passes through, nearest first. If StopDistance
+	 * is set, stops after the first cell the ray leaves beyond it; Visit may lower it.
+	 */
+	void ForEachCandidateOnRay(const FVector& Origin, const FVector& Direction, float MaxDistance, uint32 Mask,
+		TFunctionRef<void(int32 Id, const FEntry& Entry)> Visit, const float* StopDistance = nullptr) const;
+
+	static bool RayIntersectsBox(const FVector& Origin, const FVector& Direction, float MaxDistance,
+		const FEntry& Entry, float& OutDistance, float Padding = 0.0f);
+	static bool BoxesIntersect(const FVector& CenterA, const FQuat& RotationA, const FVector& ExtentA,
+		const FVector& CenterB, const FQuat& RotationB, const FVector& ExtentB);
+	static FVector GetBoundsExtent(const FQuat& Rotation, const FVector& Extent);
+};
+
+/** A zone hit by a spatial index ray query. */
+struct FInteractableZoneHit
+{
+	UColliderZone* Zone;
+	float Distance;
+};
+
+/**
+ * Index of every interactable's proximity, contact and action zones, so
+ * tools can find zones without going through the physics scene. Zones
+ * are added when their interactable begins play and re-indexed only when
+ * they move. Like the physics queries it replaces, only zones that block
+ * or overlap the interactable trace channel are returned.
+ */
+UCLASS()
+class HANDSTRAINSAMPLE_API UInteractableSpatialIndex : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterInteractable(AInteractable* Interactable);
+	void UnregisterInteractable(AInteractable* Interactable);
+
+	/** Zones hit by a ray that support any of the tool tags, nearest first. */
+	void Raycast(const FVector& Origin, const FVector& Direction, float MaxDistance, uint32 ToolTagsMask,
+		TArray<FInteractableZoneHit>& OutHits) const;
+
+	/**
+	 * Nearest zone hit by a ray that supports any of the tool tags.
+	 * @param OutNumExamined - Number of zones tested against the ray.
+	 * @return Whether a zone was hit.
+	 */
+	bool RaycastFirst(const FVector& Origin, const FVector& Direction, float MaxDistance, uint32 ToolTagsMask,
+		FInteractableZoneHit& OutHit, int32& OutNumExamined) const;
+
+	void OverlapBox(const FVector& Center, const FQuat& Rotation, const FVector& Extent, uint32 ToolTagsMask,
+		TArray<UColliderZone*>& OutZones) const;
+
+	void OverlapSphere(const FVector& Center, float Radius, uint32 ToolTagsMask,
+		TArray<UColliderZone*>& OutZones) const;
+
+	/** Zones a moving sphere touches that support any of the tool tags, in the order it enters them. */
+	void SweepSphere(const FVector& Start, const FVector& End, float Radius, uint32 ToolTagsMask,
+		TArray<FInteractableZoneHit>& OutHits) const;
+
+	int32 GetNumZones() const
+	{
+		return Grid.Num();
+	}
+
+	/**
+	 * Whether a zone was added, removed or moved within the bounds on or
+	 * after a frame. Only the last couple of frames are remembered; older
+	 * frames always count as changed.
+	 */
+	bool HasZoneChangedWithin(const FBox& Bounds, uint64 SinceFrame) const;
+
+private:
+	struct FZoneChange
+	{
+		FBox Bounds;
+		uint64 Frame;
+	};
+
+	struct FIndexedZone
+	{
+		// zones can be destroyed without being unregistered
+		TWeakObjectPtr<UColliderZone> Zone;
+		FDelegateHandle TransformUpdatedHandle;
+	};
+
+	FInteractableSpatialGrid Grid;
+	TMap<TWeakObjectPtr<UColliderZone>, int32> ZoneIds;
+	// indexed by grid id
+	TArray<FIndexedZone> IndexedZones;
+
+	mutable TArray<FInteractableSpatialGrid::FRayHit> ScratchRayHits;
+	mutable TArray<int32> ScratchIds;
+
+	TArray<FZoneChange> RecentZoneChanges;
+	uint64 ZoneChangesPrunedFrame = 0;
+
+	void RegisterZone(UColliderZone* Zone, uint32 ToolTagsMask);
+	void UnregisterZone(UColliderZone* Zone);
+	void OnZoneTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags,
+		ETeleportType Teleport);
+	UColliderZone* GetQueryableZone(int32 Id) const;
+	void RecordZoneChange(const FBox& Bounds);
+};
@@ -10,9 +10,23 @@ LICENSE file in the root directory of this source tree.
 #include "ColliderZone.h"
 #include "Interactable.h"
 
+const int32 AInteractableTool::CollisionInfosReserveSize = 8;
+
 AInteractableTool::AInteractableTool()
 {
 	PrimaryActorTick.bCanEverTick = false;
+
+	bCurrentCollisionInfosSynced = false;
+	InteractionPosition = FVector::ZeroVector;
+	PredictedInteractionPosition = FVector::ZeroVector;
+	CalculatedToolVelocity = FVector::ZeroVector;
+	CurrentIntersectingObjects.Reserve(CollisionInfosReserveSize);
+	CurrInteractableToCollisionInfos.Reserve(CollisionInfosReserveSize);
+	PrevInteractableToCollisionInfos.Reserve(CollisionInfosReserveSize);
+	AddedInteractables.Reserve(CollisionInfosReserveSize);
+	RemovedInteractables.Reserve(CollisionInfosReserveSize);
+	RemainingInteractables.Reserve(CollisionInfosReserveSize);
+	PassedThroughObjects.Reserve(CollisionInfosReserveSize);
 }
 
 /** Should be overridden. */
@@ -84,7 +98,7 @@ FCollisionInfoKeyValuePair AInteractableTool::
 
 void AInteractableTool::UpdateCurrentCollisionsMapBasedOnDepth()
 {
-	CurrInteractableToCollisionInfos.Empty();
+	BeginCurrentCollisionInfosUpdate();
 	for (auto& LatestCollisionInfo : CurrentIntersectingObjects)
 	{
 		AInteractable* CurrInteractable =
@@ -92,21 +106,18 @@ void AInteractableTool::UpdateCurrentCollisionsMapBasedOnDepth()
 		EInteractableCollisionDepth CurrDepth =
 			LatestCollisionInfo.CollisionDepth;
 
-		if (!CurrInteractableToCollisionInfos.Contains(CurrInteractable))
+		FInteractableCollisionInfo* CollisionInfoFromMap =
+			CurrInteractableToCollisionInfos.Find(CurrInteractable);
+		if (CollisionInfoFromMap == nullptr)
 		{
 			CurrInteractableToCollisionInfos.Add(CurrInteractable,
 				LatestCollisionInfo);
 		}
-		else
+		else if (CollisionInfoFromMap->CollisionDepth < CurrDepth)
 		{
-			FInteractableCollisionInfo& CollisionInfoFromMap =
-				CurrInteractableToCollisionInfos[CurrInteractable];
-			if (CollisionInfoFromMap.CollisionDepth < CurrDepth)
-			{
-				CollisionInfoFromMap.InteractableCollider =
-					LatestCollisionInfo.InteractableCollider;
-				CollisionInfoFromMap.CollisionDepth = CurrDepth;
-			}
+			CollisionInfoFromMap->InteractableCollider =
+				LatestCollisionInfo.InteractableCollider;
+			CollisionInfoFromMap->CollisionDepth = CurrDepth;
 		}
 	}
 }
@@ -114,23 +125,30 @@ void AInteractableTool::UpdateCurrentCollisionsMapBasedOnDepth()
 void AInteractableTool::UpdateCurrentCollisionsMap(AInteractable* CurrInteractable,
 	FInteractableCollisionInfo CollisionInfo)
 {
-	if (CurrInteractableToCollisionInfos.Contains(CurrInteractable))
+	FInteractableCollisionInfo* CollisionInfoFromMap =
+		CurrInteractableToCollisionInfos.Find(CurrInteractable);
+	if (CollisionInfoFromMap != nullptr)
 	{
-		CurrInteractableToCollisionInfos[CurrInteractable] =
-			CollisionInfo;
+		*CollisionInfoFromMap = CollisionInfo;
 	}
 }
 
 void AInteractableTool::SyncLatestCollisionDataWithInteractables()
 {
-	AddedInteractables.Empty();
-	RemovedInteractables.Empty();
-	RemainingInteractables.Empty();
+	AddedInteractables.Reset();
+	RemovedInteractables.Reset();
+	RemainingInteractables.Reset();
 
-	for (auto& Elem : CurrInteractableToCollisionInfos)
+	// if nothing was updated since the last sync, nothing changed either
+	const TMap<AInteractable*, FInteractableCollisionInfo>& CurrInfos = CurrInteractableToCollisionInfos;
+	const TMap<AInteractable*, FInteractableCollisionInfo>& PrevInfos = bCurrentCollisionInfosSynced
+		? CurrInteractableToCollisionInfos
+		: PrevInteractableToCollisionInfos;
+
+	for (auto& Elem : CurrInfos)
 	{
 		AInteractable* Key = Elem.Key;
-		bool IsNewItem = !PrevInteractableToCollisionInfos.Contains(Key);
+		bool IsNewItem = !PrevInfos.Contains(Key);
 		if (IsNewItem)
 		{
 			AddedInteractables.Add(Key);
@@ -141,10 +159,10 @@ void AInteractableTool::SyncLatestCollisionDataWithInteractables()
 		}
 	}
 
-	for (auto& Elem : PrevInteractableToCollisionInfos)
+	for (auto& Elem : PrevInfos)
 	{
 		AInteractable* Key = Elem.Key;
-		bool RemovedItem = !CurrInteractableToCollisionInfos.Contains(Key);
+		bool RemovedItem = !CurrInfos.Contains(Key);
 		if (RemovedItem)
 		{
 			RemovedInteractables.Add(Key);
@@ -158,7 +176,7 @@ void AInteractableTool::SyncLatestCollisionDataWithInteractables()
 		{
 			RemovedInteractable->UpdateCollisionDepth(
 				this,
-				PrevInteractableToCollisionInfos[RemovedInteractable].CollisionDepth,
+				PrevInfos[RemovedInteractable].CollisionDepth,
 				EInteractableCollisionDepth::None);
 		}
 	}
@@ -168,13 +186,13 @@ void AInteractableTool::SyncLatestCollisionDataWithInteractables()
 	{
 		if (IsValid(AddedInteractable))
 		{
-			FInteractableCollisionInfo AddedCollisionInfo =
-				CurrInteractableToCollisionInfos[AddedInteractable];
 			EInteractableCollisionDepth CollisionDepth =
-				AddedCollisionInfo.CollisionDepth;
+				CurrInfos[AddedInteractable].CollisionDepth;
+			EInteractableCollisionDepth OldCollisionDepth = StepThroughPassedDepths(AddedInteractable,
+				EInteractableCollisionDepth::None, CollisionDepth);
 			AddedInteractable->UpdateCollisionDepth(
 				this,
-				EInteractableCollisionDepth::None,
+				OldCollisionDepth,
 				CollisionDepth);
 		}
 	}
@@ -184,18 +202,43 @@ void AInteractableTool::SyncLatestCollisionDataWithInteractables()
 	{
 		if (IsValid(RemainingInteractable))
 		{
-			EInteractableCollisionDepth OldCollisionDepth = PrevInteractableToCollisionInfos[RemainingInteractable].CollisionDepth;
-			FInteractableCollisionInfo NewCollisionInfo =
-				CurrInteractableToCollisionInfos[RemainingInteractable];
-			EInteractableCollisionDepth NewCollisionDepth = NewCollisionInfo.CollisionDepth;
-			;
+			EInteractableCollisionDepth NewCollisionDepth = CurrInfos[RemainingInteractable].CollisionDepth;
+			EInteractableCollisionDepth OldCollisionDepth = StepThroughPassedDepths(RemainingInteractable,
+				PrevInfos[RemainingInteractable].CollisionDepth, NewCollisionDepth);
 			RemainingInteractable->UpdateCollisionDepth(this, OldCollisionDepth,
 				NewCollisionDepth);
 		}
 	}
 
-	PrevInteractableToCollisionInfos.Empty();
-	PrevInteractableToCollisionInfos = CurrInteractableToCollisionInfos;
+	PassedThroughObjects.Reset();
+	bCurrentCollisionInfosSynced = true;
+}
+
+EInteractableCollisionDepth AInteractableTool::StepThroughPassedDepths(AInteractable* Interactable,
+	EInteractableCollisionDepth FromDepth, EInteractableCollisionDepth ToDepth)
+{
+	for (const FInteractableCollisionInfo& PassedThroughInfo : PassedThroughObjects)
+	{
+		EInteractableCollisionDepth PassedDepth = PassedThroughInfo.CollisionDepth;
+		if (PassedThroughInfo.InteractableCollider->ParentInteractable == Interactable
+			&& PassedDepth > FromDepth && PassedDepth < ToDepth)
+		{
+			Interactable->UpdateCollisionDepth(this, FromDepth, PassedDepth);
+			FromDepth = PassedDepth;
+		}
+	}
+	return FromDepth;
+}
+
+void AInteractableTool::BeginCurrentCollisionInfosUpdate()
+{
+	// what was synced last becomes the previous state
+	if (bCurrentCollisionInfosSynced)
+	{
+		Swap(PrevInteractableToCollisionInfos, CurrInteractableToCollisionInfos);
+		bCurrentCollisionInfosSynced = false;
+	}
+	CurrInteractableToCollisionInfos.Reset();
 }
 
 void AInteractableTool::BeginDestroy()
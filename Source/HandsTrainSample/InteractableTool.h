@@ -114,6 +114,17 @@ public:
 		return InteractionPosition;
 	}
 
+	/**
+	 * Where the interaction position is expected to be once the frame is
+	 * displayed. Same as the interaction position for tools that don't
+	 * predict.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Movement")
+	FVector GetPredictedInteractionPosition() const
+	{
+		return PredictedInteractionPosition;
+	}
+
 	UFUNCTION(BlueprintPure, Category = "Movement")
 	FVector GetToolVelocity() const
 	{
@@ -176,7 +187,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Interaction")
 	void ClearAllCurrentCollisionInfos()
 	{
-		CurrInteractableToCollisionInfos.Empty();
+		BeginCurrentCollisionInfosUpdate();
 	}
 
 	/**
@@ -198,9 +209,35 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Interaction")
 	void SyncLatestCollisionDataWithInteractables();
 
+	/**
+	 * Changes whenever something besides the tool's pose could change what
+	 * it intersects, like its overlaps or pinch state. Lets the input router
+	 * skip re-evaluating idle tools.
+	 */
+	virtual uint32 GetInputChangeStamp() const
+	{
+		return 0;
+	}
+
+	/**
+	 * Region where a moving interactable could change what this tool finds.
+	 * Invalid if the tool hears about such changes some other way, like
+	 * overlap events.
+	 */
+	virtual FBox GetQueryBounds() const
+	{
+		return FBox(ForceInit);
+	}
+
 	virtual void BeginDestroy() override;
 
 protected:
+	/**
+	 * Collision info per interactable, in the order the interactables were
+	 * found. Capacity is reserved up front, the maps are reset rather than
+	 * emptied, and current and previous are swapped rather than copied, so
+	 * steady state doesn't allocate.
+	 */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Tool Properties")
 	TMap<AInteractable*, FInteractableCollisionInfo> CurrInteractableToCollisionInfos;
 
@@ -208,6 +245,7 @@ protected:
 	TMap<AInteractable*, FInteractableCollisionInfo> PrevInteractableToCollisionInfos;
 
 	FVector InteractionPosition;
+	FVector PredictedInteractionPosition;
 	FVector CalculatedToolVelocity;
 
 	/**
@@ -219,4 +257,31 @@ protected:
 	TArray<AInteractable*> AddedInteractables;
 	TArray<AInteractable*> RemovedInteractables;
 	TArray<AInteractable*> RemainingInteractables;
+
+	/**
+	 * Zones the tool passed through since the last sync, in the order it
+	 * entered them, for tools that can move through several zones in one
+	 * update. Syncing steps an interactable through each of them that lies
+	 * between its previous and current depth, so it still sees contact
+	 * before action. Cleared by every sync.
+	 */
+	TArray<FInteractableCollisionInfo> PassedThroughObjects;
+
+	// enough for the zones of a few interactables at once
+	const static int32 CollisionInfosReserveSize;
+
+private:
+	// true once the current infos have been synced, meaning they
+	// become the previous infos on the next update
+	bool bCurrentCollisionInfosSynced;
+
+	void BeginCurrentCollisionInfosUpdate();
+
+	/**
+	 * Updates an interactable through the passed through depths deeper
+	 * than FromDepth and shallower than ToDepth.
+	 * @return Depth the interactable was last updated to.
+	 */
+	EInteractableCollisionDepth StepThroughPassedDepths(AInteractable* Interactable,
+		EInteractableCollisionDepth FromDepth, EInteractableCollisionDepth ToDepth);
 };
@@ -7,13 +7,20 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "InteractableToolsInputRouter.h"
+#include "HandsTrainStats.h"
+#include "HandInputSubsystem.h"
 #include "InteractableTool.h"
 #include "Interactable.h"
+#include "InteractableSpatialIndex.h"
 #include "OculusXRHandComponent.h"
 #include "MotionControllerComponent.h"
 #include "OculusXRInputFunctionLibrary.h"
 
 InteractableToolsInputRouter::InteractableToolsInputRouter()
+	: bSkipIdleTools(false)
+	, PoseEpsilon(0.0f)
+	, RotationEpsilonRadians(0.0f)
+	, SpatialIndex(nullptr)
 {
 }
 
@@ -27,30 +34,53 @@ void InteractableToolsInputRouter::UpdateTools(UOculusXRHandComponent* LeftHand,
 	const TSet<AInteractableTool*>& RightHandNearTools,
 	const TSet<AInteractableTool*>& RightHandFarTools)
 {
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_InputRouterUpdateTools, EHandsTrainTimer::InputRouterUpdateTools);
+	// tools destroyed without being unregistered leave their state behind
+	for (auto It = ToolEvaluationStates.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
 	UpdateToolsForHand(LeftHand, LeftHandNearTools, LeftHandFarTools);
 	UpdateToolsForHand(RightHand, RightHandNearTools, RightHandFarTools);
 }
 
+void InteractableToolsInputRouter::SetSkipIdleTools(bool bInSkipIdleTools, float InPoseEpsilon,
+	float InRotationEpsilonDegrees, UInteractableSpatialIndex* InSpatialIndex)
+{
+	bSkipIdleTools = bInSkipIdleTools;
+	PoseEpsilon = InPoseEpsilon;
+	RotationEpsilonRadians = FMath::DegreesToRadians(InRotationEpsilonDegrees);
+	SpatialIndex = InSpatialIndex;
+	ToolEvaluationStates.Reset();
+}
+
+void InteractableToolsInputRouter::ForgetTool(AInteractableTool* Tool)
+{
+	ToolEvaluationStates.Remove(Tool);
+}
+
 void InteractableToolsInputRouter::UpdateToolsForHand(
 	UOculusXRHandComponent* Hand,
 	const TSet<AInteractableTool*>& HandNearTools,
 	const TSet<AInteractableTool*>& HandFarTools)
 {
-	if (!IsValid(Hand))
+	UHandInputSubsystem* HandInput = IsValid(Hand) ? Hand->GetWorld()->GetSubsystem<UHandInputSubsystem>() : nullptr;
+	if (HandInput == nullptr)
 	{
 		return;
 	}
+	const FHandInputState& HandState = HandInput->GetHandState(Hand->SkeletonType);
 
-	bool HandIsReliable = UOculusXRInputFunctionLibrary::GetTrackingConfidence(
-							  Hand->SkeletonType, 0)
-			== EOculusXRTrackingConfidence::High
-		&& UOculusXRInputFunctionLibrary::IsHandTrackingEnabled();
+	bool HandIsReliable = HandState.TrackingConfidence == EOculusXRTrackingConfidence::High
+		&& HandInput->IsHandTrackingEnabled();
 
 	bool EncounteredNearObjectsHand = UpdateToolsAndGetEncounteredObjects(
 		HandNearTools, HandIsReliable);
 
-	bool PointerPoseIsValid = UOculusXRInputFunctionLibrary::IsPointerPoseValid(
-		Hand->SkeletonType);
+	bool PointerPoseIsValid = HandState.bPointerPoseValid;
 	/**
 	 * Enable far field if near objects were not encountered, hand
 	 * tracking is reliable and pointer pose is valid.
@@ -77,6 +107,14 @@ bool InteractableToolsInputRouter::UpdateTools(const TSet<AInteractableTool*>& T
 
 	for (auto CurrentInteractableTool : Tools)
 	{
+		// a skipped tool found nothing, so it adds nothing to the result either
+		if (bSkipIdleTools && CanSkipTool(CurrentInteractableTool, ResetCollisionData))
+		{
+			HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_ToolsSkipped, EHandsTrainCounter::ToolsSkipped, 1);
+			continue;
+		}
+		HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_ToolsEvaluated, EHandsTrainCounter::ToolsEvaluated, 1);
+
 		CurrentInteractableTool->RefreshCurrentIntersectingObjects();
 		const TArray<FInteractableCollisionInfo>& CurrIntersectingObjects =
 			CurrentInteractableTool->CurrentIntersectingObjects;
@@ -132,11 +170,50 @@ bool InteractableToolsInputRouter::UpdateTools(const TSet<AInteractableTool*>& T
 
 		// Step two: sync tool with latest interactable states.
 		CurrentInteractableTool->SyncLatestCollisionDataWithInteractables();
+
+		if (bSkipIdleTools)
+		{
+			ToolEvaluationStates.FindChecked(CurrentInteractableTool).bFoundObjects =
+				CurrToolHasIntersectingObjects && !ResetCollisionData;
+		}
 	}
 
 	return AnyToolEncounteredObjects;
 }
 
+bool InteractableToolsInputRouter::CanSkipTool(AInteractableTool* Tool, bool ResetCollisionData)
+{
+	FToolEvaluationState& State = ToolEvaluationStates.FindOrAdd(Tool);
+	uint64 PrevCheckedFrame = State.LastCheckedFrame;
+	State.LastCheckedFrame = GFrameCounter;
+
+	const FTransform Pose = Tool->GetActorTransform();
+	const uint32 InputChangeStamp = Tool->GetInputChangeStamp();
+	// a tool that wasn't checked last frame may have missed zone changes
+	bool bCanSkip = !State.bFoundObjects
+		&& PrevCheckedFrame + 1 >= GFrameCounter
+		&& ResetCollisionData == State.bResetCollisionData
+		&& InputChangeStamp == State.InputChangeStamp
+		&& FVector::DistSquared(Pose.GetLocation(), State.Pose.GetLocation()) <= FMath::Square(PoseEpsilon)
+		&& Pose.GetRotation().AngularDistance(State.Pose.GetRotation()) <= RotationEpsilonRadians;
+	if (bCanSkip)
+	{
+		FBox QueryBounds = Tool->GetQueryBounds();
+		if (QueryBounds.IsValid)
+		{
+			bCanSkip = SpatialIndex != nullptr && !SpatialIndex->HasZoneChangedWithin(QueryBounds, PrevCheckedFrame);
+		}
+	}
+
+	if (!bCanSkip)
+	{
+		State.Pose = Pose;
+		State.InputChangeStamp = InputChangeStamp;
+		State.bResetCollisionData = ResetCollisionData;
+	}
+	return bCanSkip;
+}
+
 void InteractableToolsInputRouter::ToggleToolsVisualEnableState(
 	const TSet<AInteractableTool*>& Tools,
 	bool VisualEnableState)
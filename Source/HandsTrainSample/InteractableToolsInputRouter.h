@@ -11,6 +11,7 @@ LICENSE file in the root directory of this source tree.
 #include "CoreMinimal.h"
 
 class AInteractableTool;
+class UInteractableSpatialIndex;
 class UOculusXRHandComponent;
 class UMotionControllerComponent;
 
@@ -34,7 +35,43 @@ public:
 		const TSet<AInteractableTool*>& RightHandNearTools,
 		const TSet<AInteractableTool*>& RightHandFarTools);
 
+	/**
+	 * Lets tools that found nothing last time be skipped until their pose
+	 * moves beyond an epsilon, their input change stamp changes, or a zone
+	 * changes within their query bounds. Tools touching something are always
+	 * evaluated, since interactables expect a depth update every frame.
+	 * @param InSpatialIndex - Source of zone changes. Tools with query bounds
+	 * are never skipped without it.
+	 */
+	void SetSkipIdleTools(bool bInSkipIdleTools, float InPoseEpsilon, float InRotationEpsilonDegrees,
+		UInteractableSpatialIndex* InSpatialIndex);
+
+	/** Drops what was tracked for a tool that is going away. */
+	void ForgetTool(AInteractableTool* Tool);
+
 private:
+	struct FToolEvaluationState
+	{
+		// as of the last time the tool was evaluated
+		FTransform Pose;
+		uint32 InputChangeStamp = 0;
+		bool bResetCollisionData = false;
+		bool bFoundObjects = true;
+
+		uint64 LastCheckedFrame = 0;
+	};
+
+	bool bSkipIdleTools;
+	float PoseEpsilon;
+	float RotationEpsilonRadians;
+	UInteractableSpatialIndex* SpatialIndex;
+	// weak, so a new tool allocated where a destroyed one was never
+	// inherits its state
+	TMap<TWeakObjectPtr<AInteractableTool>, FToolEvaluationState> ToolEvaluationStates;
+
+	/** Whether the tool's result from last time still holds. */
+	bool CanSkipTool(AInteractableTool* Tool, bool ResetCollisionData);
+
 	void UpdateToolsForHand(UOculusXRHandComponent* Hand,
 		const TSet<AInteractableTool*>& HandNearTools,
 		const TSet<AInteractableTool*>& HandFarTools);
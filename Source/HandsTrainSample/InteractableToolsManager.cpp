@@ -7,8 +7,12 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "InteractableToolsManager.h"
+#include "HandsTrainStats.h"
 #include "OculusXRHandComponent.h"
 #include "InteractableTool.h"
+#include "HandInputSubsystem.h"
+#include "InteractableEventQueue.h"
+#include "InteractableSpatialIndex.h"
 #include "MotionControllerComponent.h"
 #include "FingerTipPokeTool.h"
 #include "Rendering/SkeletalMeshRenderData.h"
@@ -17,14 +21,36 @@ LICENSE file in the root directory of this source tree.
 AInteractableToolsManager::AInteractableToolsManager()
 {
 	PrimaryActorTick.bCanEverTick = true;
+	bSkipIdleTools = false;
+	IdleToolPoseEpsilon = 0.05f;
+	IdleToolRotationEpsilonDegrees = 0.1f;
+	bBatchInteractableEvents = false;
+	EventQueue = nullptr;
+}
+
+void AInteractableToolsManager::BeginPlay()
+{
+	Super::BeginPlay();
+	InputRouter.SetSkipIdleTools(bSkipIdleTools, IdleToolPoseEpsilon, IdleToolRotationEpsilonDegrees,
+		GetWorld()->GetSubsystem<UInteractableSpatialIndex>());
+	EventQueue = bBatchInteractableEvents ? GetWorld()->GetSubsystem<UInteractableEventQueue>() : nullptr;
 }
 
 void AInteractableToolsManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_ToolsManagerTick, EHandsTrainTimer::ToolsManagerTick);
+	if (EventQueue != nullptr)
+	{
+		EventQueue->BeginBatch();
+	}
 	InputRouter.UpdateTools(LeftHand, RightHand,
 		LeftHandNearTools, LeftHandFarTools,
 		RightHandNearTools, RightHandFarTools);
+	if (EventQueue != nullptr)
+	{
+		EventQueue->FlushBatch();
+	}
 }
 
 void AInteractableToolsManager::AssociateToolWithHand(UOculusXRHandComponent* Hand,
@@ -32,6 +58,11 @@ void AInteractableToolsManager::AssociateToolWithHand(UOculusXRHandComponent* Ha
 {
 	bool ToolIsRightHanded = Hand->MeshType == EOculusXRHandType::HandRight;
 	Tool->IsRightHandedTool = ToolIsRightHanded;
+	UHandInputSubsystem* HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
+	if (HandInput != nullptr)
+	{
+		HandInput->RegisterHand(Hand);
+	}
 	Tool->Initialize(Hand);
 	RegisterInteractableTool(Tool);
 	Tool->OnInteractableToolDeathEvent.AddDynamic(this,
@@ -91,6 +122,7 @@ void AInteractableToolsManager::RegisterInteractableTool(AInteractableTool* Inte
 
 void AInteractableToolsManager::UnRegisterInteractableTool(AInteractableTool* InteractableTool)
 {
+	InputRouter.ForgetTool(InteractableTool);
 	if (InteractableTool->IsRightHandedTool)
 	{
 		if (InteractableTool->IsFarFieldTool)
@@ -14,6 +14,7 @@ LICENSE file in the root directory of this source tree.
 #include "InteractableToolsManager.generated.h"
 
 class AInteractableTool;
+class UInteractableEventQueue;
 class UOculusXRHandComponent;
 class UMotionControllerComponent;
 
@@ -31,6 +32,22 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadonly)
 	TArray<TSubclassOf<AInteractableTool>> RightHandTools;
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tools",
+		meta = (Tooltip = "Reuse last frame's result for tools that found nothing and whose pose, input and nearby zones haven't changed"))
+	bool bSkipIdleTools;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tools",
+		meta = (Tooltip = "Distance an idle tool has to move to be evaluated again", UIMin = "0.0"))
+	float IdleToolPoseEpsilon;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tools",
+		meta = (Tooltip = "Angle in degrees an idle tool has to turn to be evaluated again", UIMin = "0.0"))
+	float IdleToolRotationEpsilonDegrees;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Tools",
+		meta = (Tooltip = "Hold interactable events raised while tools update and broadcast them once all tools are done"))
+	bool bBatchInteractableEvents;
+
 	virtual void Tick(float DeltaTime) override;
 
 	UFUNCTION(BlueprintCallable, Category = "Tools")
@@ -40,6 +57,8 @@ public:
 	void UnRegisterInteractableTool(AInteractableTool* InteractableTool);
 
 protected:
+	virtual void BeginPlay() override;
+
 	UFUNCTION(BlueprintCallable, Category = "Initialization")
 	void AssociateToolWithHand(UOculusXRHandComponent* Hand, AInteractableTool* Tool);
 
@@ -62,4 +81,5 @@ protected:
 
 private:
 	InteractableToolsInputRouter InputRouter;
+	UInteractableEventQueue* EventQueue;
 };
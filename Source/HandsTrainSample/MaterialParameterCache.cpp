@@ -0,0 +1,166 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "MaterialParameterCache.h"
+#include "Components/PrimitiveComponent.h"
+#include "HandsTrainStats.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+void UMaterialParameterCache::Deinitialize()
+{
+	ComponentMaterials.Reset();
+	Super::Deinitialize();
+}
+
+UMaterialInstanceDynamic* UMaterialParameterCache::GetDynamicMaterial(UPrimitiveComponent* Component,
+	int32 MaterialIndex)
+{
+	FMaterialSlot* Slot = FindOrCreateSlot(Component, MaterialIndex);
+	return Slot != nullptr ? Slot->Material.Get() : nullptr;
+}
+
+void UMaterialParameterCache::SetScalarParameter(UPrimitiveComponent* Component, FName ParameterName, float Value,
+	bool bForce)
+{
+	if (!IsValid(Component))
+	{
+		return;
+	}
+	for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); MaterialIndex++)
+	{
+		FMaterialSlot* Slot = FindOrCreateSlot(Component, MaterialIndex);
+		if (Slot != nullptr)
+		{
+			WriteScalar(*Slot, ParameterName, Value, bForce);
+		}
+	}
+}
+
+void UMaterialParameterCache::SetVectorParameter(UPrimitiveComponent* Component, FName ParameterName,
+	const FLinearColor& Value, bool bForce)
+{
+	if (!IsValid(Component))
+	{
+		return;
+	}
+	for (int32 MaterialIndex = 0; MaterialIndex < Component->GetNumMaterials(); MaterialIndex++)
+	{
+		FMaterialSlot* Slot = FindOrCreateSlot(Component, MaterialIndex);
+		if (Slot != nullptr)
+		{
+			WriteVector(*Slot, ParameterName, Value, bForce);
+		}
+	}
+}
+
+void UMaterialParameterCache::SetVectorParameter(UPrimitiveComponent* Component, int32 MaterialIndex,
+	FName ParameterName, const FLinearColor& Value, bool bForce)
+{
+	FMaterialSlot* Slot = FindOrCreateSlot(Component, MaterialIndex);
+	if (Slot != nullptr)
+	{
+		WriteVector(*Slot, ParameterName, Value, bForce);
+	}
+}
+
+void UMaterialParameterCache::ForgetComponent(UPrimitiveComponent* Component)
+{
+	ComponentMaterials.Remove(Component);
+}
+
+UMaterialParameterCache::FMaterialSlot* UMaterialParameterCache::FindOrCreateSlot(UPrimitiveComponent* Component,
+	int32 MaterialIndex)
+{
+	if (!IsValid(Component) || MaterialIndex < 0 || MaterialIndex >= Component->GetNumMaterials())
+	{
+		return nullptr;
+	}
+	UMaterialInterface* CurrentMaterial = Component->GetMaterial(MaterialIndex);
+	if (CurrentMaterial == nullptr)
+	{
+		return nullptr;
+	}
+
+	TArray<FMaterialSlot>* Slots = ComponentMaterials.Find(Component);
+	if (Slots == nullptr)
+	{
+		// components that went away since the last new one are dropped here
+		for (auto It = ComponentMaterials.CreateIterator(); It; ++It)
+		{
+			if (!It->Key.IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		Slots = &ComponentMaterials.Add(Component);
+	}
+	if (!Slots->IsValidIndex(MaterialIndex))
+	{
+		Slots->SetNum(MaterialIndex + 1);
+	}
+
+	FMaterialSlot& Slot = (*Slots)[MaterialIndex];
+	// first use, or the slot's material was swapped since; what was cached belongs to the old one
+	if (Slot.Material.Get() != CurrentMaterial)
+	{
+		Slot.Scalars.Reset();
+		Slot.Vectors.Reset();
+		UMaterialInstanceDynamic* DynamicMaterial = Cast<UMaterialInstanceDynamic>(CurrentMaterial);
+		if (DynamicMaterial == nullptr)
+		{
+			DynamicMaterial = Component->CreateAndSetMaterialInstanceDynamic(MaterialIndex);
+		}
+		Slot.Material = DynamicMaterial;
+	}
+	return Slot.Material.IsValid() ? &Slot : nullptr;
+}
+
+void UMaterialParameterCache::WriteScalar(FMaterialSlot& Slot, FName ParameterName, float Value, bool bForce)
+{
+	TCachedParameter<float>* Parameter = Slot.Scalars.FindByPredicate(
+		[ParameterName](const TCachedParameter<float>& Cached) { return Cached.Name == ParameterName; });
+	if (Parameter == nullptr)
+	{
+		Parameter = &Slot.Scalars.Add_GetRef({ ParameterName, INDEX_NONE, Value });
+	}
+	else if (!bForce && Parameter->Value == Value)
+	{
+		return;
+	}
+	Parameter->Value = Value;
+
+	UMaterialInstanceDynamic* DynamicMaterial = Slot.Material.Get();
+	if (Parameter->Index == INDEX_NONE || !DynamicMaterial->SetScalarParameterByIndex(Parameter->Index, Value))
+	{
+		DynamicMaterial->InitializeScalarParameterAndGetIndex(ParameterName, Value, Parameter->Index);
+	}
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_MaterialParameterWrites, EHandsTrainCounter::MaterialParameterWrites, 1);
+}
+
+void UMaterialParameterCache::WriteVector(FMaterialSlot& Slot, FName ParameterName, const FLinearColor& Value,
+	bool bForce)
+{
+	TCachedParameter<FLinearColor>* Parameter = Slot.Vectors.FindByPredicate(
+		[ParameterName](const TCachedParameter<FLinearColor>& Cached) { return Cached.Name == ParameterName; });
+	if (Parameter == nullptr)
+	{
+		Parameter = &Slot.Vectors.Add_GetRef({ ParameterName, INDEX_NONE, Value });
+	}
+	else if (!bForce && Parameter->Value == Value)
+	{
+		return;
+	}
+	Parameter->Value = Value;
+
+	UMaterialInstanceDynamic* DynamicMaterial = Slot.Material.Get();
+	if (Parameter->Index == INDEX_NONE || !DynamicMaterial->SetVectorParameterByIndex(Parameter->Index, Value))
+	{
+		DynamicMaterial->InitializeVectorParameterAndGetIndex(ParameterName, Value, Parameter->Index);
+	}
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_MaterialParameterWrites, EHandsTrainCounter::MaterialParameterWrites, 1);
+}
@@ -0,0 +1,76 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MaterialParameterCache.generated.h"
+
+class UMaterialInstanceDynamic;
+class UPrimitiveComponent;
+
+/**
+ * Sets material parameters on components through dynamic material
+ * instances that are created once per material slot. Remembers the last
+ * value written to each parameter and skips writes that wouldn't change
+ * it; the parameter's index in the instance is cached so changed values
+ * don't search the instance's parameters by name again.
+ * Values set on the materials by anything else aren't seen, so callers
+ * that know the material may have been changed behind its back pass
+ * bForce.
+ */
+UCLASS()
+class HANDSTRAINSAMPLE_API UMaterialParameterCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/**
+	 * Returns the dynamic instance in the component's material slot, making
+	 * one the first time. Null if the slot has no material.
+	 */
+	UMaterialInstanceDynamic* GetDynamicMaterial(UPrimitiveComponent* Component, int32 MaterialIndex);
+
+	/** Sets the parameter on every material of the component. */
+	void SetScalarParameter(UPrimitiveComponent* Component, FName ParameterName, float Value,
+		bool bForce = false);
+	void SetVectorParameter(UPrimitiveComponent* Component, FName ParameterName, const FLinearColor& Value,
+		bool bForce = false);
+
+	/** Sets the parameter on one of the component's materials. */
+	void SetVectorParameter(UPrimitiveComponent* Component, int32 MaterialIndex, FName ParameterName,
+		const FLinearColor& Value, bool bForce = false);
+
+	void ForgetComponent(UPrimitiveComponent* Component);
+
+private:
+	template <typename ValueType>
+	struct TCachedParameter
+	{
+		FName Name;
+		// INDEX_NONE until the instance has been asked for it
+		int32 Index;
+		ValueType Value;
+	};
+
+	struct FMaterialSlot
+	{
+		TWeakObjectPtr<UMaterialInstanceDynamic> Material;
+		TArray<TCachedParameter<float>> Scalars;
+		TArray<TCachedParameter<FLinearColor>> Vectors;
+	};
+
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, TArray<FMaterialSlot>> ComponentMaterials;
+
+	FMaterialSlot* FindOrCreateSlot(UPrimitiveComponent* Component, int32 MaterialIndex);
+	void WriteScalar(FMaterialSlot& Slot, FName ParameterName, float Value, bool bForce);
+	void WriteVector(FMaterialSlot& Slot, FName ParameterName, const FLinearColor& Value, bool bForce);
+};
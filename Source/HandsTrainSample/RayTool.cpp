@@ -13,6 +13,8 @@ LICENSE file in the root directory of this source tree.
 #include "OculusXRInputFunctionLibrary.h"
 #include "RayToolViewHelper.h"
 #include "ColliderZone.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainStats.h"
 #include "Kismet/GameplayStatics.h"
 #include "Components/InstancedStaticMeshComponent.h"
 #include <cmath>
@@ -21,6 +23,7 @@ LICENSE file in the root directory of this source tree.
 
 const float ARayTool::MinimumRaycastDistance = 80.0f;
 const float ARayTool::ColliderRadius = 1.0f;
+const float ARayTool::MaxPrimaryRaycastDistance = 10000.0f;
 
 ARayTool::ARayTool()
 {
@@ -44,7 +47,14 @@ ARayTool::ARayTool()
 
 	ConeAngleDegrees = 20.0f;
 	FarFieldMaxDistance = 500.0f;
+	bUseSpatialIndex = true;
+	bUseFirstHitRaycast = true;
+	bLimitPrimaryRaycastToFarField = false;
 	bIsInitialized = false;
+	LastInputState = EToolInputState::Inactive;
+	InputChangeStamp = 0;
+	HandInput = nullptr;
+	SpatialIndex = nullptr;
 }
 
 EInteractableToolTags ARayTool::GetToolTags_Implementation()
@@ -62,6 +72,14 @@ void ARayTool::BeginPlay()
 	 * focus an object then release it over and over again.
 	 */
 	ConeAngleReleaseDegrees = ConeAngleDegrees * 1.2f;
+	ConeDotThreshold = FMath::Cos(FMath::DegreesToRadians(ConeAngleDegrees));
+	ConeReleaseDotThreshold = FMath::Cos(FMath::DegreesToRadians(ConeAngleReleaseDegrees));
+	// cone extends from center line, where angle is split between
+	// top and bottom half
+	ConeRadius = FMath::Tan(FMath::DegreesToRadians(ConeAngleDegrees * 0.5f)) * FarFieldMaxDistance;
+
+	HandInput = GetWorld()->GetSubsystem<UHandInputSubsystem>();
+	SpatialIndex = bUseSpatialIndex ? GetWorld()->GetSubsystem<UInteractableSpatialIndex>() : nullptr;
 }
 
 void ARayTool::Initialize_Implementation(UOculusXRHandComponent* HandComponent)
@@ -69,10 +87,6 @@ void ARayTool::Initialize_Implementation(UOculusXRHandComponent* HandComponent)
 	Hand = HandComponent;
 	RayToolViewHelperComp->Initialize(this, TargetMesh, RayMesh);
 	bIsInitialized = true;
-
-	EnableInput(GetWorld()->GetFirstPlayerController());
-
-	InputComponent->BindAxis(IsRightHandedTool ? FName(TEXT("OculusRHandIndexPinchStrength")) : FName(TEXT("OculusLHandIndexPinchStrength")));
 }
 
 void ARayTool::SetVisualEnableState_Implementation(bool NewVisualEnableState)
@@ -107,14 +121,18 @@ void ARayTool::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (!IsValid(Hand) || !bIsInitialized || !UOculusXRInputFunctionLibrary::IsPointerPoseValid(Hand->SkeletonType))
+	if (!IsValid(Hand) || !bIsInitialized || HandInput == nullptr)
+	{
+		return;
+	}
+	const FHandInputState& HandState = HandInput->GetHandState(Hand->SkeletonType);
+	if (!HandState.bPointerPoseValid)
 	{
 		return;
 	}
 
 	Hand->SetRenderCustomDepth(true);
-	FTransform PointerPoseTransform =
-		UOculusXRInputFunctionLibrary::GetPointerPose(Hand->SkeletonType);
+	const FTransform& PointerPoseTransform = HandState.PointerPose;
 	FVector CurrentPosition = PointerPoseTransform.GetLocation();
 	APawn* MainPawn = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
 	CurrentPosition += MainPawn->GetActorLocation();
@@ -124,14 +142,20 @@ void ARayTool::Tick(float DeltaTime)
 	auto PrevPosition = InteractionPosition;
 	CalculatedToolVelocity = (CurrentPosition - PrevPosition) / DeltaTime;
 	InteractionPosition = CurrentPosition;
-	float PinchStrength = GetInputAxisValue(IsRightHandedTool ? FName(TEXT("OculusRHandIndexPinchStrength")) : FName(TEXT("OculusLHandIndexPinchStrength")));
-
-	CurrPinchState.UpdateState(PinchStrength, FocusedInteractable, IsRightHandedTool);
+	PredictedInteractionPosition = CurrentPosition;
+	CurrPinchState.UpdateState(HandState.PinchStrength, FocusedInteractable, IsRightHandedTool);
+	EToolInputState InputState = GetCurrInputState();
+	if (InputState != LastInputState)
+	{
+		LastInputState = InputState;
+		InputChangeStamp++;
+	}
 	RayToolViewHelperComp->SetToolActiveState(CurrPinchState.PinchSteadyOnFocusedObject() || CurrPinchState.PinchDownOnFocusedObject());
 }
 
 void ARayTool::RefreshCurrentIntersectingObjects_Implementation()
 {
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_RayToolRefresh, EHandsTrainTimer::RayToolRefresh);
 	if (!bIsInitialized)
 	{
 		return;
@@ -147,31 +171,20 @@ void ARayTool::RefreshCurrentIntersectingObjects_Implementation()
 	// Find target interactable if we haven't found one before
 	if (!IsValid(CurrInteractableRaycastedAgainst))
 	{
-		CurrentIntersectingObjects.Empty();
+		CurrentIntersectingObjects.Reset();
 		CurrInteractableRaycastedAgainst = FindTargetInteractable();
 
 		// Found one? Query collision zones.
 		if (IsValid(CurrInteractableRaycastedAgainst))
 		{
 			auto TargetHitPoint = CurrInteractableRaycastedAgainst->GetActorLocation();
-			UWorld* TheWorld = this->GetWorld();
-			TArray<FOverlapResult> SphereOverlapResults;
-			FCollisionShape SphereShape = FCollisionShape::MakeSphere(ColliderRadius);
-
-			// See DefaultEngine.ini for a mapping between this enum and the custom
-			// traces set up in Project Settings->Engine->Collision
-			TheWorld->OverlapMultiByChannel(SphereOverlapResults,
-				TargetHitPoint,
-				GetActorRotation().Quaternion(),
-				ECollisionChannel::ECC_GameTraceChannel1,
-				SphereShape);
+			OverlapZones(TargetHitPoint, GetActorRotation().Quaternion(),
+				FCollisionShape::MakeSphere(ColliderRadius), MAX_uint32);
 
 			// Find all components encountered and focus only one the ones
 			// belonging to the targe telement
-			for (auto& CurrentOverlap : SphereOverlapResults)
+			for (UColliderZone* HitColliderZone : QueriedZones)
 			{
-				UColliderZone* HitColliderZone =
-					Cast<UColliderZone>(CurrentOverlap.Component.Get());
 				if (!IsValid(HitColliderZone))
 				{
 					continue;
@@ -210,6 +223,16 @@ void ARayTool::DeFocus_Implementation()
 	this->FocusedInteractable = nullptr;
 }
 
+FBox ARayTool::GetQueryBounds() const
+{
+	// covers the primary ray and the cone test box around it
+	FVector RayOrigin = GetActorLocation() + MinimumRaycastDistance * GetActorForwardVector();
+	float MaxDistance = bLimitPrimaryRaycastToFarField ? FarFieldMaxDistance : MaxPrimaryRaycastDistance;
+	FBox QueryBounds(RayOrigin, RayOrigin);
+	QueryBounds += RayOrigin + GetActorForwardVector() * FMath::Max(MaxDistance, FarFieldMaxDistance);
+	return QueryBounds.ExpandBy(ConeRadius * UE_SQRT_2);
+}
+
 FVector ARayTool::GetRaycastOrigin()
 {
 	return GetActorLocation() + MinimumRaycastDistance * GetActorForwardVector();
@@ -219,8 +242,6 @@ bool ARayTool::HasRayReleasedInteractable(AInteractable* NewFocusedInteractable)
 {
 	auto ToolPosition = GetActorLocation();
 	auto ToolForwardDirection = GetActorForwardVector();
-	float HysteresisDotThreshold = cos(FMath::DegreesToRadians(
-		ConeAngleReleaseDegrees));
 	auto VectorToFocusedObject = NewFocusedInteractable->GetActorLocation()
 		- ToolPosition;
 	VectorToFocusedObject.Normalize();
@@ -229,7 +250,7 @@ bool ARayTool::HasRayReleasedInteractable(AInteractable* NewFocusedInteractable)
 		ToolForwardDirection);
 	// If dot product is smaller, that we are getting closer to perpendicular
 	// So that means that angle has become too large.
-	return DotProdLineOfSight < HysteresisDotThreshold;
+	return DotProdLineOfSight < ConeReleaseDotThreshold;
 }
 
 AInteractable* ARayTool::FindTargetInteractable()
@@ -256,20 +277,45 @@ AInteractable* ARayTool::FindTargetInteractable()
 
 AInteractable* ARayTool::FindPrimaryRaycastHit(FVector RayOrigin, FVector RayDirection)
 {
-	AInteractable* InteractableCastedAgainst = nullptr;
-	UWorld* TheWorld = this->GetWorld();
-	TArray<FHitResult> Hits;
+	float MaxDistance = bLimitPrimaryRaycastToFarField ? FarFieldMaxDistance : MaxPrimaryRaycastDistance;
+	if (bUseFirstHitRaycast)
+	{
+		return FindFirstRaycastHit(RayOrigin, RayDirection, MaxDistance);
+	}
 
-	// See DefaultEngine.ini for a mapping between this enum and the custom
-	// traces set up in Project Settings->Engine->Collision
-	TheWorld->LineTraceMultiByChannel(Hits, RayOrigin,
-		RayOrigin + RayDirection * 10000.0f,
-		ECollisionChannel::ECC_GameTraceChannel1);
+	AInteractable* InteractableCastedAgainst = nullptr;
+	QueriedZones.Reset();
+	if (SpatialIndex != nullptr)
+	{
+		ZoneHits.Reset();
+		SpatialIndex->Raycast(RayOrigin, RayDirection, MaxDistance, (uint32)GetToolTags(), ZoneHits);
+		for (const FInteractableZoneHit& ZoneHit : ZoneHits)
+		{
+			QueriedZones.Add(ZoneHit.Zone);
+		}
+	}
+	else
+	{
+		UWorld* TheWorld = this->GetWorld();
+		TArray<FHitResult> Hits;
+
+		// See DefaultEngine.ini for a mapping between this enum and the custom
+		// traces set up in Project Settings->Engine->Collision
+		HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_OverlapQueries, EHandsTrainCounter::OverlapQueries, 1);
+		TheWorld->LineTraceMultiByChannel(Hits, RayOrigin,
+			RayOrigin + RayDirection * MaxDistance,
+			ECollisionChannel::ECC_GameTraceChannel1);
+		for (auto& CurrentHit : Hits)
+		{
+			QueriedZones.Add(Cast<UColliderZone>(CurrentHit.Component.Get()));
+		}
+	}
 
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_RaycastHitsExamined, EHandsTrainCounter::RaycastHitsExamined,
+		QueriedZones.Num());
 	float MinDistance = 0.0f;
-	for (auto& CurrentHit : Hits)
+	for (UColliderZone* HitColliderZone : QueriedZones)
 	{
-		UColliderZone* HitColliderZone = Cast<UColliderZone>(CurrentHit.Component.Get());
 		if (!IsValid(HitColliderZone))
 		{
 			continue;
@@ -295,64 +341,113 @@ AInteractable* ARayTool::FindPrimaryRaycastHit(FVector RayOrigin, FVector RayDir
 	return InteractableCastedAgainst;
 }
 
-AInteractable* ARayTool::FindInteractableViaConeTest(FVector RayOrigin,
-	FVector RayDirection)
+AInteractable* ARayTool::FindFirstRaycastHit(const FVector& RayOrigin, const FVector& RayDirection,
+	float MaxDistance)
 {
-	AInteractable* TargetInteractable = nullptr;
+	int32 ToolTagsMask = (int)GetToolTags();
+	if (SpatialIndex != nullptr)
+	{
+		FInteractableZoneHit ZoneHit;
+		int32 NumExamined = 0;
+		bool bHit = SpatialIndex->RaycastFirst(RayOrigin, RayDirection, MaxDistance, (uint32)ToolTagsMask,
+			ZoneHit, NumExamined);
+		HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_RaycastHitsExamined, EHandsTrainCounter::RaycastHitsExamined,
+			NumExamined);
+		return bHit ? ZoneHit.Zone->ParentInteractable : nullptr;
+	}
 
-	float MinDistance = 0.0f;
-	float MinDotProductThreshold = cos(FMath::DegreesToRadians(
-		ConeAngleDegrees));
-	// cone extends from center line, where angle is split between
-	// top and bottom half
-	float HalfAngle = FMath::DegreesToRadians(ConeAngleDegrees * 0.5f);
-	float ConeRadius = tan(HalfAngle) * FarFieldMaxDistance;
+	// Physics traces can't filter on a zone's interactable, and zones may only
+	// overlap the channel, so take every hit but stop at the first one that
+	// passes. Hits come back sorted by distance.
+	TArray<FHitResult> Hits;
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_OverlapQueries, EHandsTrainCounter::OverlapQueries, 1);
+	GetWorld()->LineTraceMultiByChannel(Hits, RayOrigin, RayOrigin + RayDirection * MaxDistance,
+		ECollisionChannel::ECC_GameTraceChannel1);
 
-	UWorld* TheWorld = this->GetWorld();
-	TArray<FOverlapResult> Results;
+	AInteractable* FirstInteractable = nullptr;
+	int32 NumExamined = 0;
+	for (const FHitResult& Hit : Hits)
+	{
+		NumExamined++;
+		UColliderZone* HitColliderZone = Cast<UColliderZone>(Hit.Component.Get());
+		if (!IsValid(HitColliderZone))
+		{
+			continue;
+		}
+		AInteractable* CurrInteractable = HitColliderZone->ParentInteractable;
+		if (IsValid(CurrInteractable) && (CurrInteractable->GetValidToolTagsMask() & ToolTagsMask) != 0)
+		{
+			FirstInteractable = CurrInteractable;
+			break;
+		}
+	}
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_RaycastHitsExamined, EHandsTrainCounter::RaycastHitsExamined,
+		NumExamined);
+	return FirstInteractable;
+}
+
+AInteractable* ARayTool::FindInteractableViaConeTest(FVector RayOrigin,
+	FVector RayDirection)
+{
 	FCollisionShape BoxShape = FCollisionShape::MakeBox(
 		FVector(FarFieldMaxDistance * 0.5,
 			ConeRadius, ConeRadius));
+	OverlapZones(RayOrigin + RayDirection * FarFieldMaxDistance * 0.5f, // center
+		GetActorRotation().Quaternion(), BoxShape, (uint32)GetToolTags());
 
-	// See DefaultEngine.ini for a mapping between this enum and the custom
-	// traces set up in Project Settings->Engine->Collision
-	TheWorld->OverlapMultiByChannel(Results,
-		RayOrigin + RayDirection * FarFieldMaxDistance * 0.5f, // center
-		GetActorRotation().Quaternion(),
-		ECollisionChannel::ECC_GameTraceChannel1,
-		BoxShape);
-
-	for (auto& Result : Results)
+	// interactables with several zones are added once per zone;
+	// the copies tie, so the result doesn't change
+	ConeCandidates.Reset();
+	for (UColliderZone* HitColliderZone : QueriedZones)
 	{
-		UColliderZone* HitColliderZone = Cast<UColliderZone>(Result.Component.Get());
 		if (!IsValid(HitColliderZone))
 		{
 			continue;
 		}
 
 		AInteractable* InteractableComponent = HitColliderZone->ParentInteractable;
-		if (!IsValid(InteractableComponent) || (InteractableComponent->GetValidToolTagsMask() & (int)GetToolTags()) == 0)
+		if (!IsValid(InteractableComponent))
 		{
 			continue;
 		}
+		ConeCandidates.Add(InteractableComponent, InteractableComponent->GetActorLocation(),
+			(uint32)InteractableComponent->GetValidToolTagsMask());
+	}
+
+	int32 NearestIndex = ConeCandidates.FindNearestInCone(RayOrigin, RayDirection, ConeDotThreshold,
+		(uint32)GetToolTags());
+	if (NearestIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+	return ConeCandidates.GetInteractable(NearestIndex);
+}
 
-		auto VectorToInteractable = InteractableComponent->GetActorLocation()
-			- RayOrigin;
-		auto DistanceToInteractable = VectorToInteractable.Size();
-		VectorToInteractable /= DistanceToInteractable;
-		float DotProduct = FVector::DotProduct(VectorToInteractable, RayDirection);
-		// Must be inside cone. Bail if too small.
-		if (DotProduct < MinDotProductThreshold)
+void ARayTool::OverlapZones(const FVector& Center, const FQuat& Rotation, const FCollisionShape& Shape,
+	uint32 ToolTagsMask)
+{
+	QueriedZones.Reset();
+	if (SpatialIndex != nullptr)
+	{
+		if (Shape.IsSphere())
 		{
-			continue;
+			SpatialIndex->OverlapSphere(Center, Shape.GetSphereRadius(), ToolTagsMask, QueriedZones);
 		}
-
-		if (TargetInteractable == nullptr || DistanceToInteractable < MinDistance)
+		else
 		{
-			TargetInteractable = InteractableComponent;
-			MinDistance = DistanceToInteractable;
+			SpatialIndex->OverlapBox(Center, Rotation, Shape.GetBox(), ToolTagsMask, QueriedZones);
 		}
+		return;
 	}
 
-	return TargetInteractable;
+	// See DefaultEngine.ini for a mapping between this enum and the custom
+	// traces set up in Project Settings->Engine->Collision
+	TArray<FOverlapResult> Results;
+	HANDSTRAIN_INC_COUNTER(STAT_HandsTrain_OverlapQueries, EHandsTrainCounter::OverlapQueries, 1);
+	GetWorld()->OverlapMultiByChannel(Results, Center, Rotation,
+		ECollisionChannel::ECC_GameTraceChannel1, Shape);
+	for (auto& Result : Results)
+	{
+		QueriedZones.Add(Cast<UColliderZone>(Result.Component.Get()));
+	}
 }
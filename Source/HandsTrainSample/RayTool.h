@@ -10,10 +10,14 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "InteractableTool.h"
+#include "InteractableConeCandidates.h"
+#include "InteractableSpatialIndex.h"
 #include "PinchStateModule.h"
 #include "RayTool.generated.h"
 
 class AInteractable;
+class UColliderZone;
+class UHandInputSubsystem;
 class UOculusXRHandComponent;
 class USplineMeshComponent;
 class URayToolViewHelper;
@@ -49,6 +53,13 @@ public:
 
 	virtual void DeFocus_Implementation() override;
 
+	virtual uint32 GetInputChangeStamp() const override
+	{
+		return InputChangeStamp;
+	}
+
+	virtual FBox GetQueryBounds() const override;
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -72,6 +83,18 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ranges")
 	float FarFieldMaxDistance;
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranges",
+		meta = (Tooltip = "Find zones through the interactable spatial index instead of physics queries"))
+	bool bUseSpatialIndex;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranges",
+		meta = (Tooltip = "Target the interactable of the nearest zone the primary ray hits, instead of ranking every hit by actor distance"))
+	bool bUseFirstHitRaycast;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Ranges",
+		meta = (Tooltip = "Limit the primary ray to FarFieldMaxDistance"))
+	bool bLimitPrimaryRaycastToFarField;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	AInteractable* FocusedInteractable;
 
@@ -121,11 +144,35 @@ protected:
 private:
 	const static float MinimumRaycastDistance;
 	const static float ColliderRadius;
+	const static float MaxPrimaryRaycastDistance;
 	const static uint32 NumMaxPrimaryHits = 10;
 	const static uint32 NumMaxSecondaryHits = 25;
 	const static uint32 NumCollidersToTest = 20;
 
 	bool bIsInitialized;
 	float ConeAngleReleaseDegrees;
+	// cone constants, cached at BeginPlay
+	float ConeDotThreshold;
+	float ConeReleaseDotThreshold;
+	float ConeRadius;
 	PinchStateModule CurrPinchState;
+	EToolInputState LastInputState;
+	uint32 InputChangeStamp;
+
+	UHandInputSubsystem* HandInput;
+
+	// null if zones are found through physics queries
+	UPROPERTY()
+	UInteractableSpatialIndex* SpatialIndex;
+	// zones found by the latest query, kept to reuse their memory
+	TArray<UColliderZone*> QueriedZones;
+	TArray<FInteractableZoneHit> ZoneHits;
+	FInteractableConeCandidates ConeCandidates;
+
+	/** Interactable of the nearest zone hit that supports this tool, if any. */
+	AInteractable* FindFirstRaycastHit(const FVector& RayOrigin, const FVector& RayDirection, float MaxDistance);
+
+	/** Zones overlapping a sphere or box, from the spatial index or physics. */
+	void OverlapZones(const FVector& Center, const FQuat& Rotation, const FCollisionShape& Shape,
+		uint32 ToolTagsMask);
 };
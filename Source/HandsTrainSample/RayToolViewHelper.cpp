@@ -12,15 +12,17 @@ LICENSE file in the root directory of this source tree.
 #include "Components/SplineMeshComponent.h"
 #include "Math/UnrealMathUtility.h"
 #include "InteractableTool.h"
+#include "HandsTrainStats.h"
 #include "Interactable.h"
+#include "MaterialParameterCache.h"
 #include "Kismet/GameplayStatics.h"
-#include "Kismet/KismetMathLibrary.h"
 
 const float URayToolViewHelper::DefaultRayCastDistance = 300.0f;
 const FName URayToolViewHelper::ColorPropertyName = "TintColor";
 const FName URayToolViewHelper::OpacityPropertName = "Opacity";
 // convert to CM (1 scale unit = 100 cm for plane mesh)
 const float URayToolViewHelper::RayScaleFactor = 0.01f;
+const int32 URayToolViewHelper::MinRaySegments = 4;
 
 URayToolViewHelper::URayToolViewHelper()
 {
@@ -28,6 +30,10 @@ URayToolViewHelper::URayToolViewHelper()
 
 	NormalColor = FColor(197, 197, 197, 255);
 	HighlightColor = FColor(230, 230, 230, 255);
+	// the default ray length gets every segment
+	RaySegmentLength = DefaultRayCastDistance / (NumRayLinePositions - 1);
+	NumActiveSegments = 0;
+	ParameterCache = nullptr;
 }
 
 void URayToolViewHelper::BeginPlay()
@@ -61,66 +67,82 @@ void URayToolViewHelper::TickComponent(float DeltaTime, ELevelTick TickType, FAc
 void URayToolViewHelper::UpdateRayMesh(FVector ToolPosition, FVector ToolForward,
 	FVector TargetPosition, float TargetDistance)
 {
-	auto P0 = ToolPosition;
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_RayMeshUpdate, EHandsTrainTimer::RayMeshUpdate);
+	const int32 MaxSegments = RayMeshSegmentTransforms.Num();
+	if (MaxSegments == 0)
+	{
+		return;
+	}
+	int32 NumSegments = FMath::Min(FMath::Max(FMath::CeilToInt(TargetDistance / RaySegmentLength), MinRaySegments),
+		MaxSegments);
+	if (NumSegments != NumActiveSegments)
+	{
+		BuildBezierTables(NumSegments);
+	}
+
 	// make points in between based on my forward as opposed to targetvector
 	// this way the curve "bends" toward to target
-	auto P1 = ToolPosition + ToolForward * TargetDistance * 0.3333333f;
-	auto P2 = ToolPosition + ToolForward * TargetDistance * 0.6666667f;
-	auto P3 = TargetPosition;
+	const FVector P1 = ToolPosition + ToolForward * TargetDistance * 0.3333333f;
+	const FVector P2 = ToolPosition + ToolForward * TargetDistance * 0.6666667f;
+	// the points are the 3x4 matrix of control points times the 4xN weight table
+	const FVector4 ControlPointsX(ToolPosition.X, P1.X, P2.X, TargetPosition.X);
+	const FVector4 ControlPointsY(ToolPosition.Y, P1.Y, P2.Y, TargetPosition.Y);
+	const FVector4 ControlPointsZ(ToolPosition.Z, P1.Z, P2.Z, TargetPosition.Z);
+	for (int32 PointIndex = 0; PointIndex <= NumSegments; PointIndex++)
+	{
+		const FVector4& Weights = PointWeights[PointIndex];
+		RayPositions[PointIndex] = FVector(Dot4(ControlPointsX, Weights), Dot4(ControlPointsY, Weights),
+			Dot4(ControlPointsZ, Weights));
+	}
 
 	auto InstanceWorldToLocal = RayMesh->GetComponentTransform().Inverse();
-	for (uint32 PntIndex = 0; PntIndex < NumRayLinePositions; PntIndex++)
+	for (int32 SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
 	{
-		FVector CurrentRayPoint = GetPointOnBezierCurve(P0, P1, P2, P3, (float)PntIndex / 25.0f);
-
-		RayPositions[PntIndex] = CurrentRayPoint;
-		// segment index at second point
-		if (PntIndex >= 1)
+		const FVector& SegmentStart = RayPositions[SegmentIndex];
+		const FVector& SegmentEnd = RayPositions[SegmentIndex + 1];
+		FVector SegmentVector = SegmentEnd - SegmentStart;
+		float SegmentSize = SegmentVector.Size();
+		FVector AveragePosition = (SegmentStart + SegmentEnd) * 0.5f;
+
+		// along the chord, so neighbouring segments meet at their shared point
+		FVector SegmentForward = SegmentSize > UE_SMALL_NUMBER ? SegmentVector / SegmentSize : ToolForward;
+		// Segment uses default up. If up is nearly parallel with forward, use world forward instead
+		FVector SegmentWorldUp = FVector::UpVector;
+		if (fabs(SegmentForward.Z - 1.0f) < 0.00001f)
 		{
-			uint32 SegmentIndex = PntIndex - 1;
-			FVector const& RayPointBefore = RayPositions[SegmentIndex];
-			FTransform& SegmentTransform = RayMeshSegmentTransforms[SegmentIndex];
-
-			FVector SegmentVector = CurrentRayPoint - RayPointBefore;
-			float SegmentSize = SegmentVector.Size();
-
-			FVector SegmentLocalScale(SegmentSize * RayScaleFactor,
-				0.2f * RayScaleFactor, 0.2f * RayScaleFactor);
-			FVector AveragePosition = (RayPointBefore + CurrentRayPoint) * 0.5f;
-			FVector SegmentLocalPosition(InstanceWorldToLocal.TransformPosition(AveragePosition));
-
-			SegmentVector /= SegmentSize;
-			// Segment uses default up
-			FVector SegmentWorldUp(0.0f, 0.0f, 1.0f);
-			SegmentWorldUp.Normalize();
-			// If up is nearly parallel/anti-parallel with forward, use worl forward instead
-			if (fabs(FVector::DotProduct(SegmentVector, SegmentWorldUp) - 1.0f)
-				< 0.00001f)
-			{
-				SegmentWorldUp = FVector(1.0f, 0.0f, 0.0f);
-			}
+			SegmentWorldUp = FVector::ForwardVector;
+		}
+		FQuat SegmentWorldRotation = FRotationMatrix::MakeFromXZ(SegmentForward, SegmentWorldUp).ToQuat();
 
-			FQuat SegmentWorldRotation = UKismetMathLibrary::MakeRotFromXZ(
-				SegmentVector, SegmentWorldUp)
-											 .Quaternion();
-			FQuat SegmentLocalRotation = InstanceWorldToLocal.TransformRotation(
-				SegmentWorldRotation);
+		RayMeshSegmentTransforms[SegmentIndex].SetComponents(
+			InstanceWorldToLocal.TransformRotation(SegmentWorldRotation),
+			InstanceWorldToLocal.TransformPosition(AveragePosition),
+			FVector(SegmentSize * RayScaleFactor, 0.2f * RayScaleFactor, 0.2f * RayScaleFactor));
+	}
 
-			SegmentTransform.SetComponents(SegmentLocalRotation, SegmentLocalPosition,
-				SegmentLocalScale);
-		}
+	// segments a short ray doesn't need are collapsed at its end
+	FVector LocalTargetPosition = InstanceWorldToLocal.TransformPosition(TargetPosition);
+	for (int32 SegmentIndex = NumSegments; SegmentIndex < MaxSegments; SegmentIndex++)
+	{
+		RayPositions[SegmentIndex + 1] = TargetPosition;
+		RayMeshSegmentTransforms[SegmentIndex].SetComponents(FQuat::Identity, LocalTargetPosition, FVector::ZeroVector);
 	}
-	RayMesh->BatchUpdateInstancesTransforms(0, RayMeshSegmentTransforms, false, true);
+
+	RayMeshUploader.Upload(RayMesh, RayMeshSegmentTransforms);
 }
 
-FVector URayToolViewHelper::GetPointOnBezierCurve(FVector P0, FVector P1, FVector P2,
-	FVector P3, float T)
+void URayToolViewHelper::BuildBezierTables(int32 NumSegments)
 {
-	T = FMath::Clamp(T, 0.0f, 1.0f);
-	float OneMinusT = 1.0f - T;
-	float OneMinusTSqr = OneMinusT * OneMinusT;
-	float TSqr = T * T;
-	return OneMinusT * OneMinusTSqr * P0 + 3.0f * OneMinusTSqr * T * P1 + 3.0f * OneMinusT * TSqr * P2 + T * TSqr * P3;
+	NumActiveSegments = NumSegments;
+	PointWeights.SetNum(NumSegments + 1);
+
+	for (int32 PointIndex = 0; PointIndex <= NumSegments; PointIndex++)
+	{
+		float T = (float)PointIndex / NumSegments;
+		float OneMinusT = 1.0f - T;
+		PointWeights[PointIndex] = FVector4(OneMinusT * OneMinusT * OneMinusT, 3.0f * OneMinusT * OneMinusT * T,
+			3.0f * OneMinusT * T * T, T * T * T);
+	}
 }
 
 void URayToolViewHelper::Initialize(AInteractableTool* Tool,
@@ -130,13 +152,12 @@ void URayToolViewHelper::Initialize(AInteractableTool* Tool,
 	InteractableTool = Tool;
 	TargetMesh = NewTargetMesh;
 	RayMesh = NewRayMesh;
+	RayMeshUploader.Invalidate();
+	ParameterCache = GetWorld()->GetSubsystem<UMaterialParameterCache>();
 
 	if (IsValid(RayMesh))
 	{
-		RayMesh->SetVectorParameterValueOnMaterials(ColorPropertyName,
-			FVector((float)NormalColor.R / 255.0f, (float)NormalColor.G / 255.0f, (float)NormalColor.B / 255.0f));
-		RayMesh->SetScalarParameterValueOnMaterials(OpacityPropertName,
-			(float)NormalColor.A / 255.0f);
+		ApplyToolActiveColor();
 		FTransform StandardTransform(FQuat::Identity, FVector::ZeroVector,
 			FVector(0.01f, RayScaleFactor, 0.01f));
 		for (uint32 SegmentIndex = 0; SegmentIndex < NumRayLinePositions; SegmentIndex++)
@@ -179,12 +200,25 @@ bool URayToolViewHelper::GetToolActiveState()
 
 void URayToolViewHelper::SetToolActiveState(bool bNewActiveState)
 {
+	// called every tick by the ray tool; the colors only change with the state
+	if (bNewActiveState == bToolActivateState)
+	{
+		return;
+	}
 	bToolActivateState = bNewActiveState;
-	RayMesh->SetVectorParameterValueOnMaterials(ColorPropertyName,
-		bToolActivateState ? FVector(HighlightColor.R / 255.0f, HighlightColor.G / 255.0f, HighlightColor.B / 255.0f)
-						   : FVector(NormalColor.R / 255.0f, NormalColor.G / 255.0f, NormalColor.B / 255.0f));
-	RayMesh->SetScalarParameterValueOnMaterials(OpacityPropertName,
-		bToolActivateState ? HighlightColor.A / 255.0f : NormalColor.A / 255.0f);
+	ApplyToolActiveColor();
+}
+
+void URayToolViewHelper::ApplyToolActiveColor()
+{
+	if (!IsValid(RayMesh) || ParameterCache == nullptr)
+	{
+		return;
+	}
+	const FColor& Color = bToolActivateState ? HighlightColor : NormalColor;
+	ParameterCache->SetVectorParameter(RayMesh, ColorPropertyName,
+		FLinearColor(Color.R / 255.0f, Color.G / 255.0f, Color.B / 255.0f));
+	ParameterCache->SetScalarParameter(RayMesh, OpacityPropertName, Color.A / 255.0f);
 }
 
 void URayToolViewHelper::SetFocusedInteractable(AInteractable* NewFocusedInteractable)
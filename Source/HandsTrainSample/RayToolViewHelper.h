@@ -10,10 +10,12 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "Components/SceneComponent.h"
+#include "InstanceTransformUploader.h"
 #include "RayToolViewHelper.generated.h"
 
 class AInteractable;
 class AInteractableTool;
+class UMaterialParameterCache;
 
 /**
  * Modifies visual state of ray tool. Not quite the same as the Unity's
@@ -69,29 +71,37 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Visual")
 	TArray<FVector> RayPositions;
 
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Visual",
+		meta = (ClampMin = "1.0", ToolTip = "Rough length of a ray segment in cm; shorter rays are drawn with fewer segments."))
+	float RaySegmentLength;
+
 private:
 	const static float DefaultRayCastDistance;
 	const static FName ColorPropertyName;
 	const static FName OpacityPropertName;
 	const static uint32 NumRayLinePositions = 25;
+	const static int32 MinRaySegments;
 	const static float RayScaleFactor;
 
+	/**
+	 * Cubic Bernstein weights of the four control points at each point
+	 * along the ray, one column of the 4xN weight matrix per point.
+	 * Rebuilt only when the number of segments changes.
+	 */
+	TArray<FVector4> PointWeights;
+	int32 NumActiveSegments;
+
 	AInteractableTool* InteractableTool;
 	UStaticMeshComponent* TargetMesh;
 	UInstancedStaticMeshComponent* RayMesh;
+	FInstanceTransformUploader RayMeshUploader;
+	UMaterialParameterCache* ParameterCache;
+
+	void ApplyToolActiveColor();
 
 	void UpdateRayMesh(FVector ToolPosition, FVector ToolForward,
 		FVector TargetPosition, float TargetDistance);
 
-	/**
-	 * Returns point on four-point Bezier curve.
-	 * @param P0 - Beginning point.
-	 * @param P1 - t=1/3 point.
-	 * @param P2 - t=2/3 point.
-	 * @param P3 - End point.
-	 * @param T - Interpolation parameter.
-	 * @return Point along Bezier curve.
-	 */
-	FVector GetPointOnBezierCurve(FVector P0, FVector P1, FVector P2,
-		FVector P3, float T);
+	/** Spreads the points evenly in t, from the tool (t=0) to the target (t=1). */
+	void BuildBezierTables(int32 NumSegments);
 };
@@ -0,0 +1,205 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RingBufferVelocityEstimator.generated.h"
+
+UENUM(BlueprintType)
+enum class EVelocityEstimate : uint8
+{
+	// average of the per-frame velocities in the window
+	Mean,
+	// slope of a line fit to the positions in the window
+	LeastSquares,
+	// one euro filter on the positions; smooth when slow, responsive when fast
+	OneEuro,
+};
+
+/**
+ * Estimates the velocity of a tracked point from its last Capacity
+ * positions. Adding a sample is O(1): the mean keeps a running sum, and
+ * the one euro filter only keeps its previous state. The least squares
+ * fit is computed over the window when asked for. The one euro estimate is
+ * the velocity of the filtered position, whose cutoff rises with speed.
+ */
+template <int32 Capacity>
+class TRingBufferVelocityEstimator
+{
+	static_assert(Capacity >= 2, "Need at least two positions to estimate a velocity");
+
+public:
+	TRingBufferVelocityEstimator()
+		: Mode(EVelocityEstimate::Mean)
+		, OneEuroMinCutoff(1.0f)
+		, OneEuroBeta(0.5f)
+		, OneEuroDerivativeCutoff(1.0f)
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		NextIndex = 0;
+		NumPositions = 0;
+		NumVelocities = 0;
+		VelocitySum = FVector::ZeroVector;
+		Time = 0.0;
+		FilteredPosition = FVector::ZeroVector;
+		FilteredVelocity = FVector::ZeroVector;
+		SmoothedRawVelocity = FVector::ZeroVector;
+	}
+
+	void SetMode(EVelocityEstimate InMode)
+	{
+		Mode = InMode;
+	}
+
+	/**
+	 * @param MinCutoff - Cutoff frequency in Hz when the point is still; lower is smoother.
+	 * @param Beta - Hz added to the cutoff per cm/s of speed; higher lags less.
+	 * @param DerivativeCutoff - Cutoff frequency in Hz for the speed that raises the cutoff.
+	 */
+	void SetOneEuroParameters(float MinCutoff, float Beta, float DerivativeCutoff)
+	{
+		OneEuroMinCutoff = MinCutoff;
+		OneEuroBeta = Beta;
+		OneEuroDerivativeCutoff = DerivativeCutoff;
+	}
+
+	/** Adds the position for a frame. The first one only sets where the point starts. */
+	void AddSample(const FVector& Position, float DeltaTime)
+	{
+		if (NumPositions > 0 && DeltaTime <= 0.0f)
+		{
+			return;
+		}
+
+		if (NumPositions > 0)
+		{
+			const FVector& LastPosition = Positions[GetLatestIndex()];
+			FVector Velocity = (Position - LastPosition) / DeltaTime;
+			Time += DeltaTime;
+
+			// the velocity about to be overwritten leaves the running sum
+			if (NumVelocities == Capacity)
+			{
+				VelocitySum -= Velocities[NextIndex];
+			}
+			else
+			{
+				NumVelocities++;
+			}
+			Velocities[NextIndex] = Velocity;
+			VelocitySum += Velocity;
+
+			UpdateOneEuro(Position, DeltaTime);
+		}
+		else
+		{
+			FilteredPosition = Position;
+			FilteredVelocity = FVector::ZeroVector;
+			SmoothedRawVelocity = FVector::ZeroVector;
+		}
+
+		Positions[NextIndex] = Position;
+		Times[NextIndex] = Time;
+		NumPositions = FMath::Min(NumPositions + 1, Capacity);
+		NextIndex = (NextIndex + 1) % Capacity;
+	}
+
+	FVector GetVelocity() const
+	{
+		if (NumVelocities == 0)
+		{
+			return FVector::ZeroVector;
+		}
+		switch (Mode)
+		{
+			case EVelocityEstimate::LeastSquares:
+				return GetLeastSquaresVelocity();
+			case EVelocityEstimate::OneEuro:
+				return FilteredVelocity;
+			default:
+				return VelocitySum / NumVelocities;
+		}
+	}
+
+	int32 GetNumSamples() const
+	{
+		return NumPositions;
+	}
+
+private:
+	EVelocityEstimate Mode;
+	float OneEuroMinCutoff;
+	float OneEuroBeta;
+	float OneEuroDerivativeCutoff;
+
+	// Velocities[i] is the velocity from the position before Positions[i] to it
+	FVector Positions[Capacity];
+	double Times[Capacity];
+	FVector Velocities[Capacity];
+	int32 NextIndex;
+	int32 NumPositions;
+	int32 NumVelocities;
+	FVector VelocitySum;
+	double Time;
+
+	FVector FilteredPosition;
+	FVector FilteredVelocity;
+	// speed estimate that sets the position filter's cutoff
+	FVector SmoothedRawVelocity;
+
+	int32 GetLatestIndex() const
+	{
+		return (NextIndex + Capacity - 1) % Capacity;
+	}
+
+	static float GetSmoothingFactor(float Cutoff, float DeltaTime)
+	{
+		float TimeConstant = 1.0f / (2.0f * PI * Cutoff);
+		return 1.0f / (1.0f + TimeConstant / DeltaTime);
+	}
+
+	void UpdateOneEuro(const FVector& Position, float DeltaTime)
+	{
+		FVector RawVelocity = (Position - FilteredPosition) / DeltaTime;
+		SmoothedRawVelocity = FMath::Lerp(SmoothedRawVelocity, RawVelocity,
+			GetSmoothingFactor(OneEuroDerivativeCutoff, DeltaTime));
+		float Cutoff = OneEuroMinCutoff + OneEuroBeta * SmoothedRawVelocity.Size();
+		FVector NewFilteredPosition = FMath::Lerp(FilteredPosition, Position, GetSmoothingFactor(Cutoff, DeltaTime));
+		FilteredVelocity = (NewFilteredPosition - FilteredPosition) / DeltaTime;
+		FilteredPosition = NewFilteredPosition;
+	}
+
+	FVector GetLeastSquaresVelocity() const
+	{
+		// times are centered on their mean so the sums stay small
+		double MeanTime = 0.0;
+		FVector MeanPosition = FVector::ZeroVector;
+		for (int32 Index = 0; Index < NumPositions; Index++)
+		{
+			MeanTime += Times[Index];
+			MeanPosition += Positions[Index];
+		}
+		MeanTime /= NumPositions;
+		MeanPosition /= NumPositions;
+
+		double TimeVariance = 0.0;
+		FVector Covariance = FVector::ZeroVector;
+		for (int32 Index = 0; Index < NumPositions; Index++)
+		{
+			double CenteredTime = Times[Index] - MeanTime;
+			TimeVariance += CenteredTime * CenteredTime;
+			Covariance += (Positions[Index] - MeanPosition) * CenteredTime;
+		}
+		return TimeVariance > UE_DOUBLE_SMALL_NUMBER ? Covariance / TimeVariance : FVector::ZeroVector;
+	}
+};
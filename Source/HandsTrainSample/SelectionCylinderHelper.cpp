@@ -9,6 +9,7 @@ LICENSE file in the root directory of this source tree.
 #include "SelectionCylinderHelper.h"
 #include "Components/StaticMeshComponent.h"
 #include "Materials/MaterialInstanceDynamic.h"
+#include "MaterialParameterCache.h"
 
 const FName USelectionCylinderHelper::BaseMaterialName = FName("Base");
 const FName USelectionCylinderHelper::TintParamName = FName("TintColor");
@@ -16,12 +17,25 @@ const FName USelectionCylinderHelper::TintParamName = FName("TintColor");
 USelectionCylinderHelper::USelectionCylinderHelper()
 {
 	PrimaryComponentTick.bCanEverTick = false;
+	ParameterCache = nullptr;
 }
 
 void USelectionCylinderHelper::Initialize(UStaticMeshComponent* StaticMeshComponent)
 {
 	this->MeshComponent = StaticMeshComponent;
 	CurrSelectionState = ESelectionState::Off;
+	ParameterCache = GetWorld()->GetSubsystem<UMaterialParameterCache>();
+
+	IsBaseMaterial.Reset();
+	if (ParameterCache != nullptr && IsValid(MeshComponent))
+	{
+		FString BaseMaterialString = BaseMaterialName.ToString();
+		for (int32 MaterialIndex = 0; MaterialIndex < MeshComponent->GetNumMaterials(); ++MaterialIndex)
+		{
+			UMaterialInstanceDynamic* DynamicMaterial = ParameterCache->GetDynamicMaterial(MeshComponent, MaterialIndex);
+			IsBaseMaterial.Add(DynamicMaterial != nullptr && DynamicMaterial->GetName().Contains(BaseMaterialString));
+		}
+	}
 }
 
 ESelectionState USelectionCylinderHelper::GetSelectionState()
@@ -50,28 +64,14 @@ void USelectionCylinderHelper::SetSelectionState(ESelectionState SelectionState)
 
 void USelectionCylinderHelper::AffectSelectionColor(bool bIsSelectedState)
 {
-	const TArray<UMaterialInterface*> MaterialInterfaces = MeshComponent->GetMaterials();
-	for (int32 MaterialIndex = 0; MaterialIndex < MaterialInterfaces.Num(); ++MaterialIndex)
+	if (ParameterCache == nullptr)
 	{
-		UMaterialInterface* MaterialInterface = MaterialInterfaces[MaterialIndex];
-		if (MaterialInterface)
-		{
-			UMaterialInstanceDynamic* DynamicMaterial = Cast<UMaterialInstanceDynamic>(MaterialInterface);
-			if (!DynamicMaterial)
-			{
-				DynamicMaterial = MeshComponent->CreateAndSetMaterialInstanceDynamic(MaterialIndex);
-			}
-
-			if (DynamicMaterial->GetName().Contains(BaseMaterialName.ToString()))
-			{
-				DynamicMaterial->SetVectorParameterValue(
-					TintParamName, bIsSelectedState ? FVector(DefaultColorBase) : FVector(HighlightColorBase));
-			}
-			else
-			{
-				DynamicMaterial->SetVectorParameterValue(
-					TintParamName, bIsSelectedState ? FVector(DefaultColor) : FVector(HighlightColor));
-			}
-		}
+		return;
+	}
+	for (int32 MaterialIndex = 0; MaterialIndex < IsBaseMaterial.Num(); ++MaterialIndex)
+	{
+		FColor Color = IsBaseMaterial[MaterialIndex] ? (bIsSelectedState ? DefaultColorBase : HighlightColorBase)
+													 : (bIsSelectedState ? DefaultColor : HighlightColor);
+		ParameterCache->SetVectorParameter(MeshComponent, MaterialIndex, TintParamName, FLinearColor(FVector(Color)));
 	}
 }
@@ -21,6 +21,7 @@ enum class ESelectionState : uint8
 };
 
 class UStaticMeshComponent;
+class UMaterialParameterCache;
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class HANDSTRAINSAMPLE_API USelectionCylinderHelper : public UActorComponent
@@ -59,6 +60,9 @@ private:
 	const static FName TintParamName;
 
 	ESelectionState CurrSelectionState;
+	UMaterialParameterCache* ParameterCache;
+	// which of the mesh's materials take the base colors, found once in Initialize
+	TArray<bool> IsBaseMaterial;
 
 	void AffectSelectionColor(bool bIsSelectedState);
 };
@@ -0,0 +1,146 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableTool.h"
+#include "ScopedAllocationCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 NumButtons = 1000;
+	const int32 NumTools = 4;
+	const int32 NumWarmUpFrames = 16;
+	const int32 NumFrames = 300;
+
+	/**
+	 * Depth of a tool in a button on a frame. Each tool holds a depth for a
+	 * few frames, so updates are a mix of enter, exit and stay, and buttons
+	 * and tools are out of step with each other.
+	 */
+	EInteractableCollisionDepth GetDepth(int32 Frame, int32 ButtonIndex, int32 ToolIndex)
+	{
+		const EInteractableCollisionDepth Depths[6] = { EInteractableCollisionDepth::None,
+			EInteractableCollisionDepth::Proximity, EInteractableCollisionDepth::Contact,
+			EInteractableCollisionDepth::Action, EInteractableCollisionDepth::Contact,
+			EInteractableCollisionDepth::Proximity };
+		return Depths[((Frame + ButtonIndex * 7) / (ToolIndex + 2) + ToolIndex) % 6];
+	}
+
+	/** Tells every button about every tool, the way tools sync with the interactables they touch. */
+	void UpdateButtons(const TArray<ACollidableInteractable*>& Buttons, const TArray<AInteractableTool*>& Tools,
+		int32 Frame)
+	{
+		for (int32 ButtonIndex = 0; ButtonIndex < Buttons.Num(); ButtonIndex++)
+		{
+			for (int32 ToolIndex = 0; ToolIndex < Tools.Num(); ToolIndex++)
+			{
+				EInteractableCollisionDepth OldDepth = GetDepth(Frame - 1, ButtonIndex, ToolIndex);
+				EInteractableCollisionDepth NewDepth = GetDepth(Frame, ButtonIndex, ToolIndex);
+				if (OldDepth != EInteractableCollisionDepth::None || NewDepth != EInteractableCollisionDepth::None)
+				{
+					Buttons[ButtonIndex]->UpdateCollisionDepth(Tools[ToolIndex], OldDepth, NewDepth);
+				}
+			}
+		}
+	}
+
+	const TArray<FInteractableToolSlot>& GetToolSlots(ACollidableInteractable* Button)
+	{
+		return *FindFProperty<FArrayProperty>(ACollidableInteractable::StaticClass(), TEXT("ToolSlots"))
+			->ContainerPtrToValuePtr<TArray<FInteractableToolSlot>>(Button);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCollidableInteractableBenchmarkTest, "HandsTrain.CollidableInteractable.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FCollidableInteractableBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	TArray<ACollidableInteractable*> Buttons;
+	for (int32 ButtonIndex = 0; ButtonIndex < NumButtons; ButtonIndex++)
+	{
+		FVector Position((ButtonIndex % 40) * 30.0f, (ButtonIndex / 40) * 30.0f, 100.0f);
+		Buttons.Add(World.SpawnInteractable(FTransform(Position), EInteractableToolTags::All));
+	}
+	// two poke like tools that compete for buttons, and two ray like tools that share them
+	TArray<AInteractableTool*> Tools;
+	for (int32 ToolIndex = 0; ToolIndex < NumTools; ToolIndex++)
+	{
+		AInteractableTool* Tool = World.Spawn<AInteractableTool>();
+		Tool->IsFarFieldTool = ToolIndex >= NumTools / 2;
+		Tools.Add(Tool);
+	}
+
+	// the first frames may still grow the slot arrays
+	int32 Frame = 0;
+	for (; Frame < NumWarmUpFrames; Frame++)
+	{
+		UpdateButtons(Buttons, Tools, Frame);
+	}
+
+	int32 NumAllocations = 0;
+	double StartTime = FPlatformTime::Seconds();
+	{
+		FScopedAllocationCounter AllocationCounter;
+		for (int32 Count = 0; Count < NumFrames; Count++, Frame++)
+		{
+			UpdateButtons(Buttons, Tools, Frame);
+		}
+		NumAllocations = AllocationCounter.GetNumAllocations();
+	}
+	double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+	TestEqual(FString::Printf(TEXT("allocations over %d frames"), NumFrames), NumAllocations, 0);
+
+	// far field tools always get a slot matching their depth; only one near field tool controls a button
+	int32 NumMismatches = 0;
+	for (int32 ButtonIndex = 0; ButtonIndex < NumButtons; ButtonIndex++)
+	{
+		const TArray<FInteractableToolSlot>& ToolSlots = GetToolSlots(Buttons[ButtonIndex]);
+		int32 NumNearFieldSlots = 0;
+		for (int32 ToolIndex = 0; ToolIndex < NumTools; ToolIndex++)
+		{
+			const FInteractableToolSlot* ToolSlot = ToolSlots.FindByPredicate(
+				[Tool = Tools[ToolIndex]](const FInteractableToolSlot& Slot) { return Slot.Tool == Tool; });
+			if (!Tools[ToolIndex]->IsFarFieldTool)
+			{
+				NumNearFieldSlots += ToolSlot != nullptr ? 1 : 0;
+				continue;
+			}
+			EInteractableCollisionDepth Depth = GetDepth(Frame - 1, ButtonIndex, ToolIndex);
+			EInteractableState ExpectedState = Depth == EInteractableCollisionDepth::Contact ? EInteractableState::ContactState
+				: Depth == EInteractableCollisionDepth::Action                            ? EInteractableState::ActionState
+																						  : EInteractableState::Default;
+			EInteractableState State = ToolSlot != nullptr ? ToolSlot->State : EInteractableState::Default;
+			NumMismatches += State != ExpectedState ? 1 : 0;
+		}
+		NumMismatches += NumNearFieldSlots > 1 ? 1 : 0;
+	}
+	TestEqual(TEXT("buttons with unexpected tool slots"), NumMismatches, 0);
+
+	int32 NumUpdates = 0;
+	for (int32 Count = Frame - NumFrames; Count < Frame; Count++)
+	{
+		for (int32 ButtonIndex = 0; ButtonIndex < NumButtons; ButtonIndex++)
+		{
+			for (int32 ToolIndex = 0; ToolIndex < NumTools; ToolIndex++)
+			{
+				NumUpdates += GetDepth(Count - 1, ButtonIndex, ToolIndex) != EInteractableCollisionDepth::None
+					|| GetDepth(Count, ButtonIndex, ToolIndex) != EInteractableCollisionDepth::None ? 1 : 0;
+			}
+		}
+	}
+	AddInfo(FString::Printf(TEXT("%d buttons, %d tools: %.3f ms per frame, %.1f ns per depth update"), NumButtons,
+		NumTools, ElapsedTime * 1000.0 / NumFrames, ElapsedTime * 1.0e9 / FMath::Max(NumUpdates, 1)));
+	return true;
+}
+
+#endif
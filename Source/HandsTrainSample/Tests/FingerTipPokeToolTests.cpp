@@ -0,0 +1,218 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "Components/CapsuleComponent.h"
+#include "FingerTipPokeTool.h"
+#include "HAL/FileManager.h"
+#include "HandInputSource.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainStats.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableToolsManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+#include "OculusXRHandComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// thin buttons in a row along Y, pressed along X; the action zone is
+	// 1 unit deep, contact 2 and proximity 4
+	const int32 NumButtons = 6;
+	const float ButtonSpacing = 40.0f;
+	const FVector ActionZoneExtent(0.5f, 2.0f, 2.0f);
+	const float TipRadius = 0.8f;
+	const float TipHalfHeight = 1.5f;
+
+	// each press runs the tip from in front of a button to behind it, then
+	// lifts it over the button to come back, so it's never pressed from behind
+	const float PressStartX = -10.0f;
+	const float PressEndX = 10.0f;
+	const float LiftZ = 30.0f;
+	// units per frame; at 72 Hz the fastest is over 6 m/s
+	const float PressSpeeds[6] = { 0.5f, 1.0f, 2.0f, 4.0f, 6.0f, 9.0f };
+	const int32 NumPressesPerSpeed = 8;
+
+	FVector GetButtonPosition(int32 ButtonIndex)
+	{
+		return FVector(0.0f, ButtonIndex * ButtonSpacing, 0.0f);
+	}
+
+	void AddTipFrame(FHandInputRecorder& Recorder, TArray<int32>& OutButtonPressed, int32 ButtonIndex,
+		const FVector& TipPosition)
+	{
+		OutButtonPressed.Add(ButtonIndex);
+		FHandInputFrame Frame;
+		Frame.bHandTrackingEnabled = true;
+		FHandInputState& HandState = Frame.Hands[FHandInputFrame::GetHandIndex(EOculusXRHandType::HandRight)];
+		HandState.TrackingConfidence = EOculusXRTrackingConfidence::High;
+		HandState.ComponentTransform = FTransform(TipPosition);
+		Recorder.AddFrame(Frame);
+	}
+
+	/**
+	 * Records presses at every speed on every button. Each press starts at a
+	 * random offset, so fast ones land on different spots of the button.
+	 * @param OutButtonPressed - Button being pressed on each frame.
+	 * @return Number of presses recorded.
+	 */
+	int32 RecordPresses(FHandInputRecorder& Recorder, TArray<int32>& OutButtonPressed)
+	{
+		FRandomStream Random(3141);
+		int32 NumPresses = 0;
+		for (float Speed : PressSpeeds)
+		{
+			for (int32 Press = 0; Press < NumPressesPerSpeed; Press++)
+			{
+				int32 ButtonIndex = NumPresses % NumButtons;
+				FVector ButtonPosition = GetButtonPosition(ButtonIndex);
+				// come down in front of the button
+				AddTipFrame(Recorder, OutButtonPressed, ButtonIndex, ButtonPosition + FVector(PressStartX, 0.0f, LiftZ));
+				float X = PressStartX - Random.FRandRange(0.0f, Speed);
+				for (; X <= PressEndX; X += Speed)
+				{
+					AddTipFrame(Recorder, OutButtonPressed, ButtonIndex, ButtonPosition + FVector(X, 0.0f, 0.0f));
+				}
+				AddTipFrame(Recorder, OutButtonPressed, ButtonIndex, ButtonPosition + FVector(X, 0.0f, LiftZ));
+				NumPresses++;
+			}
+		}
+		return NumPresses;
+	}
+
+	EInteractableState GetToolState(ACollidableInteractable* Button, AInteractableTool* Tool)
+	{
+		const TArray<FInteractableToolSlot>& ToolSlots = *FindFProperty<FArrayProperty>(
+			ACollidableInteractable::StaticClass(), TEXT("ToolSlots"))
+			->ContainerPtrToValuePtr<TArray<FInteractableToolSlot>>(Button);
+		const FInteractableToolSlot* ToolSlot = ToolSlots.FindByPredicate([Tool](const FInteractableToolSlot& Slot) {
+			return Slot.Tool == Tool;
+		});
+		return ToolSlot != nullptr ? ToolSlot->State : EInteractableState::Default;
+	}
+
+	struct FPressResult
+	{
+		int32 NumPresses = 0;
+		int32 NumWrongButtonPresses = 0;
+		int32 NumSweptContacts = 0;
+	};
+
+	/** Replays the recording to a finger tip poke tool, counting how often each button goes into action. */
+	FPressResult ReplayPresses(const FString& RecordingPath, const TArray<int32>& ButtonPressed, bool bSweepContacts)
+	{
+		FHandsTrainTestWorld World;
+		TArray<ACollidableInteractable*> Buttons;
+		for (int32 ButtonIndex = 0; ButtonIndex < NumButtons; ButtonIndex++)
+		{
+			ACollidableInteractable* Button = World.SpawnInteractable(FTransform(GetButtonPosition(ButtonIndex)),
+				EInteractableToolTags::Poke, ActionZoneExtent);
+			// the bone capsules overlap zones the way the project's collision profiles set them up
+			UColliderZone* Zones[3] = { Button->ActionZone, Button->ContactZone, Button->ProximityZone };
+			for (UColliderZone* Zone : Zones)
+			{
+				Zone->SetCollisionObjectType(ECollisionChannel::ECC_GameTraceChannel3);
+				Zone->SetCollisionResponseToChannel(ECollisionChannel::ECC_EngineTraceChannel2, ECR_Overlap);
+				Zone->SetGenerateOverlapEvents(true);
+			}
+			Buttons.Add(Button);
+		}
+
+		// the recording poses the hand, and the index tip capsule follows it with its tip on the hand's origin
+		AActor* HandOwner = World.Spawn<AActor>();
+		UOculusXRHandComponent* Hand = NewObject<UOculusXRHandComponent>(HandOwner);
+		Hand->SkeletonType = EOculusXRHandType::HandRight;
+		Hand->MeshType = EOculusXRHandType::HandRight;
+		Hand->PrimaryComponentTick.bCanEverTick = false;
+		HandOwner->SetRootComponent(Hand);
+		Hand->RegisterComponent();
+		UCapsuleComponent* Capsule = NewObject<UCapsuleComponent>(HandOwner);
+		Capsule->InitCapsuleSize(TipRadius, TipHalfHeight);
+		Capsule->SetupAttachment(Hand);
+		Capsule->SetRelativeLocationAndRotation(FVector(-TipHalfHeight, 0.0f, 0.0f), FRotator(-90.0f, 0.0f, 0.0f));
+		Capsule->RegisterComponent();
+		FOculusXRCapsuleCollider CapsuleCollider;
+		CapsuleCollider.Capsule = Capsule;
+		CapsuleCollider.BoneId = EOculusXRBone::Index_3;
+		Hand->CollisionCapsules.Add(CapsuleCollider);
+
+		AInteractableToolsManager* Manager = World.Spawn<AInteractableToolsManager>();
+		AFingerTipPokeTool* PokeTool = World.Spawn<AFingerTipPokeTool>();
+		PokeTool->FingerToFollow = EHandFinger::Index;
+		PokeTool->bSweepContacts = bSweepContacts;
+		Manager->AddTickPrerequisiteActor(PokeTool);
+		struct
+		{
+			UOculusXRHandComponent* Hand;
+			AInteractableTool* Tool;
+		} Params = { Hand, PokeTool };
+		Manager->ProcessEvent(Manager->FindFunctionChecked(TEXT("AssociateToolWithHand")), &Params);
+
+		FPressResult Result;
+		UHandInputSubsystem* HandInput = World.Get()->GetSubsystem<UHandInputSubsystem>();
+		if (!HandInput->StartPlayback(RecordingPath))
+		{
+			return Result;
+		}
+		TArray<EInteractableState> PrevStates;
+		PrevStates.Init(EInteractableState::Default, NumButtons);
+		for (int32 Frame = 0; HandInput->IsPlayingBack(); Frame++)
+		{
+			// the engine loop isn't running, so count frames the way it would
+			GFrameCounter++;
+			World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+			Result.NumSweptContacts += FHandsTrainFrameStats::GetCount(EHandsTrainCounter::SweptContacts);
+			for (int32 ButtonIndex = 0; ButtonIndex < NumButtons; ButtonIndex++)
+			{
+				EInteractableState State = GetToolState(Buttons[ButtonIndex], PokeTool);
+				if (State == EInteractableState::ActionState && PrevStates[ButtonIndex] != EInteractableState::ActionState)
+				{
+					Result.NumPresses++;
+					bool bExpectedButton = ButtonPressed.IsValidIndex(Frame) && ButtonPressed[Frame] == ButtonIndex;
+					Result.NumWrongButtonPresses += bExpectedButton ? 0 : 1;
+				}
+				PrevStates[ButtonIndex] = State;
+			}
+		}
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFingerTipPokeToolFastPressesTest, "HandsTrain.FingerTipPokeTool.FastPresses",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FFingerTipPokeToolFastPressesTest::RunTest(const FString& Parameters)
+{
+	TArray<int32> ButtonPressed;
+	FHandInputRecorder Recorder;
+	int32 NumPresses = RecordPresses(Recorder, ButtonPressed);
+	FString RecordingPath = FPaths::ConvertRelativePathToFull(
+		FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("FastPresses.bin")));
+	if (!TestTrue(TEXT("recording saved"), Recorder.Save(RecordingPath)))
+	{
+		return false;
+	}
+
+	FPressResult Swept = ReplayPresses(RecordingPath, ButtonPressed, true);
+	FPressResult Overlapped = ReplayPresses(RecordingPath, ButtonPressed, false);
+	IFileManager::Get().Delete(*RecordingPath);
+
+	TestEqual(TEXT("presses seen with swept contacts"), Swept.NumPresses, NumPresses);
+	TestEqual(TEXT("presses on the wrong button with swept contacts"), Swept.NumWrongButtonPresses, 0);
+	TestTrue(TEXT("sweeps found contacts"), Swept.NumSweptContacts > 0);
+	// otherwise the recording isn't fast enough to test anything
+	TestTrue(TEXT("overlaps alone miss fast presses"), Overlapped.NumPresses < NumPresses);
+	TestEqual(TEXT("presses on the wrong button with overlaps alone"), Overlapped.NumWrongButtonPresses, 0);
+	AddInfo(FString::Printf(TEXT("%d presses: %d missed with swept contacts (%d swept), %d missed with overlaps alone"),
+		NumPresses, NumPresses - Swept.NumPresses, Swept.NumSweptContacts, NumPresses - Overlapped.NumPresses));
+	return true;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandBoneSegmentKernel.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandBoneSegmentKernelMatchesScalarTest, "HandsTrain.HandBoneSegments.MatchesScalar",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHandBoneSegmentKernelMatchesScalarTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(4321);
+	const FTransform WorldToInstance(FRotator(10.0f, 30.0f, -5.0f), FVector(20.0f, -40.0f, 100.0f));
+	const float LengthScale = 0.01f;
+	const float Thickness = 0.01f;
+	// marks segments that weren't written
+	const FTransform Untouched(FQuat::Identity, FVector(-1.0f), FVector(7.0f));
+
+	for (int32 Trial = 0; Trial < 20; Trial++)
+	{
+		// a chain of bones, like a finger, plus a few cases the kernel treats specially
+		const int32 NumBones = 6 + Trial;
+		TArray<FTransform> BoneTransforms;
+		for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
+		{
+			FVector Position(Random.FRandRange(-20.0f, 20.0f), Random.FRandRange(-20.0f, 20.0f),
+				Random.FRandRange(80.0f, 120.0f));
+			BoneTransforms.Add(FTransform(FRotator(Random.FRandRange(-180.0f, 180.0f),
+				Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-180.0f, 180.0f)), Position));
+		}
+		// bones in the same place make a degenerate segment
+		BoneTransforms[2].SetLocation(BoneTransforms[1].GetLocation());
+
+		FHandBoneSegmentKernel Kernel;
+		for (int32 BoneIndex = 1; BoneIndex < NumBones; BoneIndex++)
+		{
+			Kernel.AddSegment(BoneIndex - 1, BoneIndex);
+		}
+
+		// looking straight down the last segment falls back to the bones' up vectors
+		FVector ViewPosition = Random.GetUnitVector() * 50.0f;
+		if (Trial % 2 == 1)
+		{
+			FVector Start = BoneTransforms[NumBones - 2].GetLocation();
+			FVector End = BoneTransforms[NumBones - 1].GetLocation();
+			ViewPosition = (Start + End) * 0.5f + (End - Start).GetSafeNormal() * 50.0f;
+		}
+
+		TArray<FTransform> SegmentTransforms;
+		TArray<FTransform> ScalarSegmentTransforms;
+		SegmentTransforms.Init(Untouched, Kernel.Num());
+		ScalarSegmentTransforms.Init(Untouched, Kernel.Num());
+		Kernel.Compute(BoneTransforms, WorldToInstance, ViewPosition, LengthScale, Thickness, SegmentTransforms);
+		Kernel.ComputeScalar(BoneTransforms, WorldToInstance, ViewPosition, LengthScale, Thickness,
+			ScalarSegmentTransforms);
+
+		for (int32 Index = 0; Index < Kernel.Num(); Index++)
+		{
+			const FTransform& Transform = SegmentTransforms[Index];
+			const FTransform& ScalarTransform = ScalarSegmentTransforms[Index];
+			FString What = FString::Printf(TEXT("trial %d, segment %d"), Trial, Index);
+			TestTrue(What + TEXT(" location"), Transform.GetLocation().Equals(ScalarTransform.GetLocation(), 0.01f));
+			TestTrue(What + TEXT(" rotation"), Transform.GetRotation().Equals(ScalarTransform.GetRotation(), 0.001f));
+			TestTrue(What + TEXT(" scale"), Transform.GetScale3D().Equals(ScalarTransform.GetScale3D(), 0.0001f));
+		}
+		TestTrue(TEXT("degenerate segment is left alone"), SegmentTransforms[1].Equals(Untouched));
+	}
+	return true;
+}
+
+#endif
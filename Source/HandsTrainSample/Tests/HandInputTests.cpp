@@ -0,0 +1,283 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HAL/FileManager.h"
+#include "HandInputSource.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainTestWorld.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OculusXRHandComponent.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// recordings store transforms in single precision
+	const float Tolerance = 0.001f;
+
+	FTransform GetRandomTransform(FRandomStream& Random)
+	{
+		return FTransform(FRotator(Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-180.0f, 180.0f),
+			Random.FRandRange(-180.0f, 180.0f)), Random.GetUnitVector() * Random.FRandRange(0.0f, 100.0f));
+	}
+
+	/** A frame with every field set; bone scales are left at one, since recordings drop them. */
+	FHandInputFrame GetRandomFrame(FRandomStream& Random, int32 NumBones)
+	{
+		FHandInputFrame Frame;
+		Frame.bHandTrackingEnabled = Random.FRand() < 0.8f;
+		for (FHandInputState& HandState : Frame.Hands)
+		{
+			HandState.TrackingConfidence = Random.FRand() < 0.5f ? EOculusXRTrackingConfidence::High
+				: EOculusXRTrackingConfidence::Low;
+			HandState.bPointerPoseValid = Random.FRand() < 0.5f;
+			HandState.PointerPose = GetRandomTransform(Random);
+			HandState.HandScale = Random.FRandRange(0.8f, 1.2f);
+			HandState.PinchStrength = Random.FRand();
+			HandState.ComponentTransform = GetRandomTransform(Random);
+			for (int32 BoneIndex = 0; BoneIndex < NumBones; BoneIndex++)
+			{
+				HandState.BoneSpaceTransforms.Add(GetRandomTransform(Random));
+			}
+		}
+		return Frame;
+	}
+
+	void TestFramesEqual(FAutomationTestBase& Test, const FString& What, const FHandInputFrame& Actual,
+		const FHandInputFrame& Expected)
+	{
+		Test.TestEqual(What + TEXT(" tracking enabled"), Actual.bHandTrackingEnabled, Expected.bHandTrackingEnabled);
+		for (int32 HandIndex = 0; HandIndex < 2; HandIndex++)
+		{
+			const FHandInputState& Hand = Actual.Hands[HandIndex];
+			const FHandInputState& ExpectedHand = Expected.Hands[HandIndex];
+			FString HandWhat = FString::Printf(TEXT("%s hand %d"), *What, HandIndex);
+			Test.TestTrue(HandWhat + TEXT(" confidence"), Hand.TrackingConfidence == ExpectedHand.TrackingConfidence);
+			Test.TestEqual(HandWhat + TEXT(" pointer pose valid"), Hand.bPointerPoseValid, ExpectedHand.bPointerPoseValid);
+			Test.TestTrue(HandWhat + TEXT(" pointer pose"), Hand.PointerPose.Equals(ExpectedHand.PointerPose, Tolerance));
+			Test.TestEqual(HandWhat + TEXT(" scale"), Hand.HandScale, ExpectedHand.HandScale);
+			Test.TestEqual(HandWhat + TEXT(" pinch strength"), Hand.PinchStrength, ExpectedHand.PinchStrength);
+			Test.TestTrue(HandWhat + TEXT(" component transform"),
+				Hand.ComponentTransform.Equals(ExpectedHand.ComponentTransform, Tolerance));
+			if (!Test.TestEqual(HandWhat + TEXT(" bone count"), Hand.BoneSpaceTransforms.Num(),
+					ExpectedHand.BoneSpaceTransforms.Num()))
+			{
+				continue;
+			}
+			for (int32 BoneIndex = 0; BoneIndex < Hand.BoneSpaceTransforms.Num(); BoneIndex++)
+			{
+				Test.TestTrue(FString::Printf(TEXT("%s bone %d"), *HandWhat, BoneIndex),
+					Hand.BoneSpaceTransforms[BoneIndex].Equals(ExpectedHand.BoneSpaceTransforms[BoneIndex], Tolerance));
+			}
+		}
+	}
+
+	FString GetTestRecordingPath(const TCHAR* Filename)
+	{
+		return FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), Filename));
+	}
+
+	/** Saves frames the way HandsTrain.StopHandInputRecording does. */
+	bool SaveRecording(const FString& Path, const TArray<FHandInputFrame>& Frames)
+	{
+		FHandInputRecorder Recorder;
+		for (const FHandInputFrame& Frame : Frames)
+		{
+			Recorder.AddFrame(Frame);
+		}
+		return Recorder.Save(Path);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandInputFrameRoundTripTest, "HandsTrain.HandInput.FrameRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHandInputFrameRoundTripTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(8642);
+	// no bones is what live input reads each frame; 24 is a full hand skeleton
+	for (int32 NumBones : { 0, 1, 24 })
+	{
+		FHandInputFrame Frame = GetRandomFrame(Random, NumBones);
+		TArray<uint8> Data;
+		FMemoryWriter Writer(Data);
+		Frame.Serialize(Writer);
+
+		FHandInputFrame ReadBack;
+		FMemoryReader Reader(Data);
+		ReadBack.Serialize(Reader);
+		TestFalse(TEXT("read without errors"), Reader.IsError());
+		TestEqual(TEXT("read everything written"), Reader.Tell(), Reader.TotalSize());
+		TestFramesEqual(*this, FString::Printf(TEXT("%d bones"), NumBones), ReadBack, Frame);
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandInputRecordingRoundTripTest, "HandsTrain.HandInput.RecordingRoundTrip",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHandInputRecordingRoundTripTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1357);
+	TArray<FHandInputFrame> Frames;
+	for (int32 FrameIndex = 0; FrameIndex < 200; FrameIndex++)
+	{
+		Frames.Add(GetRandomFrame(Random, FrameIndex % 3 == 0 ? 24 : 0));
+	}
+	FString Path = GetTestRecordingPath(TEXT("HandInputRoundTrip.bin"));
+	if (!TestTrue(TEXT("recording saved"), SaveRecording(Path, Frames)))
+	{
+		return false;
+	}
+
+	FRecordedHandInputSource Source;
+	bool bLoaded = Source.Load(Path);
+	IFileManager::Get().Delete(*Path);
+	if (!TestTrue(TEXT("recording loaded"), bLoaded))
+	{
+		return false;
+	}
+	TestEqual(TEXT("frame count"), Source.GetNumFrames(), Frames.Num());
+	for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); FrameIndex++)
+	{
+		FHandInputFrame Frame;
+		if (!TestTrue(FString::Printf(TEXT("frame %d read"), FrameIndex), Source.ReadFrame(Frame)))
+		{
+			return false;
+		}
+		TestFramesEqual(*this, FString::Printf(TEXT("frame %d"), FrameIndex), Frame, Frames[FrameIndex]);
+	}
+	FHandInputFrame Frame;
+	TestFalse(TEXT("no frames past the end"), Source.ReadFrame(Frame));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandInputDamagedRecordingTest, "HandsTrain.HandInput.DamagedRecording",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHandInputDamagedRecordingTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(2468);
+	TArray<FHandInputFrame> Frames;
+	for (int32 FrameIndex = 0; FrameIndex < 20; FrameIndex++)
+	{
+		Frames.Add(GetRandomFrame(Random, 24));
+	}
+	FString Path = GetTestRecordingPath(TEXT("HandInputDamaged.bin"));
+	if (!TestTrue(TEXT("recording saved"), SaveRecording(Path, Frames)))
+	{
+		return false;
+	}
+	TArray<uint8> FileData;
+	FFileHelper::LoadFileToArray(FileData, *Path);
+
+	AddExpectedError(TEXT("is not a hand input recording"), EAutomationExpectedErrorFlags::Contains, 1);
+	AddExpectedError(TEXT("is truncated"), EAutomationExpectedErrorFlags::Contains, 2);
+	AddExpectedError(TEXT("Could not read hand input recording"), EAutomationExpectedErrorFlags::Contains, 1);
+
+	FRecordedHandInputSource Source;
+	// the header is the magic, the version and the frame count
+	TArray<uint8> WrongMagic = FileData;
+	WrongMagic[0] ^= 0xff;
+	FFileHelper::SaveArrayToFile(WrongMagic, *Path);
+	TestFalse(TEXT("wrong magic is rejected"), Source.Load(Path));
+
+	// more frames than the file could hold is caught before anything is allocated
+	TArray<uint8> HugeFrameCount = FileData;
+	int32 NumFrames = MAX_int32;
+	FMemory::Memcpy(&HugeFrameCount[8], &NumFrames, sizeof(NumFrames));
+	FFileHelper::SaveArrayToFile(HugeFrameCount, *Path);
+	TestFalse(TEXT("huge frame count is rejected"), Source.Load(Path));
+
+	// cut off in the middle of the last frame's bones
+	TArray<uint8> Truncated = FileData;
+	Truncated.SetNum(Truncated.Num() - 100);
+	FFileHelper::SaveArrayToFile(Truncated, *Path);
+	TestFalse(TEXT("truncated recording is rejected"), Source.Load(Path));
+	FHandInputFrame Frame;
+	TestFalse(TEXT("nothing left to play after a failed load"), Source.ReadFrame(Frame));
+
+	IFileManager::Get().Delete(*Path);
+	TestFalse(TEXT("missing recording is rejected"), Source.Load(Path));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHandInputSubsystemPlaybackTest, "HandsTrain.HandInput.SubsystemPlayback",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FHandInputSubsystemPlaybackTest::RunTest(const FString& Parameters)
+{
+	// a hand component with no mesh has no bones, so only frames without
+	// bones match its skeleton and get applied to it
+	FRandomStream Random(9753);
+	TArray<FHandInputFrame> Frames;
+	for (int32 FrameIndex = 0; FrameIndex < 30; FrameIndex++)
+	{
+		Frames.Add(GetRandomFrame(Random, FrameIndex % 5 == 4 ? 24 : 0));
+	}
+	FString Path = GetTestRecordingPath(TEXT("HandInputPlayback.bin"));
+	if (!TestTrue(TEXT("recording saved"), SaveRecording(Path, Frames)))
+	{
+		return false;
+	}
+
+	FHandsTrainTestWorld World;
+	UHandInputSubsystem* HandInput = World.Get()->GetSubsystem<UHandInputSubsystem>();
+	UOculusXRHandComponent* Hand = NewObject<UOculusXRHandComponent>(World.Spawn<AActor>());
+	Hand->SkeletonType = EOculusXRHandType::HandRight;
+	Hand->MeshType = EOculusXRHandType::HandRight;
+	Hand->PrimaryComponentTick.bCanEverTick = false;
+	Hand->RegisterComponent();
+	HandInput->RegisterHand(Hand);
+
+	AddExpectedError(TEXT("Could not read hand input recording"), EAutomationExpectedErrorFlags::Contains, 1);
+	TestFalse(TEXT("missing recording isn't played"),
+		HandInput->StartPlayback(GetTestRecordingPath(TEXT("HandInputMissing.bin"))));
+	bool bStarted = HandInput->StartPlayback(Path);
+	IFileManager::Get().Delete(*Path);
+	if (!TestTrue(TEXT("playback started"), bStarted))
+	{
+		return false;
+	}
+
+	const int32 RightHandIndex = FHandInputFrame::GetHandIndex(EOculusXRHandType::HandRight);
+	FTransform HandTransform = Hand->GetComponentTransform();
+	for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); FrameIndex++)
+	{
+		World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+		FString What = FString::Printf(TEXT("frame %d"), FrameIndex);
+		TestTrue(What + TEXT(" still playing"), HandInput->IsPlayingBack());
+		TestEqual(What + TEXT(" tracking enabled"), HandInput->IsHandTrackingEnabled(),
+			Frames[FrameIndex].bHandTrackingEnabled);
+		FHandInputFrame Frame;
+		Frame.bHandTrackingEnabled = HandInput->IsHandTrackingEnabled();
+		Frame.Hands[0] = HandInput->GetHandState(EOculusXRHandType::HandLeft);
+		Frame.Hands[1] = HandInput->GetHandState(EOculusXRHandType::HandRight);
+		TestFramesEqual(*this, What, Frame, Frames[FrameIndex]);
+
+		const FHandInputState& HandState = Frames[FrameIndex].Hands[RightHandIndex];
+		if (HandState.BoneSpaceTransforms.Num() == 0)
+		{
+			HandTransform = HandState.ComponentTransform;
+		}
+		TestTrue(What + TEXT(" hand posed from matching frames only"),
+			Hand->GetComponentTransform().Equals(HandTransform, Tolerance));
+	}
+
+	// back to live input once the recording runs out
+	World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+	TestFalse(TEXT("playback stops at the end"), HandInput->IsPlayingBack());
+	return true;
+}
+
+#endif
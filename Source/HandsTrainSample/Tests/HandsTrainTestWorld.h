@@ -0,0 +1,144 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollidableInteractable.h"
+#include "ColliderZone.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "InteractableEnums.h"
+#include "TrackSegment.h"
+#include "TrackSegmentMetaInfo.h"
+#include "TrainTrack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * A game world for tests that need actors. Play has begun, but nothing ticks
+ * unless the test does it; the world is torn down when this goes out of scope.
+ */
+class FHandsTrainTestWorld
+{
+public:
+	FHandsTrainTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false);
+		World->AddToRoot();
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+		World->InitializeActorsForPlay(FURL());
+		World->BeginPlay();
+	}
+
+	~FHandsTrainTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		World->RemoveFromRoot();
+	}
+
+	UWorld* Get() const
+	{
+		return World;
+	}
+
+	template<typename T>
+	T* Spawn(const FTransform& Transform = FTransform::Identity)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		return World->SpawnActor<T>(T::StaticClass(), Transform, SpawnParameters);
+	}
+
+	/**
+	 * Spawns a closed track, laid out from meta infos the way placed tracks
+	 * are: a rectangle of straights with a right turn in each corner.
+	 * Segments have no meshes.
+	 * @param bUseInstancedSegments - Whether segments are instances or actors.
+	 */
+	ATrainTrack* SpawnLoopTrack(int32 NumStraightsPerSide, bool bUseInstancedSegments,
+		const FTransform& Transform = FTransform::Identity)
+	{
+		ATrainTrack* Track = World->SpawnActorDeferred<ATrainTrack>(ATrainTrack::StaticClass(), Transform);
+		Track->TrackSegmentBP = ATrackSegment::StaticClass();
+		Track->bUseInstancedSegments = bUseInstancedSegments;
+		int32 SegmentIndex = 0;
+		for (int32 Side = 0; Side < 4; Side++)
+		{
+			for (int32 Straight = 0; Straight < NumStraightsPerSide; Straight++)
+			{
+				AddSegmentInfo(Track, ESegmentType::Straight, SegmentIndex++);
+			}
+			AddSegmentInfo(Track, ESegmentType::RightTurn, SegmentIndex++);
+		}
+		// segment actors have to exist before the track's BeginPlay finds them
+		if (!bUseInstancedSegments)
+		{
+			Track->SetUpTrack();
+		}
+		Track->FinishSpawning(Transform);
+		return Track;
+	}
+
+	/**
+	 * Spawns an interactable whose action, contact and proximity zones are
+	 * nested boxes, each twice the size of the one inside it, and overlap
+	 * the interactable trace channel. Zones are indexed when it begins play.
+	 * @param ActionZoneExtent - Half size of the action zone.
+	 */
+	template<typename T = ACollidableInteractable>
+	T* SpawnInteractable(const FTransform& Transform, EInteractableToolTags ValidToolTags,
+		const FVector& ActionZoneExtent = FVector(5.0f))
+	{
+		T* Interactable = World->SpawnActorDeferred<T>(T::StaticClass(), Transform);
+		// protected, so set through reflection the way the editor would
+		FArrayProperty* ValidToolTagsProperty =
+			FindFProperty<FArrayProperty>(AInteractable::StaticClass(), TEXT("AllValidToolTags"));
+		ValidToolTagsProperty->ContainerPtrToValuePtr<TArray<EInteractableToolTags>>(Interactable)->Add(ValidToolTags);
+
+		UColliderZone* Zones[3] = { Interactable->ActionZone, Interactable->ContactZone, Interactable->ProximityZone };
+		FVector ZoneExtent = ActionZoneExtent;
+		for (UColliderZone* Zone : Zones)
+		{
+			Zone->SetBoxExtent(ZoneExtent, false);
+			Zone->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Zone->SetCollisionResponseToAllChannels(ECR_Ignore);
+			Zone->SetCollisionResponseToChannel(ECollisionChannel::ECC_GameTraceChannel1, ECR_Overlap);
+			ZoneExtent *= 2.0f;
+		}
+		Interactable->FinishSpawning(Transform);
+		return Interactable;
+	}
+
+	/** Sets a property tests can't reach from code, the way the editor would. */
+	template<typename TValue>
+	static void SetProperty(UObject* Object, FName PropertyName, const TValue& Value)
+	{
+		FProperty* Property = FindFProperty<FProperty>(Object->GetClass(), PropertyName);
+		check(Property != nullptr && Property->GetSize() == sizeof(TValue));
+		Property->CopyCompleteValue(Property->ContainerPtrToValuePtr<void>(Object), &Value);
+	}
+
+	static UTrackSegmentMetaInfo* AddSegmentInfo(ATrainTrack* Track, ESegmentType SegmentType, int32 SegmentIndex,
+		int32 BranchFromSegmentIndex = INDEX_NONE, int32 MergeIntoSegmentIndex = INDEX_NONE)
+	{
+		UTrackSegmentMetaInfo* SegmentInfo = NewObject<UTrackSegmentMetaInfo>(Track);
+		SegmentInfo->TrackSegmentType = SegmentType;
+		SegmentInfo->SegmentIndex = SegmentIndex;
+		SegmentInfo->BranchFromSegmentIndex = BranchFromSegmentIndex;
+		SegmentInfo->MergeIntoSegmentIndex = MergeIntoSegmentIndex;
+		return SegmentInfo;
+	}
+
+private:
+	UWorld* World;
+};
+
+#endif
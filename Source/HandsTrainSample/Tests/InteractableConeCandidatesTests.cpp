@@ -0,0 +1,97 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "InteractableConeCandidates.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const float CosConeAngle = 0.9f;
+	const uint32 ToolTagsMask = 0x2;
+
+	void AddRandomCandidates(FInteractableConeCandidates& Candidates, int32 NumCandidates, FRandomStream& Random)
+	{
+		Candidates.Reset();
+		for (int32 Index = 0; Index < NumCandidates; Index++)
+		{
+			FVector Position(Random.FRandRange(-500.0f, 500.0f), Random.FRandRange(-500.0f, 500.0f),
+				Random.FRandRange(-500.0f, 500.0f));
+			Candidates.Add(nullptr, Position, 1u << Random.RandRange(0, 2));
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FConeCandidatesMatchScalarTest, "HandsTrain.ConeCandidates.MatchesScalar",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FConeCandidatesMatchScalarTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1234);
+	FInteractableConeCandidates Candidates;
+	// odd counts leave padding in the last group of four
+	const int32 CandidateCounts[5] = { 0, 1, 7, 64, 509 };
+	for (int32 NumCandidates : CandidateCounts)
+	{
+		for (int32 Query = 0; Query < 50; Query++)
+		{
+			AddRandomCandidates(Candidates, NumCandidates, Random);
+			FVector Origin = Random.GetUnitVector() * 100.0f;
+			FVector Direction = Random.GetUnitVector();
+			int32 NearestIndex = Candidates.FindNearestInCone(Origin, Direction, CosConeAngle, ToolTagsMask);
+			int32 ScalarNearestIndex = Candidates.FindNearestInConeScalar(Origin, Direction, CosConeAngle,
+				ToolTagsMask);
+			TestEqual(FString::Printf(TEXT("%d candidates, query %d"), NumCandidates, Query), NearestIndex,
+				ScalarNearestIndex);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FConeCandidatesTimingTest, "HandsTrain.ConeCandidates.Timing",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FConeCandidatesTimingTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(5678);
+	FInteractableConeCandidates Candidates;
+	const int32 CandidateCounts[3] = { 1000, 10000, 100000 };
+	const int32 NumQueries = 100;
+	for (int32 NumCandidates : CandidateCounts)
+	{
+		AddRandomCandidates(Candidates, NumCandidates, Random);
+		FVector Origin = FVector::ZeroVector;
+		FVector Direction = FVector::ForwardVector;
+
+		// sum the results so the calls can't be optimized away
+		int32 IndexSum = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Query = 0; Query < NumQueries; Query++)
+		{
+			IndexSum += Candidates.FindNearestInCone(Origin, Direction, CosConeAngle, ToolTagsMask);
+		}
+		double VectorTime = FPlatformTime::Seconds() - StartTime;
+
+		int32 ScalarIndexSum = 0;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Query = 0; Query < NumQueries; Query++)
+		{
+			ScalarIndexSum += Candidates.FindNearestInConeScalar(Origin, Direction, CosConeAngle, ToolTagsMask);
+		}
+		double ScalarTime = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual(FString::Printf(TEXT("%d candidates"), NumCandidates), IndexSum, ScalarIndexSum);
+		AddInfo(FString::Printf(TEXT("%d candidates: %.3f ms vector, %.3f ms scalar per query"), NumCandidates,
+			VectorTime * 1000.0 / NumQueries, ScalarTime * 1000.0 / NumQueries));
+	}
+	return true;
+}
+
+#endif
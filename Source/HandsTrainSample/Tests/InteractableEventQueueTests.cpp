@@ -0,0 +1,106 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandsTrainStats.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableEventQueue.h"
+#include "InteractableEventRecorder.h"
+#include "InteractableTool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Queues a zone event and returns the line the recorder writes for it. */
+	FString EnqueueZoneEvent(UInteractableEventQueue* Queue, UColliderZone* Zone, AInteractableTool* Tool,
+		ECollisionInteractionType InteractionType)
+	{
+		AInteractable* Interactable = Zone->ParentInteractable;
+		EInteractableCollisionDepth Depth = Zone == Interactable->ActionZone ? EInteractableCollisionDepth::Action
+			: Zone == Interactable->ContactZone                             ? EInteractableCollisionDepth::Contact
+																			: EInteractableCollisionDepth::Proximity;
+		Queue->EnqueueZoneEvent(Interactable, Depth, FColliderZoneArgs(Zone, GFrameCounter, Tool, InteractionType));
+		return FString::Printf(TEXT("%s %s %d"), *UInteractableEventRecorder::Describe(Zone),
+			*UInteractableEventRecorder::Describe(Tool), (int32)InteractionType);
+	}
+
+	FString EnqueueStateChange(UInteractableEventQueue* Queue, AInteractable* Interactable, AInteractableTool* Tool,
+		EInteractableState NewState)
+	{
+		Queue->EnqueueStateChange(Interactable,
+			FInteractableStateArgs(Interactable, Tool, EInteractableState::Default, NewState, FColliderZoneArgs()));
+		return FString::Printf(TEXT("%s %s %d"), *UInteractableEventRecorder::Describe(Interactable),
+			*UInteractableEventRecorder::Describe(Tool), (int32)NewState);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableEventQueueOrderingTest, "HandsTrain.InteractableEventQueue.Ordering",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableEventQueueOrderingTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	UInteractableEventQueue* Queue = World.Get()->GetSubsystem<UInteractableEventQueue>();
+	ACollidableInteractable* Button = World.SpawnInteractable(FTransform::Identity, EInteractableToolTags::All);
+	ACollidableInteractable* DestroyedButton =
+		World.SpawnInteractable(FTransform(FVector(100.0f, 0.0f, 0.0f)), EInteractableToolTags::All);
+	AInteractableTool* FirstTool = World.Spawn<AInteractableTool>();
+	AInteractableTool* SecondTool = World.Spawn<AInteractableTool>();
+	UInteractableEventRecorder* Recorder = NewObject<UInteractableEventRecorder>();
+	Recorder->Listen(Button);
+	Recorder->Listen(DestroyedButton);
+
+	// a frame of its own, so the queue depth counter only has this batch
+	GFrameCounter++;
+	Queue->BeginBatch();
+	TestTrue(TEXT("collecting after BeginBatch"), Queue->IsCollecting());
+	TArray<FString> Expected;
+	const ECollisionInteractionType Stay = ECollisionInteractionType::Stay;
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, Stay));
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ProximityZone, SecondTool, Stay));
+	// repeated stays keep the first one's place
+	EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, Stay);
+	Expected.Add(EnqueueStateChange(Queue, Button, FirstTool, EInteractableState::ProximityState));
+	// leaving and coming back starts over, for that zone and tool only
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, ECollisionInteractionType::Exit));
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, Stay));
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ContactZone, FirstTool, ECollisionInteractionType::Enter));
+	EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, Stay);
+	EnqueueZoneEvent(Queue, Button->ProximityZone, SecondTool, Stay);
+	Expected.Add(EnqueueZoneEvent(Queue, Button->ContactZone, FirstTool, Stay));
+	Expected.Add(EnqueueStateChange(Queue, Button, FirstTool, EInteractableState::ContactState));
+	// queued, but gone by the time the batch goes out
+	EnqueueZoneEvent(Queue, DestroyedButton->ActionZone, FirstTool, ECollisionInteractionType::Enter);
+	DestroyedButton->Destroy();
+	TestEqual(TEXT("nothing is broadcast while collecting"), Recorder->Events.Num(), 0);
+
+	Queue->FlushBatch();
+	TestFalse(TEXT("collecting after FlushBatch"), Queue->IsCollecting());
+	TestEqual(TEXT("events broadcast"), Recorder->Events.Num(), Expected.Num());
+	for (int32 Index = 0; Index < FMath::Min(Recorder->Events.Num(), Expected.Num()); Index++)
+	{
+		TestEqual(FString::Printf(TEXT("event %d"), Index), Recorder->Events[Index], Expected[Index]);
+	}
+	TestEqual(TEXT("queue depth counted"), (int32)FHandsTrainFrameStats::GetCount(EHandsTrainCounter::QueuedInteractableEvents),
+		Expected.Num() + 1);
+
+	// stays are only dropped within a batch
+	GFrameCounter++;
+	Recorder->Events.Reset();
+	Queue->BeginBatch();
+	FString NextStay = EnqueueZoneEvent(Queue, Button->ProximityZone, FirstTool, Stay);
+	Queue->FlushBatch();
+	TestEqual(TEXT("events broadcast in the next batch"), Recorder->Events.Num(), 1);
+	TestTrue(TEXT("stay broadcast in the next batch"), Recorder->Events.Num() == 1 && Recorder->Events[0] == NextStay);
+	TestEqual(TEXT("queue depth counted for the next batch"),
+		(int32)FHandsTrainFrameStats::GetCount(EHandsTrainCounter::QueuedInteractableEvents), 1);
+	return true;
+}
+
+#endif
@@ -0,0 +1,54 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interactable.h"
+#include "InteractableEventRecorder.generated.h"
+
+/**
+ * Listens to an interactable's zone and state events for tests, and keeps
+ * a line for each one in the order they were broadcast.
+ */
+UCLASS()
+class HANDSTRAINSAMPLE_API UInteractableEventRecorder : public UObject
+{
+	GENERATED_BODY()
+public:
+	TArray<FString> Events;
+
+	void Listen(AInteractable* Interactable)
+	{
+		Interactable->OnProximityZoneEvent.AddDynamic(this, &UInteractableEventRecorder::ZoneEvent);
+		Interactable->OnContactZoneEvent.AddDynamic(this, &UInteractableEventRecorder::ZoneEvent);
+		Interactable->OnActionZoneEvent.AddDynamic(this, &UInteractableEventRecorder::ZoneEvent);
+		Interactable->OnInteractableStateChanged.AddDynamic(this, &UInteractableEventRecorder::StateChanged);
+	}
+
+	/** Names zones, tools and interactables the same way the recorded lines do. */
+	static FString Describe(const UObject* Object)
+	{
+		return Object != nullptr ? Object->GetName() : TEXT("none");
+	}
+
+protected:
+	UFUNCTION()
+	void ZoneEvent(const FColliderZoneArgs& ZoneArgs)
+	{
+		Events.Add(FString::Printf(TEXT("%s %s %d"), *Describe(ZoneArgs.Zone), *Describe(ZoneArgs.CollidingTool),
+			(int32)ZoneArgs.InteractionT));
+	}
+
+	UFUNCTION()
+	void StateChanged(const FInteractableStateArgs& StateArgs)
+	{
+		Events.Add(FString::Printf(TEXT("%s %s %d"), *Describe(StateArgs.Interactable), *Describe(StateArgs.Tool),
+			(int32)StateArgs.NewInteractableState));
+	}
+};
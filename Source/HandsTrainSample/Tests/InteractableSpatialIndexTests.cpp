@@ -0,0 +1,314 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "CollidableInteractable.h"
+#include "ColliderZone.h"
+#include "Engine/OverlapResult.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableSpatialIndex.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const uint32 RayMask = (uint32)EInteractableToolTags::Ray;
+	const uint32 PokeMask = (uint32)EInteractableToolTags::Poke;
+
+	FVector RandomPosition(FRandomStream& Random, float Range)
+	{
+		return FVector(Random.FRandRange(-Range, Range), Random.FRandRange(-Range, Range),
+			Random.FRandRange(-Range, Range));
+	}
+
+	FTransform RandomBoxTransform(FRandomStream& Random)
+	{
+		FRotator Rotation(Random.FRandRange(-180.0f, 180.0f), Random.FRandRange(-180.0f, 180.0f),
+			Random.FRandRange(-180.0f, 180.0f));
+		return FTransform(Rotation, RandomPosition(Random, 1000.0f));
+	}
+
+	FVector RandomExtent(FRandomStream& Random)
+	{
+		return FVector(Random.FRandRange(2.0f, 60.0f), Random.FRandRange(2.0f, 60.0f), Random.FRandRange(2.0f, 60.0f));
+	}
+
+	/** Same boxes in both grids, in the same order, so ids match. */
+	void AddRandomBoxes(FInteractableSpatialGrid& Grid, FInteractableSpatialGrid& ReferenceGrid, int32 NumBoxes,
+		FRandomStream& Random)
+	{
+		const uint32 Masks[3] = { RayMask, PokeMask, RayMask | PokeMask };
+		for (int32 Index = 0; Index < NumBoxes; Index++)
+		{
+			FTransform BoxTransform = RandomBoxTransform(Random);
+			FVector Extent = RandomExtent(Random);
+			uint32 Mask = Masks[Random.RandRange(0, 2)];
+			Grid.Add(BoxTransform, Extent, Mask);
+			ReferenceGrid.Add(BoxTransform, Extent, Mask);
+		}
+	}
+
+	bool SameIds(TArray<int32> Ids, TArray<int32> ReferenceIds)
+	{
+		Ids.Sort();
+		ReferenceIds.Sort();
+		return Ids == ReferenceIds;
+	}
+
+	bool SameHits(const TArray<FInteractableSpatialGrid::FRayHit>& Hits,
+		const TArray<FInteractableSpatialGrid::FRayHit>& ReferenceHits)
+	{
+		if (Hits.Num() != ReferenceHits.Num())
+		{
+			return false;
+		}
+		// boxes entered at the same distance may come in either order
+		for (int32 Index = 0; Index < Hits.Num(); Index++)
+		{
+			if (!FMath::IsNearlyEqual(Hits[Index].Distance, ReferenceHits[Index].Distance, 0.001f))
+			{
+				return false;
+			}
+		}
+		TArray<int32> Ids;
+		TArray<int32> ReferenceIds;
+		for (int32 Index = 0; Index < Hits.Num(); Index++)
+		{
+			Ids.Add(Hits[Index].Id);
+			ReferenceIds.Add(ReferenceHits[Index].Id);
+		}
+		return SameIds(Ids, ReferenceIds);
+	}
+
+	/**
+	 * Runs random queries on a grid and on one with a few huge cells,
+	 * which tests every box, so only the cell walks can differ.
+	 */
+	void CompareQueries(FAutomationTestBase& Test, const FInteractableSpatialGrid& Grid,
+		const FInteractableSpatialGrid& ReferenceGrid, FRandomStream& Random, const TCHAR* Stage)
+	{
+		const int32 NumQueries = 200;
+		int32 NumMismatches = 0;
+		int32 NumFound = 0;
+		for (int32 Query = 0; Query < NumQueries; Query++)
+		{
+			uint32 Mask = Query % 2 == 0 ? RayMask : PokeMask;
+			FVector Origin = RandomPosition(Random, 1200.0f);
+			FVector Direction = Random.GetUnitVector();
+			float MaxDistance = Random.FRandRange(10.0f, 2500.0f);
+
+			TArray<FInteractableSpatialGrid::FRayHit> Hits;
+			TArray<FInteractableSpatialGrid::FRayHit> ReferenceHits;
+			Grid.Raycast(Origin, Direction, MaxDistance, Mask, Hits);
+			ReferenceGrid.Raycast(Origin, Direction, MaxDistance, Mask, ReferenceHits);
+			NumMismatches += SameHits(Hits, ReferenceHits) ? 0 : 1;
+			NumFound += Hits.Num();
+
+			// skipping some boxes makes the walk go past them
+			auto Accept = [](int32 Id) { return Id % 3 != 0; };
+			FInteractableSpatialGrid::FRayHit FirstHit;
+			FInteractableSpatialGrid::FRayHit ReferenceFirstHit;
+			int32 NumTested;
+			int32 ReferenceNumTested;
+			bool bHit = Grid.RaycastFirst(Origin, Direction, MaxDistance, Mask, Accept, FirstHit, NumTested);
+			bool bReferenceHit = ReferenceGrid.RaycastFirst(Origin, Direction, MaxDistance, Mask, Accept,
+				ReferenceFirstHit, ReferenceNumTested);
+			NumMismatches += bHit != bReferenceHit
+				|| (bHit && !FMath::IsNearlyEqual(FirstHit.Distance, ReferenceFirstHit.Distance, 0.001f)) ? 1 : 0;
+
+			FVector Center = RandomPosition(Random, 1000.0f);
+			TArray<int32> Ids;
+			TArray<int32> ReferenceIds;
+			FQuat Rotation = RandomBoxTransform(Random).GetRotation();
+			FVector Extent = RandomExtent(Random) * 3.0f;
+			Grid.OverlapBox(Center, Rotation, Extent, Mask, Ids);
+			ReferenceGrid.OverlapBox(Center, Rotation, Extent, Mask, ReferenceIds);
+			NumMismatches += SameIds(Ids, ReferenceIds) ? 0 : 1;
+			NumFound += Ids.Num();
+
+			Ids.Reset();
+			ReferenceIds.Reset();
+			float Radius = Random.FRandRange(1.0f, 200.0f);
+			Grid.OverlapSphere(Center, Radius, Mask, Ids);
+			ReferenceGrid.OverlapSphere(Center, Radius, Mask, ReferenceIds);
+			NumMismatches += SameIds(Ids, ReferenceIds) ? 0 : 1;
+			NumFound += Ids.Num();
+
+			Hits.Reset();
+			ReferenceHits.Reset();
+			FVector End = Center + Random.GetUnitVector() * Random.FRandRange(0.0f, 100.0f);
+			Grid.SweepSphere(Center, End, Radius * 0.1f, Mask, Hits);
+			ReferenceGrid.SweepSphere(Center, End, Radius * 0.1f, Mask, ReferenceHits);
+			NumMismatches += SameHits(Hits, ReferenceHits) ? 0 : 1;
+			NumFound += Hits.Num();
+		}
+		Test.TestEqual(FString::Printf(TEXT("%s: queries that differ from a full scan"), Stage), NumMismatches, 0);
+		// make sure the queries weren't all misses
+		Test.TestTrue(FString::Printf(TEXT("%s: boxes found"), Stage), NumFound > NumQueries);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableSpatialGridMatchesScanTest, "HandsTrain.SpatialIndex.GridMatchesScan",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableSpatialGridMatchesScanTest::RunTest(const FString& Parameters)
+{
+	FRandomStream Random(1357);
+	FInteractableSpatialGrid Grid(50.0f);
+	FInteractableSpatialGrid ReferenceGrid(1.e7f);
+	const int32 NumBoxes = 2000;
+	AddRandomBoxes(Grid, ReferenceGrid, NumBoxes, Random);
+	CompareQueries(*this, Grid, ReferenceGrid, Random, TEXT("added"));
+
+	// move a quarter of the boxes and remove another quarter
+	for (int32 Id = 0; Id < NumBoxes; Id += 4)
+	{
+		FTransform BoxTransform = RandomBoxTransform(Random);
+		FVector Extent = RandomExtent(Random);
+		Grid.Update(Id, BoxTransform, Extent);
+		ReferenceGrid.Update(Id, BoxTransform, Extent);
+		Grid.Remove(Id + 1);
+		ReferenceGrid.Remove(Id + 1);
+	}
+	TestEqual(TEXT("boxes left"), Grid.Num(), NumBoxes - NumBoxes / 4);
+	CompareQueries(*this, Grid, ReferenceGrid, Random, TEXT("moved and removed"));
+
+	// freed ids are reused
+	AddRandomBoxes(Grid, ReferenceGrid, NumBoxes / 8, Random);
+	TestEqual(TEXT("boxes after reuse"), Grid.Num(), NumBoxes - NumBoxes / 8);
+	CompareQueries(*this, Grid, ReferenceGrid, Random, TEXT("re-added"));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableSpatialGridKnownHitsTest, "HandsTrain.SpatialIndex.KnownHits",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableSpatialGridKnownHitsTest::RunTest(const FString& Parameters)
+{
+	FInteractableSpatialGrid Grid(50.0f);
+	// a 20 unit cube turned 45 degrees, so the ray meets its edge
+	int32 TurnedId = Grid.Add(FTransform(FRotator(0.0f, 45.0f, 0.0f), FVector(100.0f, 0.0f, 0.0f)),
+		FVector(10.0f), RayMask);
+	int32 PokeId = Grid.Add(FTransform(FVector(300.0f, 0.0f, 0.0f)), FVector(10.0f), PokeMask);
+
+	TArray<FInteractableSpatialGrid::FRayHit> Hits;
+	Grid.Raycast(FVector::ZeroVector, FVector::ForwardVector, 1000.0f, RayMask, Hits);
+	TestEqual(TEXT("ray hits"), Hits.Num(), 1);
+	if (Hits.Num() == 1)
+	{
+		TestEqual(TEXT("ray hits the turned box"), Hits[0].Id, TurnedId);
+		TestEqual(TEXT("at its edge"), Hits[0].Distance, 100.0f - 10.0f * UE_SQRT_2, 0.001f);
+	}
+	Hits.Reset();
+	Grid.Raycast(FVector::ZeroVector, FVector::ForwardVector, 80.0f, RayMask, Hits);
+	TestEqual(TEXT("short ray misses"), Hits.Num(), 0);
+
+	TArray<int32> Ids;
+	Grid.OverlapSphere(FVector::ZeroVector, 85.0f, RayMask, Ids);
+	TestEqual(TEXT("sphere short of the edge"), Ids.Num(), 0);
+	Grid.OverlapSphere(FVector::ZeroVector, 86.0f, RayMask, Ids);
+	TestEqual(TEXT("sphere reaching the edge"), Ids.Num(), 1);
+
+	Ids.Reset();
+	Grid.OverlapBox(FVector(300.0f, 0.0f, 25.0f), FQuat::Identity, FVector(20.0f), RayMask | PokeMask, Ids);
+	TestTrue(TEXT("box overlaps the poke box"), Ids.Num() == 1 && Ids[0] == PokeId);
+
+	Grid.Remove(PokeId);
+	Ids.Reset();
+	Grid.OverlapBox(FVector(300.0f, 0.0f, 25.0f), FQuat::Identity, FVector(20.0f), RayMask | PokeMask, Ids);
+	TestEqual(TEXT("removed box is gone"), Ids.Num(), 0);
+	TestEqual(TEXT("boxes left"), Grid.Num(), 1);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableSpatialIndexBenchmarkTest, "HandsTrain.SpatialIndex.Benchmark",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableSpatialIndexBenchmarkTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	// a wall of 5k buttons in front of the player, 30 units apart
+	const int32 NumInteractables = 5000;
+	const int32 NumColumns = 100;
+	for (int32 Index = 0; Index < NumInteractables; Index++)
+	{
+		FVector Position(300.0f, (Index % NumColumns - NumColumns / 2) * 30.0f, (Index / NumColumns) * 30.0f);
+		World.SpawnInteractable(FTransform(Position), EInteractableToolTags::Ray, FVector(2.0f));
+	}
+	UInteractableSpatialIndex* SpatialIndex = World.Get()->GetSubsystem<UInteractableSpatialIndex>();
+	TestEqual(TEXT("zones indexed"), SpatialIndex->GetNumZones(), 3 * NumInteractables);
+	// lets the physics scene pick up the new bodies
+	World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+
+	// the ray tool's cone box, and a poke sized sphere, aimed around the wall
+	FRandomStream Random(2468);
+	const int32 NumQueries = 200;
+	const FVector ConeExtent(500.0f, 50.0f, 50.0f);
+	TArray<FVector> Centers;
+	TArray<FQuat> Rotations;
+	for (int32 Query = 0; Query < NumQueries; Query++)
+	{
+		FRotator Aim(Random.FRandRange(0.0f, 60.0f), Random.FRandRange(-60.0f, 60.0f), 0.0f);
+		Rotations.Add(Aim.Quaternion());
+		Centers.Add(FVector(0.0f, 0.0f, 500.0f) + Aim.Vector() * ConeExtent.X);
+	}
+
+	TArray<UColliderZone*> IndexZones;
+	TArray<FOverlapResult> Overlaps;
+	int32 NumMismatches = 0;
+	int32 NumFound = 0;
+	double IndexTime = 0.0;
+	double PhysicsTime = 0.0;
+	for (int32 Query = 0; Query < NumQueries; Query++)
+	{
+		for (bool bSphere : { false, true })
+		{
+			FCollisionShape Shape = bSphere ? FCollisionShape::MakeSphere(40.0f) : FCollisionShape::MakeBox(ConeExtent);
+			IndexZones.Reset();
+			double StartTime = FPlatformTime::Seconds();
+			if (bSphere)
+			{
+				SpatialIndex->OverlapSphere(Centers[Query], Shape.GetSphereRadius(), RayMask, IndexZones);
+			}
+			else
+			{
+				SpatialIndex->OverlapBox(Centers[Query], Rotations[Query], ConeExtent, RayMask, IndexZones);
+			}
+			IndexTime += FPlatformTime::Seconds() - StartTime;
+
+			Overlaps.Reset();
+			StartTime = FPlatformTime::Seconds();
+			World.Get()->OverlapMultiByChannel(Overlaps, Centers[Query], Rotations[Query],
+				ECollisionChannel::ECC_GameTraceChannel1, Shape);
+			PhysicsTime += FPlatformTime::Seconds() - StartTime;
+
+			TSet<UColliderZone*> PhysicsZones;
+			for (const FOverlapResult& Overlap : Overlaps)
+			{
+				PhysicsZones.Add(Cast<UColliderZone>(Overlap.Component.Get()));
+			}
+			bool bSame = PhysicsZones.Num() == IndexZones.Num();
+			for (UColliderZone* Zone : IndexZones)
+			{
+				bSame = bSame && PhysicsZones.Contains(Zone);
+			}
+			NumMismatches += bSame ? 0 : 1;
+			NumFound += IndexZones.Num();
+		}
+	}
+	// physics pads shapes a little, so a zone grazing a query can come out either way
+	TestTrue(FString::Printf(TEXT("index and physics agree (%d of %d differ)"), NumMismatches, 2 * NumQueries),
+		NumMismatches <= 2 * NumQueries / 50);
+	TestTrue(TEXT("zones found"), NumFound > NumQueries);
+	AddInfo(FString::Printf(TEXT("%d interactables: %.4f ms per index query, %.4f ms per physics query"),
+		NumInteractables, IndexTime * 1000.0 / (2 * NumQueries), PhysicsTime * 1000.0 / (2 * NumQueries)));
+	return true;
+}
+
+#endif
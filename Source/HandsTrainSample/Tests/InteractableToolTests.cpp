@@ -0,0 +1,141 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "ColliderZone.h"
+#include "HandsTrainTestWorld.h"
+#include "Interactable.h"
+#include "InteractableTool.h"
+#include "ScopedAllocationCounter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 NumInteractables = 4;
+
+	/** An interactable with a proximity, contact and action zone. */
+	AInteractable* SpawnInteractable(FHandsTrainTestWorld& World, float X)
+	{
+		AInteractable* Interactable = World.Spawn<AInteractable>(FTransform(FVector(X, 0.0f, 0.0f)));
+		UColliderZone** Zones[3] = { &Interactable->ProximityZone, &Interactable->ContactZone,
+			&Interactable->ActionZone };
+		for (UColliderZone** Zone : Zones)
+		{
+			*Zone = NewObject<UColliderZone>(Interactable);
+			(*Zone)->ParentInteractable = Interactable;
+		}
+		return Interactable;
+	}
+
+	/** Fills in what the tool touches on a frame, the way tools do in RefreshCurrentIntersectingObjects. */
+	void SetIntersectingObjects(AInteractableTool* Tool, const TArray<AInteractable*>& Interactables, int32 Frame)
+	{
+		Tool->CurrentIntersectingObjects.Reset();
+		// two of the interactables at a time, so some are added, removed and kept every frame
+		for (int32 Offset = 0; Offset < 2; Offset++)
+		{
+			AInteractable* Interactable = Interactables[(Frame + Offset) % Interactables.Num()];
+			Tool->CurrentIntersectingObjects.Add(FInteractableCollisionInfo(Interactable->ProximityZone,
+				EInteractableCollisionDepth::Proximity, Tool));
+			if ((Frame + Offset) % 3 != 0)
+			{
+				Tool->CurrentIntersectingObjects.Add(FInteractableCollisionInfo(Interactable->ContactZone,
+					EInteractableCollisionDepth::Contact, Tool));
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableToolNoAllocationsTest, "HandsTrain.InteractableTool.NoAllocationsPerFrame",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableToolNoAllocationsTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	AInteractableTool* Tool = World.Spawn<AInteractableTool>();
+	TArray<AInteractable*> Interactables;
+	for (int32 Index = 0; Index < NumInteractables; Index++)
+	{
+		Interactables.Add(SpawnInteractable(World, Index * 100.0f));
+	}
+
+	// the first few frames may still grow the containers
+	int32 Frame = 0;
+	for (; Frame < NumInteractables * 3; Frame++)
+	{
+		SetIntersectingObjects(Tool, Interactables, Frame);
+		Tool->UpdateCurrentCollisionsMapBasedOnDepth();
+		Tool->SyncLatestCollisionDataWithInteractables();
+	}
+
+	const int32 NumFrames = 10000;
+	int32 NumAllocations = 0;
+	double StartTime = FPlatformTime::Seconds();
+	{
+		FScopedAllocationCounter AllocationCounter;
+		for (int32 Count = 0; Count < NumFrames; Count++, Frame++)
+		{
+			SetIntersectingObjects(Tool, Interactables, Frame);
+			Tool->UpdateCurrentCollisionsMapBasedOnDepth();
+			Tool->SyncLatestCollisionDataWithInteractables();
+		}
+		NumAllocations = AllocationCounter.GetNumAllocations();
+	}
+	double ElapsedTime = FPlatformTime::Seconds() - StartTime;
+
+	TestEqual(FString::Printf(TEXT("allocations over %d frames"), NumFrames), NumAllocations, 0);
+	AddInfo(FString::Printf(TEXT("%d frames: %.4f ms per frame"), NumFrames, ElapsedTime * 1000.0 / NumFrames));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInteractableToolCollisionOrderTest, "HandsTrain.InteractableTool.CollisionOrder",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInteractableToolCollisionOrderTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	AInteractableTool* Tool = World.Spawn<AInteractableTool>();
+	TArray<AInteractable*> Interactables;
+	for (int32 Index = 0; Index < NumInteractables; Index++)
+	{
+		Interactables.Add(SpawnInteractable(World, Index * 100.0f));
+	}
+
+	// infos keep the order the interactables were found in, whatever their addresses
+	const int32 FoundOrders[3][NumInteractables] = { { 2, 0, 3, 1 }, { 1, 3, 0, 2 }, { 3, 2, 1, 0 } };
+	for (const int32(&FoundOrder)[NumInteractables] : FoundOrders)
+	{
+		Tool->CurrentIntersectingObjects.Reset();
+		for (int32 Index : FoundOrder)
+		{
+			Tool->CurrentIntersectingObjects.Add(FInteractableCollisionInfo(Interactables[Index]->ProximityZone,
+				EInteractableCollisionDepth::Proximity, Tool));
+		}
+		// a deeper zone of the first one found later on doesn't move it
+		Tool->CurrentIntersectingObjects.Add(FInteractableCollisionInfo(
+			Interactables[FoundOrder[0]]->ActionZone, EInteractableCollisionDepth::Action, Tool));
+		Tool->UpdateCurrentCollisionsMapBasedOnDepth();
+		Tool->SyncLatestCollisionDataWithInteractables();
+
+		// the first info is returned even though another interactable is closer
+		FVector ClosestToLast = Interactables[FoundOrder[NumInteractables - 1]]->GetActorLocation();
+		FCollisionInfoKeyValuePair First = Tool->GetFirstCurrentCollisionInfoClosestToPosition(ClosestToLast);
+		TestTrue(TEXT("first found comes first"), First.Interactable == Interactables[FoundOrder[0]]);
+		TestTrue(TEXT("deepest zone is kept"),
+			First.CollisionInfo.CollisionDepth == EInteractableCollisionDepth::Action);
+	}
+
+	Tool->ClearAllCurrentCollisionInfos();
+	Tool->SyncLatestCollisionDataWithInteractables();
+	FCollisionInfoKeyValuePair None = Tool->GetFirstCurrentCollisionInfoClosestToPosition(FVector::ZeroVector);
+	TestNull(TEXT("cleared"), None.Interactable);
+	return true;
+}
+
+#endif
@@ -0,0 +1,247 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HandInputSource.h"
+#include "HandInputSubsystem.h"
+#include "HandsTrainStats.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableToolsManager.h"
+#include "Misc/Paths.h"
+#include "OculusXRHandComponent.h"
+#include "RayTool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// a wall of interactables in front of the player
+	const int32 GridSize = 5;
+	const float GridSpacing = 100.0f;
+	const float GridDistance = 400.0f;
+
+	// the pointer turns to a new aim point, then holds still for the rest of the segment
+	const int32 NumSegments = 28;
+	const int32 FramesPerSegment = 30;
+	const int32 FramesToTurn = 10;
+	const int32 FirstPinchFrame = 18;
+	const int32 LastPinchFrame = 23;
+	// on segments aimed at nothing, an interactable is moved into the ray while it holds still
+	const int32 MoveIntoRayFrame = 20;
+
+	FVector GetGridPosition(int32 Index)
+	{
+		return FVector(GridDistance, (Index % GridSize - GridSize / 2) * GridSpacing,
+			(Index / GridSize - GridSize / 2) * GridSpacing);
+	}
+
+	bool IsAimedAtNothing(int32 Segment)
+	{
+		return Segment % 4 == 3;
+	}
+
+	/** Far enough above the wall that the cone test finds nothing either. */
+	FVector GetAimPoint(int32 Segment)
+	{
+		if (IsAimedAtNothing(Segment))
+		{
+			return FVector(GridDistance, (Segment % 3 - 1) * 2.0f * GridSpacing, 7.0f * GridSpacing);
+		}
+		return GetGridPosition((Segment * 7) % (GridSize * GridSize));
+	}
+
+	/** Right hand only; tracking is lost for a whole segment now and then. */
+	void RecordInput(FHandInputRecorder& Recorder)
+	{
+		FQuat PrevRotation = FQuat::Identity;
+		for (int32 Segment = 0; Segment < NumSegments; Segment++)
+		{
+			FQuat Rotation = GetAimPoint(Segment).ToOrientationQuat();
+			for (int32 SegmentFrame = 0; SegmentFrame < FramesPerSegment; SegmentFrame++)
+			{
+				FHandInputFrame Frame;
+				Frame.bHandTrackingEnabled = true;
+				FHandInputState& HandState = Frame.Hands[FHandInputFrame::GetHandIndex(EOculusXRHandType::HandRight)];
+				HandState.TrackingConfidence = Segment % 7 == 5 ? EOculusXRTrackingConfidence::Low
+					: EOculusXRTrackingConfidence::High;
+				HandState.bPointerPoseValid = true;
+				float Alpha = FMath::Min((float)SegmentFrame / FramesToTurn, 1.0f);
+				HandState.PointerPose = FTransform(FQuat::Slerp(PrevRotation, Rotation, Alpha));
+				HandState.PinchStrength = SegmentFrame >= FirstPinchFrame && SegmentFrame <= LastPinchFrame ? 1.0f : 0.0f;
+				Recorder.AddFrame(Frame);
+			}
+			PrevRotation = Rotation;
+		}
+	}
+
+	UObject* GetFocusedInteractable(ARayTool* RayTool)
+	{
+		return FindFProperty<FObjectProperty>(ARayTool::StaticClass(), TEXT("FocusedInteractable"))
+			->GetObjectPropertyValue_InContainer(RayTool);
+	}
+
+	/** What the rest of the game sees of the tool and interactables after a frame. */
+	FString DescribeFrame(ARayTool* RayTool, const TArray<ACollidableInteractable*>& Interactables)
+	{
+		FString Description = FString::Printf(TEXT("focus %d, input %d, %d intersecting;"),
+			Interactables.IndexOfByKey(GetFocusedInteractable(RayTool)), (int32)RayTool->GetCurrInputState(),
+			RayTool->CurrentIntersectingObjects.Num());
+
+		FArrayProperty* ToolSlotsProperty =
+			FindFProperty<FArrayProperty>(ACollidableInteractable::StaticClass(), TEXT("ToolSlots"));
+		for (int32 Index = 0; Index < Interactables.Num(); Index++)
+		{
+			const TArray<FInteractableToolSlot>& ToolSlots =
+				*ToolSlotsProperty->ContainerPtrToValuePtr<TArray<FInteractableToolSlot>>(Interactables[Index]);
+			for (const FInteractableToolSlot& ToolSlot : ToolSlots)
+			{
+				Description += FString::Printf(TEXT(" %d:%d"), Index, (int32)ToolSlot.State);
+			}
+		}
+		return Description;
+	}
+
+	struct FReplayResult
+	{
+		TArray<FString> Frames;
+		int32 NumFramesFocusedOnMovedInteractable = 0;
+		int32 NumToolsEvaluated = 0;
+		int32 NumToolsSkipped = 0;
+		double Seconds = 0.0;
+	};
+
+	/** Plays the recording to a ray tool the way a level sets it up, in a world of its own. */
+	FReplayResult Replay(const FString& RecordingPath, bool bSkipIdleTools)
+	{
+		FHandsTrainTestWorld World;
+		// ray tools are placed relative to the player pawn
+		APlayerController* Controller = World.Spawn<APlayerController>();
+		Controller->Possess(World.Spawn<APawn>());
+
+		TArray<ACollidableInteractable*> Interactables;
+		for (int32 Index = 0; Index < GridSize * GridSize; Index++)
+		{
+			Interactables.Add(World.SpawnInteractable(FTransform(GetGridPosition(Index)), EInteractableToolTags::Ray));
+		}
+
+		// only posed by the recording, which has no bones here
+		UOculusXRHandComponent* Hand = NewObject<UOculusXRHandComponent>(World.Spawn<AActor>());
+		Hand->SkeletonType = EOculusXRHandType::HandRight;
+		Hand->MeshType = EOculusXRHandType::HandRight;
+		Hand->PrimaryComponentTick.bCanEverTick = false;
+		Hand->RegisterComponent();
+
+		AInteractableToolsManager* Manager = World.Get()->SpawnActorDeferred<AInteractableToolsManager>(
+			AInteractableToolsManager::StaticClass(), FTransform::Identity);
+		Manager->bSkipIdleTools = bSkipIdleTools;
+		Manager->FinishSpawning(FTransform::Identity);
+
+		// set on the ray tool blueprint in the game
+		ARayTool* RayTool = World.Spawn<ARayTool>();
+		RayTool->IsFarFieldTool = true;
+		Manager->AddTickPrerequisiteActor(RayTool);
+		struct
+		{
+			UOculusXRHandComponent* Hand;
+			AInteractableTool* Tool;
+		} Params = { Hand, RayTool };
+		Manager->ProcessEvent(Manager->FindFunctionChecked(TEXT("AssociateToolWithHand")), &Params);
+
+		FReplayResult Result;
+		UHandInputSubsystem* HandInput = World.Get()->GetSubsystem<UHandInputSubsystem>();
+		if (!HandInput->StartPlayback(RecordingPath))
+		{
+			return Result;
+		}
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumSegments * FramesPerSegment; Frame++)
+		{
+			// the engine loop isn't running, so count frames the way it would;
+			// idle tool skipping and zone change tracking go by the frame count
+			GFrameCounter++;
+
+			int32 Segment = Frame / FramesPerSegment;
+			int32 SegmentFrame = Frame % FramesPerSegment;
+			int32 MovedIndex = Segment % Interactables.Num();
+			if (IsAimedAtNothing(Segment) && SegmentFrame == MoveIntoRayFrame)
+			{
+				Interactables[MovedIndex]->SetActorLocation(GetAimPoint(Segment).GetSafeNormal() * GridDistance);
+			}
+			else if (IsAimedAtNothing(Segment) && SegmentFrame == FramesPerSegment - 1)
+			{
+				Interactables[MovedIndex]->SetActorLocation(GetGridPosition(MovedIndex));
+			}
+
+			World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+
+			Result.NumToolsEvaluated += FHandsTrainFrameStats::GetCount(EHandsTrainCounter::ToolsEvaluated);
+			Result.NumToolsSkipped += FHandsTrainFrameStats::GetCount(EHandsTrainCounter::ToolsSkipped);
+			Result.Frames.Add(DescribeFrame(RayTool, Interactables));
+			if (IsAimedAtNothing(Segment) && SegmentFrame > MoveIntoRayFrame
+				&& GetFocusedInteractable(RayTool) == Interactables[MovedIndex])
+			{
+				Result.NumFramesFocusedOnMovedInteractable++;
+			}
+		}
+		Result.Seconds = FPlatformTime::Seconds() - StartTime;
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputRouterSkipIdleToolsParityTest, "HandsTrain.InputRouter.SkipIdleToolsParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FInputRouterSkipIdleToolsParityTest::RunTest(const FString& Parameters)
+{
+	FHandInputRecorder Recorder;
+	RecordInput(Recorder);
+	FString RecordingPath = FPaths::ConvertRelativePathToFull(
+		FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("InputRouterReplay.bin")));
+	if (!TestTrue(TEXT("recording saved"), Recorder.Save(RecordingPath)))
+	{
+		return false;
+	}
+
+	FReplayResult Evaluated = Replay(RecordingPath, false);
+	FReplayResult Skipped = Replay(RecordingPath, true);
+	IFileManager::Get().Delete(*RecordingPath);
+
+	const int32 NumFrames = NumSegments * FramesPerSegment;
+	TestEqual(TEXT("frames replayed without skipping"), Evaluated.Frames.Num(), NumFrames);
+	TestEqual(TEXT("frames replayed with skipping"), Skipped.Frames.Num(), NumFrames);
+	int32 NumMismatches = 0;
+	for (int32 Frame = 0; Frame < FMath::Min(Evaluated.Frames.Num(), Skipped.Frames.Num()); Frame++)
+	{
+		if (Evaluated.Frames[Frame] == Skipped.Frames[Frame])
+		{
+			continue;
+		}
+		NumMismatches++;
+		if (NumMismatches <= 5)
+		{
+			AddError(FString::Printf(TEXT("frame %d: '%s' when evaluated, '%s' when skipped"), Frame,
+				*Evaluated.Frames[Frame], *Skipped.Frames[Frame]));
+		}
+	}
+	TestEqual(TEXT("frames where skipping idle tools changed the result"), NumMismatches, 0);
+
+	// otherwise the parity above doesn't say much
+	TestTrue(TEXT("interactables moved into the ray are focused"), Evaluated.NumFramesFocusedOnMovedInteractable > 0);
+	TestEqual(TEXT("nothing is skipped with skipping off"), Evaluated.NumToolsSkipped, 0);
+	TestTrue(TEXT("idle tools are skipped"), Skipped.NumToolsSkipped > 0);
+	AddInfo(FString::Printf(TEXT("%d frames: %d evaluations in %.3f ms without skipping, %d evaluations and %d skips in %.3f ms with"),
+		NumFrames, Evaluated.NumToolsEvaluated, Evaluated.Seconds * 1000.0, Skipped.NumToolsEvaluated,
+		Skipped.NumToolsSkipped, Skipped.Seconds * 1000.0));
+	return true;
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandsTrainTestWorld.h"
+#include "Interactable.h"
+#include "Math/RandomStream.h"
+#include "RayTool.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	ARayTool* SpawnRayTool(FHandsTrainTestWorld& World, bool bUseSpatialIndex)
+	{
+		// the index is picked up at BeginPlay
+		ARayTool* RayTool = World.Get()->SpawnActorDeferred<ARayTool>(ARayTool::StaticClass(), FTransform::Identity);
+		FHandsTrainTestWorld::SetProperty(RayTool, TEXT("bUseSpatialIndex"), bUseSpatialIndex);
+		RayTool->FinishSpawning(FTransform::Identity);
+		return RayTool;
+	}
+
+	/** Calls the protected, blueprint callable FindPrimaryRaycastHit. */
+	AInteractable* FindPrimaryRaycastHit(ARayTool* RayTool, bool bUseFirstHitRaycast, const FVector& RayOrigin,
+		const FVector& RayDirection)
+	{
+		FHandsTrainTestWorld::SetProperty(RayTool, TEXT("bUseFirstHitRaycast"), bUseFirstHitRaycast);
+		struct
+		{
+			FVector RayOrigin;
+			FVector RayDirection;
+			AInteractable* ReturnValue;
+		} Params = { RayOrigin, RayDirection, nullptr };
+		RayTool->ProcessEvent(RayTool->FindFunctionChecked(TEXT("FindPrimaryRaycastHit")), &Params);
+		return Params.ReturnValue;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRayToolFirstHitParityTest, "HandsTrain.RayTool.FirstHitParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRayToolFirstHitParityTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	FRandomStream Random(97531);
+
+	// interactables far enough apart that whatever a ray aimed at one passes
+	// through first also has the nearer center, so both paths should agree;
+	// every fourth one only takes poke tools, so the ray has to skip it
+	const int32 NumInteractables = 600;
+	const float MinSeparation = 60.0f;
+	TArray<AInteractable*> Interactables;
+	TArray<FVector> Positions;
+	while (Positions.Num() < NumInteractables)
+	{
+		FVector Position(Random.FRandRange(100.0f, 1500.0f), Random.FRandRange(-700.0f, 700.0f),
+			Random.FRandRange(-700.0f, 700.0f));
+		bool bTooClose = Positions.ContainsByPredicate([&](const FVector& Other) {
+			return FVector::DistSquared(Position, Other) < MinSeparation * MinSeparation;
+		});
+		if (bTooClose)
+		{
+			continue;
+		}
+		EInteractableToolTags ToolTags = Positions.Num() % 4 == 3 ? EInteractableToolTags::Poke
+			: EInteractableToolTags::Ray;
+		Positions.Add(Position);
+		Interactables.Add(World.SpawnInteractable(FTransform(Position), ToolTags, FVector(2.0f)));
+	}
+	ARayTool* IndexRayTool = SpawnRayTool(World, true);
+	ARayTool* PhysicsRayTool = SpawnRayTool(World, false);
+	// lets the physics scene pick up the new bodies
+	World.Get()->Tick(LEVELTICK_All, 1.0f / 72.0f);
+
+	const int32 NumRays = 1000;
+	int32 NumHits = 0;
+	int32 NumMismatches = 0;
+	double FirstHitTime = 0.0;
+	double AllHitsTime = 0.0;
+	for (int32 Ray = 0; Ray < NumRays; Ray++)
+	{
+		// aimed at an interactable, or at nothing in particular
+		FVector RayDirection = Ray % 5 == 4 ? Random.GetUnitVector()
+			: Positions[Random.RandRange(0, NumInteractables - 1)].GetSafeNormal();
+
+		// the old path through physics is what the others have to match
+		double StartTime = FPlatformTime::Seconds();
+		AInteractable* Expected = FindPrimaryRaycastHit(PhysicsRayTool, false, FVector::ZeroVector, RayDirection);
+		AInteractable* IndexAllHits = FindPrimaryRaycastHit(IndexRayTool, false, FVector::ZeroVector, RayDirection);
+		AllHitsTime += FPlatformTime::Seconds() - StartTime;
+		StartTime = FPlatformTime::Seconds();
+		AInteractable* PhysicsFirstHit = FindPrimaryRaycastHit(PhysicsRayTool, true, FVector::ZeroVector, RayDirection);
+		AInteractable* IndexFirstHit = FindPrimaryRaycastHit(IndexRayTool, true, FVector::ZeroVector, RayDirection);
+		FirstHitTime += FPlatformTime::Seconds() - StartTime;
+
+		if (IndexAllHits != Expected || PhysicsFirstHit != Expected || IndexFirstHit != Expected)
+		{
+			NumMismatches++;
+			if (NumMismatches <= 5)
+			{
+				AddError(FString::Printf(TEXT("ray %d: expected %s, got %s (index), %s (physics first hit), %s (index first hit)"),
+					Ray, *GetNameSafe(Expected), *GetNameSafe(IndexAllHits), *GetNameSafe(PhysicsFirstHit),
+					*GetNameSafe(IndexFirstHit)));
+			}
+		}
+		if (Expected != nullptr)
+		{
+			NumHits++;
+			TestTrue(TEXT("only ray interactables are picked"),
+				(Expected->GetValidToolTagsMask() & (int)EInteractableToolTags::Ray) != 0);
+		}
+	}
+	TestEqual(TEXT("rays where the paths disagree"), NumMismatches, 0);
+	TestTrue(TEXT("rays hit something"), NumHits > NumRays / 2);
+	AddInfo(FString::Printf(TEXT("%d rays, %d hits: %.4f ms per all hits query, %.4f ms per first hit query"),
+		NumRays, NumHits, AllHitsTime * 1000.0 / (2 * NumRays), FirstHitTime * 1000.0 / (2 * NumRays)));
+	return true;
+}
+
+#endif
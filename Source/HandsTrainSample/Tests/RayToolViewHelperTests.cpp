@@ -0,0 +1,232 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "HandsTrainTestWorld.h"
+#include "InteractableTool.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Math/RandomStream.h"
+#include "RayToolViewHelper.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// match the view helper's instance count and mesh scale
+	const int32 MaxSegments = 24;
+	const int32 MinSegments = 4;
+	const float RayScaleFactor = 0.01f;
+	const float DefaultRayCastDistance = 300.0f;
+
+	const int32 NumPoses = 200;
+	const int32 NumBenchmarkUpdates = 20000;
+
+	struct FRayPose
+	{
+		FTransform ToolTransform;
+		// none for the default length ray
+		AInteractable* Target = nullptr;
+	};
+
+	/**
+	 * Segment transforms the way the view helper built them one point at a
+	 * time, with each segment along the chord between its points. Points
+	 * are spread over the segments in use, and unused segments collapse at
+	 * the target.
+	 */
+	void BuildReferenceTransforms(const FVector& ToolPosition, const FVector& ToolForward,
+		const FVector& TargetPosition, int32 NumSegments, const FTransform& InstanceWorldToLocal,
+		TArray<FTransform>& OutTransforms)
+	{
+		float TargetDistance = (TargetPosition - ToolPosition).Size();
+		FVector P0 = ToolPosition;
+		FVector P1 = ToolPosition + ToolForward * TargetDistance * 0.3333333f;
+		FVector P2 = ToolPosition + ToolForward * TargetDistance * 0.6666667f;
+		FVector P3 = TargetPosition;
+
+		OutTransforms.SetNum(MaxSegments);
+		FVector RayPointBefore = P0;
+		for (int32 PointIndex = 1; PointIndex <= NumSegments; PointIndex++)
+		{
+			float T = FMath::Clamp((float)PointIndex / NumSegments, 0.0f, 1.0f);
+			float OneMinusT = 1.0f - T;
+			FVector CurrentRayPoint = OneMinusT * OneMinusT * OneMinusT * P0 + 3.0f * OneMinusT * OneMinusT * T * P1
+				+ 3.0f * OneMinusT * T * T * P2 + T * T * T * P3;
+
+			FVector SegmentVector = CurrentRayPoint - RayPointBefore;
+			float SegmentSize = SegmentVector.Size();
+			SegmentVector /= SegmentSize;
+			FVector SegmentWorldUp(0.0f, 0.0f, 1.0f);
+			if (fabs(FVector::DotProduct(SegmentVector, SegmentWorldUp) - 1.0f) < 0.00001f)
+			{
+				SegmentWorldUp = FVector(1.0f, 0.0f, 0.0f);
+			}
+			FQuat SegmentWorldRotation = UKismetMathLibrary::MakeRotFromXZ(SegmentVector, SegmentWorldUp).Quaternion();
+			OutTransforms[PointIndex - 1].SetComponents(InstanceWorldToLocal.TransformRotation(SegmentWorldRotation),
+				InstanceWorldToLocal.TransformPosition((RayPointBefore + CurrentRayPoint) * 0.5f),
+				FVector(SegmentSize * RayScaleFactor, 0.2f * RayScaleFactor, 0.2f * RayScaleFactor));
+			RayPointBefore = CurrentRayPoint;
+		}
+		for (int32 SegmentIndex = NumSegments; SegmentIndex < MaxSegments; SegmentIndex++)
+		{
+			OutTransforms[SegmentIndex].SetComponents(FQuat::Identity, InstanceWorldToLocal.TransformPosition(P3),
+				FVector::ZeroVector);
+		}
+	}
+
+	/** World space ends of a segment mesh that runs along its X axis. */
+	void GetSegmentEnds(const FTransform& SegmentWorldTransform, FVector& OutStart, FVector& OutEnd)
+	{
+		FVector HalfLength = SegmentWorldTransform.GetUnitAxis(EAxis::X)
+			* (SegmentWorldTransform.GetScale3D().X / RayScaleFactor * 0.5f);
+		OutStart = SegmentWorldTransform.GetLocation() - HalfLength;
+		OutEnd = SegmentWorldTransform.GetLocation() + HalfLength;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRayToolViewHelperChordParityTest, "HandsTrain.RayToolViewHelper.ChordParity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FRayToolViewHelperChordParityTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	FRandomStream Random(8642);
+
+	AInteractableTool* Tool = World.Spawn<AInteractableTool>();
+	USceneComponent* ToolRoot = NewObject<USceneComponent>(Tool);
+	Tool->SetRootComponent(ToolRoot);
+	ToolRoot->RegisterComponent();
+
+	// the ray mesh is off the world origin, so instances are placed in its space
+	AActor* View = World.Spawn<AActor>();
+	UInstancedStaticMeshComponent* RayMesh = NewObject<UInstancedStaticMeshComponent>(View);
+	View->SetRootComponent(RayMesh);
+	RayMesh->RegisterComponent();
+	RayMesh->SetWorldTransform(FTransform(FRotator(0.0f, 30.0f, 10.0f), FVector(15.0f, -40.0f, 120.0f)));
+	UStaticMeshComponent* TargetMesh = NewObject<UStaticMeshComponent>(View);
+	TargetMesh->SetupAttachment(RayMesh);
+	TargetMesh->RegisterComponent();
+	URayToolViewHelper* ViewHelper = NewObject<URayToolViewHelper>(View);
+	ViewHelper->RegisterComponent();
+	ViewHelper->Initialize(Tool, TargetMesh, RayMesh);
+	float RaySegmentLength = FindFProperty<FFloatProperty>(URayToolViewHelper::StaticClass(), TEXT("RaySegmentLength"))
+		->GetPropertyValue_InContainer(ViewHelper);
+	const TArray<FTransform>& SegmentTransforms = *FindFProperty<FArrayProperty>(URayToolViewHelper::StaticClass(),
+		TEXT("RayMeshSegmentTransforms"))->ContainerPtrToValuePtr<TArray<FTransform>>(ViewHelper);
+	if (!TestEqual(TEXT("ray mesh instances"), SegmentTransforms.Num(), MaxSegments))
+	{
+		return false;
+	}
+
+	// targets from right next to the tool to past the full segment count, anywhere around it
+	TArray<FRayPose> Poses;
+	for (int32 PoseIndex = 0; PoseIndex < NumPoses; PoseIndex++)
+	{
+		FRayPose& Pose = Poses.AddDefaulted_GetRef();
+		FVector ToolPosition = Random.GetUnitVector() * Random.FRandRange(0.0f, 200.0f);
+		// every tenth pose is a default ray straight up, where the segments need another up vector
+		bool bStraightUp = PoseIndex % 10 == 9;
+		FRotator ToolRotation = bStraightUp ? FRotator(90.0f, 0.0f, 0.0f) : Random.GetUnitVector().Rotation();
+		Pose.ToolTransform = FTransform(ToolRotation, ToolPosition);
+		if (!bStraightUp && PoseIndex % 5 != 0)
+		{
+			float TargetDistance = Random.FRandRange(2.0f, 1.5f * MaxSegments * RaySegmentLength);
+			Pose.Target = World.SpawnInteractable(FTransform(ToolPosition + Random.GetUnitVector() * TargetDistance),
+				EInteractableToolTags::Ray);
+		}
+	}
+
+	auto UpdateRay = [Tool, ViewHelper](const FRayPose& Pose) {
+		Tool->SetActorTransform(Pose.ToolTransform);
+		ViewHelper->SetFocusedInteractable(Pose.Target);
+		ViewHelper->TickComponent(1.0f / 72.0f, LEVELTICK_All, &ViewHelper->PrimaryComponentTick);
+	};
+	auto GetTargetPosition = [](const FRayPose& Pose) {
+		return Pose.Target != nullptr ? Pose.Target->GetActorLocation()
+									  : Pose.ToolTransform.GetLocation()
+				+ Pose.ToolTransform.GetUnitAxis(EAxis::X) * DefaultRayCastDistance;
+	};
+
+	int32 NumMismatches = 0;
+	int32 NumGaps = 0;
+	TSet<int32> SegmentCounts;
+	TArray<FTransform> ReferenceTransforms;
+	for (int32 PoseIndex = 0; PoseIndex < NumPoses; PoseIndex++)
+	{
+		const FRayPose& Pose = Poses[PoseIndex];
+		UpdateRay(Pose);
+
+		FVector ToolPosition = Pose.ToolTransform.GetLocation();
+		FVector TargetPosition = GetTargetPosition(Pose);
+		int32 NumSegments = FMath::Clamp(
+			FMath::CeilToInt((TargetPosition - ToolPosition).Size() / RaySegmentLength), MinSegments, MaxSegments);
+		SegmentCounts.Add(NumSegments);
+		BuildReferenceTransforms(ToolPosition, Pose.ToolTransform.GetUnitAxis(EAxis::X), TargetPosition, NumSegments,
+			RayMesh->GetComponentTransform().Inverse(), ReferenceTransforms);
+
+		for (int32 SegmentIndex = 0; SegmentIndex < MaxSegments; SegmentIndex++)
+		{
+			if (SegmentTransforms[SegmentIndex].Equals(ReferenceTransforms[SegmentIndex], 0.001f))
+			{
+				continue;
+			}
+			NumMismatches++;
+			if (NumMismatches <= 5)
+			{
+				AddError(FString::Printf(TEXT("pose %d segment %d: %s, chord reference %s"), PoseIndex, SegmentIndex,
+					*SegmentTransforms[SegmentIndex].ToString(), *ReferenceTransforms[SegmentIndex].ToString()));
+			}
+		}
+
+		// each segment starts where the one before it ends, from the tool to the target
+		FVector PrevEnd = ToolPosition;
+		for (int32 SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+		{
+			FVector Start;
+			FVector End;
+			GetSegmentEnds(SegmentTransforms[SegmentIndex] * RayMesh->GetComponentTransform(), Start, End);
+			NumGaps += FVector::Distance(Start, PrevEnd) > 0.01f ? 1 : 0;
+			PrevEnd = End;
+		}
+		NumGaps += FVector::Distance(PrevEnd, TargetPosition) > 0.01f ? 1 : 0;
+	}
+	TestEqual(TEXT("segments that differ from the chord reference"), NumMismatches, 0);
+	TestEqual(TEXT("gaps between segments"), NumGaps, 0);
+	// otherwise short rays weren't covered
+	TestTrue(TEXT("segment count follows the ray length"), SegmentCounts.Contains(MinSegments)
+		&& SegmentCounts.Contains(MaxSegments) && SegmentCounts.Num() > 2);
+
+	// the same poses through the view helper and through the reference
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Update = 0; Update < NumBenchmarkUpdates; Update++)
+	{
+		UpdateRay(Poses[Update % NumPoses]);
+	}
+	double ViewHelperSeconds = FPlatformTime::Seconds() - StartTime;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Update = 0; Update < NumBenchmarkUpdates; Update++)
+	{
+		const FRayPose& Pose = Poses[Update % NumPoses];
+		Tool->SetActorTransform(Pose.ToolTransform);
+		FVector ToolPosition = Pose.ToolTransform.GetLocation();
+		FVector TargetPosition = GetTargetPosition(Pose);
+		int32 NumSegments = FMath::Clamp(
+			FMath::CeilToInt((TargetPosition - ToolPosition).Size() / RaySegmentLength), MinSegments, MaxSegments);
+		BuildReferenceTransforms(ToolPosition, Pose.ToolTransform.GetUnitAxis(EAxis::X), TargetPosition, NumSegments,
+			RayMesh->GetComponentTransform().Inverse(), ReferenceTransforms);
+	}
+	double ReferenceSeconds = FPlatformTime::Seconds() - StartTime;
+	AddInfo(FString::Printf(TEXT("%d updates: %.3f us each through the view helper (with upload), %.3f us each for the reference"),
+		NumBenchmarkUpdates, ViewHelperSeconds * 1.0e6 / NumBenchmarkUpdates,
+		ReferenceSeconds * 1.0e6 / NumBenchmarkUpdates));
+	return true;
+}
+
+#endif
@@ -0,0 +1,98 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "RingBufferVelocityEstimator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const float FrameTime = 1.0f / 72.0f;
+	const int32 WindowSize = 10;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVelocityEstimatorConstantVelocityTest,
+	"HandsTrain.VelocityEstimator.ConstantVelocity",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVelocityEstimatorConstantVelocityTest::RunTest(const FString& Parameters)
+{
+	const FVector Velocity(100.0f, -20.0f, 5.0f);
+	const EVelocityEstimate Modes[3] = { EVelocityEstimate::Mean, EVelocityEstimate::LeastSquares,
+		EVelocityEstimate::OneEuro };
+	for (EVelocityEstimate Mode : Modes)
+	{
+		TRingBufferVelocityEstimator<WindowSize> Estimator;
+		Estimator.SetMode(Mode);
+		for (int32 Frame = 0; Frame < 60; Frame++)
+		{
+			Estimator.AddSample(Velocity * (Frame * FrameTime), FrameTime);
+		}
+		// the one euro filter only gets there asymptotically
+		float Tolerance = Mode == EVelocityEstimate::OneEuro ? 0.02f * Velocity.Size() : 0.01f;
+		TestTrue(FString::Printf(TEXT("mode %d velocity"), (int32)Mode),
+			Estimator.GetVelocity().Equals(Velocity, Tolerance));
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVelocityEstimatorOneEuroJitterTest,
+	"HandsTrain.VelocityEstimator.OneEuroSmoothsJitter",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVelocityEstimatorOneEuroJitterTest::RunTest(const FString& Parameters)
+{
+	TRingBufferVelocityEstimator<WindowSize> Estimator;
+	Estimator.SetMode(EVelocityEstimate::OneEuro);
+
+	// a still finger with a millimeter of tracking noise
+	double RawSquares = 0.0;
+	double FilteredSquares = 0.0;
+	FVector LastPosition = FVector::ZeroVector;
+	for (int32 Frame = 0; Frame < 200; Frame++)
+	{
+		FVector Position(0.1f * FMath::Sin(Frame * 2.3f), 0.0f, 0.0f);
+		Estimator.AddSample(Position, FrameTime);
+		if (Frame >= 50)
+		{
+			RawSquares += ((Position - LastPosition) / FrameTime).SizeSquared();
+			FilteredSquares += Estimator.GetVelocity().SizeSquared();
+		}
+		LastPosition = Position;
+	}
+	TestTrue(TEXT("jitter is filtered out"), FilteredSquares < 0.04 * RawSquares);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVelocityEstimatorOneEuroResponseTest,
+	"HandsTrain.VelocityEstimator.OneEuroFollowsFastMotion",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FVelocityEstimatorOneEuroResponseTest::RunTest(const FString& Parameters)
+{
+	TRingBufferVelocityEstimator<WindowSize> Estimator;
+	Estimator.SetMode(EVelocityEstimate::OneEuro);
+
+	FVector Position = FVector::ZeroVector;
+	for (int32 Frame = 0; Frame < 20; Frame++)
+	{
+		Estimator.AddSample(Position, FrameTime);
+	}
+	// a poke at 1 m/s; the cutoff rises with speed so the estimate catches up within a few frames
+	const FVector Velocity(100.0f, 0.0f, 0.0f);
+	for (int32 Frame = 0; Frame < 5; Frame++)
+	{
+		Position += Velocity * FrameTime;
+		Estimator.AddSample(Position, FrameTime);
+	}
+	TestTrue(TEXT("estimate after five frames"), Estimator.GetVelocity().X > 0.8f * Velocity.X);
+	return true;
+}
+
+#endif
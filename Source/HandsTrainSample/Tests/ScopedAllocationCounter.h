@@ -0,0 +1,91 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Counts heap allocations made on this thread while in scope, by standing in
+ * for GMalloc and passing everything through to it.
+ */
+class FScopedAllocationCounter : public FMalloc
+{
+public:
+	FScopedAllocationCounter()
+		: InnerMalloc(GMalloc), ThreadId(FPlatformTLS::GetCurrentThreadId()), NumAllocations(0)
+	{
+		GMalloc = this;
+	}
+
+	virtual ~FScopedAllocationCounter()
+	{
+		GMalloc = InnerMalloc;
+	}
+
+	int32 GetNumAllocations() const
+	{
+		return NumAllocations;
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return InnerMalloc->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return TEXT("ScopedAllocationCounter");
+	}
+
+private:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == ThreadId)
+		{
+			NumAllocations++;
+		}
+	}
+
+	FMalloc* InnerMalloc;
+	uint32 ThreadId;
+	int32 NumAllocations;
+};
+
+#endif
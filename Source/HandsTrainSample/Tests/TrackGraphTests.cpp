@@ -0,0 +1,95 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "TrackGraph.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const float EdgeLength = 10.0f;
+
+	/**
+	 * A loop of four edges with a branch (edge 4) leaving the end of edge 1
+	 * and nothing joined at its end yet.
+	 */
+	void BuildLoopWithBranch(FTrackGraph& Graph)
+	{
+		Graph.Reset();
+		for (int32 Edge = 0; Edge < 5; Edge++)
+		{
+			Graph.AddEdge(EdgeLength);
+		}
+		for (int32 Edge = 0; Edge < 4; Edge++)
+		{
+			Graph.Connect(Edge, (Edge + 1) % 4);
+		}
+		Graph.AddDivergingLeg(1, 4);
+	}
+
+	/** Edge a cursor ends up on after moving from the middle of an edge. */
+	int32 GetEdgeAfter(const FTrackGraph& Graph, int32 StartEdge, float Delta)
+	{
+		FTrackRouteCursor Cursor;
+		Cursor.Edge = StartEdge;
+		Cursor.DistanceOnEdge = 0.5f * EdgeLength;
+		Graph.Advance(Cursor, Delta);
+		return Cursor.Edge;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackGraphMergeAfterJunctionTest, "HandsTrain.TrackGraph.MergeAfterJunction",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackGraphMergeAfterJunctionTest::RunTest(const FString& Parameters)
+{
+	FTrackGraph Graph;
+	BuildLoopWithBranch(Graph);
+
+	// the start of edge 2 is the junction's switch, so there's no room left
+	TestFalse(TEXT("merge right after the junction is rejected"), Graph.AddMergingLeg(4, 2));
+	TestEqual(TEXT("junction still leads straight on"), GetEdgeAfter(Graph, 1, EdgeLength), 2);
+	int32 JunctionNode = Graph.FindSwitchNode(1);
+	Graph.SetDiverging(JunctionNode, true);
+	TestEqual(TEXT("junction still leads onto the branch"), GetEdgeAfter(Graph, 1, EdgeLength), 4);
+
+	TestTrue(TEXT("merge one segment later"), Graph.AddMergingLeg(4, 3));
+	TestEqual(TEXT("branch rejoins the loop"), GetEdgeAfter(Graph, 4, EdgeLength), 3);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackGraphSwitchNodesTest, "HandsTrain.TrackGraph.SwitchNodes",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackGraphSwitchNodesTest::RunTest(const FString& Parameters)
+{
+	FTrackGraph Graph;
+	BuildLoopWithBranch(Graph);
+	Graph.AddMergingLeg(4, 3);
+
+	int32 JunctionNode = Graph.FindSwitchNode(1);
+	int32 MergeNode = Graph.FindSwitchNode(3);
+	TestTrue(TEXT("junction has a switch"), JunctionNode != INDEX_NONE);
+	TestTrue(TEXT("merge has a switch"), MergeNode != INDEX_NONE);
+	TestTrue(TEXT("junction and merge are different switches"), JunctionNode != MergeNode);
+	TestEqual(TEXT("no switch around edge 0"), Graph.FindSwitchNode(0), (int32)INDEX_NONE);
+
+	// the merge is set from its trunk, and only matters going backward
+	Graph.SetDiverging(MergeNode, true);
+	TestTrue(TEXT("merge is diverging"), Graph.IsDiverging(MergeNode));
+	TestFalse(TEXT("junction is untouched"), Graph.IsDiverging(JunctionNode));
+	TestEqual(TEXT("forward through the junction"), GetEdgeAfter(Graph, 1, EdgeLength), 2);
+	TestEqual(TEXT("backward through the merge"), GetEdgeAfter(Graph, 3, -EdgeLength), 4);
+
+	Graph.SetDiverging(MergeNode, false);
+	TestEqual(TEXT("backward past the merge"), GetEdgeAfter(Graph, 3, -EdgeLength), 2);
+	return true;
+}
+
+#endif
@@ -0,0 +1,180 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "TrackOccupancy.h"
+#include "TrainDistanceIntegrator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const int32 NumSegments = 2000;
+	const float SegmentLength = 20.0f;
+	const float TrackLength = NumSegments * SegmentLength;
+	const int32 NumTrains = 500;
+	const float TrainSpacing = TrackLength / NumTrains;
+	// span of a train around its distance, like a locomotive's consist extents
+	const float RearExtent = -40.0f;
+	const float FrontExtent = 10.0f;
+	const float MinFollowingDistance = 10.0f;
+
+	/** Moves along the track the way ATrainLocomotive::UpdateDistance does. */
+	struct FTestTrain
+	{
+		int32 OccupancyId;
+		float Distance;
+		float Speed;
+		FTrainDistanceIntegrator DistanceIntegrator;
+
+		void UpdateOccupancy(FTrackOccupancy& Occupancy) const
+		{
+			float LeadDistance = (float)DistanceIntegrator.GetSimDistance();
+			Occupancy.UpdateTrain(OccupancyId, LeadDistance + RearExtent, LeadDistance + FrontExtent);
+		}
+
+		void UpdateDistance(FTrackOccupancy& Occupancy, float DeltaTime, bool bUseFixedTimestep,
+			int32& InOutNumLimitedSteps)
+		{
+			auto LimitStep = [&](float Step) {
+				float AllowedStep = Occupancy.LimitStep(OccupancyId, Step, MinFollowingDistance);
+				InOutNumLimitedSteps += AllowedStep != Step ? 1 : 0;
+				return AllowedStep;
+			};
+
+			if (bUseFixedTimestep)
+			{
+				DistanceIntegrator.SetTimestep(1.0 / 120.0, 8);
+				DistanceIntegrator.Advance(DeltaTime, TrackLength, [&](double StepTime) {
+					UpdateOccupancy(Occupancy);
+					return (double)LimitStep(Speed * (float)StepTime);
+				});
+				Distance = (float)DistanceIntegrator.GetInterpolatedDistance(TrackLength);
+				UpdateOccupancy(Occupancy);
+				return;
+			}
+
+			Distance = fmod(Distance + LimitStep(Speed * DeltaTime), TrackLength);
+			DistanceIntegrator.Reset(Distance);
+			UpdateOccupancy(Occupancy);
+		}
+	};
+
+	/** Runs every train for a while and checks the gaps between them after each frame. */
+	void RunTrains(FAutomationTestBase& Test, bool bUseFixedTimestep)
+	{
+		TArray<float> SegmentStartDistances;
+		for (int32 SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+		{
+			SegmentStartDistances.Add(SegmentIndex * SegmentLength);
+		}
+		FTrackOccupancy Occupancy;
+		Occupancy.Initialize(SegmentStartDistances, TrackLength);
+
+		// every seventh train stands still for a while, so the ones behind it queue up
+		FRandomStream Random(2024);
+		TArray<FTestTrain> Trains;
+		Trains.SetNum(NumTrains);
+		for (int32 TrainIndex = 0; TrainIndex < NumTrains; TrainIndex++)
+		{
+			FTestTrain& Train = Trains[TrainIndex];
+			Train.OccupancyId = Occupancy.RegisterTrain();
+			Train.Distance = TrainIndex * TrainSpacing;
+			Train.Speed = Random.FRandRange(50.0f, 400.0f);
+			Train.DistanceIntegrator.Reset(Train.Distance);
+			Train.UpdateOccupancy(Occupancy);
+		}
+
+		const float DeltaTime = 1.0f / 72.0f;
+		const int32 NumFrames = 720;
+		int32 NumLimitedSteps = 0;
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			for (int32 TrainIndex = 0; TrainIndex < NumTrains; TrainIndex++)
+			{
+				FTestTrain& Train = Trains[TrainIndex];
+				bool bHeldUp = TrainIndex % 7 == 0 && Frame < NumFrames / 2;
+				float Speed = Train.Speed;
+				Train.Speed = bHeldUp ? 0.0f : Speed;
+				Train.UpdateDistance(Occupancy, DeltaTime, bUseFixedTimestep, NumLimitedSteps);
+				Train.Speed = Speed;
+			}
+
+			// trains only move forward, so each one stays behind the next
+			for (int32 TrainIndex = 0; TrainIndex < NumTrains; TrainIndex++)
+			{
+				const FTestTrain& Train = Trains[TrainIndex];
+				const FTestTrain& TrainAhead = Trains[(TrainIndex + 1) % NumTrains];
+				float Head = (float)Train.DistanceIntegrator.GetSimDistance() + FrontExtent;
+				float AheadTail = (float)TrainAhead.DistanceIntegrator.GetSimDistance() + RearExtent;
+				float Gap = FMath::Fmod(AheadTail - Head + 2.0f * TrackLength, TrackLength);
+				// anything past half the loop means the trains overlap
+				if (Gap > 0.5f * TrackLength)
+				{
+					Gap -= TrackLength;
+				}
+				if (Gap < MinFollowingDistance - 0.05f)
+				{
+					Test.AddError(FString::Printf(TEXT("fixed timestep %d, frame %d: train %d is %f behind the next"),
+						bUseFixedTimestep ? 1 : 0, Frame, TrainIndex, Gap));
+					return;
+				}
+			}
+		}
+		Test.TestTrue(TEXT("trains had to hold back"), NumLimitedSteps > 0);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackOccupancySpacingTest, "HandsTrain.TrackOccupancy.KeepsSpacing",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackOccupancySpacingTest::RunTest(const FString& Parameters)
+{
+	double StartTime = FPlatformTime::Seconds();
+	RunTrains(*this, false);
+	double VariableTime = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	RunTrains(*this, true);
+	double FixedTime = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d trains on %d segments: %.3f ms per frame variable, %.3f ms fixed"),
+		NumTrains, NumSegments, VariableTime * 1000.0 / 720, FixedTime * 1000.0 / 720));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackOccupancyFindTrainAheadTest, "HandsTrain.TrackOccupancy.FindTrainAhead",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackOccupancyFindTrainAheadTest::RunTest(const FString& Parameters)
+{
+	FTrackOccupancy Occupancy;
+	Occupancy.Initialize({ 0.0f, 100.0f, 200.0f, 300.0f }, 400.0f);
+	int32 TrainA = Occupancy.RegisterTrain();
+	int32 TrainB = Occupancy.RegisterTrain();
+	// B straddles the end of the loop
+	Occupancy.UpdateTrain(TrainA, 250.0f, 300.0f);
+	Occupancy.UpdateTrain(TrainB, 380.0f, 420.0f);
+
+	int32 TrainAheadId;
+	float Gap;
+	TestTrue(TEXT("A sees B ahead"), Occupancy.FindTrainAhead(TrainA, true, 1000.0f, TrainAheadId, Gap));
+	TestEqual(TEXT("B is ahead of A"), TrainAheadId, TrainB);
+	TestEqual(TEXT("gap ahead of A"), Gap, 80.0f, 0.001f);
+
+	TestTrue(TEXT("A sees B behind"), Occupancy.FindTrainAhead(TrainA, false, 1000.0f, TrainAheadId, Gap));
+	TestEqual(TEXT("gap behind A"), Gap, 230.0f, 0.001f);
+
+	TestFalse(TEXT("B is out of reach"), Occupancy.FindTrainAhead(TrainA, true, 50.0f, TrainAheadId, Gap));
+	TestEqual(TEXT("step is cut short"), Occupancy.LimitStep(TrainA, 100.0f, 10.0f), 70.0f, 0.001f);
+	TestEqual(TEXT("short step is kept"), Occupancy.LimitStep(TrainA, 5.0f, 10.0f), 5.0f);
+	return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandsTrainTestWorld.h"
+#include "Math/RandomStream.h"
+#include "TrackPoseCache.h"
+#include "TrainTrack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const float CircleRadius = 20.0f;
+
+	/** A circle, driven counterclockwise and facing the way it's driven. */
+	void EvaluateCirclePose(float DistanceIntoTrack, FTransform& Pose)
+	{
+		float Angle = DistanceIntoTrack / CircleRadius;
+		Pose.SetLocation(FVector(CircleRadius * FMath::Cos(Angle), CircleRadius * FMath::Sin(Angle), 0.0f));
+		Pose.SetRotation(FQuat(FVector::UpVector, Angle + HALF_PI));
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackPoseCacheErrorBoundsTest, "HandsTrain.TrackPoseCache.ErrorBounds",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackPoseCacheErrorBoundsTest::RunTest(const FString& Parameters)
+{
+	const float TrackLength = 2.0f * PI * CircleRadius;
+	const float SampleSpacing = 2.0f;
+	const float MaxPositionError = 1.0f;
+	const float MaxAngleError = 1.0e-6f;
+
+	// the position bound alone is met right away
+	FTrackPoseCache PositionOnlyCache;
+	TestTrue(TEXT("position bound met"), PositionOnlyCache.Build(TrackLength, SampleSpacing, MaxPositionError, PI,
+		EvaluateCirclePose));
+
+	FTrackPoseCache Cache;
+	TestTrue(TEXT("both bounds met"), Cache.Build(TrackLength, SampleSpacing, MaxPositionError, MaxAngleError,
+		EvaluateCirclePose));
+	TestTrue(TEXT("angle bound refines the spacing"), Cache.GetNumSamples() > PositionOnlyCache.GetNumSamples());
+	TestTrue(TEXT("measured position error"), Cache.GetMaxMeasuredError() <= MaxPositionError);
+	TestTrue(TEXT("measured angle error"), Cache.GetMaxMeasuredAngleError() <= MaxAngleError);
+
+	// the bounds hold away from where they were measured too
+	FRandomStream Random(2002);
+	FTransform ExactPose, CachedPose;
+	float MaxSeenPositionError = 0.0f;
+	float MaxSeenAngleError = 0.0f;
+	for (int32 Query = 0; Query < 10000; Query++)
+	{
+		float Distance = Random.FRandRange(0.0f, TrackLength);
+		EvaluateCirclePose(Distance, ExactPose);
+		Cache.EvaluatePose(Distance, CachedPose);
+		MaxSeenPositionError = FMath::Max(MaxSeenPositionError,
+			(float)FVector::Dist(ExactPose.GetLocation(), CachedPose.GetLocation()));
+		MaxSeenAngleError = FMath::Max(MaxSeenAngleError,
+			(float)ExactPose.GetRotation().AngularDistance(CachedPose.GetRotation()));
+	}
+	TestTrue(FString::Printf(TEXT("position error %f"), MaxSeenPositionError), MaxSeenPositionError <= MaxPositionError);
+	// measuring at quarter points can miss a little of the peak
+	TestTrue(FString::Printf(TEXT("angle error %g"), MaxSeenAngleError), MaxSeenAngleError <= 1.5f * MaxAngleError);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrackPoseCacheFollowsTrackTest, "HandsTrain.TrackPoseCache.FollowsTrack",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrackPoseCacheFollowsTrackTest::RunTest(const FString& Parameters)
+{
+	for (bool bUseInstancedSegments : { true, false })
+	{
+		FHandsTrainTestWorld World;
+		ATrainTrack* Track = World.SpawnLoopTrack(4, bUseInstancedSegments);
+		FTransform OldTrackTransform = Track->GetActorTransform();
+
+		const int32 NumPoses = 20;
+		TArray<FTransform> OldPoses;
+		for (int32 PoseIndex = 0; PoseIndex < NumPoses; PoseIndex++)
+		{
+			int32 SegmentIndexHint = INDEX_NONE;
+			FTransform& Pose = OldPoses.AddDefaulted_GetRef();
+			Track->EvaluatePose(PoseIndex * Track->GetTrackLength() / NumPoses, Pose, SegmentIndexHint);
+		}
+
+		Track->SetActorLocationAndRotation(FVector(100.0f, -50.0f, 10.0f), FRotator(0.0f, 30.0f, 0.0f));
+		FTransform NewTrackTransform = Track->GetActorTransform();
+		for (int32 PoseIndex = 0; PoseIndex < NumPoses; PoseIndex++)
+		{
+			int32 SegmentIndexHint = INDEX_NONE;
+			FTransform Pose;
+			Track->EvaluatePose(PoseIndex * Track->GetTrackLength() / NumPoses, Pose, SegmentIndexHint);
+			FTransform ExpectedPose = OldPoses[PoseIndex].GetRelativeTransform(OldTrackTransform) * NewTrackTransform;
+			FString What = FString::Printf(TEXT("%s, pose %d"),
+				bUseInstancedSegments ? TEXT("instanced") : TEXT("actors"), PoseIndex);
+			TestTrue(What + TEXT(" location"), Pose.GetLocation().Equals(ExpectedPose.GetLocation(), 0.1f));
+			TestTrue(What + TEXT(" rotation"), Pose.GetRotation().Equals(ExpectedPose.GetRotation(), 0.001f));
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,221 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "Components/SceneComponent.h"
+#include "HandsTrainTestWorld.h"
+#include "NormalTrainCar.h"
+#include "TrainConsistSim.h"
+#include "TrainTrack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const float CarSpacing = 30.0f;
+	const float AxleOffset = 10.0f;
+	const int32 WheelsPerAxle = 2;
+
+	USceneComponent* AddSceneComponent(AActor* Owner, USceneComponent* Parent, FName Name, const FVector& Location)
+	{
+		USceneComponent* Component = NewObject<USceneComponent>(Owner, Name);
+		Component->SetRelativeLocation(Location);
+		if (Parent != nullptr)
+		{
+			Component->SetupAttachment(Parent);
+		}
+		Component->RegisterComponent();
+		return Component;
+	}
+
+	/** A car with the components the imported blueprints have, found by name in BeginPlay. */
+	ANormalTrainCar* SpawnCar(FHandsTrainTestWorld& World, ATrainTrack* Track, ATrainCarBase* Lead,
+		float DistanceBehindLead, bool bWithWheels)
+	{
+		ANormalTrainCar* Car = World.Get()->SpawnActorDeferred<ANormalTrainCar>(ANormalTrainCar::StaticClass(),
+			FTransform::Identity);
+		Car->SetRootComponent(AddSceneComponent(Car, nullptr, TEXT("Root"), FVector::ZeroVector));
+		if (bWithWheels)
+		{
+			USceneComponent* WheelBases[2] = {
+				AddSceneComponent(Car, Car->GetRootComponent(), TEXT("WheelBaseFront"), FVector(AxleOffset, 0.0f, 0.0f)),
+				AddSceneComponent(Car, Car->GetRootComponent(), TEXT("WheelBaseBack"), FVector(-AxleOffset, 0.0f, 0.0f))
+			};
+			for (int32 WheelBaseIndex = 0; WheelBaseIndex < 2; WheelBaseIndex++)
+			{
+				for (int32 WheelIndex = 0; WheelIndex < WheelsPerAxle; WheelIndex++)
+				{
+					FName WheelName(*FString::Printf(TEXT("Wheel_A_%d_%d"), WheelBaseIndex, WheelIndex));
+					AddSceneComponent(Car, WheelBases[WheelBaseIndex], WheelName,
+						FVector(0.0f, WheelIndex == 0 ? -2.0f : 2.0f, 0.0f));
+				}
+			}
+		}
+		Car->Scale = 1.0f;
+		Car->TrainTrack = Track;
+		Car->ParentLocomotive = Lead;
+		Car->DistanceBehindParent = DistanceBehindLead;
+		Car->FinishSpawning(FTransform::Identity);
+		return Car;
+	}
+
+	/**
+	 * A train of cars following a lead that only carries the distance, the
+	 * way the locomotive drives its cars.
+	 */
+	struct FTestConsist
+	{
+		ATrainTrack* Track;
+		ANormalTrainCar* Lead;
+		TArray<ANormalTrainCar*> Cars;
+		FTrainConsistSim ConsistSim;
+
+		FTestConsist(FHandsTrainTestWorld& World, ATrainTrack* InTrack, int32 NumCars)
+			: Track(InTrack)
+		{
+			Lead = SpawnCar(World, Track, nullptr, 0.0f, false);
+			for (int32 CarIndex = 0; CarIndex < NumCars; CarIndex++)
+			{
+				ANormalTrainCar* Car = SpawnCar(World, Track, Lead, CarIndex * CarSpacing, true);
+				Car->AddToConsist(ConsistSim, Car->Scale * Car->DistanceBehindParent);
+				Cars.Add(Car);
+			}
+		}
+
+		void SetLeadDistance(float LeadDistance)
+		{
+			FTrainCarPose LeadPose;
+			LeadPose.Distance = LeadDistance;
+			Lead->ApplyConsistPose(LeadPose);
+		}
+
+		/** Each car places itself, as with bUseConsistSim off. */
+		void UpdateActors(float LeadDistance)
+		{
+			SetLeadDistance(LeadDistance);
+			for (ANormalTrainCar* Car : Cars)
+			{
+				Car->UpdateState(0.0f);
+			}
+		}
+
+		/** The whole train is simulated, then written back. */
+		void UpdateSim(float LeadDistance)
+		{
+			SetLeadDistance(LeadDistance);
+			ConsistSim.Advance(LeadDistance, Track->GetTrackLength(),
+				[this](float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint) {
+					return Track->EvaluatePose(DistanceIntoTrack, Pose, SegmentIndexHint);
+				});
+			for (int32 CarIndex = 0; CarIndex < Cars.Num(); CarIndex++)
+			{
+				Cars[CarIndex]->ApplyConsistPose(ConsistSim.GetCarPose(CarIndex));
+			}
+		}
+	};
+
+	/** Transforms of every component of a car, in a fixed order. */
+	void GetCarTransforms(const ANormalTrainCar* Car, TArray<FTransform>& OutTransforms)
+	{
+		OutTransforms.Reset();
+		TInlineComponentArray<USceneComponent*> Components(Car);
+		Components.Sort([](const USceneComponent& A, const USceneComponent& B) {
+			return A.GetFName().LexicalLess(B.GetFName());
+		});
+		for (const USceneComponent* Component : Components)
+		{
+			OutTransforms.Add(Component->GetComponentTransform());
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainConsistSimMatchesActorsTest, "HandsTrain.ConsistSim.MatchesActorPath",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainConsistSimMatchesActorsTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	ATrainTrack* Track = World.SpawnLoopTrack(4, true);
+	FTestConsist Consist(World, Track, 6);
+
+	TArray<TArray<FTransform>> ActorTransforms;
+	TArray<FTransform> SimTransforms;
+	ActorTransforms.SetNum(Consist.Cars.Num());
+	// far enough to take the whole train around every corner and past the end of the loop
+	const int32 NumFrames = 200;
+	float FrameStep = 1.3f * Track->GetTrackLength() / NumFrames;
+	for (int32 Frame = 0; Frame < NumFrames; Frame++)
+	{
+		float LeadDistance = Frame * FrameStep;
+		Consist.UpdateActors(LeadDistance);
+		for (int32 CarIndex = 0; CarIndex < Consist.Cars.Num(); CarIndex++)
+		{
+			GetCarTransforms(Consist.Cars[CarIndex], ActorTransforms[CarIndex]);
+		}
+
+		Consist.UpdateSim(LeadDistance);
+		for (int32 CarIndex = 0; CarIndex < Consist.Cars.Num(); CarIndex++)
+		{
+			GetCarTransforms(Consist.Cars[CarIndex], SimTransforms);
+			for (int32 Index = 0; Index < SimTransforms.Num(); Index++)
+			{
+				const FTransform& ActorTransform = ActorTransforms[CarIndex][Index];
+				if (!ActorTransform.Equals(SimTransforms[Index], 0.01f))
+				{
+					AddError(FString::Printf(TEXT("frame %d, car %d, component %d: %s instead of %s"), Frame, CarIndex,
+						Index, *SimTransforms[Index].ToString(), *ActorTransform.ToString()));
+					return true;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainConsistSimTimingTest, "HandsTrain.ConsistSim.Timing",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainConsistSimTimingTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	// long enough for the biggest train
+	ATrainTrack* Track = World.SpawnLoopTrack(100, true);
+	const int32 CarCounts[2] = { 6, 500 };
+	const int32 NumFrames = 200;
+	for (int32 NumCars : CarCounts)
+	{
+		FTestConsist Consist(World, Track, NumCars);
+		float FrameStep = 2.0f;
+
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			Consist.UpdateActors(Frame * FrameStep);
+		}
+		double ActorTime = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			Consist.UpdateSim(Frame * FrameStep);
+		}
+		double SimTime = FPlatformTime::Seconds() - StartTime;
+
+		AddInfo(FString::Printf(TEXT("%d cars: %.3f ms per frame with each car placing itself, %.3f ms with the consist sim"), NumCars,
+			ActorTime * 1000.0 / NumFrames, SimTime * 1000.0 / NumFrames));
+
+		Consist.Lead->Destroy();
+		for (ANormalTrainCar* Car : Consist.Cars)
+		{
+			Car->Destroy();
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "TrainDistanceIntegrator.h"
+#include "TrainMotionProfile.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	const double TrackLength = 1000.0;
+	const double FixedTimestep = 1.0 / 120.0;
+	const int32 MaxSubsteps = 8;
+	const double RunTime = 6.0;
+
+	/**
+	 * Runs a train that speeds up and slows down again over a tick schedule,
+	 * the same way the locomotive does: the motion profile moves once per step.
+	 * @param OutDistanceAtStep - Simulated distance after each frame, by step count;
+	 * negative for step counts no frame ended on.
+	 */
+	void RunSchedule(float FrameRate, int32 HitchEvery, TArray<double>& OutDistanceAtStep)
+	{
+		FTrainDistanceIntegrator Integrator;
+		Integrator.SetTimestep(FixedTimestep, MaxSubsteps);
+		Integrator.Reset(0.0);
+
+		FTrainMotionProfile MotionProfile;
+		MotionProfile.Start(0.0f, 300.0f, 2.0f, 0.5f);
+		float Speed = 0.0f;
+		bool bSlowingDown = false;
+
+		OutDistanceAtStep.Init(-1.0, FMath::CeilToInt(RunTime / FixedTimestep) + MaxSubsteps + 1);
+		float FrameTime = 1.0f / FrameRate;
+		int32 NumFrames = FMath::CeilToInt(RunTime * FrameRate);
+		for (int32 Frame = 0; Frame < NumFrames; Frame++)
+		{
+			// a long frame now and then, like a hitch on device
+			float DeltaTime = HitchEvery > 0 && Frame % HitchEvery == HitchEvery - 1 ? 3.0f * FrameTime : FrameTime;
+			Integrator.Advance(DeltaTime, TrackLength, [&](double StepTime) {
+				Speed = MotionProfile.Advance((float)StepTime);
+				if (MotionProfile.IsFinished() && !bSlowingDown)
+				{
+					MotionProfile.Start(Speed, 50.0f, 1.5f, 0.5f);
+					bSlowingDown = true;
+				}
+				return (double)(Speed * (float)StepTime);
+			});
+
+			uint64 NumSteps = Integrator.GetNumSteps();
+			if (OutDistanceAtStep.IsValidIndex((int32)NumSteps))
+			{
+				OutDistanceAtStep[(int32)NumSteps] = Integrator.GetSimDistance();
+			}
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainDistanceIntegratorFrameRateTest, "HandsTrain.DistanceIntegrator.SameAtAnyFrameRate",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainDistanceIntegratorFrameRateTest::RunTest(const FString& Parameters)
+{
+	// 120 Hz takes one step a frame, so it sees every step count
+	TArray<double> ReferenceDistances;
+	RunSchedule(120.0f, 0, ReferenceDistances);
+
+	const float FrameRates[4] = { 60.0f, 72.0f, 90.0f, 120.0f };
+	for (float FrameRate : FrameRates)
+	{
+		for (int32 HitchEvery : { 0, 37 })
+		{
+			TArray<double> Distances;
+			RunSchedule(FrameRate, HitchEvery, Distances);
+
+			int32 NumCompared = 0;
+			for (int32 Step = 0; Step < Distances.Num(); Step++)
+			{
+				if (Distances[Step] < 0.0 || ReferenceDistances[Step] < 0.0)
+				{
+					continue;
+				}
+				// bit for bit, so replays match
+				if (Distances[Step] != ReferenceDistances[Step])
+				{
+					AddError(FString::Printf(TEXT("%.0f Hz, hitch every %d: step %d is at %.17g instead of %.17g"),
+						FrameRate, HitchEvery, Step, Distances[Step], ReferenceDistances[Step]));
+					break;
+				}
+				NumCompared++;
+			}
+			TestTrue(FString::Printf(TEXT("%.0f Hz, hitch every %d compared enough steps"), FrameRate, HitchEvery),
+				NumCompared > 100);
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainDistanceIntegratorInterpolationTest, "HandsTrain.DistanceIntegrator.Interpolation",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainDistanceIntegratorInterpolationTest::RunTest(const FString& Parameters)
+{
+	FTrainDistanceIntegrator Integrator;
+	Integrator.SetTimestep(0.01, MaxSubsteps);
+	Integrator.Reset(TrackLength - 0.5);
+
+	// one step of 1 unit crosses the end of the loop
+	Integrator.Advance(0.01, TrackLength, [](double StepTime) { return 1.0; });
+	TestEqual(TEXT("wrapped"), Integrator.GetSimDistance(), 0.5, 1e-9);
+
+	// half a step later the drawn distance is halfway, on the short way around
+	Integrator.Advance(0.005, TrackLength, [](double StepTime) { return 1.0; });
+	TestEqual(TEXT("no extra step"), (int32)Integrator.GetNumSteps(), 1);
+	TestEqual(TEXT("interpolated"), Integrator.GetInterpolatedDistance(TrackLength), 0.0, 1e-6);
+	return true;
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "TrainMotionProfile.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	struct FSpeedCurveCase
+	{
+		float StartSpeed;
+		float GoalSpeed;
+		float Duration;
+		float JerkTimeFraction;
+	};
+
+	// a start, a stop and speed steps in both directions
+	const FSpeedCurveCase SpeedCurveCases[] = {
+		{ 0.0f, 300.0f, 2.7f, 0.5f },
+		{ 300.0f, 0.0f, 2.7f, 0.5f },
+		{ 100.0f, 150.0f, 0.5f, 0.0f },
+		{ 150.0f, 100.0f, 0.5f, 1.0f },
+		{ 100.0f, 350.0f, 1.0f, 0.3f },
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainMotionProfileSpeedCurveTest, "HandsTrain.MotionProfile.SpeedCurves",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainMotionProfileSpeedCurveTest::RunTest(const FString& Parameters)
+{
+	const int32 NumSamples = 2000;
+	for (const FSpeedCurveCase& Case : SpeedCurveCases)
+	{
+		FString What = FString::Printf(TEXT("%.0f to %.0f in %.1f s, jerk fraction %.1f"), Case.StartSpeed,
+			Case.GoalSpeed, Case.Duration, Case.JerkTimeFraction);
+		FTrainMotionProfile Profile;
+		Profile.Start(Case.StartSpeed, Case.GoalSpeed, Case.Duration, Case.JerkTimeFraction);
+		TestEqual(What + TEXT(": start"), Profile.GetSpeedAt(0.0f), Case.StartSpeed);
+		TestEqual(What + TEXT(": end"), Profile.GetSpeedAt(Case.Duration), Case.GoalSpeed);
+
+		// the curve has no more acceleration than a ramp with the same
+		// jerk time needs, and changes it by no more than that jerk allows
+		float SpeedChange = Case.GoalSpeed - Case.StartSpeed;
+		float JerkTime = 0.5f * Case.Duration * Case.JerkTimeFraction;
+		float PeakAcceleration = FMath::Abs(SpeedChange) / (Case.Duration - JerkTime);
+		float SampleTime = Case.Duration / NumSamples;
+		float MaxAccelerationChange = JerkTime > 0.0f
+			? PeakAcceleration / JerkTime * SampleTime
+			: PeakAcceleration;
+		float Distance = 0.0f;
+		float LastAcceleration = 0.0f;
+		for (int32 Sample = 0; Sample < NumSamples; Sample++)
+		{
+			float Speed = Profile.GetSpeedAt(Sample * SampleTime);
+			float NextSpeed = Profile.GetSpeedAt((Sample + 1) * SampleTime);
+			Distance += 0.5f * (Speed + NextSpeed) * SampleTime;
+			float Acceleration = (NextSpeed - Speed) / SampleTime;
+			if (Acceleration * SpeedChange < -0.01f
+				|| FMath::Abs(Acceleration) > PeakAcceleration * 1.01f
+				|| (Sample > 0 && FMath::Abs(Acceleration - LastAcceleration) > MaxAccelerationChange * 1.01f + 0.01f))
+			{
+				AddError(FString::Printf(TEXT("%s: acceleration %f at %f s after %f"), *What, Acceleration,
+					Sample * SampleTime, LastAcceleration));
+				break;
+			}
+			LastAcceleration = Acceleration;
+		}
+		// the curve is symmetric, so it covers as much ground as a linear ramp
+		TestEqual(What + TEXT(": distance"), Distance, 0.5f * (Case.StartSpeed + Case.GoalSpeed) * Case.Duration,
+			0.01f * FMath::Abs(SpeedChange) + 0.01f);
+		if (JerkTime > 0.0f)
+		{
+			TestTrue(What + TEXT(": eases in"), FMath::Abs(Profile.GetSpeedAt(SampleTime) - Case.StartSpeed)
+				< 0.01f * FMath::Abs(SpeedChange));
+			TestTrue(What + TEXT(": eases out"), FMath::Abs(Profile.GetSpeedAt(Case.Duration - SampleTime) - Case.GoalSpeed)
+				< 0.01f * FMath::Abs(SpeedChange));
+		}
+	}
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainMotionProfileAdvanceTest, "HandsTrain.MotionProfile.Advance",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainMotionProfileAdvanceTest::RunTest(const FString& Parameters)
+{
+	FTrainMotionProfile Profile;
+	Profile.Start(0.0f, 300.0f, 2.0f, 0.5f);
+	float Time = 0.0f;
+	// uneven frames, like a device that hitches
+	for (int32 Frame = 0; !Profile.IsFinished(); Frame++)
+	{
+		float DeltaTime = Frame % 9 == 8 ? 0.05f : 1.0f / 72.0f;
+		float Speed = Profile.Advance(DeltaTime);
+		Time = FMath::Min(Time + DeltaTime, 2.0f);
+		if (Speed != Profile.GetSpeedAt(Time))
+		{
+			AddError(FString::Printf(TEXT("frame %d: %f instead of %f"), Frame, Speed, Profile.GetSpeedAt(Time)));
+			break;
+		}
+	}
+	TestEqual(TEXT("lands on the goal"), Profile.Advance(1.0f), 300.0f);
+	TestTrue(TEXT("still active until stopped"), Profile.IsActive());
+
+	// no time to ramp jumps straight to the goal
+	Profile.Start(300.0f, 0.0f, 0.0f, 0.5f);
+	TestTrue(TEXT("zero duration is finished"), Profile.IsFinished());
+	TestEqual(TEXT("zero duration jumps"), Profile.Advance(0.0f), 0.0f);
+	return true;
+}
+
+#endif
@@ -0,0 +1,259 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "Misc/AutomationTest.h"
+#include "HandsTrainTestWorld.h"
+#include "Math/RandomStream.h"
+#include "TrackSegment.h"
+#include "TrainTrack.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** The linear search GetTrackSegment used to do. */
+	ATrackSegment* FindTrackSegmentByScan(const TArray<ATrackSegment*>& TrackSegments, float DistanceIntoTrack)
+	{
+		unsigned int NumSegments = TrackSegments.Num();
+		unsigned int LastSegmentIndex = NumSegments - 1;
+		for (unsigned int SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+		{
+			auto CurrSegment = TrackSegments[SegmentIndex];
+			auto NextSegment = TrackSegments[(SegmentIndex + 1) % NumSegments];
+			if (DistanceIntoTrack >= CurrSegment->StartDistance
+				&& (DistanceIntoTrack < NextSegment->StartDistance || SegmentIndex == LastSegmentIndex))
+			{
+				return CurrSegment;
+			}
+		}
+		return nullptr;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainTrackSegmentLookupTest, "HandsTrain.TrainTrack.SegmentLookup",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainTrackSegmentLookupTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	// 10k segment actors
+	ATrainTrack* Track = World.SpawnLoopTrack(2500, false);
+	const TArray<ATrackSegment*>& TrackSegments = Track->TrackSegments;
+	float TrackLength = Track->GetTrackLength();
+	TestEqual(TEXT("segments"), TrackSegments.Num(), 10004);
+
+	// segment boundaries, where off-by-one mistakes show up
+	for (const ATrackSegment* TrackSegment : TrackSegments)
+	{
+		float Distance = TrackSegment->StartDistance;
+		if (Track->GetTrackSegment(Distance) != FindTrackSegmentByScan(TrackSegments, Distance))
+		{
+			AddError(FString::Printf(TEXT("segment %d: wrong segment at its start"), TrackSegment->SegmentIndex));
+			break;
+		}
+	}
+
+	// random distances, including ones past either end
+	FRandomStream Random(1001);
+	for (int32 Query = 0; Query < 1000; Query++)
+	{
+		float Distance = Random.FRandRange(-10.0f, TrackLength + 10.0f);
+		if (Track->GetTrackSegment(Distance) != FindTrackSegmentByScan(TrackSegments, Distance))
+		{
+			AddError(FString::Printf(TEXT("wrong segment at %f"), Distance));
+			break;
+		}
+	}
+
+	// hinted lookups the way cars make them: forward around the loop, then backward
+	const int32 NumSteps = 20000;
+	float Step = 1.7f * TrackLength / NumSteps;
+	int32 SegmentIndexHint = INDEX_NONE;
+	for (int32 StepIndex = 0; StepIndex < NumSteps; StepIndex++)
+	{
+		float Distance = FMath::Fmod(StepIndex < NumSteps / 2 ? StepIndex * Step : (NumSteps - StepIndex) * Step,
+			TrackLength);
+		if (Track->GetTrackSegment(Distance, SegmentIndexHint) != FindTrackSegmentByScan(TrackSegments, Distance))
+		{
+			AddError(FString::Printf(TEXT("step %d: wrong hinted segment at %f"), StepIndex, Distance));
+			break;
+		}
+	}
+
+	// timings for the three ways of looking a segment up
+	const int32 NumQueries = 2000;
+	TArray<float> Distances;
+	for (int32 Query = 0; Query < NumQueries; Query++)
+	{
+		Distances.Add(FMath::Fmod(Query * 3.1f, TrackLength));
+	}
+	// sum the indices so the calls can't be optimized away
+	int32 IndexSum = 0;
+	double StartTime = FPlatformTime::Seconds();
+	for (float Distance : Distances)
+	{
+		IndexSum += FindTrackSegmentByScan(TrackSegments, Distance)->SegmentIndex;
+	}
+	double ScanTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 SearchIndexSum = 0;
+	StartTime = FPlatformTime::Seconds();
+	for (float Distance : Distances)
+	{
+		SearchIndexSum += Track->GetTrackSegment(Distance)->SegmentIndex;
+	}
+	double SearchTime = FPlatformTime::Seconds() - StartTime;
+
+	int32 HintedIndexSum = 0;
+	SegmentIndexHint = INDEX_NONE;
+	StartTime = FPlatformTime::Seconds();
+	for (float Distance : Distances)
+	{
+		HintedIndexSum += Track->GetTrackSegment(Distance, SegmentIndexHint)->SegmentIndex;
+	}
+	double HintedTime = FPlatformTime::Seconds() - StartTime;
+
+	TestEqual(TEXT("search finds what the scan finds"), SearchIndexSum, IndexSum);
+	TestEqual(TEXT("hinted lookup finds what the scan finds"), HintedIndexSum, IndexSum);
+	AddInfo(FString::Printf(TEXT("%d segments: %.3f us scan, %.3f us binary search, %.3f us hinted per lookup"),
+		TrackSegments.Num(), ScanTime * 1.0e6 / NumQueries, SearchTime * 1.0e6 / NumQueries,
+		HintedTime * 1.0e6 / NumQueries));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainTrackSegmentIndexFollowsEditsTest, "HandsTrain.TrainTrack.SegmentIndexFollowsEdits",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainTrackSegmentIndexFollowsEditsTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	ATrainTrack* Track = World.SpawnLoopTrack(3, false);
+	float GridSize = Track->GridSize;
+
+	// same number of segments before and after, but the second one gets longer
+	TArray<UTrackSegmentMetaInfo*> TrackSegmentInfos;
+	Track->GetComponents<UTrackSegmentMetaInfo>(TrackSegmentInfos);
+	TrackSegmentInfos.Sort(ATrainTrack::SegmentInfoPredicate);
+	TrackSegmentInfos[1]->TrackSegmentType = ESegmentType::LeftTurn;
+	Track->SetUpTrack();
+
+	float TurnLength = TrackSegmentInfos[1]->GetSegmentLength(GridSize);
+	float ThirdSegmentStart = GridSize + TurnLength;
+	int32 SegmentIndex;
+	ESegmentType SegmentType;
+	float StartDistance;
+	FTransform StartTransform;
+	TestTrue(TEXT("found"), Track->GetTrackSegmentInfo(ThirdSegmentStart - 1.0f, SegmentIndex, SegmentType,
+		StartDistance, StartTransform));
+	TestEqual(TEXT("edited segment"), SegmentIndex, 1);
+	TestTrue(TEXT("edited segment is a turn"), SegmentType == ESegmentType::LeftTurn);
+	TestTrue(TEXT("found"), Track->GetTrackSegmentInfo(ThirdSegmentStart + 1.0f, SegmentIndex, SegmentType,
+		StartDistance, StartTransform));
+	TestEqual(TEXT("segment after the edit"), SegmentIndex, 2);
+	TestEqual(TEXT("segment after the edit starts later"), StartDistance, ThirdSegmentStart, 0.001f);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainTrackIncrementalRegenerationTest, "HandsTrain.TrainTrack.IncrementalRegeneration",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainTrackIncrementalRegenerationTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	// 5k segment actors
+	ATrainTrack* Track = World.SpawnLoopTrack(1249, false);
+	const int32 NumSegments = 5000;
+	TestEqual(TEXT("segments"), Track->TrackSegments.Num(), NumSegments);
+	TArray<ATrackSegment*> SegmentsBefore = Track->TrackSegments;
+	TArray<FTransform> TransformsBefore;
+	for (const ATrackSegment* TrackSegment : SegmentsBefore)
+	{
+		TransformsBefore.Add(TrackSegment->GetActorTransform());
+	}
+
+	TArray<UTrackSegmentMetaInfo*> TrackSegmentInfos;
+	Track->GetComponents<UTrackSegmentMetaInfo>(TrackSegmentInfos);
+	TrackSegmentInfos.Sort(ATrainTrack::SegmentInfoPredicate);
+
+	// nothing changed, so nothing gets touched
+	double StartTime = FPlatformTime::Seconds();
+	Track->SetUpTrack();
+	double UnchangedTime = FPlatformTime::Seconds() - StartTime;
+	const FTrackRegenerationStats& Stats = Track->GetLastRegenerationStats();
+	TestEqual(TEXT("unchanged: spawned"), Stats.NumSpawned, 0);
+	TestEqual(TEXT("unchanged: reused"), Stats.NumReused, NumSegments);
+	TestEqual(TEXT("unchanged: updated"), Stats.NumUpdated, 0);
+	TestEqual(TEXT("unchanged: destroyed"), Stats.NumDestroyed, 0);
+	TestEqual(TEXT("unchanged: first dirty segment"), Stats.FirstDirtySegmentIndex, (int32)INDEX_NONE);
+
+	// a turn in the middle moves everything after it, and nothing before
+	const int32 EditedSegmentIndex = 2500;
+	TrackSegmentInfos[EditedSegmentIndex]->TrackSegmentType = ESegmentType::LeftTurn;
+	StartTime = FPlatformTime::Seconds();
+	Track->SetUpTrack();
+	double EditTime = FPlatformTime::Seconds() - StartTime;
+	TestEqual(TEXT("edit: spawned"), Stats.NumSpawned, 0);
+	TestEqual(TEXT("edit: reused"), Stats.NumReused, NumSegments);
+	TestEqual(TEXT("edit: updated"), Stats.NumUpdated, NumSegments - EditedSegmentIndex);
+	TestEqual(TEXT("edit: destroyed"), Stats.NumDestroyed, 0);
+	TestEqual(TEXT("edit: first dirty segment"), Stats.FirstDirtySegmentIndex, EditedSegmentIndex);
+	for (int32 SegmentIndex = 0; SegmentIndex < EditedSegmentIndex; SegmentIndex++)
+	{
+		if (!SegmentsBefore[SegmentIndex]->GetActorTransform().Equals(TransformsBefore[SegmentIndex]))
+		{
+			AddError(FString::Printf(TEXT("segment %d moved though it's before the edit"), SegmentIndex));
+			break;
+		}
+	}
+	TestTrue(TEXT("edited segment is a turn"),
+		SegmentsBefore[EditedSegmentIndex]->TrackSegmentType == ESegmentType::LeftTurn);
+
+	// dropping the last segment only destroys that one
+	TrackSegmentInfos.Last()->DestroyComponent();
+	Track->SetUpTrack();
+	TestEqual(TEXT("removal: spawned"), Stats.NumSpawned, 0);
+	TestEqual(TEXT("removal: updated"), Stats.NumUpdated, 0);
+	TestEqual(TEXT("removal: destroyed"), Stats.NumDestroyed, 1);
+
+	AddInfo(FString::Printf(TEXT("%d segments: %.1f ms to regenerate unchanged, %.1f ms after one edit"),
+		NumSegments, UnchangedTime * 1000.0, EditTime * 1000.0));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrainTrackInstancedRenderCostTest, "HandsTrain.TrainTrack.InstancedRenderCost",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FTrainTrackInstancedRenderCostTest::RunTest(const FString& Parameters)
+{
+	FHandsTrainTestWorld World;
+	const int32 NumSegments = 1004;
+	ATrainTrack* ActorTrack = World.SpawnLoopTrack(250, false);
+	ATrainTrack* InstancedTrack = World.SpawnLoopTrack(250, true, FTransform(FVector(0.0f, 0.0f, 1000.0f)));
+	ActorTrack->LogTrackInformation();
+	InstancedTrack->LogTrackInformation();
+
+	FTrackSegmentRenderStats ActorStats = ActorTrack->GetSegmentRenderStats();
+	TestEqual(TEXT("actors: segment actors"), ActorStats.NumSegmentActors, NumSegments);
+	TestEqual(TEXT("actors: instances"), ActorStats.NumSegmentInstances, 0);
+	// a segment has a mesh for each shape
+	TestTrue(TEXT("actors: components"), ActorStats.NumSegmentComponents >= 3 * NumSegments);
+
+	FTrackSegmentRenderStats InstancedStats = InstancedTrack->GetSegmentRenderStats();
+	TestEqual(TEXT("instanced: segment actors"), InstancedStats.NumSegmentActors, 0);
+	TestEqual(TEXT("instanced: components"), InstancedStats.NumSegmentComponents, 0);
+	TestEqual(TEXT("instanced: instances"), InstancedStats.NumSegmentInstances, NumSegments);
+
+	AddInfo(FString::Printf(
+		TEXT("%d segments: %d actors with %d components (%llu bytes) vs %d instances (%llu bytes)"),
+		NumSegments, ActorStats.NumSegmentActors, ActorStats.NumSegmentComponents,
+		(uint64)ActorStats.SegmentActorBytes, InstancedStats.NumSegmentInstances,
+		(uint64)InstancedStats.SegmentInstanceBytes));
+	return true;
+}
+
+#endif
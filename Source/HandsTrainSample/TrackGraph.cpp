@@ -0,0 +1,196 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrackGraph.h"
+
+FTrackGraph::FTrackGraph()
+{
+}
+
+void FTrackGraph::Reset()
+{
+	EdgeLengths.Reset();
+	EdgeStartNodes.Reset();
+	EdgeEndNodes.Reset();
+	Nodes.Reset();
+}
+
+int32 FTrackGraph::AddEdge(float Length)
+{
+	EdgeStartNodes.Add(INDEX_NONE);
+	EdgeEndNodes.Add(INDEX_NONE);
+	return EdgeLengths.Add(FMath::Max(Length, 0.0f));
+}
+
+bool FTrackGraph::Connect(int32 FromEdge, int32 ToEdge)
+{
+	if (!EdgeLengths.IsValidIndex(FromEdge) || !EdgeLengths.IsValidIndex(ToEdge))
+	{
+		return false;
+	}
+	return AddEndToNode(FindOrAddNode(MakeEnd(FromEdge, true)), MakeEnd(ToEdge, false));
+}
+
+bool FTrackGraph::AddDivergingLeg(int32 JunctionEdge, int32 BranchEdge)
+{
+	if (!EdgeLengths.IsValidIndex(JunctionEdge) || !EdgeLengths.IsValidIndex(BranchEdge))
+	{
+		return false;
+	}
+	// the junction's end is already the trunk since Connect
+	// adds the edge it comes from first
+	return AddEndToNode(FindOrAddNode(MakeEnd(JunctionEdge, true)), MakeEnd(BranchEdge, false));
+}
+
+bool FTrackGraph::AddMergingLeg(int32 BranchEdge, int32 TrunkEdge)
+{
+	if (!EdgeLengths.IsValidIndex(BranchEdge) || !EdgeLengths.IsValidIndex(TrunkEdge))
+	{
+		return false;
+	}
+
+	int32 TrunkEnd = MakeEnd(TrunkEdge, false);
+	int32 NodeIndex = FindOrAddNode(TrunkEnd);
+	FTrackNode& Node = Nodes[NodeIndex];
+	// a node only has room for one switch
+	if (Node.NumEnds >= 3)
+	{
+		return false;
+	}
+	// a merge is a junction seen from the other side, so the
+	// edge leaving it has to become the trunk
+	for (int32 EndIndex = 1; EndIndex < Node.NumEnds; EndIndex++)
+	{
+		if (Node.Ends[EndIndex] == TrunkEnd)
+		{
+			Swap(Node.Ends[0], Node.Ends[EndIndex]);
+		}
+	}
+	return AddEndToNode(NodeIndex, MakeEnd(BranchEdge, true));
+}
+
+int32 FTrackGraph::FindSwitchNode(int32 Edge) const
+{
+	if (!EdgeLengths.IsValidIndex(Edge))
+	{
+		return INDEX_NONE;
+	}
+	for (int32 NodeIndex : { EdgeEndNodes[Edge], EdgeStartNodes[Edge] })
+	{
+		if (NodeIndex != INDEX_NONE && Nodes[NodeIndex].NumEnds == 3)
+		{
+			return NodeIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+void FTrackGraph::SetDiverging(int32 NodeIndex, bool bDiverging)
+{
+	if (Nodes.IsValidIndex(NodeIndex))
+	{
+		Nodes[NodeIndex].bDiverging = bDiverging;
+	}
+}
+
+bool FTrackGraph::IsDiverging(int32 NodeIndex) const
+{
+	return Nodes.IsValidIndex(NodeIndex) && Nodes[NodeIndex].bDiverging;
+}
+
+bool FTrackGraph::Advance(FTrackRouteCursor& Cursor, float Delta) const
+{
+	if (!EdgeLengths.IsValidIndex(Cursor.Edge))
+	{
+		return false;
+	}
+
+	Cursor.DeadEndShortfall = 0.0f;
+	bool bForward = Delta >= 0.0f;
+	float Remaining = FMath::Abs(Delta);
+	// zero-length edges could otherwise loop forever
+	int32 MaxEdgesCrossed = EdgeLengths.Num() + 1;
+	for (int32 EdgesCrossed = 0; EdgesCrossed < MaxEdgesCrossed; EdgesCrossed++)
+	{
+		float Length = EdgeLengths[Cursor.Edge];
+		bool bAlongEdge = bForward != Cursor.bReversed;
+		float RoomOnEdge = bAlongEdge ? Length - Cursor.DistanceOnEdge : Cursor.DistanceOnEdge;
+		if (Remaining <= RoomOnEdge)
+		{
+			Cursor.DistanceOnEdge += bAlongEdge ? Remaining : -Remaining;
+			return true;
+		}
+		Remaining -= RoomOnEdge;
+
+		int32 ArrivingEnd = MakeEnd(Cursor.Edge, bAlongEdge);
+		int32 NodeIndex = bAlongEdge ? EdgeEndNodes[Cursor.Edge] : EdgeStartNodes[Cursor.Edge];
+		int32 NextEnd = NodeIndex != INDEX_NONE ? GetNextEnd(Nodes[NodeIndex], ArrivingEnd) : INDEX_NONE;
+		if (NextEnd == INDEX_NONE)
+		{
+			// dead end; stop at the end of the line
+			Cursor.DistanceOnEdge = bAlongEdge ? Length : 0.0f;
+			Cursor.DeadEndShortfall = bForward ? Remaining : -Remaining;
+			return false;
+		}
+
+		bool bEnterAtStart = (NextEnd % 2) == 0;
+		Cursor.Edge = NextEnd / 2;
+		Cursor.DistanceOnEdge = bEnterAtStart ? 0.0f : EdgeLengths[Cursor.Edge];
+		Cursor.bReversed = bEnterAtStart != bForward;
+	}
+
+	return false;
+}
+
+int32& FTrackGraph::GetNodeOfEnd(int32 End)
+{
+	int32 Edge = End / 2;
+	return (End % 2) == 1 ? EdgeEndNodes[Edge] : EdgeStartNodes[Edge];
+}
+
+int32 FTrackGraph::FindOrAddNode(int32 End)
+{
+	int32& NodeIndex = GetNodeOfEnd(End);
+	if (NodeIndex == INDEX_NONE)
+	{
+		FTrackNode NewNode;
+		NewNode.Ends[0] = End;
+		NewNode.NumEnds = 1;
+		NewNode.bDiverging = false;
+		NodeIndex = Nodes.Add(NewNode);
+	}
+	return NodeIndex;
+}
+
+bool FTrackGraph::AddEndToNode(int32 NodeIndex, int32 End)
+{
+	FTrackNode& Node = Nodes[NodeIndex];
+	int32& NodeOfEnd = GetNodeOfEnd(End);
+	if (NodeOfEnd != INDEX_NONE || Node.NumEnds >= 3)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Track edge %d is already connected or node is full!"),
+			End / 2);
+		return false;
+	}
+	Node.Ends[Node.NumEnds++] = End;
+	NodeOfEnd = NodeIndex;
+	return true;
+}
+
+int32 FTrackGraph::GetNextEnd(const FTrackNode& Node, int32 ArrivingEnd) const
+{
+	if (Node.NumEnds < 2)
+	{
+		return INDEX_NONE;
+	}
+	if (Node.Ends[0] == ArrivingEnd)
+	{
+		return (Node.NumEnds == 3 && Node.bDiverging) ? Node.Ends[2] : Node.Ends[1];
+	}
+	return Node.Ends[0];
+}
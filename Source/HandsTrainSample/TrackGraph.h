@@ -0,0 +1,111 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Position of something traveling through a track graph.
+ */
+struct FTrackRouteCursor
+{
+	int32 Edge = INDEX_NONE;
+	float DistanceOnEdge = 0.0f;
+	// true if moving forward means moving from the edge's end to its start
+	bool bReversed = false;
+	// last distance the cursor was moved to, for callers that track
+	// position as a distance and need it turned into steps
+	float RouteDistance = 0.0f;
+	// signed distance the last move couldn't cover because it ran into a
+	// dead end; zero if the cursor got where it was sent
+	float DeadEndShortfall = 0.0f;
+};
+
+/**
+ * Track layout as edges (one per segment, with its arc length) joined at
+ * nodes. A node joins up to three edge ends, like a railway switch: the
+ * trunk comes first, followed by the straight and the diverging legs.
+ * Arriving from the trunk continues onto whichever leg the switch is set
+ * to; arriving from either leg always continues onto the trunk.
+ */
+class HANDSTRAINSAMPLE_API FTrackGraph
+{
+public:
+	FTrackGraph();
+
+	void Reset();
+
+	/** @return Index of the new edge. */
+	int32 AddEdge(float Length);
+
+	/** Joins the end of FromEdge to the start of ToEdge. */
+	bool Connect(int32 FromEdge, int32 ToEdge);
+
+	/** Joins the start of BranchEdge to the end of JunctionEdge as the diverging leg. */
+	bool AddDivergingLeg(int32 JunctionEdge, int32 BranchEdge);
+
+	/**
+	 * Joins the end of BranchEdge to the start of TrunkEdge as the diverging leg.
+	 * Fails if a switch is already there, like right after a junction.
+	 */
+	bool AddMergingLeg(int32 BranchEdge, int32 TrunkEdge);
+
+	/**
+	 * Switch at the end of an edge, or else at its start.
+	 * @return Node index, or INDEX_NONE if neither end is at a switch.
+	 */
+	int32 FindSwitchNode(int32 Edge) const;
+
+	void SetDiverging(int32 NodeIndex, bool bDiverging);
+
+	bool IsDiverging(int32 NodeIndex) const;
+
+	/**
+	 * Moves a cursor along the graph, following switches. Each edge crossed
+	 * costs constant time, so small per-frame steps are O(1).
+	 * @param Cursor - Cursor to move.
+	 * @param Delta - Distance to move; negative moves backward.
+	 * @return False if the cursor stopped at a dead end.
+	 */
+	bool Advance(FTrackRouteCursor& Cursor, float Delta) const;
+
+	int32 GetNumEdges() const
+	{
+		return EdgeLengths.Num();
+	}
+
+	float GetEdgeLength(int32 Edge) const
+	{
+		return EdgeLengths[Edge];
+	}
+
+private:
+	struct FTrackNode
+	{
+		// edge ends, encoded as edge * 2 + (1 if end, 0 if start)
+		int32 Ends[3];
+		int32 NumEnds;
+		bool bDiverging;
+	};
+
+	TArray<float> EdgeLengths;
+	TArray<int32> EdgeStartNodes;
+	TArray<int32> EdgeEndNodes;
+	TArray<FTrackNode> Nodes;
+
+	static int32 MakeEnd(int32 Edge, bool bEndOfEdge)
+	{
+		return Edge * 2 + (bEndOfEdge ? 1 : 0);
+	}
+
+	int32& GetNodeOfEnd(int32 End);
+	int32 FindOrAddNode(int32 End);
+	bool AddEndToNode(int32 NodeIndex, int32 End);
+	int32 GetNextEnd(const FTrackNode& Node, int32 ArrivingEnd) const;
+};
@@ -0,0 +1,215 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrackOccupancy.h"
+#include "Algo/BinarySearch.h"
+
+FTrackOccupancy::FTrackOccupancy()
+{
+	TrackLength = 0.0f;
+	NumTrains = 0;
+}
+
+void FTrackOccupancy::Initialize(const TArray<float>& InSegmentStartDistances, float InTrackLength)
+{
+	TrackLength = InTrackLength;
+	NumTrains = 0;
+	SegmentStartDistances = InSegmentStartDistances;
+	SegmentTrains.Reset();
+	SegmentTrains.SetNum(SegmentStartDistances.Num());
+	Trains.Reset();
+	FreeTrainIds.Reset();
+}
+
+int32 FTrackOccupancy::RegisterTrain()
+{
+	int32 TrainId = FreeTrainIds.Num() > 0 ? FreeTrainIds.Pop() : Trains.AddDefaulted();
+	FOccupiedInterval& Train = Trains[TrainId];
+	Train.Tail = 0.0f;
+	Train.Head = 0.0f;
+	Train.FirstSegment = INDEX_NONE;
+	Train.NumSegments = 0;
+	Train.bActive = true;
+	NumTrains++;
+	return TrainId;
+}
+
+void FTrackOccupancy::UnregisterTrain(int32 TrainId)
+{
+	if (!Trains.IsValidIndex(TrainId) || !Trains[TrainId].bActive)
+	{
+		return;
+	}
+	RemoveFromSegments(TrainId);
+	Trains[TrainId].bActive = false;
+	FreeTrainIds.Add(TrainId);
+	NumTrains--;
+}
+
+void FTrackOccupancy::UpdateTrain(int32 TrainId, float TailDistance, float HeadDistance)
+{
+	if (!Trains.IsValidIndex(TrainId) || !Trains[TrainId].bActive || SegmentTrains.Num() == 0)
+	{
+		return;
+	}
+
+	FOccupiedInterval& Train = Trains[TrainId];
+	Train.Tail = TailDistance;
+	Train.Head = FMath::Max(TailDistance, HeadDistance);
+
+	// most updates move the train within the segments it already
+	// occupies, in which case the lists stay as they are
+	int32 FirstSegment, NumCoveredSegments;
+	GetSegmentRange(Train, FirstSegment, NumCoveredSegments);
+	if (FirstSegment != Train.FirstSegment || NumCoveredSegments != Train.NumSegments)
+	{
+		RemoveFromSegments(TrainId);
+		AddToSegments(TrainId);
+	}
+}
+
+bool FTrackOccupancy::FindTrainAhead(int32 TrainId, bool bForward, float MaxLookDistance,
+	int32& OutTrainId, float& OutGap) const
+{
+	OutTrainId = INDEX_NONE;
+	OutGap = MaxLookDistance;
+	int32 NumSegments = SegmentTrains.Num();
+	if (!Trains.IsValidIndex(TrainId) || !Trains[TrainId].bActive || NumSegments == 0)
+	{
+		return false;
+	}
+
+	const FOccupiedInterval& Train = Trains[TrainId];
+	float Front = WrapDistance(bForward ? Train.Head : Train.Tail);
+	int32 StartSegment = FindSegmentIndex(Front);
+
+	for (int32 Step = 0; Step < NumSegments; Step++)
+	{
+		int32 SegmentIndex = bForward ? (StartSegment + Step) % NumSegments
+									  : (StartSegment - Step + NumSegments) % NumSegments;
+		if (Step > 0)
+		{
+			// how far this segment's near edge is from us
+			float SegmentEdge = bForward
+				? SegmentStartDistances[SegmentIndex]
+				: (SegmentIndex + 1 < NumSegments ? SegmentStartDistances[SegmentIndex + 1] : TrackLength);
+			float DistanceToSegment = WrapDistance(bForward ? SegmentEdge - Front : Front - SegmentEdge);
+			if (DistanceToSegment > MaxLookDistance)
+			{
+				break;
+			}
+		}
+
+		for (int32 OtherTrainId : SegmentTrains[SegmentIndex])
+		{
+			if (OtherTrainId == TrainId)
+			{
+				continue;
+			}
+			const FOccupiedInterval& OtherTrain = Trains[OtherTrainId];
+			float OtherLength = OtherTrain.Head - OtherTrain.Tail;
+			float Gap = 0.0f;
+			// if we are already inside the other train, there is no gap
+			if (WrapDistance(Front - OtherTrain.Tail) > OtherLength)
+			{
+				Gap = bForward ? WrapDistance(OtherTrain.Tail - Front)
+							   : WrapDistance(Front - OtherTrain.Head);
+			}
+			if (Gap <= OutGap)
+			{
+				OutGap = Gap;
+				OutTrainId = OtherTrainId;
+			}
+		}
+
+		// trains first listed in later segments are always further away
+		if (OutTrainId != INDEX_NONE)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+float FTrackOccupancy::LimitStep(int32 TrainId, float Step, float MinGap) const
+{
+	if (NumTrains < 2)
+	{
+		return Step;
+	}
+
+	// only trains we could reach with this step matter
+	int32 TrainAheadId;
+	float Gap;
+	bool bForward = Step >= 0.0f;
+	float StepSize = FMath::Abs(Step);
+	if (!FindTrainAhead(TrainId, bForward, StepSize + MinGap, TrainAheadId, Gap))
+	{
+		return Step;
+	}
+	float AllowedStep = FMath::Clamp(Gap - MinGap, 0.0f, StepSize);
+	return bForward ? AllowedStep : -AllowedStep;
+}
+
+float FTrackOccupancy::WrapDistance(float Distance) const
+{
+	if (TrackLength <= 0.0f)
+	{
+		return 0.0f;
+	}
+	Distance = FMath::Fmod(Distance, TrackLength);
+	return Distance < 0.0f ? Distance + TrackLength : Distance;
+}
+
+int32 FTrackOccupancy::FindSegmentIndex(float WrappedDistance) const
+{
+	return FMath::Max(0, Algo::UpperBound(SegmentStartDistances, WrappedDistance) - 1);
+}
+
+void FTrackOccupancy::GetSegmentRange(const FOccupiedInterval& Train,
+	int32& OutFirstSegment, int32& OutNumSegments) const
+{
+	int32 NumSegments = SegmentTrains.Num();
+	float WrappedTail = WrapDistance(Train.Tail);
+	float WrappedHead = WrapDistance(Train.Head);
+	OutFirstSegment = FindSegmentIndex(WrappedTail);
+	int32 LastSegment = FindSegmentIndex(WrappedHead);
+
+	OutNumSegments = (LastSegment - OutFirstSegment + NumSegments) % NumSegments + 1;
+	// a train as long as the track wraps back into its first segment
+	if ((Train.Head - Train.Tail) >= TrackLength
+		|| (OutFirstSegment == LastSegment && WrappedHead < WrappedTail))
+	{
+		OutNumSegments = NumSegments;
+	}
+}
+
+void FTrackOccupancy::AddToSegments(int32 TrainId)
+{
+	FOccupiedInterval& Train = Trains[TrainId];
+	GetSegmentRange(Train, Train.FirstSegment, Train.NumSegments);
+
+	int32 NumSegments = SegmentTrains.Num();
+	for (int32 Step = 0; Step < Train.NumSegments; Step++)
+	{
+		SegmentTrains[(Train.FirstSegment + Step) % NumSegments].Add(TrainId);
+	}
+}
+
+void FTrackOccupancy::RemoveFromSegments(int32 TrainId)
+{
+	FOccupiedInterval& Train = Trains[TrainId];
+	int32 NumSegments = SegmentTrains.Num();
+	for (int32 Step = 0; Step < Train.NumSegments; Step++)
+	{
+		SegmentTrains[(Train.FirstSegment + Step) % NumSegments].RemoveSingleSwap(TrainId);
+	}
+	Train.FirstSegment = INDEX_NONE;
+	Train.NumSegments = 0;
+}
@@ -0,0 +1,90 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Keeps track of which train occupies which stretch of a looping track.
+ * Each segment lists the trains overlapping it, so finding the train ahead
+ * only looks at the segments between two trains instead of at every train.
+ */
+class HANDSTRAINSAMPLE_API FTrackOccupancy
+{
+public:
+	FTrackOccupancy();
+
+	/**
+	 * Clears all trains and sets up one interval list per segment.
+	 * @param InSegmentStartDistances - Sorted start distance of each segment.
+	 * @param InTrackLength - Length of the whole loop.
+	 */
+	void Initialize(const TArray<float>& InSegmentStartDistances, float InTrackLength);
+
+	/** @return Id used to update and query the train. */
+	int32 RegisterTrain();
+
+	void UnregisterTrain(int32 TrainId);
+
+	/**
+	 * Moves a train's interval. Distances may be unwrapped; the interval
+	 * goes forward from tail to head.
+	 */
+	void UpdateTrain(int32 TrainId, float TailDistance, float HeadDistance);
+
+	/**
+	 * Finds the closest train in the direction of travel.
+	 * @param TrainId - Train doing the query.
+	 * @param bForward - Looks past the head if true, behind the tail otherwise.
+	 * @param MaxLookDistance - Trains further than this are ignored.
+	 * @param OutTrainId - Closest train found.
+	 * @param OutGap - Free track between the two trains.
+	 * @return True if a train was found.
+	 */
+	bool FindTrainAhead(int32 TrainId, bool bForward, float MaxLookDistance,
+		int32& OutTrainId, float& OutGap) const;
+
+	/**
+	 * Shortens a step so the train stops MinGap short of the train ahead.
+	 * @param Step - Signed distance the train wants to move.
+	 * @return Signed distance it may move.
+	 */
+	float LimitStep(int32 TrainId, float Step, float MinGap) const;
+
+	int32 GetNumTrains() const
+	{
+		return NumTrains;
+	}
+
+private:
+	struct FOccupiedInterval
+	{
+		float Tail;
+		float Head;
+		// segment range the train is listed in, walking forward with wrap
+		int32 FirstSegment;
+		int32 NumSegments;
+		bool bActive;
+	};
+
+	float TrackLength;
+	int32 NumTrains;
+	TArray<float> SegmentStartDistances;
+	// trains overlapping each segment
+	TArray<TArray<int32>> SegmentTrains;
+	TArray<FOccupiedInterval> Trains;
+	TArray<int32> FreeTrainIds;
+
+	float WrapDistance(float Distance) const;
+	int32 FindSegmentIndex(float WrappedDistance) const;
+	void GetSegmentRange(const FOccupiedInterval& Train,
+		int32& OutFirstSegment, int32& OutNumSegments) const;
+	void AddToSegments(int32 TrainId);
+	void RemoveFromSegments(int32 TrainId);
+};
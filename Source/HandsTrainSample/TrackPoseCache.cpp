@@ -0,0 +1,153 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrackPoseCache.h"
+
+const int32 FTrackPoseCache::MaxNumSamples = 1 << 16;
+
+FTrackPoseCache::FTrackPoseCache()
+{
+	Reset();
+}
+
+void FTrackPoseCache::Reset()
+{
+	TrackLength = 0.0f;
+	SampleSpacing = 0.0f;
+	InvSampleSpacing = 0.0f;
+	MaxMeasuredError = 0.0f;
+	MaxMeasuredAngleError = 0.0f;
+
+	LocationX.Reset();
+	LocationY.Reset();
+	LocationZ.Reset();
+	RotationX.Reset();
+	RotationY.Reset();
+	RotationZ.Reset();
+	RotationW.Reset();
+}
+
+bool FTrackPoseCache::Build(float InTrackLength, float InitialSampleSpacing,
+	float MaxPositionError, float MaxAngleError, FPoseEvaluator EvaluateExactPose)
+{
+	Reset();
+	if (InTrackLength <= 0.0f || InitialSampleSpacing <= 0.0f)
+	{
+		return false;
+	}
+
+	TrackLength = InTrackLength;
+	// round to a whole number of intervals so the last sample lands
+	// exactly on the end of the track
+	int32 NumIntervals = FMath::Max(1, FMath::CeilToInt(TrackLength / InitialSampleSpacing));
+	while (true)
+	{
+		SampleTrack(NumIntervals, EvaluateExactPose);
+		MeasureMaxErrors(EvaluateExactPose, MaxMeasuredError, MaxMeasuredAngleError);
+		if (MaxMeasuredError <= MaxPositionError && MaxMeasuredAngleError <= MaxAngleError)
+		{
+			return true;
+		}
+		if ((NumIntervals * 2 + 1) > MaxNumSamples)
+		{
+			UE_LOG(LogTemp, Warning,
+				TEXT("Track pose cache error %f (angle %f) exceeds bound %f (angle %f) with %d samples."),
+				MaxMeasuredError, MaxMeasuredAngleError, MaxPositionError, MaxAngleError, GetNumSamples());
+			return false;
+		}
+		NumIntervals *= 2;
+	}
+}
+
+void FTrackPoseCache::SampleTrack(int32 NumIntervals, FPoseEvaluator EvaluateExactPose)
+{
+	int32 NumSamples = NumIntervals + 1;
+	SampleSpacing = TrackLength / NumIntervals;
+	InvSampleSpacing = 1.0f / SampleSpacing;
+
+	LocationX.SetNumUninitialized(NumSamples);
+	LocationY.SetNumUninitialized(NumSamples);
+	LocationZ.SetNumUninitialized(NumSamples);
+	RotationX.SetNumUninitialized(NumSamples);
+	RotationY.SetNumUninitialized(NumSamples);
+	RotationZ.SetNumUninitialized(NumSamples);
+	RotationW.SetNumUninitialized(NumSamples);
+
+	FTransform Pose;
+	FQuat PrevRotation = FQuat::Identity;
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++)
+	{
+		EvaluateExactPose(SampleIndex * SampleSpacing, Pose);
+		FVector Location = Pose.GetLocation();
+		FQuat Rotation = Pose.GetRotation();
+		// keep neighbors in the same hemisphere so a plain lerp
+		// between them takes the short way around
+		if (SampleIndex > 0 && (Rotation | PrevRotation) < 0.0f)
+		{
+			Rotation = -Rotation;
+		}
+		PrevRotation = Rotation;
+
+		LocationX[SampleIndex] = Location.X;
+		LocationY[SampleIndex] = Location.Y;
+		LocationZ[SampleIndex] = Location.Z;
+		RotationX[SampleIndex] = Rotation.X;
+		RotationY[SampleIndex] = Rotation.Y;
+		RotationZ[SampleIndex] = Rotation.Z;
+		RotationW[SampleIndex] = Rotation.W;
+	}
+}
+
+// position is off the most halfway between samples, but a normalized
+// lerp of rotations is exact there and off the most closer to the samples
+void FTrackPoseCache::MeasureMaxErrors(FPoseEvaluator EvaluateExactPose, float& OutMaxPositionError,
+	float& OutMaxAngleError) const
+{
+	const float Alphas[3] = { 0.25f, 0.5f, 0.75f };
+	float MaxErrorSquared = 0.0f;
+	OutMaxAngleError = 0.0f;
+	FTransform ExactPose, CachedPose;
+	int32 NumIntervals = GetNumSamples() - 1;
+	for (int32 IntervalIndex = 0; IntervalIndex < NumIntervals; IntervalIndex++)
+	{
+		for (float Alpha : Alphas)
+		{
+			float Distance = (IntervalIndex + Alpha) * SampleSpacing;
+			EvaluateExactPose(Distance, ExactPose);
+			EvaluatePose(Distance, CachedPose);
+			MaxErrorSquared = FMath::Max(MaxErrorSquared,
+				(float)FVector::DistSquared(ExactPose.GetLocation(), CachedPose.GetLocation()));
+			OutMaxAngleError = FMath::Max(OutMaxAngleError,
+				(float)ExactPose.GetRotation().AngularDistance(CachedPose.GetRotation()));
+		}
+	}
+	OutMaxPositionError = FMath::Sqrt(MaxErrorSquared);
+}
+
+void FTrackPoseCache::EvaluatePose(float DistanceIntoTrack, FTransform& Pose) const
+{
+	float SamplePosition = FMath::Clamp(DistanceIntoTrack, 0.0f, TrackLength) * InvSampleSpacing;
+	int32 SampleIndex = FMath::Min((int32)SamplePosition, GetNumSamples() - 2);
+	float Alpha = SamplePosition - SampleIndex;
+	int32 NextIndex = SampleIndex + 1;
+
+	Pose.SetLocation(FVector(
+		FMath::Lerp(LocationX[SampleIndex], LocationX[NextIndex], Alpha),
+		FMath::Lerp(LocationY[SampleIndex], LocationY[NextIndex], Alpha),
+		FMath::Lerp(LocationZ[SampleIndex], LocationZ[NextIndex], Alpha)));
+
+	// samples are close together, so a normalized lerp is
+	// indistinguishable from a slerp and much cheaper
+	FQuat Rotation(
+		FMath::Lerp(RotationX[SampleIndex], RotationX[NextIndex], Alpha),
+		FMath::Lerp(RotationY[SampleIndex], RotationY[NextIndex], Alpha),
+		FMath::Lerp(RotationZ[SampleIndex], RotationZ[NextIndex], Alpha),
+		FMath::Lerp(RotationW[SampleIndex], RotationW[NextIndex], Alpha));
+	Rotation.Normalize();
+	Pose.SetRotation(Rotation);
+}
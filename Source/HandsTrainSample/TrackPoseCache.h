@@ -0,0 +1,90 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Track poses baked at a fixed arc-length spacing. Positions and rotations
+ * are stored component-wise in separate arrays so evaluating a pose is just
+ * an index computation and an interpolation between two samples, with no
+ * trig or actor transform access.
+ */
+class HANDSTRAINSAMPLE_API FTrackPoseCache
+{
+public:
+	FTrackPoseCache();
+
+	/** Evaluates the exact pose at a distance along the track. */
+	typedef TFunctionRef<void(float DistanceIntoTrack, FTransform& Pose)> FPoseEvaluator;
+
+	/**
+	 * Samples the track, halving the spacing until interpolated poses stay
+	 * within both error bounds of the exact ones.
+	 * @param InTrackLength - Length of the track to sample.
+	 * @param InitialSampleSpacing - Distance between samples to start with.
+	 * @param MaxPositionError - Max allowed position error between samples.
+	 * @param MaxAngleError - Max allowed rotation error between samples, in radians.
+	 * @param EvaluateExactPose - Analytic pose of the track.
+	 * @return True if both error bounds were met.
+	 */
+	bool Build(float InTrackLength, float InitialSampleSpacing, float MaxPositionError, float MaxAngleError,
+		FPoseEvaluator EvaluateExactPose);
+
+	void Reset();
+
+	bool IsValid() const
+	{
+		return LocationX.Num() > 1;
+	}
+
+	int32 GetNumSamples() const
+	{
+		return LocationX.Num();
+	}
+
+	float GetSampleSpacing() const
+	{
+		return SampleSpacing;
+	}
+
+	float GetMaxMeasuredError() const
+	{
+		return MaxMeasuredError;
+	}
+
+	/** In radians. */
+	float GetMaxMeasuredAngleError() const
+	{
+		return MaxMeasuredAngleError;
+	}
+
+	/**
+	 * Interpolates the cached pose. Distance is clamped to the track.
+	 * Only location and rotation of Pose are written.
+	 */
+	void EvaluatePose(float DistanceIntoTrack, FTransform& Pose) const;
+
+private:
+	// caps the refinement so a bad error bound can't eat all memory
+	const static int32 MaxNumSamples;
+
+	float TrackLength;
+	float SampleSpacing;
+	float InvSampleSpacing;
+	float MaxMeasuredError;
+	float MaxMeasuredAngleError;
+
+	TArray<float> LocationX, LocationY, LocationZ;
+	TArray<float> RotationX, RotationY, RotationZ, RotationW;
+
+	void SampleTrack(int32 NumIntervals, FPoseEvaluator EvaluateExactPose);
+	void MeasureMaxErrors(FPoseEvaluator EvaluateExactPose, float& OutMaxPositionError,
+		float& OutMaxAngleError) const;
+};
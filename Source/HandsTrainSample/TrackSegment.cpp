@@ -16,6 +16,8 @@ ATrackSegment::ATrackSegment()
 {
 	PrimaryActorTick.bCanEverTick = false;
 	TrackSegmentType = ESegmentType::Straight;
+	BranchFromSegmentIndex = INDEX_NONE;
+	MergeIntoSegmentIndex = INDEX_NONE;
 
 	RootSceneComponent = CreateDefaultSubobject<USceneComponent>(FName(TEXT("Root")));
 	RootComponent = RootSceneComponent;
@@ -42,14 +44,19 @@ ATrackSegment::ATrackSegment()
 
 float ATrackSegment::GetSegmentLength() const
 {
-	switch (TrackSegmentType)
+	return ComputeSegmentLength(TrackSegmentType, GridSize);
+}
+
+float ATrackSegment::ComputeSegmentLength(ESegmentType SegmentType, float SegmentGridSize)
+{
+	switch (ToShapeType(SegmentType))
 	{
 		case ESegmentType::Straight:
-			return GridSize;
+			return SegmentGridSize;
 		default:
 			// return quarter of circumference
 			// for turns
-			return 0.5f * PI * ComputeRadius();
+			return 0.5f * PI * 0.5f * SegmentGridSize;
 	}
 }
 
@@ -60,24 +67,32 @@ FTransform ATrackSegment::GetEndPose() const
 	return newPose;
 }
 
+void ATrackSegment::UpdatePoseInSegment(float DistanceIntoSegment, FTransform& Pose) const
+{
+	ComputePoseInSegment(TrackSegmentType, GridSize, GetTransform(), DistanceIntoSegment, Pose);
+}
+
 // note that start of segment's mesh starts at 0 for forward (X) in local space
 //
-void ATrackSegment::UpdatePoseInSegment(float DistanceIntoSegment, FTransform& Pose) const
+void ATrackSegment::ComputePoseInSegment(ESegmentType SegmentType, float SegmentGridSize,
+	const FTransform& SegmentTransform, float DistanceIntoSegment, FTransform& Pose)
 {
-	float CurrentRadius = ComputeRadius();
+	float CurrentRadius = 0.5f * SegmentGridSize;
+	ESegmentType ShapeType = ToShapeType(SegmentType);
 
-	if (TrackSegmentType == ESegmentType::Straight)
+	if (ShapeType == ESegmentType::Straight)
 	{
-		Pose.SetLocation(GetActorLocation() + DistanceIntoSegment * GetActorForwardVector());
-		Pose.SetRotation(GetActorRotation().Quaternion());
+		Pose.SetLocation(SegmentTransform.GetLocation()
+			+ DistanceIntoSegment * SegmentTransform.GetUnitAxis(EAxis::X));
+		Pose.SetRotation(SegmentTransform.GetRotation());
 	}
-	else if (TrackSegmentType == ESegmentType::LeftTurn)
+	else if (ShapeType == ESegmentType::LeftTurn)
 	{
-		float NormalizedDistanceIntoSegment = DistanceIntoSegment / GetSegmentLength();
+		float NormalizedDistanceIntoSegment = DistanceIntoSegment
+			/ ComputeSegmentLength(ShapeType, SegmentGridSize);
 		// the turn is 90 degrees, so find out how far we are into it
 		// by multiply angle for quarter circle by normalized distance into it
 		float Angle = 0.5f * PI * NormalizedDistanceIntoSegment;
-		const FTransform& actorTransform = GetTransform();
 
 		// sin represents x component in local space, which starts from 0 and goes to radius
 		// cos, or the right component, starts from 0 and goes to -radius
@@ -87,34 +102,56 @@ void ATrackSegment::UpdatePoseInSegment(float DistanceIntoSegment, FTransform& P
 		// note negation (left turn means train pose needs to go in opposite direction -- opposite
 		// of left-hand rule)
 		FRotator LocalRotation(0, -Angle * 180.0f / PI, 0);
-		Pose.SetLocation(actorTransform.TransformPosition(LocalPosition));
-		Pose.SetRotation(actorTransform.TransformRotation(LocalRotation.Quaternion()));
+		Pose.SetLocation(SegmentTransform.TransformPosition(LocalPosition));
+		Pose.SetRotation(SegmentTransform.TransformRotation(LocalRotation.Quaternion()));
 	}
 	else
 	{
-		float NormalizedDistanceIntoSegment = DistanceIntoSegment / GetSegmentLength();
+		float NormalizedDistanceIntoSegment = DistanceIntoSegment
+			/ ComputeSegmentLength(ShapeType, SegmentGridSize);
 		float Angle = 0.5f * PI * NormalizedDistanceIntoSegment;
-		const FTransform& ActorTransform = GetTransform();
 		// forward goes from 0 to radius units
 		// right component goes from 0 to radius units
 		FVector LocalPosition(CurrentRadius * sin(Angle),
 			CurrentRadius - CurrentRadius * cos(Angle), 0.0f);
 		FRotator LocalRotation(0, Angle * 180.0f / PI, 0);
-		Pose.SetLocation(ActorTransform.TransformPosition(LocalPosition));
-		Pose.SetRotation(ActorTransform.TransformRotation(LocalRotation.Quaternion()));
+		Pose.SetLocation(SegmentTransform.TransformPosition(LocalPosition));
+		Pose.SetRotation(SegmentTransform.TransformRotation(LocalRotation.Quaternion()));
 	}
 }
 
+FTransform ATrackSegment::ComputeMeshRelativeTransform(float SegmentGridSize,
+	const FTransform& MeshTemplateTransform)
+{
+	// same as what EnableMeshAndRegenerateTrack and
+	// MoveMeshBottomTowardPivot do to the mesh component
+	FTransform MeshTransform = MeshTemplateTransform;
+	MeshTransform.SetScale3D(FVector(SegmentGridSize / OriginalMeshGridSize));
+	MeshTransform.SetLocation(FVector::ForwardVector * SegmentGridSize * 0.5f);
+	return MeshTransform;
+}
+
+void FTrackSegmentData::InitFromSegment(const ATrackSegment& TrackSegment)
+{
+	TrackSegmentType = TrackSegment.TrackSegmentType;
+	SegmentIndex = TrackSegment.SegmentIndex;
+	BranchFromSegmentIndex = TrackSegment.BranchFromSegmentIndex;
+	MergeIntoSegmentIndex = TrackSegment.MergeIntoSegmentIndex;
+	GridSize = TrackSegment.GridSize;
+	StartDistance = TrackSegment.StartDistance;
+	Transform = TrackSegment.GetTransform();
+}
+
 void ATrackSegment::EnableMeshAndRegenerateTrack()
 {
 	for (unsigned int SegmentTypeIndex = (unsigned int)ESegmentType::Straight;
 		SegmentTypeIndex <= (unsigned int)ESegmentType::RightTurn; SegmentTypeIndex++)
 	{
 		ToggleStaticMesh(SegmentMeshes[SegmentTypeIndex],
-			SegmentTypeIndex == (unsigned int)TrackSegmentType);
+			SegmentTypeIndex == (unsigned int)GetShapeType());
 	}
 
-	UStaticMeshComponent* MeshComp = SegmentMeshes[(unsigned int)TrackSegmentType];
+	UStaticMeshComponent* MeshComp = GetMeshComp();
 	if (IsValid(MeshComp))
 	{
 		MeshComp->SetRelativeScale3D(FVector(
@@ -129,7 +166,7 @@ void ATrackSegment::EnableMeshAndRegenerateTrack()
 // mesh forward halfway
 void ATrackSegment::MoveMeshBottomTowardPivot()
 {
-	UStaticMeshComponent* MeshComp = SegmentMeshes[(unsigned int)TrackSegmentType];
+	UStaticMeshComponent* MeshComp = GetMeshComp();
 
 	if (IsValid(MeshComp))
 	{
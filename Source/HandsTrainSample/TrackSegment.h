@@ -18,6 +18,8 @@ enum class ESegmentType : uint8
 	Straight,
 	LeftTurn,
 	RightTurn,
+	// straight piece whose end can switch onto a branch
+	Junction,
 };
 
 UCLASS()
@@ -58,6 +60,15 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Positioning")
 	int SegmentIndex;
 
+	// If set, this segment starts a branch at the end of that junction segment
+	// instead of following the segment before it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Positioning")
+	int BranchFromSegmentIndex;
+
+	// If set, the end of this segment joins the start of that segment
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Positioning")
+	int MergeIntoSegmentIndex;
+
 	UFUNCTION(BlueprintCallable, Category = "Positioning")
 	FTransform GetEndPose() const;
 
@@ -71,10 +82,23 @@ public:
 		return GridSize / OriginalMeshGridSize;
 	}
 
+	/** Scale of segment meshes (and trains) for a grid size. */
+	static float ComputeScaleRatio(float SegmentGridSize)
+	{
+		return SegmentGridSize / OriginalMeshGridSize;
+	}
+
 	UFUNCTION(BlueprintCallable, Category = "Positioning")
 	class UStaticMeshComponent* GetMeshComp()
 	{
-		return SegmentMeshes[(unsigned int)TrackSegmentType];
+		return SegmentMeshes[(unsigned int)GetShapeType()];
+	}
+
+	/** Type whose mesh and geometry this segment uses; junctions are straight. */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Positioning")
+	ESegmentType GetShapeType() const
+	{
+		return ToShapeType(TrackSegmentType);
 	}
 
 	UFUNCTION(BlueprintCallable, Category = "Positioning")
@@ -86,6 +110,24 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Positioning")
 	void UpdatePoseInSegment(float DistanceIntoSegment, FTransform& Pose) const;
 
+	static ESegmentType ToShapeType(ESegmentType SegmentType)
+	{
+		return SegmentType == ESegmentType::Junction ? ESegmentType::Straight : SegmentType;
+	}
+
+	/** Segment geometry without an actor, shared with instanced tracks. */
+	static float ComputeSegmentLength(ESegmentType SegmentType, float SegmentGridSize);
+
+	static void ComputePoseInSegment(ESegmentType SegmentType, float SegmentGridSize,
+		const FTransform& SegmentTransform, float DistanceIntoSegment, FTransform& Pose);
+
+	/**
+	 * Transform of a segment's mesh relative to the segment.
+	 * @param MeshTemplateTransform - Relative transform of the mesh component in the blueprint.
+	 */
+	static FTransform ComputeMeshRelativeTransform(float SegmentGridSize,
+		const FTransform& MeshTemplateTransform);
+
 protected:
 	const static float OriginalMeshGridSize;
 
@@ -99,3 +141,39 @@ protected:
 	void ToggleStaticMesh(UStaticMeshComponent* MeshComp,
 		bool ToggleValue);
 };
+
+/**
+ * Logical part of a track segment, without an actor. Tracks keep one of
+ * these per segment for pose evaluation whether or not segments are actors.
+ */
+struct FTrackSegmentData
+{
+	ESegmentType TrackSegmentType = ESegmentType::Straight;
+	int32 SegmentIndex = INDEX_NONE;
+	int32 BranchFromSegmentIndex = INDEX_NONE;
+	int32 MergeIntoSegmentIndex = INDEX_NONE;
+	float GridSize = 0.0f;
+	float StartDistance = 0.0f;
+	// world transform of the start of the segment
+	FTransform Transform;
+
+	void InitFromSegment(const ATrackSegment& TrackSegment);
+
+	float GetSegmentLength() const
+	{
+		return ATrackSegment::ComputeSegmentLength(TrackSegmentType, GridSize);
+	}
+
+	void UpdatePoseInSegment(float DistanceIntoSegment, FTransform& Pose) const
+	{
+		ATrackSegment::ComputePoseInSegment(TrackSegmentType, GridSize, Transform,
+			DistanceIntoSegment, Pose);
+	}
+
+	FTransform GetEndPose() const
+	{
+		FTransform EndPose;
+		UpdatePoseInSegment(GetSegmentLength(), EndPose);
+		return EndPose;
+	}
+};
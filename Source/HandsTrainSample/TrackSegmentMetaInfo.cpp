@@ -11,6 +11,8 @@ LICENSE file in the root directory of this source tree.
 UTrackSegmentMetaInfo::UTrackSegmentMetaInfo()
 {
 	PrimaryComponentTick.bCanEverTick = false;
+	BranchFromSegmentIndex = INDEX_NONE;
+	MergeIntoSegmentIndex = INDEX_NONE;
 }
 
 float UTrackSegmentMetaInfo::GetSegmentLength(float GridSize) const
@@ -18,6 +20,7 @@ float UTrackSegmentMetaInfo::GetSegmentLength(float GridSize) const
 	switch (TrackSegmentType)
 	{
 		case ESegmentType::Straight:
+		case ESegmentType::Junction:
 			return GridSize;
 		default:
 			// return quarter of circumference
@@ -28,6 +28,15 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Positioning")
 	int SegmentIndex;
 
+	// Junction segment this segment branches off from, if any. Branch
+	// segments must come after all segments of the main loop
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Positioning")
+	int BranchFromSegmentIndex;
+
+	// Segment whose start this segment's end joins, if any
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Positioning")
+	int MergeIntoSegmentIndex;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = "Positioning",
 		meta = (Tooltip = "Start distance of segment"))
 	float StartDistance;
@@ -8,6 +8,8 @@ LICENSE file in the root directory of this source tree.
 
 #include "TrainCarBase.h"
 #include "TrackSegment.h"
+#include "TrainConsistSim.h"
+#include "Components/SceneComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 
 const FVector ATrainCarBase::UpOffset(0.0f, 0.0f, 1.95f);
@@ -18,6 +20,8 @@ ATrainCarBase::ATrainCarBase()
 	PrimaryActorTick.bCanEverTick = false;
 
 	Distance = 0.0f;
+	FrontSegmentHint = INDEX_NONE;
+	RearSegmentHint = INDEX_NONE;
 }
 
 void ATrainCarBase::BeginPlay()
@@ -44,6 +48,13 @@ void ATrainCarBase::BeginPlay()
 	}
 }
 
+float ATrainCarBase::GetDeadEndShortfall() const
+{
+	float FrontShortfall = FrontRouteCursor.DeadEndShortfall;
+	float RearShortfall = RearRouteCursor.DeadEndShortfall;
+	return FMath::Abs(FrontShortfall) >= FMath::Abs(RearShortfall) ? FrontShortfall : RearShortfall;
+}
+
 void ATrainCarBase::UpdateCarPosition()
 {
 	if (!IsValid(FrontWheelBase) || !IsValid(RearWheelBase))
@@ -54,8 +65,8 @@ void ATrainCarBase::UpdateCarPosition()
 	FVector FrontWheelsRelativeLoc = FrontWheelBase->GetRelativeLocation();
 	FVector RearWheelsRelativeLoc = RearWheelBase->GetRelativeLocation();
 	// because the model is rotated in the blueprint, forward in relative direction is z TODO remove
-	UpdatePose(Distance + FrontWheelsRelativeLoc[0] * Scale, FrontPose);
-	UpdatePose(Distance + RearWheelsRelativeLoc[0] * Scale, RearPose);
+	UpdatePose(Distance + FrontWheelsRelativeLoc[0] * Scale, FrontPose, FrontSegmentHint, FrontRouteCursor);
+	UpdatePose(Distance + RearWheelsRelativeLoc[0] * Scale, RearPose, RearSegmentHint, RearRouteCursor);
 
 	const FVector& FrontPosePosition = FrontPose.GetLocation();
 	const FVector& RearPosePosition = RearPose.GetLocation();
@@ -71,6 +82,76 @@ void ATrainCarBase::UpdateCarPosition()
 	RearWheelBase->SetWorldRotation(RearPose.GetRotation());
 }
 
+int32 ATrainCarBase::AddToConsist(FTrainConsistSim& ConsistSim, float DistanceBehindLead) const
+{
+	if (!IsValid(FrontWheelBase) || !IsValid(RearWheelBase))
+	{
+		return INDEX_NONE;
+	}
+
+	// because the model is rotated in the blueprint, forward in relative direction is z TODO remove
+	return ConsistSim.AddCar(DistanceBehindLead,
+		FrontWheelBase->GetRelativeLocation()[0] * Scale,
+		RearWheelBase->GetRelativeLocation()[0] * Scale,
+		ATrainCarBase::WheelRadius,
+		UpOffset,
+		GetActorQuat());
+}
+
+void ATrainCarBase::ApplyConsistPose(const FTrainCarPose& CarPose)
+{
+	Distance = CarPose.Distance;
+	if (!IsValid(RootComponent) || !IsValid(FrontWheelBase) || !IsValid(RearWheelBase))
+	{
+		return;
+	}
+
+	// children only get new relative rotations here; the root's transform
+	// update below carries all of them along in a single pass
+	const FTransform OldRootTransform = RootComponent->GetComponentTransform();
+	const FTransform NewRootTransform(CarPose.Rotation, CarPose.Location, OldRootTransform.GetScale3D());
+	FrontWheelBase->SetRelativeRotation_Direct(GetRelativeRotationAfterRootMove(FrontWheelBase,
+		CarPose.FrontAxleRotation, OldRootTransform, NewRootTransform).Rotator());
+	RearWheelBase->SetRelativeRotation_Direct(GetRelativeRotationAfterRootMove(RearWheelBase,
+		CarPose.RearAxleRotation, OldRootTransform, NewRootTransform).Rotator());
+
+	FRotator WheelRotation(CarPose.WheelPitch, 0, 0);
+	for (auto Wheel : TrainWheels)
+	{
+		if (IsValid(Wheel))
+		{
+			Wheel->SetRelativeRotation_Direct(WheelRotation);
+		}
+	}
+
+	FTransform NewRootRelativeTransform = NewRootTransform;
+	if (const USceneComponent* RootParent = RootComponent->GetAttachParent())
+	{
+		NewRootRelativeTransform = NewRootTransform.GetRelativeTransform(
+			RootParent->GetSocketTransform(RootComponent->GetAttachSocketName()));
+	}
+	RootComponent->SetRelativeLocation_Direct(NewRootRelativeTransform.GetLocation());
+	RootComponent->SetRelativeRotation_Direct(NewRootRelativeTransform.Rotator());
+	// teleporting propagates to children even if the root stays put
+	RootComponent->UpdateComponentToWorld(EUpdateTransformFlags::None, ETeleportType::TeleportPhysics);
+	RootComponent->UpdateOverlaps();
+}
+
+FQuat ATrainCarBase::GetRelativeRotationAfterRootMove(const USceneComponent* Component,
+	const FQuat& WorldRotation, const FTransform& OldRootTransform, const FTransform& NewRootTransform) const
+{
+	const USceneComponent* Parent = Component->GetAttachParent();
+	if (Parent == nullptr)
+	{
+		return WorldRotation;
+	}
+	// the parent is carried along rigidly by the root
+	FQuat OldParentRotation = Parent->GetSocketQuaternion(Component->GetAttachSocketName());
+	FQuat NewParentRotation = NewRootTransform.GetRotation() * OldRootTransform.GetRotation().Inverse()
+		* OldParentRotation;
+	return NewParentRotation.Inverse() * WorldRotation;
+}
+
 void ATrainCarBase::RotateCarWheels()
 {
 	// dividing distance by radius gives us how
@@ -85,7 +166,8 @@ void ATrainCarBase::RotateCarWheels()
 	}
 }
 
-void ATrainCarBase::UpdatePose(float PoseDistance, FTransform& Pose)
+void ATrainCarBase::UpdatePose(float PoseDistance, FTransform& Pose, int32& SegmentHint,
+	FTrackRouteCursor& RouteCursor)
 {
 	if (!IsValid(TrainTrack))
 	{
@@ -100,11 +182,13 @@ void ATrainCarBase::UpdatePose(float PoseDistance, FTransform& Pose)
 		PoseDistance += TrackLength;
 	}
 
-	ATrackSegment* trackSegment = TrainTrack->GetTrackSegment(PoseDistance);
-	if (IsValid(trackSegment))
+	if (TrainTrack->HasBranches())
+	{
+		TrainTrack->EvaluateRoutePose(PoseDistance, Pose, RouteCursor);
+	}
+	else
 	{
-		float DistanceIntoSegment = PoseDistance - trackSegment->StartDistance;
-		trackSegment->UpdatePoseInSegment(DistanceIntoSegment, Pose);
+		TrainTrack->EvaluatePose(PoseDistance, Pose, SegmentHint);
 	}
 }
 
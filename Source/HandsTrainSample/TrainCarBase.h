@@ -13,6 +13,9 @@ LICENSE file in the root directory of this source tree.
 #include "TrainTrack.h"
 #include "TrainCarBase.generated.h"
 
+class FTrainConsistSim;
+struct FTrainCarPose;
+
 /**
  * Base class for all trains. The blueprint is constructed via
  * importing an FBX, so all children of this actor's scene graph
@@ -42,6 +45,26 @@ public:
 		return Distance;
 	}
 
+	/**
+	 * Adds this car's dimensions to a consist simulation.
+	 * @return Index of the car in the sim, or INDEX_NONE if the car has no wheel bases.
+	 */
+	int32 AddToConsist(FTrainConsistSim& ConsistSim, float DistanceBehindLead) const;
+
+	/**
+	 * Writes a simulated pose to the car and its wheels. Child rotations are
+	 * set without updating them, then one teleporting transform update of the
+	 * root moves everything, followed by one overlap update.
+	 */
+	void ApplyConsistPose(const FTrainCarPose& CarPose);
+
+	/**
+	 * Signed distance the axle that ran into a dead end on the last update
+	 * fell short by, or zero if neither did. Only tracks with branches have
+	 * dead ends.
+	 */
+	float GetDeadEndShortfall() const;
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -70,7 +93,20 @@ private:
 
 	FTransform FrontPose, RearPose;
 
-	void UpdatePose(float PoseDistance, FTransform& Pose);
+	// last track segments found for each axle, used to speed up lookups
+	int32 FrontSegmentHint;
+	int32 RearSegmentHint;
+
+	// where each axle is on tracks with branches
+	FTrackRouteCursor FrontRouteCursor;
+	FTrackRouteCursor RearRouteCursor;
+
+	void UpdatePose(float PoseDistance, FTransform& Pose, int32& SegmentHint,
+		FTrackRouteCursor& RouteCursor);
 
 	FQuat ConstructLookRotation(const FVector& LookDirection, const FVector& UpVector);
+
+	/** Relative rotation that gives a child a world rotation once the root has moved. */
+	FQuat GetRelativeRotationAfterRootMove(const USceneComponent* Component, const FQuat& WorldRotation,
+		const FTransform& OldRootTransform, const FTransform& NewRootTransform) const;
 };
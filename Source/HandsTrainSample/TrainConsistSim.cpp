@@ -0,0 +1,126 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrainConsistSim.h"
+
+FTrainConsistSim::FTrainConsistSim()
+{
+}
+
+void FTrainConsistSim::Reset()
+{
+	DistancesBehindLead.Reset();
+	FrontAxleOffsets.Reset();
+	RearAxleOffsets.Reset();
+	InvWheelRadii.Reset();
+	UpOffsets.Reset();
+
+	CarDistances.Reset();
+	WheelPitches.Reset();
+	FrontSegmentHints.Reset();
+	RearSegmentHints.Reset();
+	Locations.Reset();
+	Rotations.Reset();
+	FrontAxleRotations.Reset();
+	RearAxleRotations.Reset();
+}
+
+int32 FTrainConsistSim::AddCar(float DistanceBehindLead, float FrontAxleOffset, float RearAxleOffset,
+	float WheelRadius, const FVector& UpOffset, const FQuat& InitialRotation)
+{
+	DistancesBehindLead.Add(DistanceBehindLead);
+	FrontAxleOffsets.Add(FrontAxleOffset);
+	RearAxleOffsets.Add(RearAxleOffset);
+	InvWheelRadii.Add(WheelRadius > 0.0f ? 1.0f / WheelRadius : 0.0f);
+	UpOffsets.Add(UpOffset);
+
+	CarDistances.Add(0.0f);
+	WheelPitches.Add(0.0f);
+	FrontSegmentHints.Add(INDEX_NONE);
+	RearSegmentHints.Add(INDEX_NONE);
+	Locations.Add(FVector::ZeroVector);
+	Rotations.Add(InitialRotation);
+	FrontAxleRotations.Add(InitialRotation);
+	return RearAxleRotations.Add(InitialRotation);
+}
+
+void FTrainConsistSim::Advance(float LeadDistance, float TrackLength, FTrackEvaluator EvaluateTrack)
+{
+	if (TrackLength <= 0.0f)
+	{
+		return;
+	}
+
+	auto WrapDistance = [TrackLength](float AxleDistance) {
+		// distance can be negative; add track length to it
+		// in case that happens
+		AxleDistance = FMath::Fmod(TrackLength + AxleDistance, TrackLength);
+		return AxleDistance < 0.0f ? AxleDistance + TrackLength : AxleDistance;
+	};
+
+	FTransform FrontPose, RearPose;
+	int32 NumCars = Num();
+	for (int32 CarIndex = 0; CarIndex < NumCars; CarIndex++)
+	{
+		float CarDistance = LeadDistance - DistancesBehindLead[CarIndex];
+		CarDistances[CarIndex] = CarDistance;
+
+		// dividing distance by radius gives us how
+		// many radians we have traveled
+		float AngleOfRot = FMath::Fmod(CarDistance * InvWheelRadii[CarIndex], TWO_PI);
+		WheelPitches[CarIndex] = -180.0f / PI * AngleOfRot;
+
+		// evaluate both axles even if the front one fails; route cursors
+		// have to be moved every time or they fall behind
+		bool bFoundFront = EvaluateTrack(WrapDistance(CarDistance + FrontAxleOffsets[CarIndex]), FrontPose,
+			FrontSegmentHints[CarIndex]);
+		bool bFoundRear = EvaluateTrack(WrapDistance(CarDistance + RearAxleOffsets[CarIndex]), RearPose,
+			RearSegmentHints[CarIndex]);
+		if (!bFoundFront || !bFoundRear)
+		{
+			continue;
+		}
+
+		// the car looks toward the front axle and keeps its previous up axis,
+		// but its position is based on the center of both axles
+		FVector FrontPosition = FrontPose.GetLocation();
+		FVector RearPosition = RearPose.GetLocation();
+		FVector LookDirection = (FrontPosition - RearPosition).GetSafeNormal();
+		FVector UpVector = Rotations[CarIndex].GetUpVector();
+		Rotations[CarIndex] = FRotationMatrix::MakeFromXZ(LookDirection, UpVector).ToQuat();
+		Locations[CarIndex] = 0.5f * (FrontPosition + RearPosition) + UpOffsets[CarIndex];
+		FrontAxleRotations[CarIndex] = FrontPose.GetRotation();
+		RearAxleRotations[CarIndex] = RearPose.GetRotation();
+	}
+}
+
+FTrainCarPose FTrainConsistSim::GetCarPose(int32 CarIndex) const
+{
+	FTrainCarPose CarPose;
+	CarPose.Distance = CarDistances[CarIndex];
+	CarPose.Location = Locations[CarIndex];
+	CarPose.Rotation = Rotations[CarIndex];
+	CarPose.FrontAxleRotation = FrontAxleRotations[CarIndex];
+	CarPose.RearAxleRotation = RearAxleRotations[CarIndex];
+	CarPose.WheelPitch = WheelPitches[CarIndex];
+	return CarPose;
+}
+
+void FTrainConsistSim::GetExtents(float& OutFront, float& OutRear) const
+{
+	OutFront = 0.0f;
+	OutRear = 0.0f;
+	int32 NumCars = Num();
+	for (int32 CarIndex = 0; CarIndex < NumCars; CarIndex++)
+	{
+		float FrontAxle = FrontAxleOffsets[CarIndex] - DistancesBehindLead[CarIndex];
+		float RearAxle = RearAxleOffsets[CarIndex] - DistancesBehindLead[CarIndex];
+		OutFront = FMath::Max3(OutFront, FrontAxle, RearAxle);
+		OutRear = FMath::Min3(OutRear, FrontAxle, RearAxle);
+	}
+}
@@ -0,0 +1,98 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Result of simulating one car of a consist for a frame.
+ */
+struct FTrainCarPose
+{
+	float Distance;
+	FVector Location;
+	FQuat Rotation;
+	FQuat FrontAxleRotation;
+	FQuat RearAxleRotation;
+	// wheel rotation around the axle, in degrees
+	float WheelPitch;
+};
+
+/**
+ * Moves every car of a train along its track in one pass. Car data is
+ * kept in parallel arrays and the track is only accessed through a
+ * callback, so this doesn't depend on actors and can be run headless.
+ */
+class HANDSTRAINSAMPLE_API FTrainConsistSim
+{
+public:
+	FTrainConsistSim();
+
+	/**
+	 * Evaluates the track pose at a distance in [0, track length].
+	 * SegmentIndexHint is per-axle state kept by the sim for the evaluator;
+	 * it starts out as INDEX_NONE and the evaluator may store any index in it.
+	 */
+	typedef TFunctionRef<bool(float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint)> FTrackEvaluator;
+
+	void Reset();
+
+	/**
+	 * Adds a car to the back of the consist.
+	 * @param DistanceBehindLead - How far the car's origin trails the lead car's.
+	 * @param FrontAxleOffset - Distance of the front axle ahead of the car's origin.
+	 * @param RearAxleOffset - Distance of the rear axle ahead of the car's origin.
+	 * @param WheelRadius - Used to turn traveled distance into wheel rotation.
+	 * @param UpOffset - Offset of the car above the track.
+	 * @param InitialRotation - Current rotation of the car; its up axis seeds the look rotation.
+	 * @return Index of the car.
+	 */
+	int32 AddCar(float DistanceBehindLead, float FrontAxleOffset, float RearAxleOffset,
+		float WheelRadius, const FVector& UpOffset, const FQuat& InitialRotation);
+
+	int32 Num() const
+	{
+		return DistancesBehindLead.Num();
+	}
+
+	/**
+	 * Updates every car for the lead car's new distance.
+	 * @param LeadDistance - Distance of the lead car. Not wrapped.
+	 * @param TrackLength - Used to wrap axle distances onto the track.
+	 * @param EvaluateTrack - Track pose lookup.
+	 */
+	void Advance(float LeadDistance, float TrackLength, FTrackEvaluator EvaluateTrack);
+
+	FTrainCarPose GetCarPose(int32 CarIndex) const;
+
+	/**
+	 * Span of the consist's axles relative to the lead car's distance.
+	 * @param OutFront - Offset of the frontmost axle.
+	 * @param OutRear - Offset of the rearmost axle; usually negative.
+	 */
+	void GetExtents(float& OutFront, float& OutRear) const;
+
+private:
+	// static car description
+	TArray<float> DistancesBehindLead;
+	TArray<float> FrontAxleOffsets;
+	TArray<float> RearAxleOffsets;
+	TArray<float> InvWheelRadii;
+	TArray<FVector> UpOffsets;
+
+	// per-frame state
+	TArray<float> CarDistances;
+	TArray<float> WheelPitches;
+	TArray<int32> FrontSegmentHints;
+	TArray<int32> RearSegmentHints;
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+	TArray<FQuat> FrontAxleRotations;
+	TArray<FQuat> RearAxleRotations;
+};
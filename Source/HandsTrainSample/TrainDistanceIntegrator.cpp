@@ -0,0 +1,88 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrainDistanceIntegrator.h"
+
+FTrainDistanceIntegrator::FTrainDistanceIntegrator()
+	: FixedTimestep(1.0 / 120.0)
+	, MaxSubsteps(8)
+	, Accumulator(0.0)
+	, SimDistance(0.0)
+	, PrevSimDistance(0.0)
+	, NumSteps(0)
+{
+}
+
+void FTrainDistanceIntegrator::Reset(double NewDistance)
+{
+	Accumulator = 0.0;
+	SimDistance = NewDistance;
+	PrevSimDistance = NewDistance;
+	NumSteps = 0;
+}
+
+void FTrainDistanceIntegrator::SetTimestep(double InFixedTimestep, int32 InMaxSubsteps)
+{
+	FixedTimestep = FMath::Max(InFixedTimestep, 1.0 / 1000.0);
+	MaxSubsteps = FMath::Max(InMaxSubsteps, 1);
+}
+
+int32 FTrainDistanceIntegrator::Advance(double DeltaTime, double TrackLength, FStepFunction ComputeStep)
+{
+	if (TrackLength <= 0.0)
+	{
+		return 0;
+	}
+
+	Accumulator += FMath::Max(DeltaTime, 0.0);
+	int32 NumSubsteps = 0;
+	while (Accumulator >= FixedTimestep && NumSubsteps < MaxSubsteps)
+	{
+		PrevSimDistance = SimDistance;
+		SimDistance = WrapDistance(SimDistance + ComputeStep(FixedTimestep), TrackLength);
+		Accumulator -= FixedTimestep;
+		NumSubsteps++;
+		NumSteps++;
+	}
+
+	// hit the substep cap; drop the backlog instead of
+	// falling further behind every frame
+	if (Accumulator >= FixedTimestep)
+	{
+		Accumulator = FMath::Fmod(Accumulator, FixedTimestep);
+	}
+	return NumSubsteps;
+}
+
+double FTrainDistanceIntegrator::GetInterpolatedDistance(double TrackLength) const
+{
+	if (TrackLength <= 0.0)
+	{
+		return SimDistance;
+	}
+
+	double Alpha = FMath::Clamp(Accumulator / FixedTimestep, 0.0, 1.0);
+	// take the short way around if the last step crossed the
+	// end of the loop
+	double Step = SimDistance - PrevSimDistance;
+	if (Step > 0.5 * TrackLength)
+	{
+		Step -= TrackLength;
+	}
+	else if (Step < -0.5 * TrackLength)
+	{
+		Step += TrackLength;
+	}
+	return WrapDistance(PrevSimDistance + Alpha * Step, TrackLength);
+}
+
+double FTrainDistanceIntegrator::WrapDistance(double Distance, double TrackLength)
+{
+	Distance = FMath::Fmod(Distance, TrackLength);
+	return Distance < 0.0 ? Distance + TrackLength : Distance;
+}
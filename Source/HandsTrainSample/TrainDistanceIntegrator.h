@@ -0,0 +1,72 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Moves a distance along a looping track in fixed time steps. Frame time is
+ * accumulated and consumed in whole steps, and the distance is kept in
+ * double precision, so the simulated distance after N steps doesn't depend
+ * on the frame rate. The distance to render is interpolated between the
+ * last two steps using the time left over in the accumulator.
+ */
+class HANDSTRAINSAMPLE_API FTrainDistanceIntegrator
+{
+public:
+	FTrainDistanceIntegrator();
+
+	/** Returns the signed distance to move in a step of StepTime seconds. */
+	typedef TFunctionRef<double(double StepTime)> FStepFunction;
+
+	/** Places the integrator at a distance and drops any accumulated time. */
+	void Reset(double NewDistance);
+
+	/**
+	 * @param InFixedTimestep - Simulated seconds per step.
+	 * @param InMaxSubsteps - Steps allowed per frame; time beyond that is dropped
+	 * so a long hitch can't stall the game catching up.
+	 */
+	void SetTimestep(double InFixedTimestep, int32 InMaxSubsteps);
+
+	/**
+	 * Runs as many fixed steps as the accumulated time allows.
+	 * @param DeltaTime - Frame time to add to the accumulator. Only decides how
+	 * many steps run; every step is FixedTimestep long whatever the frame rate.
+	 * @param TrackLength - Distances are wrapped into [0, TrackLength).
+	 * @param ComputeStep - Distance to move for each step.
+	 * @return Number of steps run.
+	 */
+	int32 Advance(double DeltaTime, double TrackLength, FStepFunction ComputeStep);
+
+	/** Distance of the latest step. */
+	double GetSimDistance() const
+	{
+		return SimDistance;
+	}
+
+	/** Distance between the last two steps, for rendering. */
+	double GetInterpolatedDistance(double TrackLength) const;
+
+	uint64 GetNumSteps() const
+	{
+		return NumSteps;
+	}
+
+private:
+	double FixedTimestep;
+	int32 MaxSubsteps;
+
+	double Accumulator;
+	double SimDistance;
+	double PrevSimDistance;
+	uint64 NumSteps;
+
+	static double WrapDistance(double Distance, double TrackLength);
+};
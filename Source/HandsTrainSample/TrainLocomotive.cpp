@@ -7,6 +7,7 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "TrainLocomotive.h"
+#include "HandsTrainStats.h"
 #include "NormalTrainCar.h"
 #include "Components/AudioComponent.h"
 #include "Kismet/KismetMathLibrary.h"
@@ -24,6 +25,22 @@ ATrainLocomotive::ATrainLocomotive()
 
 	InitialSpeed = 15.0f;
 	bIsMoving = false;
+	bUseConsistSim = true;
+	bConsistNeedsRebuild = true;
+	bKeepDistanceFromTrains = true;
+	MinFollowingDistance = 10.0f;
+	bUseNativeMotionProfile = true;
+	JerkTimeFraction = 0.5f;
+	SpeedStepDuration = 0.5f;
+	bProfileIsStartStop = false;
+	bProfileStartsTrain = false;
+	bUseFixedTimestep = false;
+	FixedTimestep = 1.0f / 120.0f;
+	MaxSubstepsPerFrame = 8;
+	OccupancyId = INDEX_NONE;
+	ConsistFrontExtent = 0.0f;
+	ConsistRearExtent = 0.0f;
+	bWarnedOccupancyOnBranches = false;
 }
 
 void ATrainLocomotive::BeginPlay()
@@ -32,8 +49,10 @@ void ATrainLocomotive::BeginPlay()
 
 	bIsMoving = false;
 	Distance = 0.0f;
+	DistanceIntegrator.Reset(Distance);
 	bIsStartingOrStopping = false;
 	CurrentSpeed = 0.0f;
+	MotionProfile.Stop();
 	SpeedDiv = AccelerationSounds.Num() > 0 ? (MaxSpeed - MinSpeed) / (float)AccelerationSounds.Num()
 											: 0;
 
@@ -43,6 +62,17 @@ void ATrainLocomotive::BeginPlay()
 		TEXT("SmokeParticleSystem")));
 }
 
+void ATrainLocomotive::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (OccupancyId != INDEX_NONE && IsValid(TrainTrack))
+	{
+		TrainTrack->GetTrackOccupancy().UnregisterTrain(OccupancyId);
+	}
+	OccupancyId = INDEX_NONE;
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ATrainLocomotive::Initialize(TArray<ANormalTrainCar*> NewChildCars)
 {
 	ChildCars.Empty();
@@ -52,6 +82,43 @@ void ATrainLocomotive::Initialize(TArray<ANormalTrainCar*> NewChildCars)
 	{
 		ChildTrainCar->ParentLocomotive = this;
 	}
+	bConsistNeedsRebuild = true;
+}
+
+void ATrainLocomotive::RebuildConsist()
+{
+	ConsistSim.Reset();
+	ConsistCars.Reset();
+	AxleRouteCursors.Reset();
+	bConsistNeedsRebuild = false;
+
+	if (AddToConsist(ConsistSim, 0.0f) != INDEX_NONE)
+	{
+		ConsistCars.Add(this);
+	}
+	for (ANormalTrainCar* ChildTrainCar : ChildCars)
+	{
+		// if everything is scaled, take that into account
+		if (IsValid(ChildTrainCar)
+			&& ChildTrainCar->AddToConsist(ConsistSim, ChildTrainCar->Scale * ChildTrainCar->DistanceBehindParent) != INDEX_NONE)
+		{
+			ConsistCars.Add(ChildTrainCar);
+		}
+	}
+
+	ConsistSim.GetExtents(ConsistFrontExtent, ConsistRearExtent);
+	if (OccupancyId == INDEX_NONE && IsValid(TrainTrack))
+	{
+		OccupancyId = TrainTrack->GetTrackOccupancy().RegisterTrain();
+	}
+	UpdateOccupancy();
+}
+
+void ATrainLocomotive::PlaceOnTrack(float NewDistance)
+{
+	Distance = NewDistance;
+	DistanceIntegrator.Reset(Distance);
+	UpdateOccupancy();
 }
 
 void ATrainLocomotive::Tick(float DeltaTime)
@@ -62,14 +129,45 @@ void ATrainLocomotive::Tick(float DeltaTime)
 
 void ATrainLocomotive::UpdateState(float DeltaTime)
 {
+	HANDSTRAIN_SCOPE_TIMER(STAT_HandsTrain_LocomotiveUpdate, EHandsTrainTimer::LocomotiveUpdate);
 	if (!bIsMoving)
 	{
 		return;
 	}
 
+	// fixed steps advance the profile once per step instead, so the distance
+	// covered while ramping doesn't depend on the frame rate
+	if (!bUseFixedTimestep || !IsValid(TrainTrack))
+	{
+		UpdateMotionProfile(DeltaTime);
+	}
+
+	if (bUseConsistSim)
+	{
+		UpdateDistance(DeltaTime);
+		UpdateConsist();
+		return;
+	}
+
 	if (IsValid(TrainTrack))
 	{
 		UpdateDistance(DeltaTime);
+	}
+	UpdateCarsAlongTrack(DeltaTime);
+
+	// a car that ran into a dead end stops the whole train there
+	float Shortfall = FindDeadEndShortfall();
+	if (Shortfall != 0.0f)
+	{
+		StopAtDeadEnd(Shortfall);
+		UpdateCarsAlongTrack(0.0f);
+	}
+}
+
+void ATrainLocomotive::UpdateCarsAlongTrack(float DeltaTime)
+{
+	if (IsValid(TrainTrack))
+	{
 		UpdateCarPosition();
 		RotateCarWheels();
 	}
@@ -85,15 +183,206 @@ void ATrainLocomotive::UpdateState(float DeltaTime)
 	}
 }
 
+float ATrainLocomotive::FindDeadEndShortfall() const
+{
+	// every car moves the same way, so the biggest shortfall
+	// belongs to whichever axle leads
+	float Shortfall = GetDeadEndShortfall();
+	auto KeepLarger = [&Shortfall](float CarShortfall) {
+		if (FMath::Abs(CarShortfall) > FMath::Abs(Shortfall))
+		{
+			Shortfall = CarShortfall;
+		}
+	};
+	for (const FTrackRouteCursor& Cursor : AxleRouteCursors)
+	{
+		KeepLarger(Cursor.DeadEndShortfall);
+	}
+	for (const ANormalTrainCar* TrainCar : ChildCars)
+	{
+		if (IsValid(TrainCar))
+		{
+			KeepLarger(TrainCar->GetDeadEndShortfall());
+		}
+	}
+	return Shortfall;
+}
+
+void ATrainLocomotive::StopAtDeadEnd(float Shortfall)
+{
+	// pull the train back by what the leading axle couldn't cover, so
+	// Distance doesn't keep running on while the cars stand still
+	float TrackLength = TrainTrack->GetTrackLength();
+	Distance = FMath::Fmod(Distance - Shortfall + TrackLength, TrackLength);
+	DistanceIntegrator.Reset(Distance);
+	UpdateOccupancy();
+}
+
+void ATrainLocomotive::UpdateMotionProfile(float DeltaTime)
+{
+	if (!MotionProfile.IsActive())
+	{
+		return;
+	}
+
+	CurrentSpeed = MotionProfile.Advance(DeltaTime);
+	if (!MotionProfile.IsFinished())
+	{
+		return;
+	}
+
+	MotionProfile.Stop();
+	if (!bProfileIsStartStop)
+	{
+		return;
+	}
+
+	// same end state the blueprint animation used to leave behind
+	bIsStartingOrStopping = false;
+	if (bProfileStartsTrain)
+	{
+		UpdateSmokeEmissionBasedOnSpeed();
+		PlayEngineSoundAndGetLength(EEngineSoundState::AccelerateOrSetProperSpeed);
+	}
+	else
+	{
+		bIsMoving = false;
+		SmokeParticleSystemComp->Deactivate();
+	}
+	StartStopFinished(bProfileStartsTrain);
+}
+
+void ATrainLocomotive::StartSpeedStep(float SpeedChange)
+{
+	// stack on top of a step that is still ramping
+	float BaseSpeed = MotionProfile.IsActive() ? MotionProfile.GetGoalSpeed() : CurrentSpeed;
+	float GoalSpeed = FMath::Clamp(BaseSpeed + SpeedChange, MinSpeed, MaxSpeed);
+	if (bUseNativeMotionProfile)
+	{
+		MotionProfile.Start(CurrentSpeed, GoalSpeed, SpeedStepDuration, JerkTimeFraction);
+		bProfileIsStartStop = false;
+	}
+	else
+	{
+		CurrentSpeed = GoalSpeed;
+	}
+	UpdateSmokeEmissionBasedOnSpeed();
+	PlayEngineSoundAndGetLength(EEngineSoundState::AccelerateOrSetProperSpeed);
+}
+
 void ATrainLocomotive::UpdateDistance(float DeltaTime)
 {
 	if (!IsValid(TrainTrack))
 	{
 		return;
 	}
+	if (bUseFixedTimestep)
+	{
+		// cars are drawn between the last two steps, so
+		// they trail the simulation by up to one step
+		double TrackLength = TrainTrack->GetTrackLength();
+		DistanceIntegrator.SetTimestep(FixedTimestep, MaxSubstepsPerFrame);
+		DistanceIntegrator.Advance(DeltaTime, TrackLength, [this](double StepTime) {
+			// every step measures its gap from where the previous one left us
+			UpdateOccupancy();
+			UpdateMotionProfile((float)StepTime);
+			float SignedSpeed = bInReverse ? -CurrentSpeed : CurrentSpeed;
+			return (double)LimitStepToTrainAhead(SignedSpeed * (float)StepTime);
+		});
+		Distance = (float)DistanceIntegrator.GetInterpolatedDistance(TrackLength);
+		UpdateOccupancy();
+		return;
+	}
+
 	auto SignedSpeed = bInReverse ? -CurrentSpeed : CurrentSpeed;
-	Distance = fmod(Distance + SignedSpeed * DeltaTime,
-		TrainTrack->GetTrackLength());
+	float Step = LimitStepToTrainAhead(SignedSpeed * DeltaTime);
+	Distance = fmod(Distance + Step, TrainTrack->GetTrackLength());
+	DistanceIntegrator.Reset(Distance);
+	UpdateOccupancy();
+}
+
+float ATrainLocomotive::LimitStepToTrainAhead(float Step) const
+{
+	// occupancy is measured along the main loop, which
+	// doesn't say where trains on branches are
+	if (!bKeepDistanceFromTrains || OccupancyId == INDEX_NONE || !IsValid(TrainTrack)
+		|| TrainTrack->HasBranches())
+	{
+		return Step;
+	}
+	return TrainTrack->GetTrackOccupancy().LimitStep(OccupancyId, Step, MinFollowingDistance);
+}
+
+void ATrainLocomotive::UpdateOccupancy()
+{
+	if (bKeepDistanceFromTrains && !bWarnedOccupancyOnBranches && IsValid(TrainTrack)
+		&& TrainTrack->HasBranches())
+	{
+		UE_LOG(LogTemp, Warning,
+			TEXT("%s: keeping distance from other trains is not supported on tracks with branches"),
+			*GetName());
+		bWarnedOccupancyOnBranches = true;
+	}
+	if (OccupancyId != INDEX_NONE && IsValid(TrainTrack))
+	{
+		// the simulated distance, not the one drawn; with fixed steps the
+		// drawn one trails it, and outside of them the two are the same
+		float LeadDistance = (float)DistanceIntegrator.GetSimDistance();
+		TrainTrack->GetTrackOccupancy().UpdateTrain(OccupancyId,
+			LeadDistance + ConsistRearExtent, LeadDistance + ConsistFrontExtent);
+	}
+}
+
+void ATrainLocomotive::UpdateConsist()
+{
+	if (!IsValid(TrainTrack))
+	{
+		return;
+	}
+	if (bConsistNeedsRebuild)
+	{
+		RebuildConsist();
+	}
+
+	ATrainTrack* Track = TrainTrack;
+	if (Track->HasBranches())
+	{
+		auto EvaluateRoute = [this, Track](float DistanceIntoTrack, FTransform& Pose, int32& CursorIndex) {
+			if (!AxleRouteCursors.IsValidIndex(CursorIndex))
+			{
+				CursorIndex = AxleRouteCursors.AddDefaulted();
+			}
+			return Track->EvaluateRoutePose(DistanceIntoTrack, Pose, AxleRouteCursors[CursorIndex]);
+		};
+		ConsistSim.Advance(Distance, Track->GetTrackLength(), EvaluateRoute);
+
+		// the axle that ran into a dead end stopped there; move
+		// the rest of the consist back so it doesn't bunch up
+		float Shortfall = FindDeadEndShortfall();
+		if (Shortfall != 0.0f)
+		{
+			StopAtDeadEnd(Shortfall);
+			ConsistSim.Advance(Distance, Track->GetTrackLength(), EvaluateRoute);
+		}
+	}
+	else
+	{
+		ConsistSim.Advance(Distance, Track->GetTrackLength(),
+			[Track](float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint) {
+				return Track->EvaluatePose(DistanceIntoTrack, Pose, SegmentIndexHint);
+			});
+	}
+
+	// write results back after the whole consist is simulated
+	int32 NumCars = ConsistCars.Num();
+	for (int32 CarIndex = 0; CarIndex < NumCars; CarIndex++)
+	{
+		ATrainCarBase* TrainCar = ConsistCars[CarIndex];
+		if (IsValid(TrainCar))
+		{
+			TrainCar->ApplyConsistPose(ConsistSim.GetCarPose(CarIndex));
+		}
+	}
 }
 
 void ATrainLocomotive::StartStopTrainStateChanged()
@@ -118,11 +407,12 @@ void ATrainLocomotive::StartStopTrain(bool bStartTrain)
 		bIsMoving = true;
 		SmokeParticleSystemComp->SetFloatParameter(SpawnRateParamName,
 			0.0f);
-		TimePeriodForSpeedChange = PlayEngineSoundAndGetLength(EEngineSoundState::Start);
+		TimePeriodForSpeedChange = PlayEngineSoundForSpeed(EEngineSoundState::Start, EndSpeed);
 	}
 	else
 	{
-		TimePeriodForSpeedChange = PlayEngineSoundAndGetLength(EEngineSoundState::Stop);
+		// the ramp isn't started yet, so tell the sound where it's headed
+		TimePeriodForSpeedChange = PlayEngineSoundForSpeed(EEngineSoundState::Stop, EndSpeed);
 	}
 
 	// Make the animation time period a little shorter;
@@ -130,6 +420,14 @@ void ATrainLocomotive::StartStopTrain(bool bStartTrain)
 	// and the startup sound might stop for a moment before the normal
 	// engine sound would have a chance to begin playing.
 	TimePeriodForSpeedChange *= 0.9f;
+	if (bUseNativeMotionProfile)
+	{
+		// UpdateState evaluates the ramp and finishes the sequence
+		MotionProfile.Start(CurrentSpeed, EndSpeed, TimePeriodForSpeedChange, JerkTimeFraction);
+		bProfileIsStartStop = true;
+		bProfileStartsTrain = bStartTrain;
+		return;
+	}
 	// This animate function will complete start and stop sequence and adjust
 	// the locomotive state.
 	AnimateStartStop(bStartTrain, CurrentSpeed, EndSpeed, TimePeriodForSpeedChange,
@@ -140,9 +438,7 @@ void ATrainLocomotive::DecreaseSpeed()
 {
 	if (!bIsStartingOrStopping && bIsMoving)
 	{
-		CurrentSpeed = FMath::Clamp(CurrentSpeed - SpeedDiv, MinSpeed, MaxSpeed);
-		UpdateSmokeEmissionBasedOnSpeed();
-		PlayEngineSoundAndGetLength(EEngineSoundState::AccelerateOrSetProperSpeed);
+		StartSpeedStep(-SpeedDiv);
 	}
 }
 
@@ -150,13 +446,18 @@ void ATrainLocomotive::IncreaseSpeed()
 {
 	if (!bIsStartingOrStopping && bIsMoving)
 	{
-		CurrentSpeed = FMath::Clamp(CurrentSpeed + SpeedDiv, MinSpeed, MaxSpeed);
-		UpdateSmokeEmissionBasedOnSpeed();
-		PlayEngineSoundAndGetLength(EEngineSoundState::AccelerateOrSetProperSpeed);
+		StartSpeedStep(SpeedDiv);
 	}
 }
 
 float ATrainLocomotive::PlayEngineSoundAndGetLength(EEngineSoundState NewSoundState)
+{
+	// pick the sound for where a ramp is headed, not where it is now
+	float SoundSpeed = MotionProfile.IsActive() ? MotionProfile.GetGoalSpeed() : CurrentSpeed;
+	return PlayEngineSoundForSpeed(NewSoundState, SoundSpeed);
+}
+
+float ATrainLocomotive::PlayEngineSoundForSpeed(EEngineSoundState NewSoundState, float SoundSpeed)
 {
 	USoundBase* AudioClip = nullptr;
 
@@ -170,7 +471,7 @@ float ATrainLocomotive::PlayEngineSoundAndGetLength(EEngineSoundState NewSoundSt
 			? AccelerationSounds
 			: DecelerationSounds;
 		auto NumSounds = Sounds.Num();
-		auto SpeedIndex = FMath::RoundToInt((CurrentSpeed - MinSpeed) / SpeedDiv);
+		auto SpeedIndex = FMath::RoundToInt((SoundSpeed - MinSpeed) / SpeedDiv);
 		AudioClip = Sounds[FMath::Clamp(SpeedIndex, 0, NumSounds - 1)];
 	}
 
@@ -194,7 +495,8 @@ void ATrainLocomotive::UpdateSmokeEmissionBasedOnSpeed()
 
 float ATrainLocomotive::GetCurrentSmokeEmissionLerpValue()
 {
-	return (CurrentSpeed - MinSpeed) / (MaxSpeed - MinSpeed);
+	float SmokeSpeed = MotionProfile.IsActive() ? MotionProfile.GetGoalSpeed() : CurrentSpeed;
+	return (SmokeSpeed - MinSpeed) / (MaxSpeed - MinSpeed);
 }
 
 void ATrainLocomotive::Reverse()
@@ -10,6 +10,9 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "TrainCarBase.h"
+#include "TrainConsistSim.h"
+#include "TrainDistanceIntegrator.h"
+#include "TrainMotionProfile.h"
 #include "TrainLocomotive.generated.h"
 
 UENUM(BlueprintType)
@@ -61,8 +64,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Behaviors")
 	void Reverse();
 
+	/**
+	 * Captures car spacing and axle offsets for the consist simulation.
+	 * Needs to be called again if cars or their scale change.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Cars")
+	void RebuildConsist();
+
+	UFUNCTION(BlueprintCallable, Category = "Motion")
+	void PlaceOnTrack(float NewDistance);
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Motion")
 	float InitialSpeed;
@@ -79,9 +93,45 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion")
 	bool bInReverse;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion",
+		meta = (Tooltip = "Hold back instead of running into other trains on the track. Only works on tracks without branches"))
+	bool bKeepDistanceFromTrains;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion",
+		meta = (ClampMin = "0.0", Tooltip = "Free track to keep between this train and the one ahead"))
+	float MinFollowingDistance;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Profile",
+		meta = (Tooltip = "Ramp speed changes natively instead of through the AnimateStartStop blueprint event"))
+	bool bUseNativeMotionProfile;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Profile",
+		meta = (ClampMin = "0.0", ClampMax = "1.0", Tooltip = "Share of a speed change spent ramping acceleration up and down"))
+	float JerkTimeFraction;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Profile",
+		meta = (ClampMin = "0.0", Tooltip = "Time taken by a speed increase or decrease"))
+	float SpeedStepDuration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Fixed Timestep",
+		meta = (Tooltip = "Integrate distance in fixed steps so motion doesn't depend on frame rate"))
+	bool bUseFixedTimestep;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Fixed Timestep",
+		meta = (ClampMin = "0.001", Tooltip = "Simulated seconds per step"))
+	float FixedTimestep;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Motion|Fixed Timestep",
+		meta = (ClampMin = "1", Tooltip = "Steps allowed per frame; time beyond that is dropped"))
+	int32 MaxSubstepsPerFrame;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Cars")
 	TArray<ANormalTrainCar*> ChildCars;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cars",
+		meta = (Tooltip = "Move all cars in one pass instead of updating each car actor in turn"))
+	bool bUseConsistSim;
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Audio")
 	UAudioComponent* EngineAudioComp;
 
@@ -109,6 +159,10 @@ protected:
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Behaviors")
 	float GetCurrentSmokeEmissionLerpValue();
 
+	/** Called when a native start or stop ramp completes. */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Behaviors")
+	void StartStopFinished(bool bStartedTrain);
+
 	// Wee use a blueprint event because we need a delay node to animate over time
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category = "Behaviors")
 	void AnimateStartStop(bool bStartTrain, float StartSpeed, float GoalSpeed, float SpeedChangeDuration,
@@ -123,5 +177,35 @@ private:
 	float SpeedDiv;
 	float StandardEmissionRate;
 
+	FTrainDistanceIntegrator DistanceIntegrator;
+
+	FTrainMotionProfile MotionProfile;
+	// true if MotionProfile is a start or stop ramp rather than a speed step
+	bool bProfileIsStartStop;
+	bool bProfileStartsTrain;
+
+	FTrainConsistSim ConsistSim;
+	// car driven by each entry of the consist sim
+	TArray<ATrainCarBase*> ConsistCars;
+	bool bConsistNeedsRebuild;
+	// per-axle cursors on tracks with branches; the consist sim keeps
+	// each axle's index into this in its segment hint
+	TArray<FTrackRouteCursor> AxleRouteCursors;
+
+	// id in the track's occupancy, and span of the consist around Distance
+	int32 OccupancyId;
+	float ConsistFrontExtent;
+	float ConsistRearExtent;
+	bool bWarnedOccupancyOnBranches;
+
+	float PlayEngineSoundForSpeed(EEngineSoundState NewSoundState, float SoundSpeed);
+	void UpdateMotionProfile(float DeltaTime);
+	void StartSpeedStep(float SpeedChange);
 	void UpdateDistance(float DeltaTime);
+	void UpdateConsist();
+	void UpdateCarsAlongTrack(float DeltaTime);
+	float FindDeadEndShortfall() const;
+	void StopAtDeadEnd(float Shortfall);
+	float LimitStepToTrainAhead(float Step) const;
+	void UpdateOccupancy();
 };
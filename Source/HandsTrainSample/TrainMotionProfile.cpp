@@ -0,0 +1,90 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#include "TrainMotionProfile.h"
+
+FTrainMotionProfile::FTrainMotionProfile()
+	: NumSegments(0)
+	, StartSpeed(0.0f)
+	, GoalSpeed(0.0f)
+	, Duration(0.0f)
+	, ElapsedTime(0.0f)
+	, bIsActive(false)
+{
+}
+
+void FTrainMotionProfile::Start(float InStartSpeed, float InGoalSpeed, float InDuration, float JerkTimeFraction)
+{
+	StartSpeed = InStartSpeed;
+	GoalSpeed = InGoalSpeed;
+	Duration = FMath::Max(InDuration, 0.0f);
+	ElapsedTime = 0.0f;
+	NumSegments = 0;
+	bIsActive = true;
+
+	if (Duration <= 0.0f)
+	{
+		return;
+	}
+
+	// with JerkTime spent ramping at each end, the speed gained is
+	// PeakAcceleration * (Duration - JerkTime)
+	float JerkTime = 0.5f * Duration * FMath::Clamp(JerkTimeFraction, 0.0f, 1.0f);
+	float PeakAcceleration = (GoalSpeed - StartSpeed) / (Duration - JerkTime);
+	float Jerk = JerkTime > 0.0f ? PeakAcceleration / JerkTime : 0.0f;
+
+	float HoldStartSpeed = StartSpeed + 0.5f * PeakAcceleration * JerkTime;
+	float HoldEndTime = Duration - JerkTime;
+	AddSegment(0.0f, StartSpeed, 0.0f, Jerk);
+	AddSegment(JerkTime, HoldStartSpeed, PeakAcceleration, 0.0f);
+	AddSegment(HoldEndTime, HoldStartSpeed + PeakAcceleration * (HoldEndTime - JerkTime), PeakAcceleration, -Jerk);
+}
+
+void FTrainMotionProfile::Stop()
+{
+	bIsActive = false;
+	NumSegments = 0;
+}
+
+float FTrainMotionProfile::Advance(float DeltaTime)
+{
+	ElapsedTime = FMath::Min(ElapsedTime + DeltaTime, Duration);
+	return GetSpeedAt(ElapsedTime);
+}
+
+float FTrainMotionProfile::GetSpeedAt(float Time) const
+{
+	// land exactly on the goal instead of a rounded value
+	if (Time >= Duration || NumSegments == 0)
+	{
+		return GoalSpeed;
+	}
+	if (Time <= 0.0f)
+	{
+		return StartSpeed;
+	}
+
+	int32 SegmentIndex = NumSegments - 1;
+	while (SegmentIndex > 0 && Segments[SegmentIndex].StartTime > Time)
+	{
+		SegmentIndex--;
+	}
+	const FJerkSegment& Segment = Segments[SegmentIndex];
+	float TimeInSegment = Time - Segment.StartTime;
+	return Segment.StartSpeed + TimeInSegment * (Segment.StartAcceleration + 0.5f * Segment.Jerk * TimeInSegment);
+}
+
+void FTrainMotionProfile::AddSegment(float StartTime, float SegmentStartSpeed, float StartAcceleration, float Jerk)
+{
+	// zero-length ramps (linear profile) and holds (pure S-curve) are skipped
+	if (NumSegments > 0 && Segments[NumSegments - 1].StartTime >= StartTime)
+	{
+		NumSegments--;
+	}
+	Segments[NumSegments++] = { StartTime, SegmentStartSpeed, StartAcceleration, Jerk };
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) Meta Platforms, Inc. and affiliates.
+All rights reserved.
+
+This source code is licensed under the license found in the
+LICENSE file in the root directory of this source tree.
+*/
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Jerk-limited speed change (an S-curve) over a fixed duration. Acceleration
+ * ramps up, holds, then ramps back down so the train doesn't lurch when it
+ * starts, stops or changes speed. The curve is split into constant-jerk
+ * segments when started, so evaluating it is a short lookup and a quadratic.
+ */
+class HANDSTRAINSAMPLE_API FTrainMotionProfile
+{
+public:
+	FTrainMotionProfile();
+
+	/**
+	 * @param InStartSpeed - Speed at the start of the curve.
+	 * @param InGoalSpeed - Speed reached at the end of the curve.
+	 * @param InDuration - Time to reach the goal speed; zero or less jumps to it.
+	 * @param JerkTimeFraction - Share of the duration spent ramping acceleration,
+	 * in [0, 1]. Zero gives a linear ramp, one a curve with no constant acceleration.
+	 */
+	void Start(float InStartSpeed, float InGoalSpeed, float InDuration, float JerkTimeFraction);
+
+	void Stop();
+
+	/**
+	 * Moves time forward on the curve.
+	 * @return Speed at the new time.
+	 */
+	float Advance(float DeltaTime);
+
+	float GetSpeedAt(float Time) const;
+
+	bool IsActive() const
+	{
+		return bIsActive;
+	}
+
+	bool IsFinished() const
+	{
+		return ElapsedTime >= Duration;
+	}
+
+	float GetGoalSpeed() const
+	{
+		return GoalSpeed;
+	}
+
+	float GetDuration() const
+	{
+		return Duration;
+	}
+
+private:
+	struct FJerkSegment
+	{
+		float StartTime;
+		float StartSpeed;
+		float StartAcceleration;
+		float Jerk;
+	};
+
+	// at most ramp up, hold and ramp down
+	FJerkSegment Segments[3];
+	int32 NumSegments;
+
+	float StartSpeed;
+	float GoalSpeed;
+	float Duration;
+	float ElapsedTime;
+	bool bIsActive;
+
+	void AddSegment(float StartTime, float SegmentStartSpeed, float StartAcceleration, float Jerk);
+};
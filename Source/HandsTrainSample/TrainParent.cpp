@@ -11,6 +11,7 @@ LICENSE file in the root directory of this source tree.
 ATrainParent::ATrainParent()
 {
 	PrimaryActorTick.bCanEverTick = false;
+	StartDistance = 0.0f;
 }
 
 void ATrainParent::SpawnTrainCars(ATrainTrack* ParentTrack)
@@ -43,6 +44,7 @@ void ATrainParent::SpawnTrainCars(ATrainTrack* ParentTrack)
 	SpawnTrainCar(ParentTrack, TrainCowCarAnchorComp, TrainCowCarBP);
 
 	TrainLocomotive->Initialize(TrainChildCars);
+	TrainLocomotive->PlaceOnTrack(StartDistance);
 	TrainLocomotive->StartStopTrain(true);
 }
 
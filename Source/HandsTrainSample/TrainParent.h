@@ -33,6 +33,10 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	TArray<ANormalTrainCar*> TrainChildCars;
 
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Initialization",
+		meta = (Tooltip = "Where the locomotive starts on the track; give each train on a track its own"))
+	float StartDistance;
+
 protected:
 	UPROPERTY(EditDefaultsOnly, Category = "Initialization")
 	TSubclassOf<ATrainLocomotive> TrainLocomotiveBP;
@@ -7,6 +7,8 @@ LICENSE file in the root directory of this source tree.
 */
 
 #include "TrainTrack.h"
+#include "Algo/BinarySearch.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "Containers/Array.h"
 #include "NormalTrainCar.h"
 #include "TrainLocomotive.h"
@@ -17,6 +19,10 @@ ATrainTrack::ATrainTrack()
 	PrimaryActorTick.bCanEverTick = false;
 
 	GridSize = 45.0f;
+	bUsePoseCache = true;
+	PoseCacheSampleSpacing = 2.0f;
+	PoseCacheMaxError = 0.05f;
+	PoseCacheMaxAngleError = 0.01f;
 
 	RootSceneComponent = CreateDefaultSubobject<USceneComponent>(FName(TEXT("Root")));
 	RootComponent = RootSceneComponent;
@@ -25,13 +31,35 @@ ATrainTrack::ATrainTrack()
 	SegmentParent->SetupAttachment(RootComponent);
 	TrainParent = CreateDefaultSubobject<USceneComponent>(FName(TEXT("TrainParent")));
 	TrainParent->SetupAttachment(RootComponent);
+
+	bUseInstancedSegments = false;
+	StraightSegmentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(
+		FName(TEXT("StraightSegmentInstances")));
+	StraightSegmentInstances->SetupAttachment(SegmentParent);
+	LeftTurnSegmentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(
+		FName(TEXT("LeftTurnSegmentInstances")));
+	LeftTurnSegmentInstances->SetupAttachment(SegmentParent);
+	RightTurnSegmentInstances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(
+		FName(TEXT("RightTurnSegmentInstances")));
+	RightTurnSegmentInstances->SetupAttachment(SegmentParent);
+
+	NumMainSegments = 0;
+	TrackLength = 0.0f;
+	bSegmentDataStale = true;
+	bSegmentPosesStale = false;
 }
 
 void ATrainTrack::BeginPlay()
 {
 	Super::BeginPlay();
-	InitializeSegmentReferences();
-	SetUpTrackSegmentDistances();
+	RebuildSegmentData();
+	// instances are normally baked in the editor by SetUpTrack
+	if (bUseInstancedSegments && GetNumSegmentInstances() == 0)
+	{
+		BakeSegmentInstances();
+	}
+	TrackOccupancy.Initialize(SegmentStartDistances, TrackLength);
+	RootComponent->TransformUpdated.AddUObject(this, &ATrainTrack::OnRootTransformUpdated);
 
 	InitializeTrain();
 }
@@ -43,6 +71,16 @@ void ATrainTrack::SetUpTrack()
 	GetComponents<UTrackSegmentMetaInfo>(TrackSegmentInfos);
 	TrackSegmentInfos.Sort(ATrainTrack::SegmentInfoPredicate);
 
+	if (bUseInstancedSegments)
+	{
+		// segments become instances; remove the actors
+		BuildSegmentDataFromLayout();
+		BakeSegmentInstances();
+		CreateTrackSegments(TArray<UTrackSegmentMetaInfo*>(), TArray<float>());
+		return;
+	}
+
+	ClearSegmentInstances();
 	TArray<float> SegmentDistances;
 	SetUpTrackSegmentInformationDistances(TrackSegmentInfos, SegmentDistances);
 	CreateTrackSegments(TrackSegmentInfos, SegmentDistances);
@@ -86,6 +124,45 @@ void ATrainTrack::LogTrackInformation()
 		FVector RelativeScaleMesh = RelativeTransform.GetScale3D();
 		UE_LOG(LogTemp, Log, TEXT("Mesh scale: %f"), RelativeScaleMesh[0]);
 	}
+
+	// rough cost of each way of drawing the track, to compare the two
+	FTrackSegmentRenderStats RenderStats = GetSegmentRenderStats();
+	UE_LOG(LogTemp, Log,
+		TEXT("Track (%s): %d segment actors with %d components (%llu bytes), %d segment instances (%llu bytes)"),
+		bUseInstancedSegments ? TEXT("instanced") : TEXT("actors"),
+		RenderStats.NumSegmentActors,
+		RenderStats.NumSegmentComponents,
+		(uint64)RenderStats.SegmentActorBytes,
+		RenderStats.NumSegmentInstances,
+		(uint64)RenderStats.SegmentInstanceBytes);
+}
+
+FTrackSegmentRenderStats ATrainTrack::GetSegmentRenderStats() const
+{
+	FTrackSegmentRenderStats RenderStats;
+	TArray<AActor*> AttachedActors;
+	GetAttachedActors(AttachedActors, true);
+	for (AActor* AttachedActor : AttachedActors)
+	{
+		ATrackSegment* CastedTrackSegment = Cast<ATrackSegment>(AttachedActor);
+		if (!IsValid(CastedTrackSegment))
+		{
+			continue;
+		}
+		TInlineComponentArray<UActorComponent*> SegmentComponents(CastedTrackSegment);
+		RenderStats.NumSegmentActors++;
+		RenderStats.NumSegmentComponents += SegmentComponents.Num();
+		RenderStats.SegmentActorBytes += CastedTrackSegment->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		for (UActorComponent* SegmentComponent : SegmentComponents)
+		{
+			RenderStats.SegmentActorBytes += SegmentComponent->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+		}
+	}
+	RenderStats.NumSegmentInstances = GetNumSegmentInstances();
+	RenderStats.SegmentInstanceBytes = StraightSegmentInstances->GetResourceSizeBytes(EResourceSizeMode::Exclusive)
+		+ LeftTurnSegmentInstances->GetResourceSizeBytes(EResourceSizeMode::Exclusive)
+		+ RightTurnSegmentInstances->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	return RenderStats;
 }
 
 void ATrainTrack::SetUpTrackSegmentInformationDistances(
@@ -104,67 +181,147 @@ void ATrainTrack::CreateTrackSegments(
 	const TArray<UTrackSegmentMetaInfo*>& TrackSegmentInfos,
 	const TArray<float>& SegmentDistances)
 {
-	// remove old segments, if any
+	// segments may be added, moved or removed below
+	bSegmentDataStale = true;
+
+	// existing segments are reused by index, so only segments that
+	// actually changed get touched (and lose their baked lighting)
+	TMap<int, ATrackSegment*> ExistingSegments;
+	int NumDestroyed = 0;
 	TArray<AActor*> AttachedActors;
 	GetAttachedActors(AttachedActors, true);
 	for (AActor* Actor : AttachedActors)
 	{
 		ATrackSegment* CastedTrackSegment = Cast<ATrackSegment>(Actor);
-		if (IsValid(CastedTrackSegment))
+		if (!IsValid(CastedTrackSegment))
+		{
+			continue;
+		}
+		if (ExistingSegments.Contains(CastedTrackSegment->SegmentIndex))
 		{
 			CastedTrackSegment->Destroy();
+			NumDestroyed++;
+			continue;
 		}
+		ExistingSegments.Add(CastedTrackSegment->SegmentIndex, CastedTrackSegment);
 	}
 
 	int ChildCount = TrackSegmentInfos.Num();
+	int NumSpawned = 0;
+	int NumReused = 0;
+	int NumUpdated = 0;
+	int FirstDirtySegmentIndex = INDEX_NONE;
 	ATrackSegment* LastTrackSegment = nullptr;
+	TMap<int, ATrackSegment*> PlacedSegments;
 	for (int i = 0; i < ChildCount; i++)
 	{
 		UTrackSegmentMetaInfo* TrackSegmentInfo =
 			TrackSegmentInfos[i];
 		float Distance = SegmentDistances[i];
 
-		ATrackSegment* TrackSegment = GetWorld()->SpawnActor<ATrackSegment>(
-			TrackSegmentBP,
-			GetActorLocation(),
-			GetActorRotation());
-
-		if (!IsValid(TrackSegment))
+		// branches start at the end of their junction instead
+		if (TrackSegmentInfo->BranchFromSegmentIndex != INDEX_NONE)
 		{
-			UE_LOG(LogTemp, Error, TEXT("Could not spawn track segment %d!"),
-				i);
-			continue;
+			ATrackSegment** JunctionSegment = PlacedSegments.Find(
+				TrackSegmentInfo->BranchFromSegmentIndex);
+			LastTrackSegment = JunctionSegment != nullptr ? *JunctionSegment : nullptr;
 		}
-		TrackSegment->AttachToActor(this,
-			FAttachmentTransformRules::KeepWorldTransform,
-			FName("SegmentParent"));
-		TrackSegment->TrackSegmentType = TrackSegmentInfo->TrackSegmentType;
-		TrackSegment->SegmentIndex = TrackSegmentInfo->SegmentIndex;
-		TrackSegment->StartDistance = Distance;
-		TrackSegment->SetGridSizeAndReturnScaleRatio(GridSize);
 
 		// the starting position of this track segment should be
-		// based on the end pose of the last segment
-		if (LastTrackSegment != nullptr)
+		// based on the end pose of the last segment. since poses are
+		// compared below, a change upstream dirties everything after it
+		FTransform StartPose = LastTrackSegment != nullptr
+			? LastTrackSegment->GetEndPose()
+			: GetActorTransform();
+
+		ATrackSegment* TrackSegment = nullptr;
+		ExistingSegments.RemoveAndCopyValue(TrackSegmentInfo->SegmentIndex, TrackSegment);
+		bool bSegmentDirty = true;
+		if (IsValid(TrackSegment))
 		{
-			auto endPose = LastTrackSegment->GetEndPose();
-			// zero out relative values first, then set position (in case blueprint has values)
+			NumReused++;
+			bSegmentDirty = IsTrackSegmentDirty(TrackSegment, TrackSegmentInfo, StartPose);
+		}
+		else
+		{
+			TrackSegment = GetWorld()->SpawnActor<ATrackSegment>(
+				TrackSegmentBP,
+				GetActorLocation(),
+				GetActorRotation());
+
+			if (!IsValid(TrackSegment))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Could not spawn track segment %d!"),
+					i);
+				continue;
+			}
+			TrackSegment->AttachToActor(this,
+				FAttachmentTransformRules::KeepWorldTransform,
+				FName("SegmentParent"));
+			// zero out relative values first (in case blueprint has values)
 			TrackSegment->SetActorRelativeLocation(FVector(0.0f, 0.0f, 0.0f));
 			TrackSegment->SetActorRelativeRotation(FQuat::Identity);
-			TrackSegment->SetActorLocation(endPose.GetLocation());
-			TrackSegment->SetActorRotation(endPose.GetRotation());
+			NumSpawned++;
 		}
 
-		TrackSegment->EnableMeshAndRegenerateTrack();
-		TrackSegment->MoveMeshBottomTowardPivot();
+		TrackSegment->StartDistance = Distance;
+		if (bSegmentDirty)
+		{
+			if (FirstDirtySegmentIndex == INDEX_NONE)
+			{
+				FirstDirtySegmentIndex = TrackSegmentInfo->SegmentIndex;
+			}
+			NumUpdated++;
+
+			TrackSegment->TrackSegmentType = TrackSegmentInfo->TrackSegmentType;
+			TrackSegment->SegmentIndex = TrackSegmentInfo->SegmentIndex;
+			TrackSegment->BranchFromSegmentIndex = TrackSegmentInfo->BranchFromSegmentIndex;
+			TrackSegment->MergeIntoSegmentIndex = TrackSegmentInfo->MergeIntoSegmentIndex;
+			TrackSegment->SetGridSizeAndReturnScaleRatio(GridSize);
+			TrackSegment->SetActorLocationAndRotation(StartPose.GetLocation(), StartPose.GetRotation());
+
+			TrackSegment->EnableMeshAndRegenerateTrack();
+			TrackSegment->MoveMeshBottomTowardPivot();
+		}
 		LastTrackSegment = TrackSegment;
+		PlacedSegments.Add(TrackSegment->SegmentIndex, TrackSegment);
 	}
+
+	// whatever wasn't matched to a meta info is gone from the layout
+	for (const TPair<int, ATrackSegment*>& UnusedSegment : ExistingSegments)
+	{
+		UnusedSegment.Value->Destroy();
+		NumDestroyed++;
+	}
+
+	LastRegenerationStats.NumSpawned = NumSpawned;
+	LastRegenerationStats.NumReused = NumReused;
+	LastRegenerationStats.NumUpdated = NumUpdated;
+	LastRegenerationStats.NumDestroyed = NumDestroyed;
+	LastRegenerationStats.FirstDirtySegmentIndex = FirstDirtySegmentIndex;
+	UE_LOG(LogTemp, Log,
+		TEXT("Track regenerated: %d spawned, %d reused, %d updated, %d destroyed, first dirty segment %d"),
+		NumSpawned, NumReused, NumUpdated, NumDestroyed, FirstDirtySegmentIndex);
+}
+
+bool ATrainTrack::IsTrackSegmentDirty(const ATrackSegment* TrackSegment,
+	const UTrackSegmentMetaInfo* TrackSegmentInfo, const FTransform& StartPose) const
+{
+	const float LocationTolerance = 0.01f;
+	const float RotationTolerance = 1.e-4f;
+	return TrackSegment->TrackSegmentType != TrackSegmentInfo->TrackSegmentType
+		|| TrackSegment->BranchFromSegmentIndex != TrackSegmentInfo->BranchFromSegmentIndex
+		|| TrackSegment->MergeIntoSegmentIndex != TrackSegmentInfo->MergeIntoSegmentIndex
+		|| TrackSegment->GridSize != GridSize
+		|| !TrackSegment->GetActorLocation().Equals(StartPose.GetLocation(), LocationTolerance)
+		|| !TrackSegment->GetActorQuat().Equals(StartPose.GetRotation(), RotationTolerance);
 }
 
 void ATrainTrack::InitializeSegmentReferences()
 {
 	// reset all references before setting them
 	TrackSegments.Empty();
+	BranchSegments.Empty();
 
 	TArray<AActor*> AttachedActors;
 	GetAttachedActors(AttachedActors, true);
@@ -178,35 +335,37 @@ void ATrainTrack::InitializeSegmentReferences()
 	}
 
 	TrackSegments.Sort(ATrainTrack::SegmentPredicate);
+
+	// everything from the first branch onward is off the main loop
+	int32 FirstBranchIndex = TrackSegments.IndexOfByPredicate([](const ATrackSegment* Segment) {
+		return Segment->BranchFromSegmentIndex != INDEX_NONE;
+	});
+	if (FirstBranchIndex != INDEX_NONE)
+	{
+		BranchSegments.Append(TrackSegments.GetData() + FirstBranchIndex,
+			TrackSegments.Num() - FirstBranchIndex);
+		TrackSegments.SetNum(FirstBranchIndex);
+	}
 }
 
 void ATrainTrack::InitializeTrain()
 {
-	TArray<class ANormalTrainCar*> NormalTrainCars;
-	ATrainLocomotive* TrainLocomotive = nullptr;
-
 	TArray<AActor*> ChildActors;
 	GetAllChildActors(ChildActors, true);
-	ATrainParent* TrainParentActor = nullptr;
 
+	// every train parent on the track gets its own train
 	for (AActor* Actor : ChildActors)
 	{
-		ATrainParent* CastedTrainParent = Cast<ATrainParent>(Actor);
-		if (IsValid(CastedTrainParent))
+		ATrainParent* TrainParentActor = Cast<ATrainParent>(Actor);
+		if (!IsValid(TrainParentActor))
 		{
-			TrainParentActor = CastedTrainParent;
-			break;
+			continue;
 		}
-	}
 
-	if (IsValid(TrainParentActor))
-	{
 		TrainParentActor->SpawnTrainCars(this);
-		TrainLocomotive = TrainParentActor->TrainLocomotive;
-		NormalTrainCars = TrainParentActor->TrainChildCars;
+		ScaleTrainByScaleRatio(TrainParentActor->TrainChildCars,
+			TrainParentActor->TrainLocomotive);
 	}
-
-	ScaleTrainByScaleRatio(NormalTrainCars, TrainLocomotive);
 }
 
 void ATrainTrack::SetUpTrackSegmentDistances()
@@ -223,17 +382,237 @@ void ATrainTrack::SetUpTrackSegmentDistances()
 		TrackSegment->StartDistance = TrackLength;
 		TrackLength += TrackSegment->GetSegmentLength();
 	}
+
+	// branch segments measure distance from the start of their branch
+	float BranchLength = 0.0f;
+	for (ATrackSegment* TrackSegment : BranchSegments)
+	{
+		if (TrackSegment->BranchFromSegmentIndex != INDEX_NONE)
+		{
+			BranchLength = 0.0f;
+		}
+		TrackSegment->SetGridSizeAndReturnScaleRatio(GridSize);
+		TrackSegment->StartDistance = BranchLength;
+		BranchLength += TrackSegment->GetSegmentLength();
+	}
+}
+
+void ATrainTrack::BuildSegmentDataFromActors()
+{
+	SegmentData.Reset(TrackSegments.Num() + BranchSegments.Num());
+	NumMainSegments = TrackSegments.Num();
+
+	float NextStartDistance = 0.0f;
+	for (ATrackSegment* TrackSegment : TrackSegments)
+	{
+		// invalid entries act like zero-length segments
+		FTrackSegmentData& Data = SegmentData.AddDefaulted_GetRef();
+		Data.StartDistance = NextStartDistance;
+		if (IsValid(TrackSegment))
+		{
+			Data.InitFromSegment(*TrackSegment);
+			NextStartDistance = Data.StartDistance + Data.GetSegmentLength();
+		}
+	}
+	for (ATrackSegment* TrackSegment : BranchSegments)
+	{
+		FTrackSegmentData& Data = SegmentData.AddDefaulted_GetRef();
+		if (IsValid(TrackSegment))
+		{
+			Data.InitFromSegment(*TrackSegment);
+		}
+	}
+}
+
+void ATrainTrack::BuildSegmentDataFromLayout()
+{
+	TArray<UTrackSegmentMetaInfo*> TrackSegmentInfos;
+	GetComponents<UTrackSegmentMetaInfo>(TrackSegmentInfos);
+	TrackSegmentInfos.Sort(ATrainTrack::SegmentInfoPredicate);
+
+	SegmentData.Reset(TrackSegmentInfos.Num());
+	NumMainSegments = TrackSegmentInfos.Num();
+
+	// same placement as CreateTrackSegments, without spawning anything
+	TMap<int32, int32> PlacedSegments;
+	FTransform StartPose = GetActorTransform();
+	float NextStartDistance = 0.0f;
+	for (UTrackSegmentMetaInfo* TrackSegmentInfo : TrackSegmentInfos)
+	{
+		if (TrackSegmentInfo->BranchFromSegmentIndex != INDEX_NONE)
+		{
+			// everything from the first branch onward is off the main loop
+			if (NumMainSegments == TrackSegmentInfos.Num())
+			{
+				NumMainSegments = SegmentData.Num();
+			}
+			int32* JunctionIndex = PlacedSegments.Find(TrackSegmentInfo->BranchFromSegmentIndex);
+			StartPose = JunctionIndex != nullptr
+				? SegmentData[*JunctionIndex].GetEndPose()
+				: GetActorTransform();
+			NextStartDistance = 0.0f;
+		}
+
+		FTrackSegmentData& Data = SegmentData.AddDefaulted_GetRef();
+		Data.TrackSegmentType = TrackSegmentInfo->TrackSegmentType;
+		Data.SegmentIndex = TrackSegmentInfo->SegmentIndex;
+		Data.BranchFromSegmentIndex = TrackSegmentInfo->BranchFromSegmentIndex;
+		Data.MergeIntoSegmentIndex = TrackSegmentInfo->MergeIntoSegmentIndex;
+		Data.GridSize = GridSize;
+		Data.StartDistance = NextStartDistance;
+		Data.Transform = StartPose;
+
+		PlacedSegments.Add(Data.SegmentIndex, SegmentData.Num() - 1);
+		StartPose = Data.GetEndPose();
+		NextStartDistance += Data.GetSegmentLength();
+	}
+}
+
+UInstancedStaticMeshComponent* ATrainTrack::GetSegmentInstances(ESegmentType ShapeType) const
+{
+	switch (ShapeType)
+	{
+		case ESegmentType::LeftTurn:
+			return LeftTurnSegmentInstances;
+		case ESegmentType::RightTurn:
+			return RightTurnSegmentInstances;
+		default:
+			return StraightSegmentInstances;
+	}
+}
+
+int32 ATrainTrack::GetNumSegmentInstances() const
+{
+	return StraightSegmentInstances->GetInstanceCount()
+		+ LeftTurnSegmentInstances->GetInstanceCount()
+		+ RightTurnSegmentInstances->GetInstanceCount();
+}
+
+void ATrainTrack::ClearSegmentInstances()
+{
+	StraightSegmentInstances->ClearInstances();
+	LeftTurnSegmentInstances->ClearInstances();
+	RightTurnSegmentInstances->ClearInstances();
+}
+
+void ATrainTrack::BakeSegmentInstances()
+{
+	ClearSegmentInstances();
+
+	const ATrackSegment* SegmentTemplate = TrackSegmentBP != nullptr
+		? TrackSegmentBP->GetDefaultObject<ATrackSegment>()
+		: nullptr;
+	if (!IsValid(SegmentTemplate))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Track has no segment blueprint to take meshes from!"));
+		return;
+	}
+
+	// meshes, materials and mesh placement come from the segment blueprint
+	for (unsigned int SegmentTypeIndex = (unsigned int)ESegmentType::Straight;
+		SegmentTypeIndex <= (unsigned int)ESegmentType::RightTurn; SegmentTypeIndex++)
+	{
+		UStaticMeshComponent* MeshTemplate = SegmentTemplate->SegmentMeshes[SegmentTypeIndex];
+		UInstancedStaticMeshComponent* Instances = GetSegmentInstances((ESegmentType)SegmentTypeIndex);
+		if (!IsValid(MeshTemplate))
+		{
+			continue;
+		}
+		Instances->SetStaticMesh(MeshTemplate->GetStaticMesh());
+		for (int32 MaterialIndex = 0; MaterialIndex < MeshTemplate->GetNumMaterials(); MaterialIndex++)
+		{
+			Instances->SetMaterial(MaterialIndex, MeshTemplate->GetMaterial(MaterialIndex));
+		}
+		Instances->SetCollisionProfileName(MeshTemplate->GetCollisionProfileName());
+	}
+
+	for (const FTrackSegmentData& Data : SegmentData)
+	{
+		ESegmentType ShapeType = ATrackSegment::ToShapeType(Data.TrackSegmentType);
+		UStaticMeshComponent* MeshTemplate = SegmentTemplate->SegmentMeshes[(unsigned int)ShapeType];
+		FTransform MeshTransform = ATrackSegment::ComputeMeshRelativeTransform(Data.GridSize,
+			IsValid(MeshTemplate) ? MeshTemplate->GetRelativeTransform() : FTransform::Identity);
+		GetSegmentInstances(ShapeType)->AddInstance(MeshTransform * Data.Transform, true);
+	}
+}
+
+void ATrainTrack::RebuildSegmentIndex()
+{
+	SegmentStartDistances.Reset(NumMainSegments);
+
+	for (int32 SegmentIndex = 0; SegmentIndex < NumMainSegments; SegmentIndex++)
+	{
+		SegmentStartDistances.Add(SegmentData[SegmentIndex].StartDistance);
+	}
+
+	TrackLength = NumMainSegments > 0
+		? SegmentData[NumMainSegments - 1].StartDistance + SegmentData[NumMainSegments - 1].GetSegmentLength()
+		: 0.0f;
+}
+
+void ATrainTrack::RebuildSegmentData()
+{
+	if (bUseInstancedSegments)
+	{
+		BuildSegmentDataFromLayout();
+	}
+	else
+	{
+		InitializeSegmentReferences();
+		SetUpTrackSegmentDistances();
+		BuildSegmentDataFromActors();
+	}
+	RebuildSegmentIndex();
+	RebuildPoseCache();
+	BuildTrackGraph();
+	bSegmentDataStale = false;
+	bSegmentPosesStale = false;
+}
+
+void ATrainTrack::RebuildSegmentPoses()
+{
+	if (bUseInstancedSegments)
+	{
+		BuildSegmentDataFromLayout();
+	}
+	else
+	{
+		BuildSegmentDataFromActors();
+	}
+	RebuildPoseCache();
+	bSegmentPosesStale = false;
+}
+
+void ATrainTrack::RebuildSegmentDataIfStale()
+{
+	// segments can be queried before BeginPlay (e.g. from blueprints),
+	// after being regenerated or after the track moved
+	if (bSegmentDataStale)
+	{
+		RebuildSegmentData();
+	}
+	else if (bSegmentPosesStale)
+	{
+		RebuildSegmentPoses();
+	}
+}
+
+void ATrainTrack::OnRootTransformUpdated(USceneComponent* UpdatedComponent,
+	EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// attached segments may not have moved yet, so rebuild on the next lookup
+	bSegmentPosesStale = true;
 }
 
 void ATrainTrack::ScaleTrainByScaleRatio(TArray<ANormalTrainCar*> NormalTrainCars,
 	ATrainLocomotive* TrainLocomotive)
 {
-	if (TrackSegments.Num() == 0 || !IsValid(TrackSegments[0]))
+	if (SegmentData.Num() == 0)
 	{
 		return;
 	}
 
-	float SegmentScaleRatio = TrackSegments[0]->SetGridSizeAndReturnScaleRatio(GridSize);
+	float SegmentScaleRatio = ATrackSegment::ComputeScaleRatio(GridSize);
 	// scale everything up. the train is sized according to the default segment size
 	// so if the segment scales up or down, the train scales accordingly
 	if (TrainParent != nullptr && IsValid(TrainParent))
@@ -252,21 +631,287 @@ void ATrainTrack::ScaleTrainByScaleRatio(TArray<ANormalTrainCar*> NormalTrainCar
 			Car->Scale = SegmentScaleRatio;
 		}
 	}
+	// axle offsets and spacing depend on scale
+	if (IsValid(TrainLocomotive))
+	{
+		TrainLocomotive->RebuildConsist();
+	}
 }
 
 ATrackSegment* ATrainTrack::GetTrackSegment(float DistanceIntoTrack)
 {
-	unsigned int NumSegments = TrackSegments.Num();
-	unsigned int LastSegmentIndex = NumSegments - 1;
-	for (unsigned int SegmentIndex = 0; SegmentIndex < NumSegments; SegmentIndex++)
+	int32 SegmentIndexHint = INDEX_NONE;
+	return GetTrackSegment(DistanceIntoTrack, SegmentIndexHint);
+}
+
+ATrackSegment* ATrainTrack::GetTrackSegment(float DistanceIntoTrack, int32& SegmentIndexHint)
+{
+	RebuildSegmentDataIfStale();
+	SegmentIndexHint = FindTrackSegmentIndex(DistanceIntoTrack, SegmentIndexHint);
+	return TrackSegments.IsValidIndex(SegmentIndexHint) ? TrackSegments[SegmentIndexHint] : nullptr;
+}
+
+bool ATrainTrack::GetTrackSegmentInfo(float DistanceIntoTrack, int32& SegmentIndex, ESegmentType& SegmentType,
+	float& StartDistance, FTransform& StartTransform)
+{
+	RebuildSegmentDataIfStale();
+	int32 DataIndex = FindTrackSegmentIndex(DistanceIntoTrack);
+	if (!SegmentData.IsValidIndex(DataIndex))
+	{
+		return false;
+	}
+	const FTrackSegmentData& Data = SegmentData[DataIndex];
+	SegmentIndex = Data.SegmentIndex;
+	SegmentType = Data.TrackSegmentType;
+	StartDistance = Data.StartDistance;
+	StartTransform = Data.Transform;
+	return true;
+}
+
+int32 ATrainTrack::FindTrackSegmentIndex(float DistanceIntoTrack, int32 SegmentIndexHint) const
+{
+	int32 NumSegments = SegmentStartDistances.Num();
+	if (NumSegments == 0)
+	{
+		return INDEX_NONE;
+	}
+
+	// most lookups land in the same segment as last time or in the
+	// one right after it (or before it, if reversing)
+	if (SegmentIndexHint >= 0 && SegmentIndexHint < NumSegments)
+	{
+		int32 NextSegmentIndex = (SegmentIndexHint + 1) % NumSegments;
+		int32 PrevSegmentIndex = (SegmentIndexHint + NumSegments - 1) % NumSegments;
+		if (SegmentContainsDistance(SegmentIndexHint, DistanceIntoTrack))
+		{
+			return SegmentIndexHint;
+		}
+		if (SegmentContainsDistance(NextSegmentIndex, DistanceIntoTrack))
+		{
+			return NextSegmentIndex;
+		}
+		if (SegmentContainsDistance(PrevSegmentIndex, DistanceIntoTrack))
+		{
+			return PrevSegmentIndex;
+		}
+	}
+
+	return FindTrackSegmentIndex(DistanceIntoTrack);
+}
+
+int32 ATrainTrack::FindTrackSegmentIndex(float DistanceIntoTrack) const
+{
+	// the segment we want is the last one that starts at or before the
+	// distance, i.e. the one right before the first segment starting after it.
+	// distances before the first segment yield INDEX_NONE
+	return Algo::UpperBound(SegmentStartDistances, DistanceIntoTrack) - 1;
+}
+
+bool ATrainTrack::SegmentContainsDistance(int32 SegmentIndex, float DistanceIntoTrack) const
+{
+	int32 LastSegmentIndex = SegmentStartDistances.Num() - 1;
+	// last segment takes everything past its start, just like the
+	// original linear search did
+	return DistanceIntoTrack >= SegmentStartDistances[SegmentIndex]
+		&& (SegmentIndex == LastSegmentIndex || DistanceIntoTrack < SegmentStartDistances[SegmentIndex + 1]);
+}
+
+bool ATrainTrack::EvaluatePose(float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint)
+{
+	RebuildSegmentDataIfStale();
+	if (PoseCache.IsValid())
+	{
+		PoseCache.EvaluatePose(DistanceIntoTrack, Pose);
+		return true;
+	}
+	return EvaluateSegmentPose(DistanceIntoTrack, Pose, SegmentIndexHint);
+}
+
+bool ATrainTrack::EvaluateSegmentPose(float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint)
+{
+	SegmentIndexHint = FindTrackSegmentIndex(DistanceIntoTrack, SegmentIndexHint);
+	if (SegmentIndexHint == INDEX_NONE)
+	{
+		return false;
+	}
+	const FTrackSegmentData& Data = SegmentData[SegmentIndexHint];
+	Data.UpdatePoseInSegment(DistanceIntoTrack - Data.StartDistance, Pose);
+	return true;
+}
+
+void ATrainTrack::RebuildPoseCache()
+{
+	PoseCache.Reset();
+	if (!bUsePoseCache || TrackLength <= 0.0f)
+	{
+		return;
+	}
+
+	int32 SegmentIndexHint = INDEX_NONE;
+	bool bErrorBoundMet = PoseCache.Build(TrackLength, PoseCacheSampleSpacing, PoseCacheMaxError,
+		FMath::DegreesToRadians(PoseCacheMaxAngleError),
+		[this, &SegmentIndexHint](float DistanceIntoTrack, FTransform& Pose) {
+			EvaluateSegmentPose(DistanceIntoTrack, Pose, SegmentIndexHint);
+		});
+	UE_LOG(LogTemp, Log,
+		TEXT("Track pose cache: %d samples, spacing %f, max error %f (bound %f), max angle error %f (bound %f)%s"),
+		PoseCache.GetNumSamples(), PoseCache.GetSampleSpacing(),
+		PoseCache.GetMaxMeasuredError(), PoseCacheMaxError,
+		FMath::RadiansToDegrees(PoseCache.GetMaxMeasuredAngleError()), PoseCacheMaxAngleError,
+		bErrorBoundMet ? TEXT("") : TEXT(", bound not met"));
+}
+
+void ATrainTrack::BuildTrackGraph()
+{
+	TrackGraph.Reset();
+	SegmentIndexToEdge.Reset();
+
+	// edges are in the same order as SegmentData, so main loop
+	// edges line up with the distance index too
+	int32 NumEdges = SegmentData.Num();
+	for (const FTrackSegmentData& Data : SegmentData)
 	{
-		auto CurrSegment = TrackSegments[SegmentIndex];
-		auto NextSegment = TrackSegments[(SegmentIndex + 1) % NumSegments];
-		if (DistanceIntoTrack >= CurrSegment->StartDistance && (DistanceIntoTrack < NextSegment->StartDistance || SegmentIndex == LastSegmentIndex))
+		int32 Edge = TrackGraph.AddEdge(Data.GetSegmentLength());
+		if (Data.SegmentIndex != INDEX_NONE)
 		{
-			return CurrSegment;
+			SegmentIndexToEdge.Add(Data.SegmentIndex, Edge);
 		}
 	}
 
-	return nullptr;
+	for (int32 Edge = 0; Edge < NumEdges; Edge++)
+	{
+		if (SegmentData[Edge].MergeIntoSegmentIndex != INDEX_NONE)
+		{
+			continue;
+		}
+		if (Edge == NumMainSegments - 1)
+		{
+			// close the main loop
+			TrackGraph.Connect(Edge, 0);
+		}
+		else if (Edge + 1 < NumEdges && SegmentData[Edge + 1].BranchFromSegmentIndex == INDEX_NONE)
+		{
+			TrackGraph.Connect(Edge, Edge + 1);
+		}
+	}
+
+	// switches need their through route connected first
+	for (int32 Edge = 0; Edge < NumEdges; Edge++)
+	{
+		const FTrackSegmentData& Data = SegmentData[Edge];
+		if (Data.BranchFromSegmentIndex != INDEX_NONE)
+		{
+			int32* JunctionEdge = SegmentIndexToEdge.Find(Data.BranchFromSegmentIndex);
+			if (JunctionEdge == nullptr || SegmentData[*JunctionEdge].TrackSegmentType != ESegmentType::Junction)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Segment %d branches from %d, which is not a junction!"),
+					Data.SegmentIndex, Data.BranchFromSegmentIndex);
+			}
+			if (JunctionEdge != nullptr)
+			{
+				TrackGraph.AddDivergingLeg(*JunctionEdge, Edge);
+			}
+		}
+	}
+
+	// merges come last, so one that lands on a junction's switch is
+	// what gets rejected rather than the junction's own branch
+	for (int32 Edge = 0; Edge < NumEdges; Edge++)
+	{
+		const FTrackSegmentData& Data = SegmentData[Edge];
+		if (Data.MergeIntoSegmentIndex == INDEX_NONE)
+		{
+			continue;
+		}
+		int32* TrunkEdge = SegmentIndexToEdge.Find(Data.MergeIntoSegmentIndex);
+		if (TrunkEdge == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Segment %d merges into missing segment %d!"),
+				Data.SegmentIndex, Data.MergeIntoSegmentIndex);
+			continue;
+		}
+		if (!TrackGraph.AddMergingLeg(Edge, *TrunkEdge))
+		{
+			UE_LOG(LogTemp, Warning,
+				TEXT("Segment %d can't merge into segment %d, which already starts at a switch! Merge into a later segment."),
+				Data.SegmentIndex, Data.MergeIntoSegmentIndex);
+		}
+	}
+}
+
+FTrackRouteCursor ATrainTrack::MakeRouteCursor(float DistanceIntoTrack)
+{
+	RebuildSegmentDataIfStale();
+	FTrackRouteCursor Cursor;
+	Cursor.Edge = FindTrackSegmentIndex(DistanceIntoTrack, INDEX_NONE);
+	if (Cursor.Edge != INDEX_NONE)
+	{
+		Cursor.DistanceOnEdge = DistanceIntoTrack - SegmentData[Cursor.Edge].StartDistance;
+	}
+	return Cursor;
+}
+
+bool ATrainTrack::AdvanceRouteCursor(FTrackRouteCursor& Cursor, float Delta, FTransform& Pose)
+{
+	RebuildSegmentDataIfStale();
+	bool bStillMoving = TrackGraph.Advance(Cursor, Delta);
+	if (!SegmentData.IsValidIndex(Cursor.Edge))
+	{
+		return false;
+	}
+
+	SegmentData[Cursor.Edge].UpdatePoseInSegment(Cursor.DistanceOnEdge, Pose);
+	if (Cursor.bReversed)
+	{
+		// face the way we are traveling
+		Pose.SetRotation(Pose.GetRotation() * FQuat(FVector::UpVector, PI));
+	}
+	return bStillMoving || Delta == 0.0f;
+}
+
+bool ATrainTrack::EvaluateRoutePose(float DistanceIntoTrack, FTransform& Pose, FTrackRouteCursor& Cursor)
+{
+	if (Cursor.Edge == INDEX_NONE)
+	{
+		Cursor = MakeRouteCursor(DistanceIntoTrack);
+		Cursor.RouteDistance = DistanceIntoTrack;
+	}
+
+	// the distance wraps around the loop, so take the shorter way there
+	float Delta = DistanceIntoTrack - Cursor.RouteDistance;
+	if (Delta > 0.5f * TrackLength)
+	{
+		Delta -= TrackLength;
+	}
+	else if (Delta < -0.5f * TrackLength)
+	{
+		Delta += TrackLength;
+	}
+	bool bAdvanced = AdvanceRouteCursor(Cursor, Delta, Pose);
+	// a cursor stopped at a dead end is short of where it was sent, so
+	// the next delta has to be measured from where it really is
+	Cursor.RouteDistance = DistanceIntoTrack - Cursor.DeadEndShortfall;
+	return bAdvanced;
+}
+
+void ATrainTrack::ToggleJunction(int32 JunctionSegmentIndex)
+{
+	int32 SwitchNode = FindSwitchNode(JunctionSegmentIndex);
+	if (SwitchNode == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Segment %d doesn't end or start at a switch!"), JunctionSegmentIndex);
+		return;
+	}
+	TrackGraph.SetDiverging(SwitchNode, !TrackGraph.IsDiverging(SwitchNode));
+}
+
+bool ATrainTrack::IsJunctionDiverging(int32 JunctionSegmentIndex) const
+{
+	return TrackGraph.IsDiverging(FindSwitchNode(JunctionSegmentIndex));
+}
+
+int32 ATrainTrack::FindSwitchNode(int32 SegmentIndex) const
+{
+	const int32* Edge = SegmentIndexToEdge.Find(SegmentIndex);
+	return Edge != nullptr ? TrackGraph.FindSwitchNode(*Edge) : INDEX_NONE;
 }
@@ -9,12 +9,35 @@ LICENSE file in the root directory of this source tree.
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "TrackGraph.h"
+#include "TrackOccupancy.h"
+#include "TrackPoseCache.h"
 #include "TrackSegment.h"
 #include "TrackSegmentMetaInfo.h"
 #include "TrainTrack.generated.h"
 
 class ATrackSegment;
 
+/** What the last regeneration did to the track's segment actors. */
+struct FTrackRegenerationStats
+{
+	int32 NumSpawned = 0;
+	int32 NumReused = 0;
+	int32 NumUpdated = 0;
+	int32 NumDestroyed = 0;
+	int32 FirstDirtySegmentIndex = INDEX_NONE;
+};
+
+/** Rough cost of drawing a track's segments, to compare actors with instances. */
+struct FTrackSegmentRenderStats
+{
+	int32 NumSegmentActors = 0;
+	int32 NumSegmentComponents = 0;
+	SIZE_T SegmentActorBytes = 0;
+	int32 NumSegmentInstances = 0;
+	SIZE_T SegmentInstanceBytes = 0;
+};
+
 UCLASS()
 class HANDSTRAINSAMPLE_API ATrainTrack : public AActor
 {
@@ -39,15 +62,56 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = TrainVis)
 	class USceneComponent* TrainParent;
 
+	// segments of the main loop, in order
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Track)
 	TArray<ATrackSegment*> TrackSegments;
 
+	// segments off the main loop, reachable through junctions
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Track)
+	TArray<ATrackSegment*> BranchSegments;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Track|Pose Cache",
+		meta = (Tooltip = "Evaluate car poses from a table baked at BeginPlay instead of per-segment math"))
+	bool bUsePoseCache;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Track|Pose Cache",
+		meta = (ClampMin = "0.01", Tooltip = "Initial distance between baked poses"))
+	float PoseCacheSampleSpacing;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Track|Pose Cache",
+		meta = (ClampMin = "0.0001", Tooltip = "Max position error of baked poses; spacing is refined until met"))
+	float PoseCacheMaxError;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Track|Pose Cache",
+		meta = (ClampMin = "0.0001", Tooltip = "Max rotation error of baked poses, in degrees; spacing is refined until met"))
+	float PoseCacheMaxAngleError;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Track|Instancing",
+		meta = (Tooltip = "Draw segments as mesh instances on the track instead of spawning a segment actor for each"))
+	bool bUseInstancedSegments;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Track|Instancing")
+	class UInstancedStaticMeshComponent* StraightSegmentInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Track|Instancing")
+	class UInstancedStaticMeshComponent* LeftTurnSegmentInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Track|Instancing")
+	class UInstancedStaticMeshComponent* RightTurnSegmentInstances;
+
 	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Track")
 	void SetUpTrack();
 
 	UFUNCTION(CallInEditor, BlueprintCallable, Category = "Track")
 	void LogTrackInformation();
 
+	const FTrackRegenerationStats& GetLastRegenerationStats() const
+	{
+		return LastRegenerationStats;
+	}
+
+	FTrackSegmentRenderStats GetSegmentRenderStats() const;
+
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Track")
 	float GetTrackLength() const
 	{
@@ -57,6 +121,90 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Track")
 	ATrackSegment* GetTrackSegment(float DistanceIntoTrack);
 
+	/**
+	 * Same as above, but checks the caller's last known segment (and its
+	 * neighbors) before falling back to a binary search. Cars advance at most
+	 * one segment per frame, so this is usually a constant-time lookup.
+	 * @param DistanceIntoTrack - Distance from the start of the track.
+	 * @param SegmentIndexHint - Index into TrackSegments from the last lookup.
+	 * Updated with the index of the segment found.
+	 * @return Segment containing the distance, if any. Always null
+	 * with instanced segments; use GetTrackSegmentInfo for those.
+	 */
+	ATrackSegment* GetTrackSegment(float DistanceIntoTrack, int32& SegmentIndexHint);
+
+	/**
+	 * Looks up the main loop segment containing a distance from segment data,
+	 * so it works whether segments are actors or instances.
+	 * @param SegmentIndex - Index of the segment in the track layout.
+	 * @param StartTransform - World transform of the start of the segment.
+	 * @return False if no segment contains the distance.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Track")
+	bool GetTrackSegmentInfo(float DistanceIntoTrack, int32& SegmentIndex, ESegmentType& SegmentType,
+		float& StartDistance, FTransform& StartTransform);
+
+	/**
+	 * Pose of the track at a distance, taken from the pose cache if it's
+	 * built, otherwise from the segment containing the distance.
+	 * @param DistanceIntoTrack - Distance from the start of the track, in [0, length].
+	 * @param Pose - Location and rotation are written to this.
+	 * @param SegmentIndexHint - Same as in GetTrackSegment; unused with the cache.
+	 * @return True if a pose was found.
+	 */
+	bool EvaluatePose(float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint);
+
+	/**
+	 * Only needed after changing the cache settings; the cache
+	 * is rebuilt on its own when the track moves.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Track")
+	void RebuildPoseCache();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Track")
+	bool HasBranches() const
+	{
+		return NumMainSegments < SegmentData.Num();
+	}
+
+	/**
+	 * Flips the switch a segment ends at, like a junction, or else starts at,
+	 * like the trunk after a merge.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Track")
+	void ToggleJunction(int32 JunctionSegmentIndex);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Track")
+	bool IsJunctionDiverging(int32 JunctionSegmentIndex) const;
+
+	/** Cursor on the main loop at a distance from the start of the track. */
+	FTrackRouteCursor MakeRouteCursor(float DistanceIntoTrack);
+
+	/**
+	 * Moves a cursor through the track graph, following junction switches.
+	 * @param Cursor - Cursor to move.
+	 * @param Delta - Distance to move; negative moves backward.
+	 * @param Pose - Pose at the cursor's new position.
+	 * @return False if the cursor is invalid or hit a dead end.
+	 */
+	bool AdvanceRouteCursor(FTrackRouteCursor& Cursor, float Delta, FTransform& Pose);
+
+	/**
+	 * Moves a cursor by the change in a distance along the track, for callers
+	 * that only keep a looping distance. An invalid cursor is placed on the
+	 * main loop at that distance first.
+	 * @param DistanceIntoTrack - New distance, in [0, length].
+	 * @param Pose - Pose at the cursor's new position.
+	 * @param Cursor - Cursor following the distance.
+	 */
+	bool EvaluateRoutePose(float DistanceIntoTrack, FTransform& Pose, FTrackRouteCursor& Cursor);
+
+	/** Which train is where; shared by all trains on this track. */
+	FTrackOccupancy& GetTrackOccupancy()
+	{
+		return TrackOccupancy;
+	}
+
 	inline static bool SegmentPredicate(const ATrackSegment& Segment1,
 		const ATrackSegment& Segment2)
 	{
@@ -76,16 +224,68 @@ protected:
 private:
 	float TrackLength;
 
+	/**
+	 * Geometry of every segment, main loop first and then branches, so
+	 * that it works the same whether segments are actors or instances.
+	 */
+	TArray<FTrackSegmentData> SegmentData;
+	int32 NumMainSegments;
+
+	/**
+	 * Start distance of each main loop segment, in the same order.
+	 * Since distances only increase this doubles as a search index.
+	 */
+	TArray<float> SegmentStartDistances;
+
+	// set wherever segments are regenerated, so lookups rebuild
+	// segment data, index, pose cache and graph before answering
+	bool bSegmentDataStale;
+
+	// set when the track moves; segment data and the pose cache are
+	// in world space, but distances and connections stay the same
+	bool bSegmentPosesStale;
+
+	FTrackPoseCache PoseCache;
+	FTrackOccupancy TrackOccupancy;
+	FTrackRegenerationStats LastRegenerationStats;
+
+	// edges are indices into SegmentData
+	FTrackGraph TrackGraph;
+	TMap<int32, int32> SegmentIndexToEdge;
+
+	bool EvaluateSegmentPose(float DistanceIntoTrack, FTransform& Pose, int32& SegmentIndexHint);
+
 	void SetUpTrackSegmentInformationDistances(
 		const TArray<UTrackSegmentMetaInfo*>& TrackSegmentInfos,
 		TArray<float>& SegmentDistances);
 	void CreateTrackSegments(
 		const TArray<UTrackSegmentMetaInfo*>& TrackSegmentInfos,
 		const TArray<float>& SegmentDistances);
+	bool IsTrackSegmentDirty(const ATrackSegment* TrackSegment,
+		const UTrackSegmentMetaInfo* TrackSegmentInfo, const FTransform& StartPose) const;
 
 	void InitializeSegmentReferences();
 	void InitializeTrain();
 	void SetUpTrackSegmentDistances();
+	void BuildSegmentDataFromActors();
+	void BuildSegmentDataFromLayout();
+	void RebuildSegmentIndex();
+	void RebuildSegmentData();
+	void RebuildSegmentPoses();
+	void RebuildSegmentDataIfStale();
+	void OnRootTransformUpdated(USceneComponent* UpdatedComponent,
+		EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+	void BuildTrackGraph();
+	int32 FindSwitchNode(int32 SegmentIndex) const;
+
+	UInstancedStaticMeshComponent* GetSegmentInstances(ESegmentType ShapeType) const;
+	int32 GetNumSegmentInstances() const;
+	void ClearSegmentInstances();
+	void BakeSegmentInstances();
+
+	int32 FindTrackSegmentIndex(float DistanceIntoTrack, int32 SegmentIndexHint) const;
+	int32 FindTrackSegmentIndex(float DistanceIntoTrack) const;
+	bool SegmentContainsDistance(int32 SegmentIndex, float DistanceIntoTrack) const;
 	void ScaleTrainByScaleRatio(TArray<class ANormalTrainCar*> NormalTrainCars,
 		class ATrainLocomotive* TrainLocomotive);
 };